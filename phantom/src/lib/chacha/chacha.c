@@ -0,0 +1,117 @@
+#include "lib/chacha/chacha.h"
+
+#include <string.h>
+
+#define ROTL32(v, n) (((v) << (n)) | ((v) >> (32 - (n))))
+
+#define QUARTERROUND(a, b, c, d)                                                                   \
+    a += b;                                                                                        \
+    d ^= a;                                                                                        \
+    d = ROTL32(d, 16);                                                                             \
+    c += d;                                                                                        \
+    b ^= c;                                                                                        \
+    b = ROTL32(b, 12);                                                                             \
+    a += b;                                                                                        \
+    d ^= a;                                                                                        \
+    d = ROTL32(d, 8);                                                                              \
+    c += d;                                                                                        \
+    b ^= c;                                                                                        \
+    b = ROTL32(b, 7);
+
+static inline uint32_t _load32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) |
+           ((uint32_t)p[3] << 24);
+}
+
+static inline void _store32(uint8_t* p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+// splitmix64, used only to expand a seed into a key
+static uint64_t _splitmix64(uint64_t* state) {
+    uint64_t z = (*state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+ChaCha ChaCha_init(const uint8_t key[32], uint64_t nonce) {
+    ChaCha chacha = {.nonce = nonce, .counter = 0, .blockPos = CHACHA_BLOCK_SIZE};
+    for (int i = 0; i < 8; i++) {
+        chacha.key[i] = _load32(&key[4 * i]);
+    }
+    return chacha;
+}
+
+ChaCha ChaCha_initFromSeed(uint64_t seed) {
+    uint8_t key[32];
+    uint64_t state = seed;
+    for (int i = 0; i < 4; i++) {
+        uint64_t v = _splitmix64(&state);
+        _store32(&key[8 * i], (uint32_t)v);
+        _store32(&key[8 * i + 4], (uint32_t)(v >> 32));
+    }
+    return ChaCha_init(key, 0);
+}
+
+void ChaCha_block(const ChaCha* chacha, uint64_t counter, uint8_t out[CHACHA_BLOCK_SIZE]) {
+    // "expand 32-byte k"
+    uint32_t input[16] = {
+        0x61707865,     0x3320646e,         0x79622d32,          0x6b206574,
+        chacha->key[0], chacha->key[1],     chacha->key[2],      chacha->key[3],
+        chacha->key[4], chacha->key[5],     chacha->key[6],      chacha->key[7],
+        (uint32_t)counter, (uint32_t)(counter >> 32), (uint32_t)chacha->nonce,
+        (uint32_t)(chacha->nonce >> 32),
+    };
+
+    uint32_t x[16];
+    memcpy(x, input, sizeof(x));
+
+    for (int i = 0; i < 10; i++) {
+        // column rounds
+        QUARTERROUND(x[0], x[4], x[8], x[12]);
+        QUARTERROUND(x[1], x[5], x[9], x[13]);
+        QUARTERROUND(x[2], x[6], x[10], x[14]);
+        QUARTERROUND(x[3], x[7], x[11], x[15]);
+        // diagonal rounds
+        QUARTERROUND(x[0], x[5], x[10], x[15]);
+        QUARTERROUND(x[1], x[6], x[11], x[12]);
+        QUARTERROUND(x[2], x[7], x[8], x[13]);
+        QUARTERROUND(x[3], x[4], x[9], x[14]);
+    }
+
+    for (int i = 0; i < 16; i++) {
+        _store32(&out[4 * i], x[i] + input[i]);
+    }
+}
+
+void ChaCha_fill(ChaCha* chacha, void* buf, size_t len) {
+    uint8_t* out = buf;
+
+    // Use up what is left of the previous block.
+    size_t n = CHACHA_BLOCK_SIZE - chacha->blockPos;
+    if (n > len) {
+        n = len;
+    }
+    memcpy(out, &chacha->block[chacha->blockPos], n);
+    chacha->blockPos += n;
+    out += n;
+    len -= n;
+
+    // Write whole blocks straight into the output.
+    while (len >= CHACHA_BLOCK_SIZE) {
+        ChaCha_block(chacha, chacha->counter++, out);
+        out += CHACHA_BLOCK_SIZE;
+        len -= CHACHA_BLOCK_SIZE;
+    }
+
+    // Keep the rest of a partial block for the next call.
+    if (len > 0) {
+        ChaCha_block(chacha, chacha->counter++, chacha->block);
+        memcpy(out, chacha->block, len);
+        chacha->blockPos = len;
+    }
+}
@@ -0,0 +1,40 @@
+#ifndef LIB_CHACHA_CHACHA_H
+#define LIB_CHACHA_CHACHA_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * A deterministic stream of pseudo-random bytes from the ChaCha20 block
+ * function. It is used for the random bytes that shadow gives to managed
+ * processes, both in shadow itself and in the openssl preload library.
+ *
+ * This is not meant to be cryptographically secure in a simulation, only fast
+ * and reproducible from its key.
+ */
+
+#define CHACHA_BLOCK_SIZE 64
+
+typedef struct _ChaCha {
+    uint32_t key[8];
+    uint64_t nonce;
+    // Index of the next block in the stream.
+    uint64_t counter;
+    // The last generated block, of which the bytes from `blockPos` are unused.
+    uint8_t block[CHACHA_BLOCK_SIZE];
+    uint8_t blockPos;
+} ChaCha;
+
+// Instantiate a generator from a 32-byte key and a nonce.
+ChaCha ChaCha_init(const uint8_t key[32], uint64_t nonce);
+
+// Instantiate a generator from a 64-bit seed, expanding it into a key.
+ChaCha ChaCha_initFromSeed(uint64_t seed);
+
+// Write the 64-byte block at position `counter` of the stream to `out`.
+void ChaCha_block(const ChaCha* chacha, uint64_t counter, uint8_t out[CHACHA_BLOCK_SIZE]);
+
+// Fill `buf` with the next `len` bytes of the stream.
+void ChaCha_fill(ChaCha* chacha, void* buf, size_t len);
+
+#endif
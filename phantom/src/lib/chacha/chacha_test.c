@@ -0,0 +1,65 @@
+#include "lib/chacha/chacha.h"
+
+#include <glib.h>
+#include <stdint.h>
+#include <string.h>
+
+// The block function test vector from RFC 8439 section 2.3.2. The RFC uses a
+// 32-bit counter and a 96-bit nonce, which maps onto our 64-bit counter and
+// nonce words.
+static void blockMatchesRfc8439(void) {
+    uint8_t key[32];
+    for (int i = 0; i < 32; i++) {
+        key[i] = i;
+    }
+    ChaCha chacha = ChaCha_init(key, 0x4a000000ULL);
+
+    const uint8_t expected[CHACHA_BLOCK_SIZE] = {
+        0x10, 0xf1, 0xe7, 0xe4, 0xd1, 0x3b, 0x59, 0x15, 0x50, 0x0f, 0xdd, 0x1f, 0xa3,
+        0x20, 0x71, 0xc4, 0xc7, 0xd1, 0xf4, 0xc7, 0x33, 0xc0, 0x68, 0x03, 0x04, 0x22,
+        0xaa, 0x9a, 0xc3, 0xd4, 0x6c, 0x4e, 0xd2, 0x82, 0x64, 0x46, 0x07, 0x9f, 0xaa,
+        0x09, 0x14, 0xc2, 0xd7, 0x05, 0xd9, 0x8b, 0x02, 0xa2, 0xb5, 0x12, 0x9c, 0xd1,
+        0xde, 0x16, 0x4e, 0xb9, 0xcb, 0xd0, 0x83, 0xe8, 0xa2, 0x50, 0x3c, 0x4e,
+    };
+
+    uint8_t out[CHACHA_BLOCK_SIZE];
+    ChaCha_block(&chacha, 1 | (0x09000000ULL << 32), out);
+    g_assert_cmpmem(out, sizeof(out), expected, sizeof(expected));
+}
+
+// The stream must not depend on how it is split across calls.
+static void fillIsIndependentOfChunking(void) {
+    ChaCha whole = ChaCha_initFromSeed(1234);
+    ChaCha pieces = ChaCha_initFromSeed(1234);
+
+    uint8_t expected[1000];
+    ChaCha_fill(&whole, expected, sizeof(expected));
+
+    uint8_t actual[1000];
+    size_t chunks[] = {1, 3, 60, 64, 65, 7, 128, 200, 472};
+    size_t pos = 0;
+    for (size_t i = 0; i < G_N_ELEMENTS(chunks); i++) {
+        ChaCha_fill(&pieces, &actual[pos], chunks[i]);
+        pos += chunks[i];
+    }
+    g_assert_cmpint(pos, ==, sizeof(actual));
+    g_assert_cmpmem(actual, sizeof(actual), expected, sizeof(expected));
+}
+
+static void seedsGiveDifferentStreams(void) {
+    ChaCha a = ChaCha_initFromSeed(1);
+    ChaCha b = ChaCha_initFromSeed(2);
+
+    uint8_t bufA[32], bufB[32];
+    ChaCha_fill(&a, bufA, sizeof(bufA));
+    ChaCha_fill(&b, bufB, sizeof(bufB));
+    g_assert_true(memcmp(bufA, bufB, sizeof(bufA)) != 0);
+}
+
+int main(int argc, char** argv) {
+    g_test_init(&argc, &argv, NULL);
+    g_test_add_func("/chacha/block_matches_rfc8439", blockMatchesRfc8439);
+    g_test_add_func("/chacha/fill_is_independent_of_chunking", fillIsIndependentOfChunking);
+    g_test_add_func("/chacha/seeds_give_different_streams", seedsGiveDifferentStreams);
+    return g_test_run();
+}
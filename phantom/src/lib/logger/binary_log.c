@@ -0,0 +1,272 @@
+#include "lib/logger/binary_log.h"
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// Shadow only runs on little-endian platforms, so values are copied in native
+// byte order.
+
+typedef struct _BinaryLogBuf {
+    uint8_t* dst;
+    size_t size;
+    size_t offset;
+    bool overflowed;
+} BinaryLogBuf;
+
+static void _binarylog_put(BinaryLogBuf* buf, const void* src, size_t n) {
+    if (buf->overflowed || n > buf->size - buf->offset) {
+        buf->overflowed = true;
+        return;
+    }
+    memcpy(&buf->dst[buf->offset], src, n);
+    buf->offset += n;
+}
+
+static void _binarylog_putU8(BinaryLogBuf* buf, uint8_t v) { _binarylog_put(buf, &v, sizeof(v)); }
+
+static void _binarylog_putU32(BinaryLogBuf* buf, uint32_t v) {
+    _binarylog_put(buf, &v, sizeof(v));
+}
+
+static void _binarylog_putU64(BinaryLogBuf* buf, uint64_t v) {
+    _binarylog_put(buf, &v, sizeof(v));
+}
+
+static void _binarylog_putTagged(BinaryLogBuf* buf, char tag, const void* v, size_t n) {
+    _binarylog_putU8(buf, tag);
+    _binarylog_put(buf, v, n);
+}
+
+static void _binarylog_putString(BinaryLogBuf* buf, const char* s) {
+    if (s == NULL) {
+        _binarylog_putU8(buf, 'n');
+        return;
+    }
+    uint32_t len = strlen(s);
+    _binarylog_putU8(buf, 's');
+    _binarylog_putU32(buf, len);
+    _binarylog_put(buf, s, len);
+}
+
+typedef enum {
+    LENGTH_NONE,
+    LENGTH_HH,
+    LENGTH_H,
+    LENGTH_L,
+    LENGTH_LL,
+    LENGTH_J,
+    LENGTH_Z,
+    LENGTH_T,
+    LENGTH_BIG_L,
+} BinaryLogLength;
+
+// Parses the length modifier at `*p`, advancing past it.
+static BinaryLogLength _binarylog_parseLength(const char** p) {
+    switch (**p) {
+        case 'h':
+            (*p)++;
+            if (**p == 'h') {
+                (*p)++;
+                return LENGTH_HH;
+            }
+            return LENGTH_H;
+        case 'l':
+            (*p)++;
+            if (**p == 'l') {
+                (*p)++;
+                return LENGTH_LL;
+            }
+            return LENGTH_L;
+        case 'q': (*p)++; return LENGTH_LL;
+        case 'j': (*p)++; return LENGTH_J;
+        case 'z':
+        case 'Z': (*p)++; return LENGTH_Z;
+        case 't': (*p)++; return LENGTH_T;
+        case 'L': (*p)++; return LENGTH_BIG_L;
+        default: return LENGTH_NONE;
+    }
+}
+
+static int64_t _binarylog_signedArg(BinaryLogLength length, va_list* vargs) {
+    switch (length) {
+        case LENGTH_HH: return (signed char)va_arg(*vargs, int);
+        case LENGTH_H: return (short)va_arg(*vargs, int);
+        case LENGTH_L: return va_arg(*vargs, long);
+        case LENGTH_LL: return va_arg(*vargs, long long);
+        case LENGTH_J: return va_arg(*vargs, intmax_t);
+        case LENGTH_Z: return va_arg(*vargs, ssize_t);
+        case LENGTH_T: return va_arg(*vargs, ptrdiff_t);
+        default: return va_arg(*vargs, int);
+    }
+}
+
+static uint64_t _binarylog_unsignedArg(BinaryLogLength length, va_list* vargs) {
+    switch (length) {
+        case LENGTH_HH: return (unsigned char)va_arg(*vargs, unsigned int);
+        case LENGTH_H: return (unsigned short)va_arg(*vargs, unsigned int);
+        case LENGTH_L: return va_arg(*vargs, unsigned long);
+        case LENGTH_LL: return va_arg(*vargs, unsigned long long);
+        case LENGTH_J: return va_arg(*vargs, uintmax_t);
+        case LENGTH_Z: return va_arg(*vargs, size_t);
+        case LENGTH_T: return va_arg(*vargs, ptrdiff_t);
+        default: return va_arg(*vargs, unsigned int);
+    }
+}
+
+ssize_t binarylog_packArgs(uint8_t* dst, size_t size, const char* format, va_list vargs) {
+    // Save errno for `%m` before anything below can change it.
+    int savedErrno = errno;
+    BinaryLogBuf buf = {.dst = dst, .size = size};
+
+    // Work on a copy so that we can pass a pointer to it around; a va_list
+    // parameter may be an array type.
+    va_list args;
+    va_copy(args, vargs);
+
+    for (const char* p = format; *p != '\0' && !buf.overflowed; p++) {
+        if (*p != '%') {
+            continue;
+        }
+        p++;
+        if (*p == '%') {
+            continue;
+        }
+
+        // Flags.
+        while (*p != '\0' && strchr("-+ #0'I", *p) != NULL) {
+            p++;
+        }
+        // Width.
+        if (*p == '*') {
+            int64_t width = va_arg(args, int);
+            _binarylog_putTagged(&buf, 'i', &width, sizeof(width));
+            p++;
+        } else {
+            while (*p >= '0' && *p <= '9') {
+                p++;
+            }
+            if (*p == '$') {
+                goto unsupported;
+            }
+        }
+        // Precision.
+        if (*p == '.') {
+            p++;
+            if (*p == '*') {
+                int64_t precision = va_arg(args, int);
+                _binarylog_putTagged(&buf, 'i', &precision, sizeof(precision));
+                p++;
+            } else {
+                while (*p >= '0' && *p <= '9') {
+                    p++;
+                }
+            }
+        }
+
+        BinaryLogLength length = _binarylog_parseLength(&p);
+
+        switch (*p) {
+            case 'd':
+            case 'i': {
+                int64_t v = _binarylog_signedArg(length, &args);
+                _binarylog_putTagged(&buf, 'i', &v, sizeof(v));
+                break;
+            }
+            case 'o':
+            case 'u':
+            case 'x':
+            case 'X': {
+                uint64_t v = _binarylog_unsignedArg(length, &args);
+                _binarylog_putTagged(&buf, 'u', &v, sizeof(v));
+                break;
+            }
+            case 'c': {
+                if (length != LENGTH_NONE) {
+                    goto unsupported;
+                }
+                int64_t v = va_arg(args, int);
+                _binarylog_putTagged(&buf, 'i', &v, sizeof(v));
+                break;
+            }
+            case 'e':
+            case 'E':
+            case 'f':
+            case 'F':
+            case 'g':
+            case 'G':
+            case 'a':
+            case 'A': {
+                double v = length == LENGTH_BIG_L ? (double)va_arg(args, long double)
+                                                  : va_arg(args, double);
+                _binarylog_putTagged(&buf, 'f', &v, sizeof(v));
+                break;
+            }
+            case 's': {
+                if (length != LENGTH_NONE) {
+                    goto unsupported;
+                }
+                _binarylog_putString(&buf, va_arg(args, const char*));
+                break;
+            }
+            case 'p': {
+                uint64_t v = (uintptr_t)va_arg(args, void*);
+                _binarylog_putTagged(&buf, 'p', &v, sizeof(v));
+                break;
+            }
+            case 'm': _binarylog_putString(&buf, strerror(savedErrno)); break;
+            default: goto unsupported;
+        }
+    }
+
+    va_end(args);
+    errno = savedErrno;
+    return buf.overflowed ? -1 : (ssize_t)buf.offset;
+
+unsupported:
+    va_end(args);
+    errno = savedErrno;
+    return -1;
+}
+
+size_t binarylog_encodeString(uint8_t* dst, size_t size, uint64_t id, const char* str) {
+    BinaryLogBuf buf = {.dst = dst, .size = size};
+    size_t len = strlen(str);
+
+    _binarylog_putU8(&buf, BINARYLOG_ENTRY_STRING);
+    _binarylog_putU32(&buf, sizeof(id) + len);
+    _binarylog_putU64(&buf, id);
+    _binarylog_put(&buf, str, len);
+
+    return buf.overflowed ? 0 : buf.offset;
+}
+
+size_t binarylog_encodeRecord(uint8_t* dst, size_t size, const BinaryLogRecord* record,
+                              const uint8_t* args, size_t argsLen) {
+    BinaryLogBuf buf = {.dst = dst, .size = size};
+
+    _binarylog_putU8(&buf, BINARYLOG_ENTRY_RECORD);
+    // Filled in below, once we know the length.
+    _binarylog_putU32(&buf, 0);
+
+    _binarylog_putU8(&buf, record->level);
+    _binarylog_putU64(&buf, record->wallMicros);
+    _binarylog_putU64(&buf, record->simNanos);
+    _binarylog_putU64(&buf, record->threadId);
+    _binarylog_putU64(&buf, record->hostId);
+    _binarylog_putU64(&buf, record->fileId);
+    _binarylog_putU32(&buf, record->line);
+    _binarylog_putU64(&buf, record->functionId);
+    _binarylog_putU64(&buf, record->formatId);
+    _binarylog_put(&buf, args, argsLen);
+
+    if (buf.overflowed) {
+        return 0;
+    }
+
+    uint32_t payloadLen = buf.offset - BINARYLOG_ENTRY_HEADER_NBYTES;
+    memcpy(&dst[1], &payloadLen, sizeof(payloadLen));
+    return buf.offset;
+}
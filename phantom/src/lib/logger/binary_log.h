@@ -0,0 +1,89 @@
+#ifndef LIB_LOGGER_BINARY_LOG_H_
+#define LIB_LOGGER_BINARY_LOG_H_
+
+/*
+ * Binary log records, which Shadow and the shim write instead of text when
+ * `experimental.use_binary_log` is enabled. Formatting is deferred: a record
+ * refers to its format string, file and function names by id, and carries
+ * the raw arguments of the format string. src/tools/decode_binary_log.py
+ * renders the records as text afterwards.
+ *
+ * A binary log starts with BINARYLOG_MAGIC, followed by entries. Each entry is
+ * a u8 type and a u32 payload length, followed by the payload. Integers are
+ * little-endian.
+ *
+ * BINARYLOG_ENTRY_STRING: u64 id, then the bytes of the string, without a nul.
+ *   Defines the string that other entries refer to by `id`. Ids are nonzero.
+ *   Strings may be defined after the entries that use them.
+ *
+ * BINARYLOG_ENTRY_RECORD: u8 level, u64 wall-clock micros since the start of
+ *   the simulation, u64 simulated nanos (UINT64_MAX if there is no simulated
+ *   time), u64 thread name id, u64 host id (0 if none), u64 file name id, u32
+ *   line, u64 function or module id, u64 format string id, then the arguments
+ *   of the format string as packed by `binarylog_packArgs`.
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#include "lib/logger/log_level.h"
+
+#define BINARYLOG_MAGIC "SHDLOGB1"
+#define BINARYLOG_MAGIC_NBYTES 8
+
+enum {
+    BINARYLOG_ENTRY_STRING = 1,
+    BINARYLOG_ENTRY_RECORD = 2,
+};
+
+// Size of an entry's type and length.
+#define BINARYLOG_ENTRY_HEADER_NBYTES 5
+
+// Upper bound on the packed arguments of a single record. Records whose
+// arguments don't fit are formatted as text instead.
+#define BINARYLOG_ARGS_MAX_NBYTES 1024
+
+typedef struct _BinaryLogRecord {
+    LogLevel level;
+    uint64_t wallMicros;
+    uint64_t simNanos;
+    uint64_t threadId;
+    uint64_t hostId;
+    uint64_t fileId;
+    uint32_t line;
+    uint64_t functionId;
+    uint64_t formatId;
+} BinaryLogRecord;
+
+// Pack the arguments of the printf-style `format` from `vargs` into `dst`. Each
+// argument (including `*` widths and precisions) is a one-byte tag followed by
+// its value:
+//
+//   'i' signed integer or char, as an i64
+//   'u' unsigned integer, as a u64
+//   'f' floating point, as an IEEE-754 double
+//   'p' pointer, as a u64
+//   's' string, as a u32 length followed by its bytes
+//   'n' NULL string, with no value
+//
+// `%m` is packed as the string it would have printed.
+//
+// Returns the number of bytes written, or -1 if the format uses a conversion
+// that isn't supported (positional arguments, wide strings, `%n`), or if the
+// arguments don't fit in `size` bytes. Doesn't allocate, so that the shim can
+// use it.
+ssize_t binarylog_packArgs(uint8_t* dst, size_t size, const char* format, va_list vargs);
+
+// Encode a string entry into `dst`. Returns the number of bytes written, or 0
+// if it doesn't fit in `size` bytes.
+size_t binarylog_encodeString(uint8_t* dst, size_t size, uint64_t id, const char* str);
+
+// Encode a record entry with the `argsLen` bytes of packed arguments `args`
+// into `dst`. Returns the number of bytes written, or 0 if it doesn't fit in
+// `size` bytes.
+size_t binarylog_encodeRecord(uint8_t* dst, size_t size, const BinaryLogRecord* record,
+                              const uint8_t* args, size_t argsLen);
+
+#endif
@@ -20,14 +20,47 @@
  *         environment: 'LD_PRELOAD=/home/<username>/.local/lib/libshadow_openssl_rng.so'
  */
 
+#include <pthread.h>
+#include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <sys/syscall.h>
 #include <unistd.h>
 
+#include "lib/chacha/chacha.h"
+
+// Each thread generates its bytes locally from a stream that is keyed once
+// from shadow, instead of making a syscall for every request.
+static __thread ChaCha _rng;
+static __thread bool _rngIsSeeded = false;
+
+static void _resetAfterFork(void) {
+    // the child must not produce the same stream as the parent
+    _rngIsSeeded = false;
+}
+
+__attribute__((constructor)) static void _registerForkHandler(void) {
+    pthread_atfork(NULL, NULL, _resetAfterFork);
+}
+
 static int _getRandomBytes(unsigned char* buf, int numBytes) {
-    // shadow interposes this and will fill the buffer for us
     // return 1 on success, 0 otherwise
-    return (numBytes == syscall(SYS_getrandom, buf, (size_t)numBytes, 0)) ? 1 : 0;
+    if (numBytes < 0) {
+        return 0;
+    }
+
+    if (!_rngIsSeeded) {
+        // shadow interposes this and will fill the key deterministically
+        uint8_t key[32];
+        if (syscall(SYS_getrandom, key, sizeof(key), 0) != sizeof(key)) {
+            return 0;
+        }
+        _rng = ChaCha_init(key, 0);
+        _rngIsSeeded = true;
+    }
+
+    ChaCha_fill(&_rng, buf, (size_t)numBytes);
+    return 1;
 }
 
 int RAND_DRBG_generate(void *drbg,
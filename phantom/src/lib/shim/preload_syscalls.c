@@ -27,6 +27,7 @@ INTERPOSE_REMAP(fallocate64, fallocate);
 INTERPOSE_REMAP(fcntl64, fcntl);
 INTERPOSE_REMAP(mmap64, mmap);
 INTERPOSE_REMAP(open64, open);
+INTERPOSE_REMAP(sendfile64, sendfile);
 INTERPOSE(accept);
 INTERPOSE(accept4);
 INTERPOSE(bind);
@@ -34,6 +35,9 @@ INTERPOSE(brk);
 INTERPOSE(clock_gettime);
 INTERPOSE(close);
 INTERPOSE(connect);
+#ifdef SYS_copy_file_range
+INTERPOSE(copy_file_range);
+#endif
 INTERPOSE(creat);
 INTERPOSE(dup);
 INTERPOSE(epoll_create);
@@ -116,8 +120,13 @@ INTERPOSE(readahead);
 INTERPOSE(readlinkat);
 INTERPOSE(readv);
 INTERPOSE(recvfrom);
+INTERPOSE(recvmmsg);
+INTERPOSE(recvmsg);
 INTERPOSE(renameat);
 INTERPOSE(renameat2);
+INTERPOSE(sendfile);
+INTERPOSE(sendmmsg);
+INTERPOSE(sendmsg);
 INTERPOSE(sendto);
 INTERPOSE(setsockopt);
 INTERPOSE(set_robust_list);
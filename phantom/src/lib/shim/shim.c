@@ -25,8 +25,10 @@
 #include "lib/shim/shadow_spinlock.h"
 #include "lib/shim/shim_event.h"
 #include "lib/shim/shim_logger.h"
+#include "lib/shim/shim_rewrite.h"
 #include "lib/shim/shim_syscall.h"
 #include "lib/shim/shim_tls.h"
+#include "lib/shim/shim_zygote.h"
 #include "lib/tsc/tsc.h"
 
 // Whether Shadow is using preload-based interposition.
@@ -38,6 +40,12 @@ static bool _using_interpose_ptrace = false;
 // Whether Shadow is using the shim-side syscall handler optimization.
 static bool _using_shim_syscall_handler = true;
 
+// Whether to rewrite syscall sites that trap into the SIGSYS handler.
+static bool _using_syscall_rewriting = false;
+
+// Whether to rewrite emulated rdtsc and rdtscp instructions.
+static bool _using_rdtsc_rewriting = false;
+
 // This thread's IPC block, for communication with Shadow.
 static ShMemBlock* _shim_ipcDataBlk() {
     static ShimTlsVar v = {0};
@@ -142,7 +150,10 @@ bool shim_enableInterposition() {
 }
 
 bool shim_interpositionEnabled() {
-    return _using_interpose_preload && !*_shim_disable_interposition();
+    // In ptrace mode a thread's syscalls keep going through ptrace until its
+    // IPC channel has been set up.
+    return _using_interpose_preload && !*_shim_disable_interposition() &&
+           (!_using_interpose_ptrace || shim_thisThreadEventIPC());
 }
 
 bool shim_use_syscall_handler() { return _using_shim_syscall_handler; }
@@ -168,6 +179,9 @@ static void _set_interpose_type() {
         // From the shim's point of view, behave as if it's not running under
         // Shadow, and let all control happen via ptrace.
         _using_interpose_ptrace = true;
+        // Unless Shadow gave us an IPC channel, in which case we send it the
+        // syscalls we see, and ptrace only catches the ones we don't.
+        _using_interpose_preload = getenv("SHADOW_IPC_BLK") != NULL;
         return;
     }
     abort();
@@ -182,6 +196,12 @@ static void _set_use_shim_syscall_handler() {
     }
 }
 
+static void _set_use_shm_huge_pages() {
+    if (getenv("SHADOW_SHM_HUGE_PAGES")) {
+        shmemfile_setUseHugePages(true);
+    }
+}
+
 static void _shim_parent_init_logging() {
     // Set logger start time from environment variable.
     {
@@ -200,7 +220,7 @@ static void _shim_parent_init_logging() {
             perror("fopen");
             abort();
         }
-        logger_setDefault(shimlogger_new(log_file));
+        logger_setDefault(shimlogger_new(log_file, getenv("SHADOW_LOG_BINARY") != NULL));
     }
 }
 
@@ -294,6 +314,22 @@ static void _shim_preload_only_child_init_ipc() {
     *_shim_ipcDataBlk() = _startThread.childIpcBlk;
 }
 
+static void _shim_ptrace_child_init_ipc() {
+    assert(_using_interpose_preload);
+    assert(_using_interpose_ptrace);
+
+    assert(!shim_thisThreadEventIPC());
+    ShMemBlockSerialized ipc_blk_serialized;
+    int rv = shadow_get_ipc_blk(&ipc_blk_serialized);
+    if (rv != 0) {
+        panic("shadow_get_ipc_blk: %s", strerror(errno));
+        abort();
+    }
+
+    *_shim_ipcDataBlk() = shmemserializer_globalBlockDeserialize(&ipc_blk_serialized);
+    assert(shim_thisThreadEventIPC());
+}
+
 static void _shim_preload_only_child_ipc_wait_for_start_event() {
     assert(_using_interpose_preload);
     assert(shim_thisThreadEventIPC());
@@ -341,6 +377,10 @@ static void _shim_parent_init_ptrace() {
 
     _shim_parent_init_shm();
     _shim_parent_init_death_signal();
+    if (_using_interpose_preload) {
+        _shim_parent_init_ipc();
+        _shim_ipc_wait_for_start_event();
+    }
 
     if (shim_enableInterposition()) {
         _shim_set_allow_native_syscalls(false);
@@ -381,6 +421,13 @@ static void _handle_sigsys(int sig, siginfo_t* info, void* voidUcontext) {
        *_shim_clone_rip() = (void*)regs[REG_RIP];
     }
 
+    // Patch the site so that later calls from it don't trap. The memory
+    // changes this makes must go through Shadow, so skip it if the trap came
+    // from the shim itself while interposition was disabled.
+    if (_using_syscall_rewriting && shim_interpositionEnabled()) {
+        shimrewrite_patchSyscallSite((void*)regs[REG_RIP], regs[REG_N]);
+    }
+
     // Make the syscall via the *the shim's* syscall function (which overrides
     // libc's).  It in turn will either emulate it or (if interposition is
     // disabled), make the call natively. In the latter case, the syscall
@@ -508,6 +555,14 @@ static void _shim_parent_init_seccomp() {
     }
 }
 
+// Patch an emulated rdtsc or rdtscp so that later executions don't trap. As with
+// syscall sites, the memory changes must go through Shadow.
+static void _shim_patch_rdtsc_site(unsigned char* insn, const Tsc* tsc) {
+    if (_using_rdtsc_rewriting && shim_interpositionEnabled()) {
+        shimrewrite_patchRdtscSite(insn, tsc, shim_syscall_get_simtime_location());
+    }
+}
+
 static void _handle_sigsegv(int sig, siginfo_t* info, void* voidUcontext) {
     trace("Trapped sigsegv");
     static bool tsc_initd = false;
@@ -530,6 +585,7 @@ static void _handle_sigsegv(int sig, siginfo_t* info, void* voidUcontext) {
         regs[REG_RDX] = rdx;
         regs[REG_RAX] = rax;
         regs[REG_RIP] = rip;
+        _shim_patch_rdtsc_site(insn, &tsc);
         return;
     }
     if (isRdtscp(insn)) {
@@ -541,6 +597,7 @@ static void _handle_sigsegv(int sig, siginfo_t* info, void* voidUcontext) {
         regs[REG_RAX] = rax;
         regs[REG_RCX] = rcx;
         regs[REG_RIP] = rip;
+        _shim_patch_rdtsc_site(insn, &tsc);
         return;
     }
     error("Unhandled sigsegv");
@@ -581,11 +638,17 @@ static void _shim_parent_init_preload() {
     _shim_parent_init_logging();
     _shim_parent_init_ipc();
     _shim_parent_init_death_signal();
-    _shim_ipc_wait_for_start_event();
     _shim_parent_init_rdtsc_emu();
+    _using_rdtsc_rewriting = getenv("SHADOW_REWRITE_RDTSC") != NULL;
     if (getenv("SHADOW_USE_SECCOMP") != NULL) {
         _shim_parent_init_seccomp();
+        if (getenv("SHADOW_REWRITE_SYSCALLS") != NULL) {
+            _using_syscall_rewriting = shimrewrite_init();
+        }
     }
+    // Do as much of the initialization as possible before waiting, since Shadow
+    // may have started us well ahead of the process's start time.
+    _shim_ipc_wait_for_start_event();
 
     shim_enableInterposition();
 }
@@ -598,6 +661,10 @@ static void _shim_child_init_ptrace() {
     }
 
     _shim_child_init_shm();
+    if (_using_interpose_preload) {
+        _shim_ptrace_child_init_ipc();
+        _shim_ipc_wait_for_start_event();
+    }
 
     if (shim_enableInterposition()) {
         _shim_set_allow_native_syscalls(false);
@@ -616,12 +683,19 @@ static void _shim_child_init_preload() {
 // This function should be called before any wrapped syscall. We also use the
 // constructor attribute to be completely sure that it's called before main.
 __attribute__((constructor)) void _shim_load() {
+    if (shimzygote_isZygote()) {
+        // Leave all initialization to the instances forked from the zygote,
+        // and let the zygote's own syscalls through natively until then.
+        return;
+    }
+
     static bool did_global_pre_init = false;
     if (!did_global_pre_init) {
         // Early init; must not make any syscalls.
         did_global_pre_init = true;
         _set_interpose_type();
         _set_use_shim_syscall_handler();
+        _set_use_shm_huge_pages();
     }
 
     // Now we can use thread-local storage.
@@ -9,6 +9,7 @@
 #include <sys/time.h>
 #include <time.h>
 
+#include "lib/logger/binary_log.h"
 #include "lib/logger/log_level.h"
 #include "lib/logger/logger.h"
 #include "lib/shim/shim.h"
@@ -19,8 +20,38 @@ typedef struct _ShimLogger {
     Logger base;
     FILE* file;
     LogLevel level;
+    // Write binary records (see lib/logger/binary_log.h) instead of text.
+    bool binary;
 } ShimLogger;
 
+// Addresses of the strings that have already been defined in the binary log.
+// The strings we log are all static, so they're identified by address. When
+// the table is full, strings are defined again, which the decoder tolerates.
+#define SHIMLOGGER_DEFINED_STRINGS_CAPACITY 4096
+static uintptr_t _defined_strings[SHIMLOGGER_DEFINED_STRINGS_CAPACITY];
+
+static const char* _binary_thread_name = "shd-shim";
+static const char* _binary_text_format = "%s";
+
+// Records `str` as defined. Returns true if it wasn't already, in which case
+// the caller should write its definition.
+static bool _shimlogger_defineString(const char* str) {
+    uintptr_t id = (uintptr_t)str;
+    size_t start = (id >> 3) % SHIMLOGGER_DEFINED_STRINGS_CAPACITY;
+    for (size_t i = 0; i < SHIMLOGGER_DEFINED_STRINGS_CAPACITY; i++) {
+        uintptr_t* slot = &_defined_strings[(start + i) % SHIMLOGGER_DEFINED_STRINGS_CAPACITY];
+        uintptr_t current = __atomic_load_n(slot, __ATOMIC_RELAXED);
+        if (current == 0 && __atomic_compare_exchange_n(
+                                slot, &current, id, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+            return true;
+        }
+        if (current == id) {
+            return false;
+        }
+    }
+    return true;
+}
+
 static size_t _simulation_nanos_string(char* dst, size_t size) {
     uint64_t simulation_nanos = shim_syscall_get_simtime_nanos();
     const long nanos_per_sec = 1000000000l;
@@ -32,6 +63,55 @@ static size_t _simulation_nanos_string(char* dst, size_t size) {
         dst, size, "%02d:%02d:%02d.%09" PRIu64, tm.tm_hour, tm.tm_min, tm.tm_sec, nanos);
 }
 
+static void _shimlogger_logBinary(ShimLogger* logger, LogLevel level, const char* fileName,
+                                  const char* functionName, const int lineNumber,
+                                  const char* format, va_list vargs) {
+    // Stack-allocated to avoid dynamic allocation.
+    uint8_t buf[1024];
+    size_t offset = 0;
+    uint8_t args[256];
+
+    ssize_t argsLen = binarylog_packArgs(args, sizeof(args), format, vargs);
+    if (argsLen < 0) {
+        // Fall back to formatting the message here, and logging it as a string.
+        char text[200];
+        vsnprintf(text, sizeof(text), format, vargs);
+        format = _binary_text_format;
+        args[0] = 's';
+        uint32_t len = strlen(text);
+        memcpy(&args[1], &len, sizeof(len));
+        memcpy(&args[1 + sizeof(len)], text, len);
+        argsLen = 1 + sizeof(len) + len;
+    }
+
+    const char* strings[] = {_binary_thread_name, fileName, functionName, format};
+    for (size_t i = 0; i < sizeof(strings) / sizeof(strings[0]); i++) {
+        if (strings[i] != NULL && _shimlogger_defineString(strings[i])) {
+            offset += binarylog_encodeString(
+                &buf[offset], sizeof(buf) - offset, (uintptr_t)strings[i], strings[i]);
+        }
+    }
+
+    // Like the text log, show the simulated time of day.
+    const uint64_t nanos_per_day = 24ull * 3600 * 1000000000;
+    BinaryLogRecord record = {
+        .level = level,
+        .wallMicros = logger_elapsed_micros(),
+        .simNanos = shim_syscall_get_simtime_nanos() % nanos_per_day,
+        .threadId = (uintptr_t)_binary_thread_name,
+        .fileId = (uintptr_t)fileName,
+        .line = lineNumber,
+        .functionId = (uintptr_t)functionName,
+        .formatId = (uintptr_t)format,
+    };
+    offset += binarylog_encodeRecord(&buf[offset], sizeof(buf) - offset, &record, args, argsLen);
+
+    // See shimlogger_log for why this uses `write`.
+    if (write(fileno(logger->file), buf, offset) < 0) {
+        abort();
+    }
+}
+
 void shimlogger_log(Logger* base, LogLevel level, const char* fileName, const char* functionName,
                     const int lineNumber, const char* format, va_list vargs) {
     if (!logger_isEnabled(base, level)) {
@@ -53,6 +133,13 @@ void shimlogger_log(Logger* base, LogLevel level, const char* fileName, const ch
 
     ShimLogger* logger = (ShimLogger*)base;
 
+    if (logger->binary) {
+        _shimlogger_logBinary(logger, level, fileName, functionName, lineNumber, format, vargs);
+        shim_enableInterposition();
+        *in_logger = false;
+        return;
+    }
+
     // Keep appending to string. These functions all ensure NULL-byte termination.
 
     offset += logger_elapsed_string(&buf[offset], sizeof(buf) - offset);
@@ -109,7 +196,7 @@ void shimlogger_setLevel(Logger* base, LogLevel level) {
     logger->level = level;
 }
 
-Logger* shimlogger_new(FILE* file) {
+Logger* shimlogger_new(FILE* file, bool binary) {
     ShimLogger* logger = malloc(sizeof(*logger));
     #ifdef DEBUG
         LogLevel level = LOGLEVEL_TRACE;
@@ -127,6 +214,15 @@ Logger* shimlogger_new(FILE* file) {
             },
         .file = file,
         .level = level,
+        .binary = binary,
     };
+
+    if (binary) {
+        memset(_defined_strings, 0, sizeof(_defined_strings));
+        if (write(fileno(file), BINARYLOG_MAGIC, BINARYLOG_MAGIC_NBYTES) < 0) {
+            abort();
+        }
+    }
+
     return (Logger*)logger;
 }
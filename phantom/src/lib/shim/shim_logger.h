@@ -3,8 +3,11 @@
 
 #include "lib/logger/logger.h"
 
+#include <stdbool.h>
 #include <stdio.h>
 
-Logger* shimlogger_new(FILE* file);
+// If `binary`, the logger writes binary records (see lib/logger/binary_log.h)
+// instead of text.
+Logger* shimlogger_new(FILE* file, bool binary);
 
 #endif
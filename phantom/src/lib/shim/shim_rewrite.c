@@ -0,0 +1,526 @@
+#include "lib/shim/shim_rewrite.h"
+
+#include <assert.h>
+#include <cpuid.h>
+#include <elf.h>
+#include <inttypes.h>
+#include <link.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "lib/logger/logger.h"
+#include "lib/shim/preload_syscall.h"
+#include "lib/tsc/tsc.h"
+
+// Size reserved for each stub. See `_shimrewrite_writeSyscallStub` and
+// `_shimrewrite_writeRdtscStub`.
+#define SHIM_REWRITE_SYSCALL_STUB_SIZE 48
+#define SHIM_REWRITE_RDTSC_STUB_SIZE 128
+
+// Upper bound on the number of pages of stubs we allocate.
+#define SHIM_REWRITE_MAX_STUB_PAGES 64
+
+typedef struct _StubPage {
+    uint8_t* base;
+    size_t used;
+} StubPage;
+
+static StubPage _stubPages[SHIM_REWRITE_MAX_STUB_PAGES];
+static size_t _numStubPages = 0;
+static size_t _pageSize = 0;
+
+// Set when we run out of room for stubs, after which we stop trying.
+static bool _disabled = false;
+
+// Size of the XSAVE area for the state components enabled in XCR0. Read from
+// the entry trampoline.
+__attribute__((used)) static uint64_t _shim_rewrite_xsaveSize = 0;
+
+// Called from the entry trampoline with a pointer to the syscall number and
+// its six arguments.
+__attribute__((used)) static long _shim_rewrite_syscall(const long* regs) {
+    // Same as the SIGSYS handler: the shim decides whether to emulate the
+    // syscall or to execute it natively.
+    return shadow_raw_syscall(regs[0], regs[1], regs[2], regs[3], regs[4], regs[5], regs[6]);
+}
+
+// Entry point for rewritten syscall sites. Called by the stubs with the
+// syscall number in rax and the arguments in the syscall registers. Returns
+// the result in rax and, like the syscall instruction, only clobbers rax, rcx
+// and r11. The extended register state is saved and restored with XSAVE,
+// since the code the shim runs is free to use vector registers.
+void _shim_rewrite_entry(void) __attribute__((visibility("hidden")));
+__asm__(".text\n"
+        ".globl _shim_rewrite_entry\n"
+        ".hidden _shim_rewrite_entry\n"
+        ".type _shim_rewrite_entry, @function\n"
+        "_shim_rewrite_entry:\n"
+        "pushq %rbp\n"
+        "movq %rsp, %rbp\n"
+        "pushfq\n"
+        "cld\n"
+        /* saved registers, in the order {nr, arg1, ..., arg6} */
+        "pushq %r9\n"
+        "pushq %r8\n"
+        "pushq %r10\n"
+        "pushq %rdx\n"
+        "pushq %rsi\n"
+        "pushq %rdi\n"
+        "pushq %rax\n"
+        "movq %rsp, %rdi\n"
+        /* the XSAVE area must be 64-byte aligned, with a zeroed header */
+        "subq _shim_rewrite_xsaveSize(%rip), %rsp\n"
+        "andq $-64, %rsp\n"
+        "xorl %eax, %eax\n"
+        "movq %rax, 512(%rsp)\n"
+        "movq %rax, 520(%rsp)\n"
+        "movq %rax, 528(%rsp)\n"
+        "movq %rax, 536(%rsp)\n"
+        "movq %rax, 544(%rsp)\n"
+        "movq %rax, 552(%rsp)\n"
+        "movq %rax, 560(%rsp)\n"
+        "movq %rax, 568(%rsp)\n"
+        "movl $-1, %eax\n"
+        "movl $-1, %edx\n"
+        "xsave64 (%rsp)\n"
+        "call _shim_rewrite_syscall\n"
+        /* keep the return value in the saved rax slot */
+        "movq %rax, -64(%rbp)\n"
+        "movl $-1, %eax\n"
+        "movl $-1, %edx\n"
+        "xrstor64 (%rsp)\n"
+        "leaq -64(%rbp), %rsp\n"
+        "popq %rax\n"
+        "popq %rdi\n"
+        "popq %rsi\n"
+        "popq %rdx\n"
+        "popq %r10\n"
+        "popq %r8\n"
+        "popq %r9\n"
+        "popfq\n"
+        "popq %rbp\n"
+        "ret\n"
+        ".size _shim_rewrite_entry, .-_shim_rewrite_entry\n");
+
+bool shimrewrite_init() {
+    unsigned int eax, ebx, ecx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx) || !(ecx & bit_OSXSAVE)) {
+        warning("XSAVE isn't available; not rewriting syscall sites");
+        return false;
+    }
+
+    // EBX of leaf 0xd, sub-leaf 0 is the size needed for the components
+    // currently enabled in XCR0.
+    __cpuid_count(0xd, 0, eax, ebx, ecx, edx);
+    _shim_rewrite_xsaveSize = ebx;
+
+    return true;
+}
+
+static size_t _shimrewrite_pageSize() {
+    if (!_pageSize) {
+        _pageSize = sysconf(_SC_PAGESIZE);
+    }
+    return _pageSize;
+}
+
+static bool _shimrewrite_fitsRel32(const uint8_t* from, const uint8_t* to) {
+    int64_t diff = (int64_t)((intptr_t)to - (intptr_t)from);
+    return diff >= INT32_MIN && diff <= INT32_MAX;
+}
+
+static void _shimrewrite_storeRel32(uint8_t* dst, const uint8_t* from, const uint8_t* to) {
+    int32_t rel = (int32_t)((intptr_t)to - (intptr_t)from);
+    memcpy(dst, &rel, sizeof(rel));
+}
+
+typedef struct _SegmentQuery {
+    uintptr_t addr;
+    uintptr_t start;
+    uintptr_t end;
+    ElfW(Word) flags;
+    bool found;
+} SegmentQuery;
+
+static int _shimrewrite_findSegmentCallback(struct dl_phdr_info* info, size_t size, void* data) {
+    SegmentQuery* query = data;
+    for (int i = 0; i < info->dlpi_phnum; i++) {
+        const ElfW(Phdr)* phdr = &info->dlpi_phdr[i];
+        if (phdr->p_type != PT_LOAD) {
+            continue;
+        }
+        uintptr_t start = info->dlpi_addr + phdr->p_vaddr;
+        uintptr_t end = start + phdr->p_memsz;
+        if (query->addr >= start && query->addr < end) {
+            query->start = start;
+            query->end = end;
+            query->flags = phdr->p_flags;
+            query->found = true;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Only rewrite code that belongs to a loaded object and that isn't writable,
+// which excludes code generated at runtime.
+static bool _shimrewrite_findCodeSegment(const uint8_t* insn, SegmentQuery* segment) {
+    *segment = (SegmentQuery){.addr = (uintptr_t)insn};
+    dl_iterate_phdr(_shimrewrite_findSegmentCallback, segment);
+    return segment->found && (segment->flags & PF_X) && !(segment->flags & PF_W);
+}
+
+// Find the start of the `mov` that loads the syscall number before the syscall
+// instruction, and the length of that `mov`. Returns NULL if the site doesn't
+// have one of the forms we rewrite.
+static uint8_t* _shimrewrite_matchSite(uint8_t* syscallInsn, long n, const SegmentQuery* segment,
+                                       size_t* movLen) {
+    // mov $imm32, %rax (sign-extended)
+    uint8_t* site = syscallInsn - 7;
+    if ((uintptr_t)site >= segment->start && site[0] == 0x48 && site[1] == 0xc7 &&
+        site[2] == 0xc0) {
+        int32_t imm;
+        memcpy(&imm, &site[3], sizeof(imm));
+        if (imm == n) {
+            *movLen = 7;
+            return site;
+        }
+    }
+
+    // mov $imm32, %eax
+    site = syscallInsn - 5;
+    if ((uintptr_t)site >= segment->start && site[0] == 0xb8) {
+        // A preceding prefix would make this a different instruction, e.g.
+        // `41 b8` is a mov to %r8d.
+        if ((uintptr_t)site > segment->start) {
+            uint8_t prev = site[-1];
+            if ((prev >= 0x40 && prev <= 0x4f) || prev == 0x66 || prev == 0x67 || prev == 0xf2 ||
+                prev == 0xf3) {
+                return NULL;
+            }
+        }
+        uint32_t imm;
+        memcpy(&imm, &site[1], sizeof(imm));
+        if (imm == (uint32_t)n) {
+            *movLen = 5;
+            return site;
+        }
+    }
+
+    return NULL;
+}
+
+// Returns room for a stub from which both `site` and `resume` are reachable
+// with a rel32 jump, or NULL if we can't get one.
+static uint8_t* _shimrewrite_allocStub(const uint8_t* site, const uint8_t* resume, size_t size) {
+    size_t pageSize = _shimrewrite_pageSize();
+    for (size_t i = 0; i < _numStubPages; i++) {
+        StubPage* page = &_stubPages[i];
+        uint8_t* stub = page->base + page->used;
+        if (page->used + size <= pageSize && _shimrewrite_fitsRel32(site, stub) &&
+            _shimrewrite_fitsRel32(stub + size, resume)) {
+            page->used += size;
+            return stub;
+        }
+    }
+
+    if (_numStubPages == SHIM_REWRITE_MAX_STUB_PAGES) {
+        return NULL;
+    }
+
+    // Ask for a page near the site. The kernel treats the address only as a
+    // hint, so check where the page actually ended up.
+    uintptr_t sitePage = (uintptr_t)site & ~(uintptr_t)(pageSize - 1);
+    const intptr_t offsets[] = {-(1L << 24), (1L << 24), -(1L << 30), (1L << 30)};
+    for (size_t i = 0; i < sizeof(offsets) / sizeof(offsets[0]); i++) {
+        long rv = shadow_raw_syscall(SYS_mmap, (void*)(sitePage + offsets[i]), pageSize,
+                                     PROT_READ | PROT_WRITE | PROT_EXEC,
+                                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (rv < 0 && rv >= -4095) {
+            warning("mmap for rewriting stubs: %s", strerror(-rv));
+            return NULL;
+        }
+
+        uint8_t* base = (uint8_t*)rv;
+        if (_shimrewrite_fitsRel32(site, base) && _shimrewrite_fitsRel32(base + pageSize, resume)) {
+            _stubPages[_numStubPages++] = (StubPage){.base = base, .used = size};
+            return base;
+        }
+
+        shadow_raw_syscall(SYS_munmap, base, pageSize);
+    }
+
+    return NULL;
+}
+
+// lea -128(%rsp), %rsp: step over the red zone, which the interrupted code may
+// be using since the instructions we replace don't touch the stack
+static const uint8_t _enterRedZone[] = {0x48, 0x8d, 0x64, 0x24, 0x80};
+// lea 128(%rsp), %rsp
+static const uint8_t _leaveRedZone[] = {0x48, 0x8d, 0xa4, 0x24, 0x80, 0x00, 0x00, 0x00};
+
+static uint8_t* _shimrewrite_emit(uint8_t* p, const uint8_t* bytes, size_t len) {
+    memcpy(p, bytes, len);
+    return p + len;
+}
+
+// Emit `jmp target`.
+static uint8_t* _shimrewrite_emitJmp(uint8_t* p, const uint8_t* target) {
+    *p++ = 0xe9;
+    _shimrewrite_storeRel32(p, p + 4, target);
+    return p + 4;
+}
+
+static void _shimrewrite_writeSyscallStub(uint8_t* stub, long n, const uint8_t* resume) {
+    uint8_t* p = stub;
+
+    p = _shimrewrite_emit(p, _enterRedZone, sizeof(_enterRedZone));
+
+    // mov $n, %eax
+    *p++ = 0xb8;
+    int32_t nr = (int32_t)n;
+    memcpy(p, &nr, sizeof(nr));
+    p += sizeof(nr);
+
+    // movabs $_shim_rewrite_entry, %r11; call *%r11
+    // r11 is clobbered by the syscall instruction anyway.
+    *p++ = 0x49;
+    *p++ = 0xbb;
+    uint64_t entry = (uint64_t)(uintptr_t)_shim_rewrite_entry;
+    memcpy(p, &entry, sizeof(entry));
+    p += sizeof(entry);
+    *p++ = 0x41;
+    *p++ = 0xff;
+    *p++ = 0xd3;
+
+    p = _shimrewrite_emit(p, _leaveRedZone, sizeof(_leaveRedZone));
+    p = _shimrewrite_emitJmp(p, resume);
+
+    assert(p - stub <= SHIM_REWRITE_SYSCALL_STUB_SIZE);
+}
+
+// Overwrite the instruction at `site` with a jump to `stub`. The bytes after
+// the jump are left as they were.
+static bool _shimrewrite_writeJmp(uint8_t* site, const uint8_t* stub,
+                                  const SegmentQuery* segment) {
+    uint8_t jmp[5] = {0xe9};
+    _shimrewrite_storeRel32(&jmp[1], site + sizeof(jmp), stub);
+
+    size_t pageSize = _shimrewrite_pageSize();
+    uintptr_t protStart = (uintptr_t)site & ~(uintptr_t)(pageSize - 1);
+    uintptr_t protEnd = ((uintptr_t)site + sizeof(jmp) + pageSize - 1) & ~(uintptr_t)(pageSize - 1);
+    int prot = PROT_EXEC | ((segment->flags & PF_R) ? PROT_READ : 0);
+
+    long rv = shadow_raw_syscall(SYS_mprotect, (void*)protStart, protEnd - protStart,
+                                 prot | PROT_WRITE);
+    if (rv != 0) {
+        warning("mprotect to rewrite code at %p: %s", site, strerror(-rv));
+        return false;
+    }
+    memcpy(site, jmp, sizeof(jmp));
+    rv = shadow_raw_syscall(SYS_mprotect, (void*)protStart, protEnd - protStart, prot);
+    if (rv != 0) {
+        warning("mprotect after rewriting code at %p: %s", site, strerror(-rv));
+    }
+    return true;
+}
+
+void shimrewrite_patchSyscallSite(void* afterSyscall, long n) {
+    if (_disabled) {
+        return;
+    }
+
+    // The new thread resumes at the trapped instruction pointer, which the
+    // stub doesn't know about.
+    if (n == SYS_clone || n == SYS_vfork
+#ifdef SYS_clone3
+        || n == SYS_clone3
+#endif
+    ) {
+        return;
+    }
+
+    uint8_t* syscallInsn = (uint8_t*)afterSyscall - 2;
+    if (syscallInsn[0] != 0x0f || syscallInsn[1] != 0x05) {
+        return;
+    }
+
+    SegmentQuery segment;
+    if (!_shimrewrite_findCodeSegment(syscallInsn, &segment)) {
+        return;
+    }
+
+    size_t movLen = 0;
+    uint8_t* site = _shimrewrite_matchSite(syscallInsn, n, &segment, &movLen);
+    if (!site) {
+        return;
+    }
+    uint8_t* resume = site + movLen + 2;
+
+    uint8_t* stub = _shimrewrite_allocStub(site, resume, SHIM_REWRITE_SYSCALL_STUB_SIZE);
+    if (!stub) {
+        warning("No more room for stubs; not rewriting any more code");
+        _disabled = true;
+        return;
+    }
+    _shimrewrite_writeSyscallStub(stub, n, resume);
+
+    // The jmp replaces the first 5 bytes of the mov.
+    if (_shimrewrite_writeJmp(site, stub, &segment)) {
+        trace("Rewrote syscall %ld site at %p to use stub at %p", n, site, stub);
+    }
+}
+
+// Returns the length of the instruction at `insn` if it's one we can move into
+// a stub unchanged, or 0. We only recognize a few instructions on registers
+// that commonly follow rdtsc, e.g. the `shl $32, %rdx; or %rdx, %rax` that
+// compilers emit for `__rdtsc()`.
+static size_t _shimrewrite_movableInsnLen(const uint8_t* insn) {
+    size_t len = 0;
+    bool rexW = false;
+    if ((insn[0] & 0xf0) == 0x40) {
+        // REX prefix
+        rexW = insn[0] & 0x08;
+        len++;
+    }
+    uint8_t opcode = insn[len];
+    if (opcode >= 0xb8 && opcode <= 0xbf) {
+        // mov of an immediate to a register
+        return len + 1 + (rexW ? 8 : 4);
+    }
+    uint8_t modrm = insn[len + 1];
+    if ((modrm & 0xc0) != 0xc0) {
+        // Not a register operand.
+        return 0;
+    }
+    switch (opcode) {
+        // add, or, and, sub, xor and mov
+        case 0x01:
+        case 0x03:
+        case 0x09:
+        case 0x0b:
+        case 0x21:
+        case 0x23:
+        case 0x29:
+        case 0x2b:
+        case 0x31:
+        case 0x33:
+        case 0x89:
+        case 0x8b: return len + 2;
+        // shifts and rotates by an immediate
+        case 0xc1: return len + 3;
+        default: return 0;
+    }
+}
+
+// Emit an instruction with a rip-relative memory operand, where `bytes` is the
+// instruction up to the 32-bit displacement.
+static uint8_t* _shimrewrite_emitRipRelative(uint8_t* p, const uint8_t* bytes, size_t len,
+                                             const uint8_t* target) {
+    p = _shimrewrite_emit(p, bytes, len);
+    _shimrewrite_storeRel32(p, p + 4, target);
+    return p + 4;
+}
+
+static void _shimrewrite_writeRdtscStub(uint8_t* stub, bool isRdtscp, const Tsc* tsc,
+                                        const struct timespec* simtime, const uint8_t* moved,
+                                        size_t movedLen, const uint8_t* resume) {
+    // Constants used by the code, after the code.
+    uint8_t* simtimePtr = stub + SHIM_REWRITE_RDTSC_STUB_SIZE - 24;
+    uint8_t* cyclesPerSecond = stub + SHIM_REWRITE_RDTSC_STUB_SIZE - 16;
+    uint8_t* nanosPerSecond = stub + SHIM_REWRITE_RDTSC_STUB_SIZE - 8;
+    uint64_t value = (uint64_t)(uintptr_t)simtime;
+    memcpy(simtimePtr, &value, sizeof(value));
+    memcpy(cyclesPerSecond, &tsc->cyclesPerSecond, sizeof(tsc->cyclesPerSecond));
+    value = 1000000000;
+    memcpy(nanosPerSecond, &value, sizeof(value));
+
+    uint8_t* p = stub;
+    p = _shimrewrite_emit(p, _enterRedZone, sizeof(_enterRedZone));
+    // pushfq
+    *p++ = 0x9c;
+
+    // The same computation as `Tsc_emulateRdtsc`, using only rax and rdx.
+    // mov simtimePtr(%rip), %rdx
+    p = _shimrewrite_emitRipRelative(p, (const uint8_t[]){0x48, 0x8b, 0x15}, 3, simtimePtr);
+    // imul $1000000000, (%rdx), %rax: tv_sec in nanoseconds
+    p = _shimrewrite_emit(p, (const uint8_t[]){0x48, 0x69, 0x02, 0x00, 0xca, 0x9a, 0x3b}, 7);
+    // add 8(%rdx), %rax: plus tv_nsec
+    p = _shimrewrite_emit(p, (const uint8_t[]){0x48, 0x03, 0x42, 0x08}, 4);
+    // mulq cyclesPerSecond(%rip)
+    p = _shimrewrite_emitRipRelative(p, (const uint8_t[]){0x48, 0xf7, 0x25}, 3, cyclesPerSecond);
+    // divq nanosPerSecond(%rip)
+    p = _shimrewrite_emitRipRelative(p, (const uint8_t[]){0x48, 0xf7, 0x35}, 3, nanosPerSecond);
+    // mov %rax, %rdx; shr $32, %rdx; mov %eax, %eax
+    p = _shimrewrite_emit(p, (const uint8_t[]){0x48, 0x89, 0xc2, 0x48, 0xc1, 0xea, 0x20, 0x89, 0xc0},
+                          9);
+    if (isRdtscp) {
+        // mov $aux, %ecx, with the IA32_TSC_AUX value that the emulation uses
+        uint64_t rax, rdx, rcx, rip;
+        Tsc_emulateRdtscp(tsc, &rax, &rdx, &rcx, &rip, 0);
+        uint32_t aux = (uint32_t)rcx;
+        *p++ = 0xb9;
+        p = _shimrewrite_emit(p, (const uint8_t*)&aux, sizeof(aux));
+    }
+
+    // popfq
+    *p++ = 0x9d;
+    p = _shimrewrite_emit(p, _leaveRedZone, sizeof(_leaveRedZone));
+
+    p = _shimrewrite_emit(p, moved, movedLen);
+    p = _shimrewrite_emitJmp(p, resume);
+
+    assert(p <= simtimePtr);
+}
+
+void shimrewrite_patchRdtscSite(void* insn, const Tsc* tsc, const struct timespec* simtime) {
+    if (_disabled) {
+        return;
+    }
+
+    uint8_t* site = insn;
+    size_t insnLen;
+    if (isRdtsc(site)) {
+        insnLen = 2;
+    } else if (isRdtscp(site)) {
+        insnLen = 3;
+    } else {
+        return;
+    }
+
+    SegmentQuery segment;
+    if (!_shimrewrite_findCodeSegment(site, &segment)) {
+        return;
+    }
+
+    // The jmp needs 5 bytes, so move the instructions after the rdtsc into
+    // the stub until we have enough room.
+    uint8_t* end = site + insnLen;
+    while (end - site < 5) {
+        if ((uintptr_t)end + 10 > segment.end) {
+            return;
+        }
+        size_t len = _shimrewrite_movableInsnLen(end);
+        if (!len) {
+            return;
+        }
+        end += len;
+    }
+
+    uint8_t* stub = _shimrewrite_allocStub(site, end, SHIM_REWRITE_RDTSC_STUB_SIZE);
+    if (!stub) {
+        warning("No more room for stubs; not rewriting any more code");
+        _disabled = true;
+        return;
+    }
+    _shimrewrite_writeRdtscStub(stub, insnLen == 3, tsc, simtime, site + insnLen,
+                                end - (site + insnLen), end);
+
+    if (_shimrewrite_writeJmp(site, stub, &segment)) {
+        trace("Rewrote %s at %p to use stub at %p", insnLen == 3 ? "rdtscp" : "rdtsc", site, stub);
+    }
+}
@@ -0,0 +1,55 @@
+#ifndef SHD_SHIM_SHIM_REWRITE_H_
+#define SHD_SHIM_SHIM_REWRITE_H_
+
+#include <stdbool.h>
+#include <time.h>
+
+#include "lib/tsc/tsc.h"
+
+// Lazy rewriting of instructions that trap into the shim, so that later
+// executions of the same instruction don't pay for a signal delivery and
+// sigreturn. Patching relies on Shadow running only one thread of a managed
+// process at a time, so no other thread can be executing the bytes being
+// modified.
+//
+// Syscall instructions trapped by the seccomp filter:
+//
+// The first time a `syscall` instruction traps, the site is patched to jump
+// to a small stub that calls into the shim directly. Only sites of the form
+//
+//     mov $nr, %eax       (b8 imm32, or 48 c7 c0 imm32)
+//     syscall             (0f 05)
+//
+// inside a non-writable executable segment of a loaded object are rewritten.
+// The `mov` is overwritten with a `jmp` to the stub; the `syscall` is left in
+// place, so code that jumps directly to it still traps as before. Other sites
+// keep being handled by the SIGSYS handler.
+//
+// rdtsc and rdtscp instructions trapped by PR_TSC_SIGSEGV:
+//
+// These are too short to hold a jump, so the instructions that follow are moved
+// into the stub along with them. Only a few instructions on registers
+// are recognized. The stub computes the same value as the SIGSEGV handler from
+// the shim's cached simulation time, without calling into the shim.
+//
+// Moving instructions is only safe if nothing branches to them: a branch to one
+// of the moved instructions would land inside the `jmp` that replaced it. That
+// can't be checked here, so this is only done when the user opts in with
+// `experimental.use_rdtsc_rewriting`.
+
+// Prepare for rewriting syscall sites. Returns false if that isn't supported on
+// this CPU, in which case `shimrewrite_patchSyscallSite` must not be called.
+bool shimrewrite_init();
+
+// Try to rewrite the syscall site that trapped with the given syscall number,
+// where `afterSyscall` is the address just after its `syscall` instruction.
+// Must be called with interposition enabled, so that the memory changes it
+// makes are done through Shadow.
+void shimrewrite_patchSyscallSite(void* afterSyscall, long n);
+
+// Try to rewrite the rdtsc or rdtscp instruction at `insn` to compute its
+// result from `tsc` and the time at `simtime`, which must stay valid for the
+// life of the process. Must be called with interposition enabled.
+void shimrewrite_patchRdtscSite(void* insn, const Tsc* tsc, const struct timespec* simtime);
+
+#endif // SHD_SHIM_SHIM_REWRITE_H_
@@ -30,6 +30,8 @@ uint64_t shim_syscall_get_simtime_nanos() {
            _cached_simulation_time.tv_nsec;
 }
 
+const struct timespec* shim_syscall_get_simtime_location() { return &_cached_simulation_time; }
+
 static struct timespec* _shim_syscall_get_time() {
     // First try to get time from shared mem.
     struct timespec* simtime_ts = shim_get_shared_time_location();
@@ -3,6 +3,8 @@
 
 #include <stdarg.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
 
 /// This module allows us to short-circuit syscalls that can be handled directly
 /// in the shim without needing to perform a more expensive inter-pocess syscall
@@ -16,6 +18,10 @@ void shim_syscall_set_simtime_nanos(uint64_t simulation_nanos);
 // Returns the current cached simulation time, or 0 if it has not yet been set.
 uint64_t shim_syscall_get_simtime_nanos();
 
+// Returns the location of the cached simulation time, which doesn't change for
+// the life of the process.
+const struct timespec* shim_syscall_get_simtime_location();
+
 // Attempt to service a syscall using shared memory if available.
 //
 // Returns true on success, meaning we indeed handled the syscall.
@@ -0,0 +1,185 @@
+#include "lib/shim/shim_zygote.h"
+
+#include <dlfcn.h>
+#include <errno.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/prctl.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "lib/logger/logger.h"
+#include "lib/shim/preload_syscall.h"
+#include "lib/shim/shim.h"
+
+// Socket to Shadow if this process is a zygote, -1 if it isn't, or -2 if we
+// haven't checked yet.
+static int _shimzygote_fd = -2;
+
+static int _shimzygote_getFd() {
+    if (_shimzygote_fd == -2) {
+        const char* fd_str = getenv("SHADOW_ZYGOTE_FD");
+        _shimzygote_fd = fd_str ? atoi(fd_str) : -1;
+    }
+    return _shimzygote_fd;
+}
+
+bool shimzygote_isZygote() { return _shimzygote_getFd() >= 0; }
+
+// Read or write exactly `n` bytes. Returns false if Shadow closed the socket or
+// on error.
+static bool _shimzygote_transfer(long syscall_num, void* buf, size_t n) {
+    char* p = buf;
+    while (n > 0) {
+        long rv = shadow_real_raw_syscall(syscall_num, _shimzygote_fd, p, n);
+        if (rv == -EINTR) {
+            continue;
+        }
+        if (rv <= 0) {
+            return false;
+        }
+        p += rv;
+        n -= rv;
+    }
+    return true;
+}
+
+// Unpack a spawn request's strings into `argv`, followed by the environment,
+// in the layout that `__libc_start_main` expects. Returns the working
+// directory, or NULL if the request is malformed.
+static const char* _shimzygote_unpack(const ShimZygoteRequest* req, char* strings, char** argv) {
+    char* end = strings + req->nbytes;
+    char* p = strings;
+    const char* working_dir = NULL;
+    size_t nstrings = 1 + req->argc + req->envc;
+
+    for (size_t i = 0; i < nstrings; i++) {
+        char* nul = memchr(p, '\0', end - p);
+        if (nul == NULL) {
+            return NULL;
+        }
+        if (i == 0) {
+            working_dir = p;
+        } else if (i <= req->argc) {
+            argv[i - 1] = p;
+        } else {
+            argv[i] = p;
+        }
+        p = nul + 1;
+    }
+    argv[req->argc] = NULL;
+    argv[req->argc + 1 + req->envc] = NULL;
+    return working_dir;
+}
+
+// Set up a freshly forked instance. Exits on failure, in the same way as a
+// failed exec.
+static void _shimzygote_initChild(const ShimZygoteRequest* req, char* strings, int* argc,
+                                  char*** argv) {
+    // Until we stop being a zygote below, the shim lets syscalls through
+    // natively, as they would be before an exec.
+    close(_shimzygote_fd);
+
+    char** new_argv = malloc((req->argc + req->envc + 2) * sizeof(*new_argv));
+    const char* working_dir = new_argv ? _shimzygote_unpack(req, strings, new_argv) : NULL;
+    if (working_dir == NULL || req->argc == 0 || chdir(working_dir) < 0) {
+        _exit(127);
+    }
+
+    *argc = req->argc;
+    *argv = new_argv;
+    environ = &new_argv[req->argc + 1];
+
+    // These were set from the zygote's own arguments when libc was initialized.
+    program_invocation_name = new_argv[0];
+    const char* slash = strrchr(new_argv[0], '/');
+    program_invocation_short_name = slash ? (char*)slash + 1 : new_argv[0];
+
+    // Now that the environment is this instance's, do the per-process shim
+    // initialization that was skipped in the zygote.
+    _shimzygote_fd = -1;
+    shim_ensure_init();
+}
+
+static void _shimzygote_handleSpawn(const ShimZygoteRequest* req, int* argc, char*** argv,
+                                    bool* is_child) {
+    char* strings = malloc(req->nbytes);
+    if (strings == NULL || !_shimzygote_transfer(SYS_read, strings, req->nbytes)) {
+        _exit(EXIT_FAILURE);
+    }
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        _shimzygote_initChild(req, strings, argc, argv);
+        *is_child = true;
+        return;
+    }
+
+    ShimZygoteResponse res = {.pid = pid, .err = pid < 0 ? errno : 0};
+    free(strings);
+    if (!_shimzygote_transfer(SYS_write, &res, sizeof(res))) {
+        _exit(EXIT_FAILURE);
+    }
+}
+
+static void _shimzygote_handleWait(const ShimZygoteRequest* req) {
+    ShimZygoteResponse res = {0};
+    do {
+        res.pid = waitpid(req->pid, &res.wstatus, __WALL);
+    } while (res.pid < 0 && errno == EINTR);
+    res.err = res.pid < 0 ? errno : 0;
+
+    if (!_shimzygote_transfer(SYS_write, &res, sizeof(res))) {
+        _exit(EXIT_FAILURE);
+    }
+}
+
+// Serve requests from Shadow until one forks a new instance, and return in that
+// instance with its arguments. Exits when Shadow closes the socket.
+static void _shimzygote_serve(int* argc, char*** argv) {
+    // Exit along with the Shadow thread that started us. Instances set the same
+    // death signal during their shim initialization, so they exit along with us.
+    if (prctl(PR_SET_PDEATHSIG, SIGKILL) < 0) {
+        warning("prctl: %s", strerror(errno));
+    }
+
+    bool is_child = false;
+    while (!is_child) {
+        ShimZygoteRequest req;
+        if (!_shimzygote_transfer(SYS_read, &req, sizeof(req))) {
+            _exit(EXIT_SUCCESS);
+        }
+
+        switch (req.type) {
+            case SHIM_ZYGOTE_REQUEST_SPAWN:
+                _shimzygote_handleSpawn(&req, argc, argv, &is_child);
+                break;
+            case SHIM_ZYGOTE_REQUEST_WAIT: _shimzygote_handleWait(&req); break;
+            default: panic("Unexpected zygote request %d", req.type);
+        }
+    }
+}
+
+typedef int (*LibcStartMainFunc)(int (*main)(int, char**, char**), int argc, char** argv,
+                                 void (*init)(void), void (*fini)(void),
+                                 void (*rtld_fini)(void), void* stack_end);
+
+// Called by the program's entry point, after the dynamic linker is done and
+// before libc runs the program's own initializers and `main`. This is where a
+// zygote waits for requests.
+int __libc_start_main(int (*main)(int, char**, char**), int argc, char** argv,
+                      void (*init)(void), void (*fini)(void), void (*rtld_fini)(void),
+                      void* stack_end) {
+    LibcStartMainFunc real_libc_start_main = dlsym(RTLD_NEXT, "__libc_start_main");
+    if (real_libc_start_main == NULL) {
+        panic("dlsym: %s", dlerror());
+    }
+
+    if (shimzygote_isZygote()) {
+        _shimzygote_serve(&argc, &argv);
+    }
+
+    return real_libc_start_main(main, argc, argv, init, fini, rtld_fini, stack_end);
+}
@@ -0,0 +1,54 @@
+#ifndef SHD_SHIM_SHIM_ZYGOTE_H_
+#define SHD_SHIM_SHIM_ZYGOTE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+// A zygote is a copy of a managed program that Shadow starts once per binary.
+// The shim stops it just before the program's `main`, after the dynamic linker
+// has loaded and relocated it and library initializers have run. Shadow then
+// starts new instances of the program by asking the zygote to fork, and handing
+// the child its own working directory, arguments and environment. The per-
+// process parts of shim initialization run in the child.
+//
+// Instances are children of the zygote rather than of Shadow, so Shadow asks
+// the zygote to reap them. The zygote exits when the Shadow thread that started
+// it does, and takes its instances with it, the same as processes that Shadow
+// starts directly.
+//
+// Shadow and the zygote talk over a stream socket whose fd number the zygote
+// gets from the SHADOW_ZYGOTE_FD environment variable. Each request gets one
+// response.
+
+typedef enum {
+    // Fork a new instance. The request is followed by `nbytes` bytes holding
+    // the nul-terminated working directory, then `argc` nul-terminated
+    // arguments, then `envc` nul-terminated environment entries.
+    SHIM_ZYGOTE_REQUEST_SPAWN,
+    // Wait for the instance `pid` to exit and reap it.
+    SHIM_ZYGOTE_REQUEST_WAIT,
+} ShimZygoteRequestType;
+
+typedef struct _ShimZygoteRequest {
+    ShimZygoteRequestType type;
+    uint32_t argc;
+    uint32_t envc;
+    uint32_t nbytes;
+    pid_t pid;
+} ShimZygoteRequest;
+
+typedef struct _ShimZygoteResponse {
+    // The new or reaped instance's pid, or -1 on failure.
+    pid_t pid;
+    // The errno of a failed request.
+    int err;
+    // The wait status of a reaped instance.
+    int wstatus;
+} ShimZygoteResponse;
+
+// Whether this process is a zygote that hasn't forked yet. Doesn't make any
+// syscalls.
+bool shimzygote_isZygote();
+
+#endif // SHD_SHIM_SHIM_ZYGOTE_H_
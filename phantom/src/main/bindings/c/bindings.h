@@ -14,6 +14,7 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <sys/uio.h>
 #include "main/bindings/c/bindings-opaque.h"
 #include "main/core/scheduler/scheduler_policy_type.h"
 #include "main/core/worker.h"
@@ -107,6 +108,16 @@ void rustlogger_log(LogLevel level,
                     const char *format,
                     void *va_list);
 
+// Log a message from C whose arguments were packed by `binarylog_packArgs`
+// rather than formatted. Only used in binary log mode.
+void rustlogger_logPacked(LogLevel level,
+                          const char *file_name,
+                          const char *fn_name,
+                          int32_t line,
+                          const char *format,
+                          const uint8_t *args,
+                          uintptr_t args_len);
+
 // Creates a ShadowLogger and installs it as the default logger for Rust's
 // `log` crate. The returned pointer is never deallocated, since loggers
 // registered with the `log` crate are required to live for the life of the
@@ -118,6 +129,11 @@ void shadow_logger_init(void);
 // record actually being written, though.
 void shadow_logger_setEnableBuffering(int32_t buffering_enabled);
 
+// When enabled, the logger thread writes binary records (see
+// lib/logger/binary_log.h) rather than text. Must be called before anything is
+// logged in binary form.
+void shadow_logger_setBinaryOutput(bool binary_output);
+
 struct LogicalProcessors *lps_new(int n);
 
 void lps_free(struct LogicalProcessors *lps);
@@ -189,6 +205,22 @@ bool config_getUseExplicitBlockMessage(const struct ConfigOptions *config);
 
 bool config_getUseSeccomp(const struct ConfigOptions *config);
 
+bool config_getUseSyscallRewriting(const struct ConfigOptions *config);
+
+bool config_getUseRdtscRewriting(const struct ConfigOptions *config);
+
+bool config_getUsePtraceIpc(const struct ConfigOptions *config);
+
+bool config_getUseZygote(const struct ConfigOptions *config);
+
+bool config_getUseProcessPrespawn(const struct ConfigOptions *config);
+
+bool config_getUseBinaryLog(const struct ConfigOptions *config);
+
+bool config_getUseBinaryHeartbeats(const struct ConfigOptions *config);
+
+bool config_getUseShmemHugePages(const struct ConfigOptions *config);
+
 bool config_getUseSyscallCounters(const struct ConfigOptions *config);
 
 bool config_getUseObjectCounters(const struct ConfigOptions *config);
@@ -197,6 +229,12 @@ bool config_getUseOpensslRNGPreload(const struct ConfigOptions *config);
 
 bool config_getUseMemoryManager(const struct ConfigOptions *config);
 
+uint32_t config_getMemoryManagerRemapThreshold(const struct ConfigOptions *config);
+
+uint32_t config_getManagerProcesses(const struct ConfigOptions *config);
+
+bool config_getUseNativePrivateFiles(const struct ConfigOptions *config);
+
 bool config_getUseShimSyscallHandler(const struct ConfigOptions *config);
 
 int32_t config_getPreloadSpinMax(const struct ConfigOptions *config);
@@ -253,6 +291,10 @@ SimulationTime hostoptions_getHeartbeatInterval(const struct HostOptions *host);
 
 char *hostoptions_getPcapDirectory(const struct HostOptions *host);
 
+uint32_t hostoptions_getPcapCaptureSize(const struct HostOptions *host);
+
+bool hostoptions_getPcapUseNg(const struct HostOptions *host);
+
 char *hostoptions_getIpAddressHint(const struct HostOptions *host);
 
 char *hostoptions_getCountryCodeHint(const struct HostOptions *host);
@@ -307,6 +349,9 @@ struct Counter *_worker_objectDeallocCounter(void);
 // Returns NULL if there is no live Worker.
 struct Counter *_worker_syscallCounter(void);
 
+// Returns NULL if there is no live Worker.
+struct Counter *_worker_memoryManagerCounter(void);
+
 // ID of the current thread's Worker. Panics if the thread has no Worker.
 int32_t worker_threadID(void);
 
@@ -434,7 +479,14 @@ PluginPtr allocdmem_pluginPtr(const struct AllocdMem_u8 *allocd_mem);
 
 // Initialize the MemoryMapper if it isn't already initialized. `thread` must
 // be running and ready to make native syscalls.
-void memorymanager_initMapperIfNeeded(struct MemoryManager *memory_manager, Thread *thread);
+void memorymanager_initMapperIfNeeded(struct MemoryManager *memory_manager,
+                                      Thread *thread,
+                                      uint32_t remap_threshold,
+                                      bool huge_pages);
+
+// Move regions with frequent misses into shared memory. `thread` must be
+// running and ready to make native syscalls.
+void memorymanager_remapHotRegions(struct MemoryManager *memory_manager, Thread *thread);
 
 void memorymanager_freeRef(struct ProcessMemoryRef_u8 *memory_ref);
 
@@ -457,6 +509,22 @@ ssize_t memorymanager_readString(const struct MemoryManager *memory_manager,
                                  char *strbuf,
                                  size_t maxlen);
 
+// Copy the first `n` bytes of the plugin buffers described by `src` into
+// `dst`.
+int32_t memorymanager_readPtrv(const struct MemoryManager *memory_manager,
+                               void *dst,
+                               const struct iovec *src,
+                               uintptr_t iovcnt,
+                               uintptr_t n);
+
+// Copy `n` bytes from `src` into the plugin buffers described by `dst`,
+// filling them in order.
+int32_t memorymanager_writePtrv(struct MemoryManager *memory_manager,
+                                const struct iovec *dst,
+                                uintptr_t iovcnt,
+                                const void *src,
+                                uintptr_t n);
+
 // Copy data from this reader's memory.
 int32_t memorymanager_readPtr(const struct MemoryManager *memory_manager,
                               void *dst,
@@ -33,6 +33,45 @@ pub type GQuark = guint32;
 pub type ssize_t = __ssize_t;
 #[repr(C)]
 #[derive(Debug, Copy, Clone)]
+pub struct iovec {
+    pub iov_base: *mut ::std::os::raw::c_void,
+    pub iov_len: size_t,
+}
+#[test]
+fn bindgen_test_layout_iovec() {
+    assert_eq!(
+        ::std::mem::size_of::<iovec>(),
+        16usize,
+        concat!("Size of: ", stringify!(iovec))
+    );
+    assert_eq!(
+        ::std::mem::align_of::<iovec>(),
+        8usize,
+        concat!("Alignment of ", stringify!(iovec))
+    );
+    assert_eq!(
+        unsafe { &(*(::std::ptr::null::<iovec>())).iov_base as *const _ as usize },
+        0usize,
+        concat!(
+            "Offset of field: ",
+            stringify!(iovec),
+            "::",
+            stringify!(iov_base)
+        )
+    );
+    assert_eq!(
+        unsafe { &(*(::std::ptr::null::<iovec>())).iov_len as *const _ as usize },
+        8usize,
+        concat!(
+            "Offset of field: ",
+            stringify!(iovec),
+            "::",
+            stringify!(iov_len)
+        )
+    );
+}
+#[repr(C)]
+#[derive(Debug, Copy, Clone)]
 pub struct _GTimer {
     _unused: [u8; 0],
 }
@@ -600,6 +639,15 @@ extern "C" {
         n: size_t,
     ) -> ::std::os::raw::c_int;
 }
+extern "C" {
+    pub fn process_readPtrv(
+        proc_: *mut Process,
+        dst: *mut ::std::os::raw::c_void,
+        src: *const iovec,
+        iovcnt: size_t,
+        n: size_t,
+    ) -> ::std::os::raw::c_int;
+}
 extern "C" {
     pub fn process_getReadableString(
         process: *mut Process,
@@ -625,6 +673,15 @@ extern "C" {
         n: size_t,
     ) -> ::std::os::raw::c_int;
 }
+extern "C" {
+    pub fn process_writePtrv(
+        proc_: *mut Process,
+        dst: *const iovec,
+        iovcnt: size_t,
+        src: *const ::std::os::raw::c_void,
+        n: size_t,
+    ) -> ::std::os::raw::c_int;
+}
 extern "C" {
     pub fn process_getReadablePtr(
         proc_: *mut Process,
@@ -709,6 +766,26 @@ pub type TransportReceiveFunc = ::std::option::Option<
         port: *mut in_port_t,
     ) -> gssize,
 >;
+pub type TransportSendShadowFunc = ::std::option::Option<
+    unsafe extern "C" fn(
+        transport: *mut Transport,
+        thread: *mut Thread,
+        buffer: *const ::std::os::raw::c_void,
+        nBytes: gsize,
+        ip: in_addr_t,
+        port: in_port_t,
+    ) -> gssize,
+>;
+pub type TransportReceiveShadowFunc = ::std::option::Option<
+    unsafe extern "C" fn(
+        transport: *mut Transport,
+        thread: *mut Thread,
+        buffer: *mut ::std::os::raw::c_void,
+        nBytes: gsize,
+        ip: *mut in_addr_t,
+        port: *mut in_port_t,
+    ) -> gssize,
+>;
 #[repr(C)]
 #[derive(Debug, Copy, Clone)]
 pub struct _TransportFunctionTable {
@@ -716,13 +793,15 @@ pub struct _TransportFunctionTable {
     pub free: DescriptorFreeFunc,
     pub send: TransportSendFunc,
     pub receive: TransportReceiveFunc,
+    pub sendShadow: TransportSendShadowFunc,
+    pub receiveShadow: TransportReceiveShadowFunc,
     pub magic: guint,
 }
 #[test]
 fn bindgen_test_layout__TransportFunctionTable() {
     assert_eq!(
         ::std::mem::size_of::<_TransportFunctionTable>(),
-        40usize,
+        56usize,
         concat!("Size of: ", stringify!(_TransportFunctionTable))
     );
     assert_eq!(
@@ -771,8 +850,32 @@ fn bindgen_test_layout__TransportFunctionTable() {
         )
     );
     assert_eq!(
-        unsafe { &(*(::std::ptr::null::<_TransportFunctionTable>())).magic as *const _ as usize },
+        unsafe {
+            &(*(::std::ptr::null::<_TransportFunctionTable>())).sendShadow as *const _ as usize
+        },
         32usize,
+        concat!(
+            "Offset of field: ",
+            stringify!(_TransportFunctionTable),
+            "::",
+            stringify!(sendShadow)
+        )
+    );
+    assert_eq!(
+        unsafe {
+            &(*(::std::ptr::null::<_TransportFunctionTable>())).receiveShadow as *const _ as usize
+        },
+        40usize,
+        concat!(
+            "Offset of field: ",
+            stringify!(_TransportFunctionTable),
+            "::",
+            stringify!(receiveShadow)
+        )
+    );
+    assert_eq!(
+        unsafe { &(*(::std::ptr::null::<_TransportFunctionTable>())).magic as *const _ as usize },
+        48usize,
         concat!(
             "Offset of field: ",
             stringify!(_TransportFunctionTable),
@@ -893,12 +996,14 @@ pub struct _HostParameters {
     pub sendBufSize: guint64,
     pub autotuneSendBuf: gboolean,
     pub interfaceBufSize: guint64,
+    pub pcapCaptureSize: guint32,
+    pub pcapUseNg: gboolean,
 }
 #[test]
 fn bindgen_test_layout__HostParameters() {
     assert_eq!(
         ::std::mem::size_of::<_HostParameters>(),
-        160usize,
+        168usize,
         concat!("Size of: ", stringify!(_HostParameters))
     );
     assert_eq!(
@@ -1138,6 +1243,26 @@ fn bindgen_test_layout__HostParameters() {
             stringify!(interfaceBufSize)
         )
     );
+    assert_eq!(
+        unsafe { &(*(::std::ptr::null::<_HostParameters>())).pcapCaptureSize as *const _ as usize },
+        160usize,
+        concat!(
+            "Offset of field: ",
+            stringify!(_HostParameters),
+            "::",
+            stringify!(pcapCaptureSize)
+        )
+    );
+    assert_eq!(
+        unsafe { &(*(::std::ptr::null::<_HostParameters>())).pcapUseNg as *const _ as usize },
+        164usize,
+        concat!(
+            "Offset of field: ",
+            stringify!(_HostParameters),
+            "::",
+            stringify!(pcapUseNg)
+        )
+    );
 }
 #[repr(C)]
 #[derive(Debug, Copy, Clone)]
@@ -1393,6 +1518,22 @@ extern "C" {
         nanoDelay: SimulationTime,
     ) -> gboolean;
 }
+extern "C" {
+    pub fn worker_scheduleTaskWithHandle(
+        task: *mut Task,
+        host: *mut Host,
+        nanoDelay: SimulationTime,
+    ) -> *mut Event;
+}
+extern "C" {
+    pub fn worker_rescheduleTask(handle: *mut Event, nanoDelay: SimulationTime) -> gboolean;
+}
+extern "C" {
+    pub fn worker_cancelTask(handle: *mut Event) -> gboolean;
+}
+extern "C" {
+    pub fn worker_requeueEvent(event: *mut Event, host: *mut Host) -> gboolean;
+}
 extern "C" {
     pub fn worker_sendPacket(src: *mut Host, packet: *mut Packet);
 }
@@ -1426,9 +1567,18 @@ extern "C" {
 extern "C" {
     pub fn worker_add_syscall_counts(syscall_counts: *mut Counter);
 }
+extern "C" {
+    pub fn worker_add_memory_manager_counts(memory_manager_counts: *mut Counter);
+}
 extern "C" {
     pub fn affinity_getGoodWorkerAffinity() -> ::std::os::raw::c_int;
 }
+extern "C" {
+    pub fn affinity_getNodeOfCPU(cpu_num: ::std::os::raw::c_int) -> ::std::os::raw::c_int;
+}
+extern "C" {
+    pub fn affinity_getNNodes() -> ::std::os::raw::c_int;
+}
 extern "C" {
     pub fn affinity_initPlatformInfo() -> ::std::os::raw::c_int;
 }
@@ -13,15 +13,20 @@
 #endif
 
 #include <errno.h>
+#include <fcntl.h>
 #include <glib.h>
 #include <glib/gstdio.h>
+#include <signal.h>
 #include <stddef.h>
+#include <sys/prctl.h>
+#include <sys/wait.h>
 #include <unistd.h>
 
 #include "lib/logger/log_level.h"
 #include "lib/logger/logger.h"
 #include "main/core/controller.h"
 #include "main/core/manager.h"
+#include "main/core/partition_exchange.h"
 #include "main/core/support/definitions.h"
 #include "main/host/host.h"
 #include "main/routing/address.h"
@@ -61,6 +66,16 @@ struct _Controller {
 
     Manager* manager;
 
+    /* when the simulation is split across processes, the partition of the hosts that we run
+     * and the exchange we share with the other partitions. hosts are assigned to partitions
+     * round-robin in the order they are registered. */
+    guint nPartitions;
+    guint partition;
+    PartitionExchange* exchange;
+    guint64 nRegisteredHosts;
+    /* the processes running the other partitions, if we are partition 0 */
+    GArray* partitionPids;
+
     MAGIC_DECLARE;
 };
 
@@ -115,6 +130,12 @@ void controller_free(Controller* controller) {
     if (controller->random) {
         random_free(controller->random);
     }
+    if (controller->exchange) {
+        partitionexchange_free(controller->exchange);
+    }
+    if (controller->partitionPids) {
+        g_array_unref(controller->partitionPids);
+    }
 
     MAGIC_CLEAR(controller);
     g_free(controller);
@@ -193,9 +214,10 @@ static void _controller_initializeTimeWindows(Controller* controller) {
     /* set simulation end time */
     controller->endTime = config_getStopTime(controller->config);
 
-    /* simulation mode depends on configured number of workers */
+    /* simulation mode depends on configured number of workers. partitions exchange packets
+     * at the end of each round, so they need bounded windows even with a single worker. */
     guint nWorkers = config_getWorkers(controller->config);
-    if (nWorkers > 0) {
+    if (nWorkers > 0 || controller->nPartitions > 1) {
         /* multi threaded, manage the other workers */
         controller->executeWindowStart = 0;
         SimulationTime jump = _controller_getMinTimeJump(controller);
@@ -210,6 +232,125 @@ static void _controller_initializeTimeWindows(Controller* controller) {
     controller->bootstrapEndTime = config_getBootstrapEndTime(controller->config);
 }
 
+static void _controller_initializePartitions(Controller* controller) {
+    MAGIC_ASSERT(controller);
+
+    controller->nPartitions = MAX(1, config_getManagerProcesses(controller->config));
+    controller->partition = 0;
+
+    if (controller->nPartitions == 1) {
+        return;
+    }
+
+    if (controller->nPartitions > PARTITION_EXCHANGE_MAX_PARTITIONS) {
+        utility_panic("%u manager processes were requested, but at most %u are supported",
+                      controller->nPartitions, PARTITION_EXCHANGE_MAX_PARTITIONS);
+    }
+
+    const gchar* name = g_getenv(PARTITION_EXCHANGE_ENV_NAME);
+    const gchar* index = g_getenv(PARTITION_EXCHANGE_ENV_INDEX);
+
+    if (name == NULL || index == NULL) {
+        /* we are the first process; we start the others once our manager has created the
+         * data directory */
+        controller->exchange = partitionexchange_new(controller->nPartitions);
+    } else {
+        controller->partition = (guint)g_ascii_strtoull(index, NULL, 10);
+        controller->exchange =
+            partitionexchange_attach(name, controller->partition, controller->nPartitions);
+    }
+}
+
+static void _controller_spawnPartitions(Controller* controller) {
+    MAGIC_ASSERT(controller);
+    utility_assert(controller->partition == 0);
+
+    /* the other partitions run the same command that we were started with */
+    gchar* cmdline = NULL;
+    gsize cmdlineLength = 0;
+    GError* error = NULL;
+    if (!g_file_get_contents("/proc/self/cmdline", &cmdline, &cmdlineLength, &error)) {
+        utility_panic("unable to read our command line: %s", error->message);
+    }
+
+    GPtrArray* argv = g_ptr_array_new();
+    for (gsize i = 0; i < cmdlineLength; i += strlen(&cmdline[i]) + 1) {
+        g_ptr_array_add(argv, &cmdline[i]);
+    }
+    g_ptr_array_add(argv, NULL);
+
+    controller->partitionPids = g_array_new(FALSE, FALSE, sizeof(pid_t));
+
+    for (guint partition = 1; partition < controller->nPartitions; partition++) {
+        gchar* index = g_strdup_printf("%u", partition);
+        gchar** envv = g_get_environ();
+        envv = g_environ_setenv(envv, PARTITION_EXCHANGE_ENV_INDEX, index, TRUE);
+        envv = g_environ_setenv(envv, PARTITION_EXCHANGE_ENV_NAME,
+                                partitionexchange_getName(controller->exchange), TRUE);
+        /* avoid logging the startup message to stderr again */
+        envv = g_environ_setenv(envv, "SHADOW_SPAWNED", "TRUE", TRUE);
+        g_free(index);
+
+        gchar* logName = g_strdup_printf("shadow.partition-%u.log", partition);
+        gchar* logPath = g_build_filename(manager_getDataPath(controller->manager), logName, NULL);
+        g_free(logName);
+
+        pid_t parentPid = getpid();
+        pid_t pid = fork();
+
+        if (pid < 0) {
+            utility_panic("unable to fork partition %u: %s", partition, g_strerror(errno));
+        } else if (pid == 0) {
+            /* we have other threads, so only make async-signal-safe calls until exec */
+            if (prctl(PR_SET_PDEATHSIG, SIGKILL) != 0 || getppid() != parentPid) {
+                _exit(EXIT_FAILURE);
+            }
+            int fd = open(logPath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+            if (fd < 0 || dup2(fd, STDOUT_FILENO) < 0) {
+                _exit(EXIT_FAILURE);
+            }
+            close(fd);
+            execve("/proc/self/exe", (char**)argv->pdata, envv);
+            _exit(EXIT_FAILURE);
+        }
+
+        info("started partition %u of %u as pid %d, logging to %s", partition,
+             controller->nPartitions, (gint)pid, logPath);
+        partitionexchange_setPid(controller->exchange, partition, pid);
+        g_array_append_val(controller->partitionPids, pid);
+
+        g_free(logPath);
+        g_strfreev(envv);
+    }
+
+    g_ptr_array_unref(argv);
+    g_free(cmdline);
+}
+
+static gint _controller_awaitPartitions(Controller* controller) {
+    MAGIC_ASSERT(controller);
+
+    if (!controller->partitionPids) {
+        return 0;
+    }
+
+    gint returnCode = 0;
+    for (guint i = 0; i < controller->partitionPids->len; i++) {
+        pid_t pid = g_array_index(controller->partitionPids, pid_t, i);
+        int status = 0;
+        if (waitpid(pid, &status, 0) != pid) {
+            warning("unable to wait for partition %u (pid %d): %s", i + 1, (gint)pid,
+                    g_strerror(errno));
+            returnCode = 1;
+        } else if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            warning("partition %u (pid %d) failed with status %d", i + 1, (gint)pid, status);
+            returnCode = 1;
+        }
+    }
+
+    return returnCode;
+}
+
 static void _controller_registerArgCallback(const char* arg, void* _argArray) {
     GPtrArray* argArray = _argArray;
 
@@ -292,6 +433,8 @@ static void _controller_registerHostCallback(const char* name, const ConfigOptio
         params->heartbeatInterval = hostoptions_getHeartbeatInterval(host);
 
         params->pcapDir = hostoptions_getPcapDirectory(host);
+        params->pcapCaptureSize = hostoptions_getPcapCaptureSize(host);
+        params->pcapUseNg = hostoptions_getPcapUseNg(host);
 
         params->ipHint = hostoptions_getIpAddressHint(host);
         params->countrycodeHint = hostoptions_getCountryCodeHint(host);
@@ -311,14 +454,23 @@ static void _controller_registerHostCallback(const char* name, const ConfigOptio
         params->interfaceBufSize = config_getInterfaceBuffer(config);
         params->qdisc = config_getInterfaceQdisc(config);
 
-        manager_addNewVirtualHost(controller->manager, params);
+        /* every partition registers every host in the same order, so that they all assign
+         * the same addresses and random seeds, but only sets up the hosts it runs */
+        guint partition = controller->nRegisteredHosts++ % controller->nPartitions;
 
-        ProcessCallbackArgs processArgs;
-        processArgs.controller = controller;
-        processArgs.hostname = hostnameBuffer->str;
+        if (partition == controller->partition) {
+            manager_addNewVirtualHost(controller->manager, params);
 
-        /* now handle each virtual process the host will run */
-        hostoptions_iterProcesses(host, _controller_registerProcessCallback, (void*)&processArgs);
+            ProcessCallbackArgs processArgs;
+            processArgs.controller = controller;
+            processArgs.hostname = hostnameBuffer->str;
+
+            /* now handle each virtual process the host will run */
+            hostoptions_iterProcesses(
+                host, _controller_registerProcessCallback, (void*)&processArgs);
+        } else {
+            manager_addNewRemoteVirtualHost(controller->manager, params, partition);
+        }
 
         /* cleanup for next pass through the loop */
         g_string_free(hostnameBuffer, TRUE);
@@ -347,11 +499,12 @@ gint controller_run(Controller* controller) {
         return 1;
     }
 
+    _controller_initializePartitions(controller);
     _controller_initializeTimeWindows(controller);
 
     /* the controller will be responsible for distributing the actions to the managers so that
      * they all have a consistent view of the simulation, topology, etc.
-     * For now we only have one manager so send it everything. */
+     * Each partition has one manager, which registers every host but only runs its own. */
     guint managerSeed = random_nextUInt(controller->random);
     controller->manager = manager_new(controller, controller->config, controller->endTime,
                                       controller->bootstrapEndTime, managerSeed);
@@ -360,6 +513,10 @@ gint controller_run(Controller* controller) {
         utility_panic("unable to create manager");
     }
 
+    if (controller->nPartitions > 1 && controller->partition == 0) {
+        _controller_spawnPartitions(controller);
+    }
+
     info("registering plugins and hosts");
 
     /* register the components needed by each manager.
@@ -386,7 +543,11 @@ gint controller_run(Controller* controller) {
 
     info("simulation finished, cleaning up now");
 
-    return manager_free(controller->manager);
+    gint returnCode = manager_free(controller->manager);
+    if (_controller_awaitPartitions(controller) != 0) {
+        returnCode = -1;
+    }
+    return returnCode;
 }
 
 gboolean controller_managerFinishedCurrentRound(Controller* controller,
@@ -396,8 +557,14 @@ gboolean controller_managerFinishedCurrentRound(Controller* controller,
     MAGIC_ASSERT(controller);
     utility_assert(executeWindowStart && executeWindowEnd);
 
-    /* TODO: once we get multiple managers, we have to block them here
-     * until they have all notified us that they are finished */
+    if (controller->exchange) {
+        /* block until the managers of all partitions have finished the round, and agree
+         * with them on the next window */
+        SimulationTime minJumpTime = controller->nextMinJumpTime;
+        minNextEventTime =
+            partitionexchange_finishRound(controller->exchange, minNextEventTime, &minJumpTime);
+        controller->nextMinJumpTime = minJumpTime;
+    }
 
     /* update our detected min jump time */
     controller->minJumpTime = controller->nextMinJumpTime;
@@ -437,3 +604,23 @@ Topology* controller_getTopology(Controller* controller) {
     MAGIC_ASSERT(controller);
     return controller->topology;
 }
+
+guint controller_getPartition(Controller* controller) {
+    MAGIC_ASSERT(controller);
+    return controller->partition;
+}
+
+void controller_sendPacket(Controller* controller, guint dstPartition, SimulationTime deliverTime,
+                           Packet* packet) {
+    MAGIC_ASSERT(controller);
+    utility_assert(controller->exchange);
+    partitionexchange_sendPacket(controller->exchange, dstPartition, deliverTime, packet);
+}
+
+void controller_receivePackets(Controller* controller, PartitionExchangeReceiveFn fn,
+                               gpointer userData) {
+    MAGIC_ASSERT(controller);
+    if (controller->exchange) {
+        partitionexchange_receivePackets(controller->exchange, fn, userData);
+    }
+}
@@ -12,6 +12,7 @@
 typedef struct _Controller Controller;
 
 #include "main/bindings/c/bindings.h"
+#include "main/core/partition_exchange.h"
 #include "main/core/support/definitions.h"
 #include "main/routing/address.h"
 #include "main/routing/dns.h"
@@ -28,6 +29,16 @@ gboolean controller_managerFinishedCurrentRound(Controller*, SimulationTime, Sim
                                                 SimulationTime*);
 gdouble controller_getLatency(Controller* controller, Address* srcAddress, Address* dstAddress);
 
+// The partition of the hosts that this process runs when the simulation is split across
+// processes, or 0 if it isn't. See partition_exchange.h.
+guint controller_getPartition(Controller* controller);
+// Send `packet` to a host in another partition. Thread-safe.
+void controller_sendPacket(Controller* controller, guint dstPartition, SimulationTime deliverTime,
+                           Packet* packet);
+// Pass the packets that other partitions sent in the finished rounds to `fn`.
+void controller_receivePackets(Controller* controller, PartitionExchangeReceiveFn fn,
+                               gpointer userData);
+
 // TODO remove these eventually since they cant be shared accross remote managers
 DNS* controller_getDNS(Controller* controller);
 Topology* controller_getTopology(Controller* controller);
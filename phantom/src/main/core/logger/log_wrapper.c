@@ -1,5 +1,6 @@
 #include "main/core/logger/log_wrapper.h"
 
+#include "lib/logger/binary_log.h"
 #include "lib/logger/logger.h"
 #include "main/bindings/c/bindings.h"
 
@@ -8,16 +9,34 @@ static void _log(Logger* logger, LogLevel level, const char* fileName, const cha
     rustlogger_log(level, fileName, functionName, lineNumber, format, vargs);
 }
 
+static void _logPacked(Logger* logger, LogLevel level, const char* fileName,
+                       const char* functionName, const int lineNumber, const char* format,
+                       va_list vargs) {
+    if (!rustlogger_isEnabled(level)) {
+        return;
+    }
+
+    uint8_t args[BINARYLOG_ARGS_MAX_NBYTES];
+    ssize_t argsLen = binarylog_packArgs(args, sizeof(args), format, vargs);
+    if (argsLen < 0) {
+        // Format it here instead.
+        rustlogger_log(level, fileName, functionName, lineNumber, format, vargs);
+        return;
+    }
+
+    rustlogger_logPacked(level, fileName, functionName, lineNumber, format, args, argsLen);
+}
+
 static void _flush(Logger* logger) { rustlogger_flush(); }
 
 static bool _isEnabled(Logger* logger, LogLevel level) { return rustlogger_isEnabled(level); }
 
 static void _setLevel(Logger* logger, LogLevel level) { rustlogger_setLevel(level); }
 
-Logger* rustlogger_new() {
+Logger* rustlogger_new(bool binary) {
     Logger* logger = malloc(sizeof(*logger));
     *logger = (Logger){
-        .log = _log,
+        .log = binary ? _logPacked : _log,
         .flush = _flush,
         .destroy = rustlogger_destroy,
         .isEnabled = _isEnabled,
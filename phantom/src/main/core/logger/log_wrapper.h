@@ -1,6 +1,10 @@
+#include <stdbool.h>
+
 #include "lib/logger/logger.h"
 
-// Create a logger that delegates to Rust's `log` crate.
-Logger* rustlogger_new();
+// Create a logger that delegates to Rust's `log` crate. If `binary`, messages
+// aren't formatted; their format string and packed arguments are passed on
+// for the ShadowLogger to write as binary records.
+Logger* rustlogger_new(bool binary);
 
-void rustlogger_destroy(Logger* logger);
\ No newline at end of file
+void rustlogger_destroy(Logger* logger);
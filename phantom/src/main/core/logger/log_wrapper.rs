@@ -1,6 +1,8 @@
+use crate::core::logger::shadow_logger;
 use log::log_enabled;
 use log_bindings as c_log;
 use std::convert::TryFrom;
+use std::ffi::CStr;
 use std::os::raw::{c_char, c_int, c_void};
 use vsprintf::vsprintf_raw;
 
@@ -82,3 +84,34 @@ pub unsafe extern "C" fn rustlogger_log(
             .build(),
     );
 }
+
+/// Log a message whose arguments were packed by `binarylog_packArgs`. The
+/// message is formatted when the binary log is decoded.
+#[no_mangle]
+pub unsafe extern "C" fn rustlogger_logPacked(
+    level: log_bindings::LogLevel,
+    file_name: *const c_char,
+    fn_name: *const c_char,
+    line: i32,
+    format: *const c_char,
+    args: *const u8,
+    args_len: usize,
+) {
+    let log_level = c_to_rust_log_level(level).unwrap();
+
+    // SAFETY: format is statically allocated.
+    let format = unsafe { CStr::from_ptr(format) };
+    // SAFETY: Safe if caller provided a valid buffer.
+    let args = unsafe { std::slice::from_raw_parts(args, args_len) };
+
+    shadow_logger::log_packed(
+        log_level,
+        // SAFETY: file_name is statically allocated.
+        unsafe { optional_str(file_name) },
+        // SAFETY: fn_name is statically allocated.
+        unsafe { optional_str(fn_name) },
+        u32::try_from(line).unwrap(),
+        format,
+        args,
+    );
+}
@@ -6,7 +6,11 @@ use log::{Level, Log, Metadata, Record, SetLoggerError};
 use log_bindings as c_log;
 use once_cell::sync::Lazy;
 use std::cell::RefCell;
+use std::collections::HashMap;
 use std::convert::TryFrom;
+use std::ffi::CStr;
+use std::io::Write;
+use std::sync::atomic::{AtomicBool, Ordering};
 use std::sync::mpsc::{Receiver, Sender};
 use std::sync::Arc;
 use std::sync::{Mutex, RwLock};
@@ -133,10 +137,18 @@ pub struct ShadowLogger {
     // When false, sends a (still-asynchronous) flush command to the logger
     // thread every time a record is pushed into `records`.
     buffering_enabled: RwLock<bool>,
+
+    // When true, records are written in the binary format described in
+    // lib/logger/binary_log.h instead of as text.
+    binary_output: AtomicBool,
+
+    // State of the binary output. Only used while flushing, which normally
+    // happens on the logger thread.
+    binary_writer: Mutex<BinaryLogWriter>,
 }
 
 thread_local!(static SENDER: RefCell<Option<Sender<LoggerCommand>>> = RefCell::new(None));
-thread_local!(static THREAD_NAME: Lazy<String> = Lazy::new(|| { get_thread_name() }));
+thread_local!(static THREAD_NAME: Lazy<Arc<str>> = Lazy::new(|| { get_thread_name().into() }));
 
 fn get_thread_name() -> String {
     let mut thread_name = Vec::<i8>::with_capacity(16);
@@ -175,6 +187,8 @@ impl ShadowLogger {
             command_sender: Mutex::new(sender),
             command_receiver: Mutex::new(receiver),
             buffering_enabled: RwLock::new(false),
+            binary_output: AtomicBool::new(false),
+            binary_writer: Mutex::new(BinaryLogWriter::new()),
         };
         logger
     }
@@ -201,8 +215,6 @@ impl ShadowLogger {
     // self.records. If `done_sender` is provided, it's notified after the flush
     // has completed.
     fn flush_records(&self, done_sender: Option<Sender<()>>) -> std::io::Result<()> {
-        use std::io::Write;
-
         // Only flush records that are already in the queue, not ones that
         // arrive while we're flushing. Otherwise callers who perform a
         // synchronous flush (whether this flush operation or another one that
@@ -213,6 +225,18 @@ impl ShadowLogger {
         let stdout_unlocked = std::io::stdout();
         let stdout_locked = stdout_unlocked.lock();
         let mut stdout = std::io::BufWriter::new(stdout_locked);
+        let binary_output = self.binary_output.load(Ordering::Relaxed);
+        let mut binary_writer = if binary_output {
+            // If another thread panicked while holding the lock, the writer's
+            // state is still usable.
+            Some(
+                self.binary_writer
+                    .lock()
+                    .unwrap_or_else(|poisoned| poisoned.into_inner()),
+            )
+        } else {
+            None
+        };
         while toflush > 0 {
             let record = match self.records.pop() {
                 Some(r) => r,
@@ -224,63 +248,12 @@ impl ShadowLogger {
                 }
             };
             toflush -= 1;
-            {
-                let parts = TimeParts::from_nanos(record.wall_time.as_nanos());
-                write!(
-                    stdout,
-                    "{:02}:{:02}:{:02}.{:06}",
-                    parts.hours,
-                    parts.mins,
-                    parts.secs,
-                    parts.nanos / 1000
-                )?;
-            }
-            write!(stdout, " [{}]", record.thread_name)?;
-            if let Some(sim_time) = record.sim_time {
-                let parts = TimeParts::from_nanos(sim_time.as_nanos());
-                write!(
-                    stdout,
-                    " {:02}:{:02}:{:02}.{:09}",
-                    parts.hours, parts.mins, parts.secs, parts.nanos
-                )?;
-            } else {
-                write!(stdout, " n/a")?;
-            }
-            write!(stdout, " [{level}]", level = record.level)?;
-            if let Some(host) = record.host_info {
-                write!(
-                    stdout,
-                    " [{hostname}:{ip}]",
-                    hostname = host.name,
-                    ip = host.default_ip,
-                )?;
-            } else {
-                write!(stdout, " [n/a]",)?;
-            }
-            write!(
-                stdout,
-                " [{file}:",
-                file = record
-                    .file
-                    .map(|f| if let Some(sep_pos) = f.rfind('/') {
-                        &f[(sep_pos + 1)..]
-                    } else {
-                        f
-                    })
-                    .unwrap_or("n/a"),
-            )?;
-            if let Some(line) = record.line {
-                write!(stdout, "{line}", line = line)?;
-            } else {
-                write!(stdout, "n/a")?;
+            match binary_writer.as_mut() {
+                Some(writer) => writer.write_record(&mut stdout, &record)?,
+                None => Self::write_text_record(&mut stdout, &record)?,
             }
-            write!(
-                stdout,
-                "] [{module}] {msg}\n",
-                module = record.module_path.unwrap_or("n/a"),
-                msg = record.message
-            )?;
         }
+        stdout.flush()?;
         if let Some(done_sender) = done_sender {
             // We can't log from this thread without risking deadlock, so in the
             // unlikely case that the calling thread has gone away, just print
@@ -296,6 +269,67 @@ impl ShadowLogger {
         Ok(())
     }
 
+    // Write `record` to `stdout` as a line of text.
+    fn write_text_record(stdout: &mut impl Write, record: &ShadowLogRecord) -> std::io::Result<()> {
+        {
+            let parts = TimeParts::from_nanos(record.wall_time.as_nanos());
+            write!(
+                stdout,
+                "{:02}:{:02}:{:02}.{:06}",
+                parts.hours,
+                parts.mins,
+                parts.secs,
+                parts.nanos / 1000
+            )?;
+        }
+        write!(stdout, " [{}]", record.thread_name)?;
+        if let Some(sim_time) = record.sim_time {
+            let parts = TimeParts::from_nanos(sim_time.as_nanos());
+            write!(
+                stdout,
+                " {:02}:{:02}:{:02}.{:09}",
+                parts.hours, parts.mins, parts.secs, parts.nanos
+            )?;
+        } else {
+            write!(stdout, " n/a")?;
+        }
+        write!(stdout, " [{level}]", level = record.level)?;
+        if let Some(host) = &record.host_info {
+            write!(
+                stdout,
+                " [{hostname}:{ip}]",
+                hostname = host.name,
+                ip = host.default_ip,
+            )?;
+        } else {
+            write!(stdout, " [n/a]",)?;
+        }
+        write!(
+            stdout,
+            " [{file}:",
+            file = record
+                .file
+                .map(|f| if let Some(sep_pos) = f.rfind('/') {
+                    &f[(sep_pos + 1)..]
+                } else {
+                    f
+                })
+                .unwrap_or("n/a"),
+        )?;
+        if let Some(line) = record.line {
+            write!(stdout, "{line}", line = line)?;
+        } else {
+            write!(stdout, "n/a")?;
+        }
+        write!(
+            stdout,
+            "] [{module}] {msg}\n",
+            module = record.module_path.unwrap_or("n/a"),
+            msg = record.message
+        )?;
+        Ok(())
+    }
+
     /// When disabled, the logger thread is notified to write each record as
     /// soon as it's created.  The calling thread still isn't blocked on the
     /// record actually being written, though.
@@ -304,6 +338,67 @@ impl ShadowLogger {
         *writer = buffering_enabled;
     }
 
+    /// When enabled, records are written in binary form, and C callers pass
+    /// their format strings and packed arguments instead of formatted messages.
+    pub fn set_binary_output(&self, binary_output: bool) {
+        self.binary_output.store(binary_output, Ordering::Relaxed);
+    }
+
+    // Log a message from C whose arguments were packed by `binarylog_packArgs`.
+    fn log_packed(
+        &self,
+        level: Level,
+        file: Option<&'static str>,
+        module_path: Option<&'static str>,
+        line: u32,
+        format: &'static CStr,
+        args: &[u8],
+    ) {
+        if !self.enabled(&Metadata::builder().level(level).build()) {
+            return;
+        }
+
+        self.push_record(ShadowLogRecord::new(
+            level,
+            file,
+            module_path,
+            Some(line),
+            LogMessage::Packed {
+                format,
+                args: args.to_vec(),
+            },
+        ));
+    }
+
+    // Queue `shadowrecord` for the logger thread, and flush if needed.
+    fn push_record(&self, mut shadowrecord: ShadowLogRecord) {
+        let level = shadowrecord.level;
+
+        loop {
+            match self.records.push(shadowrecord) {
+                Ok(()) => break,
+                Err(r) => {
+                    // Queue is full. Flush it and try again.
+                    shadowrecord = r;
+                    self.flush_sync();
+                }
+            }
+        }
+
+        if level == Level::Error {
+            // Unlike in Shadow's C code, we don't abort the program on Error
+            // logs. In Rust the same purpose is filled with `panic` and
+            // `unwrap`. C callers will still exit or abort via the lib/logger wrapper.
+            //
+            // Flush *synchronously*, since we're likely about to crash one way or another.
+            self.flush_sync();
+        } else if self.records.len() > ASYNC_FLUSH_QD_LINES_THRESHOLD
+            || !*self.buffering_enabled.read().unwrap()
+        {
+            self.flush_async();
+        }
+    }
+
     // Send a flush command to the logger thread.
     fn flush_impl(&self, notify_done: Option<Sender<()>>) {
         self.send_command(LoggerCommand::Flush(notify_done))
@@ -361,50 +456,19 @@ impl Log for ShadowLogger {
             return;
         }
 
-        let message = std::fmt::format(*record.args());
-
-        let host_info = Worker::with_active_host_info(|host| host.clone());
-
-        let mut shadowrecord = ShadowLogRecord {
-            level: record.level(),
-            file: record.file_static(),
-            module_path: record.module_path_static(),
-            line: record.line(),
-            message,
-            wall_time: Duration::from_micros(unsafe {
-                u64::try_from(c_log::logger_elapsed_micros()).unwrap()
-            }),
-
-            sim_time: Worker::current_time(),
-            thread_name: THREAD_NAME
-                .try_with(|name| (*name).clone())
-                .unwrap_or_else(|_| get_thread_name()),
-            host_info,
+        // Messages without arguments don't need to be formatted.
+        let message = match record.args().as_str() {
+            Some(message) => LogMessage::Static(message),
+            None => LogMessage::Text(std::fmt::format(*record.args())),
         };
 
-        loop {
-            match self.records.push(shadowrecord) {
-                Ok(()) => break,
-                Err(r) => {
-                    // Queue is full. Flush it and try again.
-                    shadowrecord = r;
-                    self.flush_sync();
-                }
-            }
-        }
-
-        if record.level() == Level::Error {
-            // Unlike in Shadow's C code, we don't abort the program on Error
-            // logs. In Rust the same purpose is filled with `panic` and
-            // `unwrap`. C callers will still exit or abort via the lib/logger wrapper.
-            //
-            // Flush *synchronously*, since we're likely about to crash one way or another.
-            self.flush_sync();
-        } else if self.records.len() > ASYNC_FLUSH_QD_LINES_THRESHOLD
-            || !*self.buffering_enabled.read().unwrap()
-        {
-            self.flush_async();
-        }
+        self.push_record(ShadowLogRecord::new(
+            record.level(),
+            record.file_static(),
+            record.module_path_static(),
+            record.line(),
+            message,
+        ));
     }
 
     fn flush(&self) {
@@ -417,14 +481,185 @@ struct ShadowLogRecord {
     file: Option<&'static str>,
     module_path: Option<&'static str>,
     line: Option<u32>,
-    message: String,
+    message: LogMessage,
     wall_time: Duration,
 
     sim_time: Option<SimulationTime>,
-    thread_name: String,
+    thread_name: Arc<str>,
     host_info: Option<Arc<HostInfo>>,
 }
 
+impl ShadowLogRecord {
+    // Create a record with the calling thread's context.
+    fn new(
+        level: Level,
+        file: Option<&'static str>,
+        module_path: Option<&'static str>,
+        line: Option<u32>,
+        message: LogMessage,
+    ) -> Self {
+        Self {
+            level,
+            file,
+            module_path,
+            line,
+            message,
+            wall_time: Duration::from_micros(unsafe {
+                u64::try_from(c_log::logger_elapsed_micros()).unwrap()
+            }),
+            sim_time: Worker::current_time(),
+            thread_name: THREAD_NAME
+                .try_with(|name| Arc::clone(name))
+                .unwrap_or_else(|_| get_thread_name().into()),
+            host_info: Worker::with_active_host_info(|host| host.clone()),
+        }
+    }
+}
+
+enum LogMessage {
+    // Formatted by the calling thread.
+    Text(String),
+    // A message without arguments.
+    Static(&'static str),
+    // A printf-style format string from C, with its arguments packed by
+    // `binarylog_packArgs`. Only logged when binary output is enabled.
+    Packed {
+        format: &'static CStr,
+        args: Vec<u8>,
+    },
+}
+
+impl std::fmt::Display for LogMessage {
+    fn fmt(&self, f: &mut std::fmt::Formatter<'_>) -> std::fmt::Result {
+        match self {
+            LogMessage::Text(s) => write!(f, "{}", s),
+            LogMessage::Static(s) => write!(f, "{}", s),
+            // Only decode_binary_log.py knows how to format these.
+            LogMessage::Packed { format, .. } => write!(f, "{}", format.to_string_lossy()),
+        }
+    }
+}
+
+// Binary log entry types and record layout; see lib/logger/binary_log.h.
+const BINARYLOG_MAGIC: &[u8; 8] = b"SHDLOGB1";
+const BINARYLOG_ENTRY_STRING: u8 = 1;
+const BINARYLOG_ENTRY_RECORD: u8 = 2;
+
+/// Writes records in the binary format described in lib/logger/binary_log.h.
+/// Strings are interned by content, and each one is defined the first time a
+/// record refers to it.
+struct BinaryLogWriter {
+    wrote_magic: bool,
+    string_ids: HashMap<String, u64>,
+    // Reused for each record's payload.
+    payload: Vec<u8>,
+}
+
+impl BinaryLogWriter {
+    fn new() -> Self {
+        Self {
+            wrote_magic: false,
+            string_ids: HashMap::new(),
+            payload: Vec::new(),
+        }
+    }
+
+    // Returns the id of `s`, writing its definition first if it's new.
+    fn intern(&mut self, out: &mut impl Write, s: &str) -> std::io::Result<u64> {
+        if let Some(id) = self.string_ids.get(s) {
+            return Ok(*id);
+        }
+        let id = u64::try_from(self.string_ids.len()).unwrap() + 1;
+        self.string_ids.insert(s.to_string(), id);
+
+        out.write_all(&[BINARYLOG_ENTRY_STRING])?;
+        out.write_all(&u32::try_from(8 + s.len()).unwrap().to_le_bytes())?;
+        out.write_all(&id.to_le_bytes())?;
+        out.write_all(s.as_bytes())?;
+        Ok(id)
+    }
+
+    fn intern_optional(&mut self, out: &mut impl Write, s: Option<&str>) -> std::io::Result<u64> {
+        match s {
+            Some(s) => self.intern(out, s),
+            None => Ok(0),
+        }
+    }
+
+    fn write_record(
+        &mut self,
+        out: &mut impl Write,
+        record: &ShadowLogRecord,
+    ) -> std::io::Result<()> {
+        if !self.wrote_magic {
+            out.write_all(BINARYLOG_MAGIC)?;
+            self.wrote_magic = true;
+        }
+
+        let thread_id = self.intern(out, &record.thread_name)?;
+        let host_id = match &record.host_info {
+            Some(host) => self.intern(out, &format!("{}:{}", host.name, host.default_ip))?,
+            None => 0,
+        };
+        let file_id = self.intern_optional(out, record.file)?;
+        let module_id = self.intern_optional(out, record.module_path)?;
+
+        // Messages that were already formatted are logged as a "%s" format
+        // with a single string argument.
+        let mut text_arg = Vec::new();
+        let (format_id, args) = match &record.message {
+            LogMessage::Packed { format, args } => {
+                (self.intern(out, &format.to_string_lossy())?, &args[..])
+            }
+            LogMessage::Static(s) if !s.contains('%') => (self.intern(out, s)?, &[][..]),
+            LogMessage::Static(_) | LogMessage::Text(_) => {
+                let s = match &record.message {
+                    LogMessage::Text(s) => s.as_str(),
+                    LogMessage::Static(s) => s,
+                    LogMessage::Packed { .. } => unreachable!(),
+                };
+                text_arg.push(b's');
+                text_arg.extend_from_slice(&u32::try_from(s.len()).unwrap().to_le_bytes());
+                text_arg.extend_from_slice(s.as_bytes());
+                (self.intern(out, "%s")?, &text_arg[..])
+            }
+        };
+
+        let level = match record.level {
+            Level::Error => c_log::_LogLevel_LOGLEVEL_ERROR,
+            Level::Warn => c_log::_LogLevel_LOGLEVEL_WARNING,
+            Level::Info => c_log::_LogLevel_LOGLEVEL_INFO,
+            Level::Debug => c_log::_LogLevel_LOGLEVEL_DEBUG,
+            Level::Trace => c_log::_LogLevel_LOGLEVEL_TRACE,
+        };
+        let sim_nanos = record
+            .sim_time
+            .map(|t| u64::try_from(t.as_nanos()).unwrap())
+            .unwrap_or(u64::MAX);
+
+        let payload = &mut self.payload;
+        payload.clear();
+        payload.push(u8::try_from(level).unwrap());
+        payload.extend_from_slice(
+            &u64::try_from(record.wall_time.as_micros())
+                .unwrap()
+                .to_le_bytes(),
+        );
+        payload.extend_from_slice(&sim_nanos.to_le_bytes());
+        payload.extend_from_slice(&thread_id.to_le_bytes());
+        payload.extend_from_slice(&host_id.to_le_bytes());
+        payload.extend_from_slice(&file_id.to_le_bytes());
+        payload.extend_from_slice(&record.line.unwrap_or(0).to_le_bytes());
+        payload.extend_from_slice(&module_id.to_le_bytes());
+        payload.extend_from_slice(&format_id.to_le_bytes());
+        payload.extend_from_slice(args);
+
+        out.write_all(&[BINARYLOG_ENTRY_RECORD])?;
+        out.write_all(&u32::try_from(payload.len()).unwrap().to_le_bytes())?;
+        out.write_all(payload)
+    }
+}
+
 enum LoggerCommand {
     // Flush; takes an optional one-shot channel to notify that the flush has completed.
     Flush(Option<Sender<()>>),
@@ -449,4 +684,24 @@ mod export {
     pub unsafe extern "C" fn shadow_logger_setEnableBuffering(buffering_enabled: i32) {
         SHADOW_LOGGER.set_buffering_enabled(buffering_enabled != 0)
     }
+
+    /// When enabled, the logger thread writes binary records (see
+    /// lib/logger/binary_log.h) rather than text. Must be called before anything is
+    /// logged in binary form.
+    #[no_mangle]
+    pub unsafe extern "C" fn shadow_logger_setBinaryOutput(binary_output: bool) {
+        SHADOW_LOGGER.set_binary_output(binary_output)
+    }
+}
+
+/// Log a message from C whose arguments were packed by `binarylog_packArgs`.
+pub fn log_packed(
+    level: Level,
+    file: Option<&'static str>,
+    module_path: Option<&'static str>,
+    line: u32,
+    format: &'static CStr,
+    args: &[u8],
+) {
+    SHADOW_LOGGER.log_packed(level, file, module_path, line, format, args)
 }
@@ -22,14 +22,32 @@ impl LogicalProcessors {
     pub fn new(n: usize) -> Self {
         let mut lps = Vec::new();
         for _ in 0..n {
+            let cpu_id = unsafe { cshadow::affinity_getGoodWorkerAffinity() };
             lps.push(LogicalProcessor {
-                cpu_id: unsafe { cshadow::affinity_getGoodWorkerAffinity() },
+                cpu_id,
+                node: unsafe { cshadow::affinity_getNodeOfCPU(cpu_id) },
+                steal_order: Vec::new(),
                 ready_workers: SegQueue::new(),
                 done_workers: SegQueue::new(),
                 #[cfg(feature = "perf_timers")]
                 idle_timer: Mutex::new(PerfTimer::new()),
             });
         }
+
+        // Keep the logical processors of each NUMA node next to each other.
+        lps.sort_by_key(|lp| lp.node);
+
+        // Each logical processor steals from those on its own node before
+        // those on other nodes, so that workers (and the host memory they
+        // touch) only move between nodes when a whole node is out of work.
+        // Within each group we keep the round-robin order starting at `lpi`.
+        for lpi in 0..lps.len() {
+            let node = lps[lpi].node;
+            let mut order: Vec<usize> = (1..lps.len()).map(|i| (lpi + i) % lps.len()).collect();
+            order.sort_by_key(|&other| lps[other].node != node);
+            lps[lpi].steal_order = order;
+        }
+
         Self { lps }
     }
 
@@ -41,12 +59,14 @@ impl LogicalProcessors {
     /// Get a worker ID to run on `lpi`. Returns None if there are no more
     /// workers to run.
     pub fn pop_worker_to_run_on(&self, lpi: usize) -> Option<usize> {
-        for i in 0..self.lps.len() {
-            // Start with workers that last ran on `lpi`; if none are available
-            // steal from another in round-robin order.
-            let from_lpi = (lpi + i) % self.lps.len();
-            let from_lp = &self.lps[from_lpi];
-            if let Some(worker) = from_lp.ready_workers.pop() {
+        // Start with workers that last ran on `lpi`; if none are available
+        // steal from another, preferring those on the same NUMA node.
+        let lp = &self.lps[lpi];
+        if let Some(worker) = lp.ready_workers.pop() {
+            return Some(worker);
+        }
+        for &from_lpi in &lp.steal_order {
+            if let Some(worker) = self.lps[from_lpi].ready_workers.pop() {
                 return Some(worker);
             }
         }
@@ -99,6 +119,10 @@ impl LogicalProcessors {
 
 pub struct LogicalProcessor {
     cpu_id: libc::c_int,
+    /// NUMA node of `cpu_id`, or -1 if unknown
+    node: libc::c_int,
+    /// Other logical processors to steal workers from, in order of preference
+    steal_order: Vec<usize>,
     ready_workers: SegQueue<usize>,
     done_workers: SegQueue<usize>,
     #[cfg(feature = "perf_timers")]
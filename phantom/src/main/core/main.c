@@ -25,7 +25,9 @@
 #include "main/core/logger/log_wrapper.h"
 #include "main/core/support/config_handlers.h"
 #include "main/host/affinity.h"
+#include "main/shmem/shmem_allocator.h"
 #include "main/shmem/shmem_cleanup.h"
+#include "main/shmem/shmem_file.h"
 #include "main/utility/disable_aslr.h"
 #include "main/utility/utility.h"
 #include "shd-config.h"
@@ -229,8 +231,10 @@ gint main_runShadow(gint argc, gchar* argv[]) {
     LogLevel logLevel = config_getLogLevel(config);
 
     /* start up the logging subsystem to handle all future messages */
+    bool binaryLog = config_getUseBinaryLog(config);
     shadow_logger_init();
-    logger_setDefault(rustlogger_new(logLevel));
+    shadow_logger_setBinaryOutput(binaryLog);
+    logger_setDefault(rustlogger_new(binaryLog));
     logger_setLevel(logger_getDefault(), logLevel);
 
     /* disable buffering during startup so that we see every message immediately in the terminal */
@@ -246,6 +250,8 @@ gint main_runShadow(gint argc, gchar* argv[]) {
     // before we run the simluation, clean up any orphaned shared memory
     shmemcleanup_tryCleanup();
 
+    shmemfile_setUseHugePages(config_getUseShmemHugePages(config));
+
     if (config_getUseCpuPinning(config)) {
         int rc = affinity_initPlatformInfo();
         if (rc) {
@@ -253,6 +259,11 @@ gint main_runShadow(gint argc, gchar* argv[]) {
             config_free(config);
             return EXIT_FAILURE;
         }
+
+        // Workers stay on their nodes, so keep their IPC memory there too.
+        if (affinity_getNNodes() > 1) {
+            shmemallocator_setNodeLocal(true);
+        }
     }
 
     /* raise fd soft limit to hard limit */
@@ -21,10 +21,12 @@
 #include "main/core/scheduler/scheduler_policy.h"
 #include "main/core/support/config_handlers.h"
 #include "main/core/support/definitions.h"
+#include "main/core/worker.h"
 #include "main/host/host.h"
 #include "main/host/network_interface.h"
 #include "main/routing/address.h"
 #include "main/routing/dns.h"
+#include "main/routing/packet.h"
 #include "main/routing/topology.h"
 #include "main/utility/random.h"
 #include "main/utility/utility.h"
@@ -36,6 +38,24 @@
 static bool _use_openssl_rng_preload = true;
 ADD_CONFIG_HANDLER(config_getUseOpensslRNGPreload, _use_openssl_rng_preload)
 
+/* a host that is run by the manager of another partition */
+typedef struct _RemoteHost RemoteHost;
+struct _RemoteHost {
+    guint partition;
+    Address* defaultAddress;
+    guint64 bwDownKiBps;
+    guint64 bwUpKiBps;
+};
+
+/* packets from other partitions for the same host, ip, and time are delivered together */
+typedef struct _RemotePacketBatch RemotePacketBatch;
+struct _RemotePacketBatch {
+    Host* dstHost;
+    in_addr_t dstIP;
+    SimulationTime deliverTime;
+    GPtrArray* packets;
+};
+
 struct _Manager {
     Controller* controller;
 
@@ -59,9 +79,16 @@ struct _Manager {
     // Global syscall counter, we collect counts from workers at end of sim
     Counter* syscall_counter;
 
+    // Global MemoryManager access counter, by plugin memory region
+    Counter* memory_manager_counter;
+
     /* the parallel event/host/thread scheduler */
     Scheduler* scheduler;
 
+    /* hosts run by other partitions, by host id */
+    GHashTable* remoteHosts;
+    RemotePacketBatch remoteBatch;
+
     GMutex lock;
     GMutex pluginInitLock;
 
@@ -102,6 +129,17 @@ static Host* _manager_getHost(Manager* manager, GQuark hostID) {
     return scheduler_getHost(manager->scheduler, hostID);
 }
 
+static RemoteHost* _manager_getRemoteHost(Manager* manager, GQuark hostID) {
+    MAGIC_ASSERT(manager);
+    return g_hash_table_lookup(manager->remoteHosts, GUINT_TO_POINTER(hostID));
+}
+
+static void _manager_freeRemoteHost(RemoteHost* remote) {
+    topology_detach(controller_getTopology(globalmanager->controller), remote->defaultAddress);
+    address_unref(remote->defaultAddress);
+    g_free(remote);
+}
+
 static gchar* _manager_getRPath() {
     const ElfW(Dyn) *dyn = _DYNAMIC;
     const ElfW(Dyn) *rpath = NULL;
@@ -226,6 +264,9 @@ Manager* manager_new(Controller* controller, ConfigOptions* config, SimulationTi
     manager->scheduler =
         scheduler_new(manager, policy, nWorkers, schedulerSeed, endTime);
 
+    manager->remoteHosts = g_hash_table_new_full(
+        g_direct_hash, g_direct_equal, NULL, (GDestroyNotify)_manager_freeRemoteHost);
+
     manager->cwdPath = g_get_current_dir();
 
     char* dataDirectory = config_getDataDirectory(config);
@@ -240,6 +281,11 @@ Manager* manager_new(Controller* controller, ConfigOptions* config, SimulationTi
 
     manager->hostsPath = g_build_filename(manager->dataPath, "hosts", NULL);
 
+    if (controller_getPartition(controller) > 0) {
+        /* the first partition already set up the data directory that we share */
+        return manager;
+    }
+
     if (g_file_test(manager->dataPath, G_FILE_TEST_EXISTS)) {
         utility_panic("data directory '%s' already exists", manager->dataPath);
     }
@@ -297,6 +343,10 @@ gint manager_free(Manager* manager) {
         scheduler_unref(manager->scheduler);
     }
 
+    if (manager->remoteHosts) {
+        g_hash_table_destroy(manager->remoteHosts);
+    }
+
     if (manager->syscall_counter) {
         char* str = counter_alloc_string(manager->syscall_counter);
         info("Global syscall counts: %s", str);
@@ -304,6 +354,13 @@ gint manager_free(Manager* manager) {
         counter_free(manager->syscall_counter);
     }
 
+    if (manager->memory_manager_counter) {
+        char* str = counter_alloc_string(manager->memory_manager_counter);
+        info("Global memory manager access counts: %s", str);
+        counter_free_string(manager->memory_manager_counter, str);
+        counter_free(manager->memory_manager_counter);
+    }
+
     if (manager->object_counter_alloc && manager->object_counter_dealloc) {
         char* str = counter_alloc_string(manager->object_counter_alloc);
         info("Global allocated object counts: %s", str);
@@ -383,6 +440,99 @@ void manager_addNewVirtualHost(Manager* manager, HostParameters* params) {
     scheduler_addHost(manager->scheduler, host);
 }
 
+void manager_addNewRemoteVirtualHost(Manager* manager, HostParameters* params, guint partition) {
+    MAGIC_ASSERT(manager);
+
+    /* consume the same ids, addresses, and random values that host_setup would, so
+     * that we stay in step with the partition that runs the host */
+    params->id = g_quark_from_string(params->hostname);
+    params->nodeSeed = _manager_nextRandomUInt(manager);
+
+    DNS* dns = manager_getDNS(manager);
+    Address* loopbackAddress = dns_register(dns, params->id, params->hostname, "127.0.0.1");
+    Address* ethernetAddress = dns_register(dns, params->id, params->hostname, params->ipHint);
+
+    RemoteHost* remote = g_new0(RemoteHost, 1);
+    remote->partition = partition;
+    remote->defaultAddress = ethernetAddress;
+
+    Random* random = random_new(params->nodeSeed);
+    topology_attach(manager_getTopology(manager), ethernetAddress, random, params->ipHint,
+                    params->citycodeHint, params->countrycodeHint, &remote->bwDownKiBps,
+                    &remote->bwUpKiBps);
+    random_free(random);
+
+    if (params->requestedBWDownKiBps) {
+        remote->bwDownKiBps = params->requestedBWDownKiBps;
+    }
+    if (params->requestedBWUpKiBps) {
+        remote->bwUpKiBps = params->requestedBWUpKiBps;
+    }
+
+    address_unref(loopbackAddress);
+
+    g_hash_table_insert(manager->remoteHosts, GUINT_TO_POINTER(params->id), remote);
+    debug("registered host '%s' with ip %s, which partition %u runs", params->hostname,
+          address_toHostIPString(ethernetAddress), partition);
+}
+
+gint manager_getRemoteHostPartition(Manager* manager, GQuark hostID) {
+    MAGIC_ASSERT(manager);
+    RemoteHost* remote = _manager_getRemoteHost(manager, hostID);
+    return remote ? (gint)remote->partition : -1;
+}
+
+void manager_sendRemotePacket(Manager* manager, guint dstPartition, SimulationTime deliverTime,
+                              Packet* packet) {
+    MAGIC_ASSERT(manager);
+    controller_sendPacket(manager->controller, dstPartition, deliverTime, packet);
+}
+
+static void _manager_flushRemotePacketBatch(Manager* manager) {
+    MAGIC_ASSERT(manager);
+    RemotePacketBatch* batch = &manager->remoteBatch;
+
+    if (!batch->packets) {
+        return;
+    }
+
+    /* the task takes our ref on the packets. the sender isn't one of our hosts, so the
+     * event is from the receiver to itself, which also keeps the scheduler policies from
+     * moving it; it's already no earlier than the end of the round it was sent in. */
+    Task* packetTask = worker_newDeliverPacketsTask(batch->packets);
+    Event* packetEvent = event_new_(packetTask, batch->deliverTime, batch->dstHost, batch->dstHost);
+    task_unref(packetTask);
+    scheduler_push(manager->scheduler, packetEvent, batch->dstHost, batch->dstHost);
+
+    memset(batch, 0, sizeof(RemotePacketBatch));
+}
+
+static void _manager_receiveRemotePacket(SimulationTime deliverTime, in_addr_t dstIP,
+                                         const guint8* data, gsize len, gpointer userData) {
+    Manager* manager = userData;
+    MAGIC_ASSERT(manager);
+
+    Address* dstAddress = dns_resolveIPToAddress(manager_getDNS(manager), dstIP);
+    utility_assert(dstAddress);
+    Host* dstHost = _manager_getHost(manager, (GQuark)address_getID(dstAddress));
+    utility_assert(dstHost);
+
+    Packet* packet = packet_deserialize(data, len);
+
+    RemotePacketBatch* batch = &manager->remoteBatch;
+    if (!batch->packets || batch->dstHost != dstHost || batch->dstIP != dstIP ||
+        batch->deliverTime != deliverTime) {
+        _manager_flushRemotePacketBatch(manager);
+        *batch = (RemotePacketBatch){
+            .dstHost = dstHost,
+            .dstIP = dstIP,
+            .deliverTime = deliverTime,
+            .packets = g_ptr_array_new_with_free_func((GDestroyNotify)packet_unref),
+        };
+    }
+    g_ptr_array_add(batch->packets, packet);
+}
+
 static gchar** _manager_generateEnvv(Manager* manager, InterposeMethod interposeMethod,
                                      const gchar* environment) {
     MAGIC_ASSERT(manager);
@@ -544,6 +694,10 @@ Topology* manager_getTopology(Manager* manager) {
 
 guint32 manager_getNodeBandwidthUp(Manager* manager, GQuark nodeID, in_addr_t ip) {
     MAGIC_ASSERT(manager);
+    RemoteHost* remote = _manager_getRemoteHost(manager, nodeID);
+    if (remote) {
+        return (guint32)remote->bwUpKiBps;
+    }
     Host* host = _manager_getHost(manager, nodeID);
     NetworkInterface* interface = host_lookupInterface(host, ip);
     return networkinterface_getSpeedUpKiBps(interface);
@@ -551,17 +705,28 @@ guint32 manager_getNodeBandwidthUp(Manager* manager, GQuark nodeID, in_addr_t ip
 
 guint32 manager_getNodeBandwidthDown(Manager* manager, GQuark nodeID, in_addr_t ip) {
     MAGIC_ASSERT(manager);
+    RemoteHost* remote = _manager_getRemoteHost(manager, nodeID);
+    if (remote) {
+        return (guint32)remote->bwDownKiBps;
+    }
     Host* host = _manager_getHost(manager, nodeID);
     NetworkInterface* interface = host_lookupInterface(host, ip);
     return networkinterface_getSpeedDownKiBps(interface);
 }
 
+static Address* _manager_getDefaultAddress(Manager* manager, GQuark hostID) {
+    MAGIC_ASSERT(manager);
+    RemoteHost* remote = _manager_getRemoteHost(manager, hostID);
+    if (remote) {
+        return remote->defaultAddress;
+    }
+    return host_getDefaultAddress(_manager_getHost(manager, hostID));
+}
+
 gdouble manager_getLatency(Manager* manager, GQuark sourceNodeID, GQuark destinationNodeID) {
     MAGIC_ASSERT(manager);
-    Host* sourceNode = _manager_getHost(manager, sourceNodeID);
-    Host* destinationNode = _manager_getHost(manager, destinationNodeID);
-    Address* sourceAddress = host_getDefaultAddress(sourceNode);
-    Address* destinationAddress = host_getDefaultAddress(destinationNode);
+    Address* sourceAddress = _manager_getDefaultAddress(manager, sourceNodeID);
+    Address* destinationAddress = _manager_getDefaultAddress(manager, destinationNodeID);
     return controller_getLatency(manager->controller, sourceAddress, destinationAddress);
 }
 
@@ -643,6 +808,12 @@ void manager_run(Manager* manager) {
          * next event in order to fast-forward our execute window if possible */
         keepRunning = controller_managerFinishedCurrentRound(
             manager->controller, minNextEventTime, &windowStart, &windowEnd);
+
+        /* schedule the packets that hosts in other partitions sent to ours */
+        if (keepRunning) {
+            controller_receivePackets(manager->controller, _manager_receiveRemotePacket, manager);
+            _manager_flushRemotePacketBatch(manager);
+        }
     }
 
     scheduler_finish(manager->scheduler);
@@ -655,11 +826,21 @@ void manager_incrementPluginError(Manager* manager) {
     _manager_unlock(manager);
 }
 
+const gchar* manager_getDataPath(Manager* manager) {
+    MAGIC_ASSERT(manager);
+    return manager->dataPath;
+}
+
 const gchar* manager_getHostsRootPath(Manager* manager) {
     MAGIC_ASSERT(manager);
     return manager->hostsPath;
 }
 
+guint manager_getPartition(Manager* manager) {
+    MAGIC_ASSERT(manager);
+    return controller_getPartition(manager->controller);
+}
+
 static void _manager_increment_object_counts(Manager* manager, Counter** mgr_obj_counts,
                                              const char* obj_name) {
     _manager_lock(manager);
@@ -728,6 +909,23 @@ void manager_add_syscall_counts_global(Counter* syscall_counts) {
     }
 }
 
+void manager_add_memory_manager_counts(Manager* manager, Counter* memory_manager_counts) {
+    MAGIC_ASSERT(manager);
+    _manager_lock(manager);
+    // Created on the fly, like the syscall counter.
+    if (!manager->memory_manager_counter) {
+        manager->memory_manager_counter = counter_new();
+    }
+    counter_add_counter(manager->memory_manager_counter, memory_manager_counts);
+    _manager_unlock(manager);
+}
+
+void manager_add_memory_manager_counts_global(Counter* memory_manager_counts) {
+    if (globalmanager) {
+        manager_add_memory_manager_counts(globalmanager, memory_manager_counts);
+    }
+}
+
 SimulationTime manager_getBootstrapEndTime(Manager* manager) {
     MAGIC_ASSERT(manager);
     return manager->bootstrapEndTime;
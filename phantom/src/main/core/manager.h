@@ -29,6 +29,7 @@
 #include "main/core/support/definitions.h"
 #include "main/host/host_parameters.h"
 #include "main/routing/dns.h"
+#include "main/routing/packet.minimal.h"
 #include "main/routing/topology.h"
 
 typedef struct _Manager Manager;
@@ -50,10 +51,18 @@ const ConfigOptions* manager_getConfig(Manager* manager);
 SimulationTime manager_getBootstrapEndTime(Manager* manager);
 
 void manager_incrementPluginError(Manager* manager);
+const gchar* manager_getDataPath(Manager* manager);
 const gchar* manager_getHostsRootPath(Manager* manager);
+guint manager_getPartition(Manager* manager);
 
 void manager_updateMinTimeJump(Manager* manager, gdouble minPathLatency);
 
+/* the partition that runs the host, or -1 if we run it ourselves */
+gint manager_getRemoteHostPartition(Manager* manager, GQuark hostID);
+/* send a packet to a host in another partition, to be delivered at `deliverTime` */
+void manager_sendRemotePacket(Manager* manager, guint dstPartition, SimulationTime deliverTime,
+                              Packet* packet);
+
 void manager_run(Manager*);
 gboolean manager_schedulerIsRunning(Manager* manager);
 
@@ -61,6 +70,8 @@ gboolean manager_schedulerIsRunning(Manager* manager);
 void manager_addNewProgram(Manager* manager, const gchar* name, const gchar* path,
                            const gchar* startSymbol);
 void manager_addNewVirtualHost(Manager* manager, HostParameters* params);
+/* register a host that the manager of `partition` runs, so that we can route to it */
+void manager_addNewRemoteVirtualHost(Manager* manager, HostParameters* params, guint partition);
 void manager_addNewVirtualProcess(Manager* manager, const gchar* hostName, gchar* pluginName,
                                   SimulationTime startTime, SimulationTime stopTime, gchar** argv,
                                   char* environment);
@@ -85,4 +96,9 @@ void manager_add_syscall_counts(Manager* manager, Counter* syscall_counts);
 // Add the given syscall counts, used when the worker is no longer alive.
 void manager_add_syscall_counts_global(Counter* syscall_counts);
 
+// Add the given MemoryManager access counts into a global manager counter.
+void manager_add_memory_manager_counts(Manager* manager, Counter* memory_manager_counts);
+// Add the given MemoryManager access counts, used when the worker is no longer alive.
+void manager_add_memory_manager_counts_global(Counter* memory_manager_counts);
+
 #endif /* SHD_MANAGER_H_ */
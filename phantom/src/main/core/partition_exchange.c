@@ -0,0 +1,483 @@
+/*
+ * The Shadow Simulator
+ * See LICENSE for licensing information
+ */
+
+#include "main/core/partition_exchange.h"
+
+#include <errno.h>
+#include <glib.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "lib/logger/logger.h"
+#include "main/routing/packet.h"
+#include "main/shmem/shmem_file.h"
+#include "main/utility/utility.h"
+
+/* Capacity of each ring, in bytes. Must be a power of 2. The rings are only backed
+ * by memory once they are used, so most of this is never allocated. */
+#define PARTITION_EXCHANGE_RING_NBYTES (4 << 20)
+
+/* How often the wait loops check whether the other partitions are still alive. */
+#define PARTITION_EXCHANGE_CHECK_INTERVAL 4096
+
+/* A single-producer single-consumer byte queue of messages. `head` and `tail` count
+ * bytes ever consumed and produced; they live on separate cache lines so that the
+ * producer and consumer don't contend on them. */
+typedef struct _PartitionExchangeRing PartitionExchangeRing;
+struct _PartitionExchangeRing {
+    _Atomic guint64 head;
+    guint8 _pad0[64 - sizeof(guint64)];
+    _Atomic guint64 tail;
+    guint8 _pad1[64 - sizeof(guint64)];
+    guint8 data[PARTITION_EXCHANGE_RING_NBYTES];
+};
+
+typedef struct _PartitionExchangeRound PartitionExchangeRound;
+struct _PartitionExchangeRound {
+    SimulationTime minNextEventTime;
+    SimulationTime minJumpTime;
+};
+
+/* The part of the exchange that lives in shared memory. */
+typedef struct _PartitionExchangeShared PartitionExchangeShared;
+struct _PartitionExchangeShared {
+    guint32 nPartitions;
+    pid_t pids[PARTITION_EXCHANGE_MAX_PARTITIONS];
+
+    /* the barrier at the end of each round */
+    _Atomic guint32 nArrived;
+    _Atomic guint32 generation;
+
+    /* what each partition reported at the end of a round. indexed by the parity of
+     * the round, so that a partition that already moved on to the next round can't
+     * overwrite values that a slower one has yet to read. */
+    PartitionExchangeRound rounds[2][PARTITION_EXCHANGE_MAX_PARTITIONS];
+
+    /* nPartitions * nPartitions rings; the ring from src to dst is at
+     * src * nPartitions + dst */
+    PartitionExchangeRing rings[];
+};
+
+/* The header of each message in a ring. The packet follows, and the message is
+ * padded to a multiple of 8 bytes. */
+typedef struct _PartitionExchangeMessage PartitionExchangeMessage;
+struct _PartitionExchangeMessage {
+    /* total length, including this header and the padding */
+    guint32 len;
+    in_addr_t srcIP;
+    in_addr_t dstIP;
+    guint32 packetLen;
+    guint64 round;
+    SimulationTime deliverTime;
+};
+
+/* Packets to one partition, queued during a round. */
+typedef struct _PartitionExchangeOutbox PartitionExchangeOutbox;
+struct _PartitionExchangeOutbox {
+    GMutex lock;
+    GByteArray* messages;
+};
+
+/* A message that is ready to be delivered, for sorting. */
+typedef struct _PartitionExchangeReceived PartitionExchangeReceived;
+struct _PartitionExchangeReceived {
+    SimulationTime deliverTime;
+    in_addr_t srcIP;
+    in_addr_t dstIP;
+    guint srcPartition;
+    gsize offset;
+};
+
+struct _PartitionExchange {
+    ShMemFile shmf;
+    PartitionExchangeShared* shared;
+    guint nPartitions;
+    guint partition;
+
+    /* the round we're in; messages are tagged with the round they were sent in */
+    guint64 round;
+
+    /* indexed by destination partition */
+    PartitionExchangeOutbox* outboxes;
+    /* bytes copied out of the incoming rings, indexed by source partition */
+    GByteArray** inboxes;
+
+    MAGIC_DECLARE;
+};
+
+static gsize _partitionexchange_sharedNBytes(guint nPartitions) {
+    return shmemfile_goodSizeNBytes(sizeof(PartitionExchangeShared) +
+                                    nPartitions * nPartitions * sizeof(PartitionExchangeRing));
+}
+
+static PartitionExchangeRing* _partitionexchange_getRing(PartitionExchange* exchange, guint src,
+                                                         guint dst) {
+    return &exchange->shared->rings[src * exchange->nPartitions + dst];
+}
+
+static PartitionExchange* _partitionexchange_new(guint partition, guint nPartitions) {
+    PartitionExchange* exchange = g_new0(PartitionExchange, 1);
+    MAGIC_INIT(exchange);
+
+    exchange->nPartitions = nPartitions;
+    exchange->partition = partition;
+
+    exchange->outboxes = g_new0(PartitionExchangeOutbox, nPartitions);
+    exchange->inboxes = g_new0(GByteArray*, nPartitions);
+    for (guint i = 0; i < nPartitions; i++) {
+        g_mutex_init(&exchange->outboxes[i].lock);
+        exchange->outboxes[i].messages = g_byte_array_new();
+        exchange->inboxes[i] = g_byte_array_new();
+    }
+
+    return exchange;
+}
+
+PartitionExchange* partitionexchange_new(guint nPartitions) {
+    utility_assert(nPartitions > 1 && nPartitions <= PARTITION_EXCHANGE_MAX_PARTITIONS);
+
+    PartitionExchange* exchange = _partitionexchange_new(0, nPartitions);
+
+    gsize nbytes = _partitionexchange_sharedNBytes(nPartitions);
+    if (shmemfile_alloc(nbytes, &exchange->shmf) != 0) {
+        utility_panic("unable to allocate %zu bytes for the partition exchange", nbytes);
+    }
+
+    /* new shared memory is zeroed, which is a valid empty state for the rings and barrier */
+    exchange->shared = exchange->shmf.p;
+    exchange->shared->nPartitions = nPartitions;
+    exchange->shared->pids[0] = getpid();
+
+    info("created partition exchange %s for %u partitions", exchange->shmf.name, nPartitions);
+    return exchange;
+}
+
+PartitionExchange* partitionexchange_attach(const gchar* name, guint partition,
+                                            guint nPartitions) {
+    utility_assert(name != NULL);
+    utility_assert(partition > 0 && partition < nPartitions);
+
+    PartitionExchange* exchange = _partitionexchange_new(partition, nPartitions);
+
+    if (shmemfile_map(name, _partitionexchange_sharedNBytes(nPartitions), &exchange->shmf) != 0) {
+        utility_panic("unable to map partition exchange %s", name);
+    }
+
+    exchange->shared = exchange->shmf.p;
+    if (exchange->shared->nPartitions != nPartitions) {
+        utility_panic("partition exchange %s has %u partitions, but we expected %u", name,
+                      exchange->shared->nPartitions, nPartitions);
+    }
+
+    info("attached to partition exchange %s as partition %u of %u", name, partition,
+         nPartitions);
+    return exchange;
+}
+
+void partitionexchange_free(PartitionExchange* exchange) {
+    MAGIC_ASSERT(exchange);
+
+    if (exchange->partition == 0) {
+        shmemfile_free(&exchange->shmf);
+    } else {
+        shmemfile_unmap(&exchange->shmf);
+    }
+
+    for (guint i = 0; i < exchange->nPartitions; i++) {
+        g_mutex_clear(&exchange->outboxes[i].lock);
+        g_byte_array_unref(exchange->outboxes[i].messages);
+        g_byte_array_unref(exchange->inboxes[i]);
+    }
+    g_free(exchange->outboxes);
+    g_free(exchange->inboxes);
+
+    MAGIC_CLEAR(exchange);
+    g_free(exchange);
+}
+
+const gchar* partitionexchange_getName(PartitionExchange* exchange) {
+    MAGIC_ASSERT(exchange);
+    return exchange->shmf.name;
+}
+
+guint partitionexchange_getPartition(PartitionExchange* exchange) {
+    MAGIC_ASSERT(exchange);
+    return exchange->partition;
+}
+
+void partitionexchange_setPid(PartitionExchange* exchange, guint partition, pid_t pid) {
+    MAGIC_ASSERT(exchange);
+    utility_assert(partition < exchange->nPartitions);
+    exchange->shared->pids[partition] = pid;
+}
+
+void partitionexchange_sendPacket(PartitionExchange* exchange, guint dstPartition,
+                                  SimulationTime deliverTime, Packet* packet) {
+    MAGIC_ASSERT(exchange);
+    utility_assert(dstPartition < exchange->nPartitions && dstPartition != exchange->partition);
+
+    PartitionExchangeOutbox* outbox = &exchange->outboxes[dstPartition];
+    g_mutex_lock(&outbox->lock);
+
+    GByteArray* messages = outbox->messages;
+    guint start = messages->len;
+
+    PartitionExchangeMessage header = {
+        .srcIP = packet_getSourceIP(packet),
+        .dstIP = packet_getDestinationIP(packet),
+        .round = exchange->round,
+        .deliverTime = deliverTime,
+    };
+    g_byte_array_append(messages, (const guint8*)&header, sizeof(header));
+    packet_serialize(packet, messages);
+
+    guint packetLen = messages->len - start - sizeof(header);
+    guint len = (messages->len - start + 7) & ~7u;
+    g_byte_array_set_size(messages, start + len);
+
+    /* fill in the lengths now that we know them */
+    PartitionExchangeMessage* message = (PartitionExchangeMessage*)&messages->data[start];
+    message->len = len;
+    message->packetLen = packetLen;
+
+    g_mutex_unlock(&outbox->lock);
+
+    /* a message has to fit in a ring, with room to spare for other messages */
+    utility_assert(len <= PARTITION_EXCHANGE_RING_NBYTES / 4);
+}
+
+/* Panic if another partition has died, since we'd otherwise wait for it forever. */
+static void _partitionexchange_checkPartitions(PartitionExchange* exchange) {
+    if (exchange->partition == 0) {
+        for (guint i = 1; i < exchange->nPartitions; i++) {
+            pid_t pid = exchange->shared->pids[i];
+            int status = 0;
+            if (pid > 0 && waitpid(pid, &status, WNOHANG) == pid) {
+                utility_panic("partition %u (pid %d) exited with status %d before the "
+                              "simulation finished",
+                              i, (int)pid, status);
+            }
+        }
+    } else if (getppid() != exchange->shared->pids[0]) {
+        utility_panic("partition 0 (pid %d) exited before the simulation finished",
+                      (int)exchange->shared->pids[0]);
+    }
+}
+
+/* Copy everything that other partitions wrote to us into our inboxes, freeing space
+ * in the rings for them to write more. */
+static void _partitionexchange_drain(PartitionExchange* exchange) {
+    for (guint src = 0; src < exchange->nPartitions; src++) {
+        if (src == exchange->partition) {
+            continue;
+        }
+
+        PartitionExchangeRing* ring =
+            _partitionexchange_getRing(exchange, src, exchange->partition);
+        guint64 head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+        guint64 tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+        if (head == tail) {
+            continue;
+        }
+
+        gsize offset = head % PARTITION_EXCHANGE_RING_NBYTES;
+        gsize len = tail - head;
+        gsize firstLen = MIN(len, PARTITION_EXCHANGE_RING_NBYTES - offset);
+        g_byte_array_append(exchange->inboxes[src], &ring->data[offset], firstLen);
+        g_byte_array_append(exchange->inboxes[src], &ring->data[0], len - firstLen);
+
+        atomic_store_explicit(&ring->head, tail, memory_order_release);
+    }
+}
+
+/* Write as many whole messages from the front of `messages` into `ring` as fit.
+ * Returns the number of bytes written. */
+static gsize _partitionexchange_write(PartitionExchangeRing* ring, const guint8* messages,
+                                      gsize len) {
+    guint64 head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    guint64 tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    gsize space = PARTITION_EXCHANGE_RING_NBYTES - (tail - head);
+
+    gsize n = 0;
+    while (n < len) {
+        const PartitionExchangeMessage* message = (const PartitionExchangeMessage*)&messages[n];
+        if (n + message->len > space) {
+            break;
+        }
+        n += message->len;
+    }
+    if (n == 0) {
+        return 0;
+    }
+
+    gsize offset = tail % PARTITION_EXCHANGE_RING_NBYTES;
+    gsize firstLen = MIN(n, PARTITION_EXCHANGE_RING_NBYTES - offset);
+    memcpy(&ring->data[offset], messages, firstLen);
+    memcpy(&ring->data[0], &messages[firstLen], n - firstLen);
+
+    atomic_store_explicit(&ring->tail, tail + n, memory_order_release);
+    return n;
+}
+
+static void _partitionexchange_flush(PartitionExchange* exchange) {
+    for (guint dst = 0; dst < exchange->nPartitions; dst++) {
+        if (dst == exchange->partition) {
+            continue;
+        }
+
+        /* the workers are idle, so we don't need the outbox lock */
+        GByteArray* messages = exchange->outboxes[dst].messages;
+        PartitionExchangeRing* ring =
+            _partitionexchange_getRing(exchange, exchange->partition, dst);
+
+        gsize written = 0;
+        guint64 nWaits = 0;
+        while (written < messages->len) {
+            gsize n = _partitionexchange_write(
+                ring, &messages->data[written], messages->len - written);
+            written += n;
+            if (n == 0) {
+                /* the ring is full. the destination may itself be blocked writing to
+                 * us, so make room in our rings while we wait for it to drain. */
+                _partitionexchange_drain(exchange);
+                if (++nWaits % PARTITION_EXCHANGE_CHECK_INTERVAL == 0) {
+                    _partitionexchange_checkPartitions(exchange);
+                }
+                sched_yield();
+            }
+        }
+
+        g_byte_array_set_size(messages, 0);
+    }
+}
+
+SimulationTime partitionexchange_finishRound(PartitionExchange* exchange,
+                                             SimulationTime minNextEventTime,
+                                             SimulationTime* minJumpTime) {
+    MAGIC_ASSERT(exchange);
+    utility_assert(minJumpTime != NULL);
+
+    _partitionexchange_flush(exchange);
+
+    PartitionExchangeShared* shared = exchange->shared;
+    guint parity = exchange->round % 2;
+    shared->rounds[parity][exchange->partition] = (PartitionExchangeRound){
+        .minNextEventTime = minNextEventTime,
+        .minJumpTime = *minJumpTime,
+    };
+
+    /* the barrier's release and acquire also publish the values we just wrote */
+    guint32 generation = atomic_load_explicit(&shared->generation, memory_order_acquire);
+    if (atomic_fetch_add_explicit(&shared->nArrived, 1, memory_order_acq_rel) + 1 ==
+        exchange->nPartitions) {
+        /* we were the last to arrive; release the others */
+        atomic_store_explicit(&shared->nArrived, 0, memory_order_relaxed);
+        atomic_store_explicit(&shared->generation, generation + 1, memory_order_release);
+    } else {
+        guint64 nWaits = 0;
+        while (atomic_load_explicit(&shared->generation, memory_order_acquire) == generation) {
+            /* keep draining in case a partition is blocked on a full ring to us */
+            _partitionexchange_drain(exchange);
+            if (++nWaits % PARTITION_EXCHANGE_CHECK_INTERVAL == 0 &&
+                atomic_load_explicit(&shared->generation, memory_order_acquire) == generation) {
+                _partitionexchange_checkPartitions(exchange);
+            }
+            sched_yield();
+        }
+    }
+
+    SimulationTime globalMinNextEventTime = SIMTIME_MAX;
+    SimulationTime globalMinJumpTime = 0;
+    for (guint i = 0; i < exchange->nPartitions; i++) {
+        const PartitionExchangeRound* round = &shared->rounds[parity][i];
+        globalMinNextEventTime = MIN(globalMinNextEventTime, round->minNextEventTime);
+        if (round->minJumpTime > 0 &&
+            (globalMinJumpTime == 0 || round->minJumpTime < globalMinJumpTime)) {
+            globalMinJumpTime = round->minJumpTime;
+        }
+    }
+
+    exchange->round++;
+    *minJumpTime = globalMinJumpTime;
+    return globalMinNextEventTime;
+}
+
+static gint _partitionexchange_compareReceived(gconstpointer a, gconstpointer b) {
+    const PartitionExchangeReceived* ra = a;
+    const PartitionExchangeReceived* rb = b;
+
+    /* packets from the same source host keep the order they were sent in, since the
+     * source partition and offset order them within one source */
+    if (ra->deliverTime != rb->deliverTime) {
+        return ra->deliverTime < rb->deliverTime ? -1 : 1;
+    } else if (ra->dstIP != rb->dstIP) {
+        return ra->dstIP < rb->dstIP ? -1 : 1;
+    } else if (ra->srcIP != rb->srcIP) {
+        return ra->srcIP < rb->srcIP ? -1 : 1;
+    } else if (ra->srcPartition != rb->srcPartition) {
+        return ra->srcPartition < rb->srcPartition ? -1 : 1;
+    } else if (ra->offset != rb->offset) {
+        return ra->offset < rb->offset ? -1 : 1;
+    }
+    return 0;
+}
+
+void partitionexchange_receivePackets(PartitionExchange* exchange, PartitionExchangeReceiveFn fn,
+                                      gpointer userData) {
+    MAGIC_ASSERT(exchange);
+
+    _partitionexchange_drain(exchange);
+
+    /* the rounds that every partition has finished are those before ours */
+    GArray* received = g_array_new(FALSE, FALSE, sizeof(PartitionExchangeReceived));
+    gsize* consumed = g_new0(gsize, exchange->nPartitions);
+
+    for (guint src = 0; src < exchange->nPartitions; src++) {
+        GByteArray* inbox = exchange->inboxes[src];
+        gsize offset = 0;
+        while (offset + sizeof(PartitionExchangeMessage) <= inbox->len) {
+            const PartitionExchangeMessage* message =
+                (const PartitionExchangeMessage*)&inbox->data[offset];
+            utility_assert(offset + message->len <= inbox->len);
+            if (message->round >= exchange->round) {
+                /* a faster partition already sent this during the current round */
+                break;
+            }
+
+            PartitionExchangeReceived r = {
+                .deliverTime = message->deliverTime,
+                .srcIP = message->srcIP,
+                .dstIP = message->dstIP,
+                .srcPartition = src,
+                .offset = offset,
+            };
+            g_array_append_val(received, r);
+            offset += message->len;
+        }
+        consumed[src] = offset;
+    }
+
+    g_array_sort(received, _partitionexchange_compareReceived);
+
+    for (guint i = 0; i < received->len; i++) {
+        const PartitionExchangeReceived* r = &g_array_index(received, PartitionExchangeReceived, i);
+        const PartitionExchangeMessage* message =
+            (const PartitionExchangeMessage*)&exchange->inboxes[r->srcPartition]->data[r->offset];
+        fn(message->deliverTime, message->dstIP, (const guint8*)&message[1], message->packetLen,
+           userData);
+    }
+
+    for (guint src = 0; src < exchange->nPartitions; src++) {
+        if (consumed[src] > 0) {
+            g_byte_array_remove_range(exchange->inboxes[src], 0, consumed[src]);
+        }
+    }
+
+    g_free(consumed);
+    g_array_unref(received);
+}
@@ -0,0 +1,76 @@
+/*
+ * The Shadow Simulator
+ * See LICENSE for licensing information
+ */
+
+#ifndef SHD_PARTITION_EXCHANGE_H_
+#define SHD_PARTITION_EXCHANGE_H_
+
+#include <glib.h>
+#include <netinet/in.h>
+#include <sys/types.h>
+
+#include "main/core/support/definitions.h"
+#include "main/routing/packet.minimal.h"
+
+/*
+ * When `experimental.manager_processes` is greater than 1, the simulation is
+ * split across that many Shadow processes on the same machine, each running a
+ * manager for its partition of the hosts. The processes share a PartitionExchange:
+ * a shared-memory segment with a ring buffer for each ordered pair of partitions,
+ * through which hosts send packets to hosts in other partitions, and the barrier at
+ * which the partitions agree on the next execution window.
+ *
+ * Packets sent to another partition during a round are delivered at the earliest
+ * at the end of the round, and are only handed to the destination manager once
+ * every partition has finished the round.
+ */
+
+#define PARTITION_EXCHANGE_MAX_PARTITIONS 64
+
+/* environment variables that tell a spawned Shadow process which partition it
+ * runs, and the name of the exchange to attach to */
+#define PARTITION_EXCHANGE_ENV_INDEX "SHADOW_PARTITION"
+#define PARTITION_EXCHANGE_ENV_NAME "SHADOW_PARTITION_SHM"
+
+typedef struct _PartitionExchange PartitionExchange;
+
+/* Called for each packet that was received from another partition, in an order that
+ * doesn't depend on thread or process scheduling. `data` holds `len` bytes written by
+ * packet_serialize. */
+typedef void (*PartitionExchangeReceiveFn)(SimulationTime deliverTime, in_addr_t dstIP,
+                                           const guint8* data, gsize len, gpointer userData);
+
+/* Create the exchange for `nPartitions` partitions; the caller runs partition 0. */
+PartitionExchange* partitionexchange_new(guint nPartitions);
+/* Attach to the exchange called `name` as `partition` of `nPartitions`. */
+PartitionExchange* partitionexchange_attach(const gchar* name, guint partition,
+                                            guint nPartitions);
+void partitionexchange_free(PartitionExchange* exchange);
+
+const gchar* partitionexchange_getName(PartitionExchange* exchange);
+guint partitionexchange_getPartition(PartitionExchange* exchange);
+
+/* Record the pid of the process running `partition`, so that the others notice if it
+ * dies instead of waiting for it forever. */
+void partitionexchange_setPid(PartitionExchange* exchange, guint partition, pid_t pid);
+
+/* Queue `packet` for delivery at `deliverTime` to a host in `dstPartition`. May be
+ * called from any worker thread during a round. */
+void partitionexchange_sendPacket(PartitionExchange* exchange, guint dstPartition,
+                                  SimulationTime deliverTime, Packet* packet);
+
+/* Called by the main thread of each partition once its workers finish a round. Sends
+ * the packets queued during the round and waits until every partition has done the
+ * same. Returns the minimum of `minNextEventTime` over all partitions, and replaces
+ * `*minJumpTime` with the minimum over all partitions of its non-zero values. */
+SimulationTime partitionexchange_finishRound(PartitionExchange* exchange,
+                                             SimulationTime minNextEventTime,
+                                             SimulationTime* minJumpTime);
+
+/* Call `fn` for each packet that other partitions sent during the rounds that have
+ * finished. Only call from the main thread, between rounds. */
+void partitionexchange_receivePackets(PartitionExchange* exchange, PartitionExchangeReceiveFn fn,
+                                      gpointer userData);
+
+#endif /* SHD_PARTITION_EXCHANGE_H_ */
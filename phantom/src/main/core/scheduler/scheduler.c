@@ -68,8 +68,10 @@ static void _scheduler_startHostsWorkerTaskFn(void* voidScheduler) {
         if(myHosts) {
             guint nHosts = g_queue_get_length(myHosts);
             info("starting to boot %u hosts", nHosts);
+            GTimer* bootTimer = g_timer_new();
             worker_bootHosts(myHosts);
-            info("%u hosts are booted", nHosts);
+            info("%u hosts are booted in %f seconds", nHosts, g_timer_elapsed(bootTimer, NULL));
+            g_timer_destroy(bootTimer);
         }
     }
 }
@@ -254,6 +256,30 @@ gboolean scheduler_push(Scheduler* scheduler, Event* event, Host* sender, Host*
     return TRUE;
 }
 
+gboolean scheduler_reschedule(Scheduler* scheduler, Event* event, SimulationTime newTime) {
+    MAGIC_ASSERT(scheduler);
+    Host* host = event_getHost(event);
+
+    if(newTime >= scheduler->endTime) {
+        /* it would never run, so it shouldn't occupy the queue either */
+        scheduler_cancel(scheduler, event);
+        return FALSE;
+    }
+
+    if(!scheduler->policy->reschedule(scheduler->policy, event, host, newTime)) {
+        /* the event already left the queue */
+        return FALSE;
+    }
+
+    worker_setMinEventTimeNextRound(newTime);
+    return TRUE;
+}
+
+gboolean scheduler_cancel(Scheduler* scheduler, Event* event) {
+    MAGIC_ASSERT(scheduler);
+    return scheduler->policy->cancel(scheduler->policy, event, event_getHost(event));
+}
+
 void scheduler_addHost(Scheduler* scheduler, Host* host) {
     MAGIC_ASSERT(scheduler);
 
@@ -402,9 +428,12 @@ void scheduler_start(Scheduler* scheduler) {
     scheduler->isRunning = TRUE;
     g_mutex_unlock(&scheduler->globalLock);
 
+    GTimer* bootTimer = g_timer_new();
     workerpool_startTaskFn(scheduler->workerPool,
                            _scheduler_startHostsWorkerTaskFn, scheduler);
     workerpool_awaitTaskFn(scheduler->workerPool);
+    info("all hosts are booted in %f seconds", g_timer_elapsed(bootTimer, NULL));
+    g_timer_destroy(bootTimer);
 }
 
 void scheduler_continueNextRound(Scheduler* scheduler, SimulationTime windowStart, SimulationTime windowEnd) {
@@ -32,6 +32,10 @@ SimulationTime scheduler_awaitNextRound(Scheduler*);
 void scheduler_finish(Scheduler*);
 
 gboolean scheduler_push(Scheduler*, Event*, Host* sender, Host* receiver);
+/* Move a host-local event that is still queued to a new time, or remove it from the queue.
+ * Both return FALSE if the event is no longer queued (e.g. because it already ran). */
+gboolean scheduler_reschedule(Scheduler*, Event*, SimulationTime newTime);
+gboolean scheduler_cancel(Scheduler*, Event*);
 Event* scheduler_pop(Scheduler*);
 
 void scheduler_addHost(Scheduler*, Host*);
@@ -15,6 +15,8 @@ typedef struct _SchedulerPolicy SchedulerPolicy;
 typedef void (*SchedulerPolicyAddHostFunc)(SchedulerPolicy*, Host*, pthread_t);
 typedef GQueue* (*SchedulerPolicyGetHostsFunc)(SchedulerPolicy*);
 typedef void (*SchedulerPolicyPushFunc)(SchedulerPolicy*, Event*, Host*, Host*, SimulationTime);
+typedef gboolean (*SchedulerPolicyRescheduleFunc)(SchedulerPolicy*, Event*, Host*, SimulationTime);
+typedef gboolean (*SchedulerPolicyCancelFunc)(SchedulerPolicy*, Event*, Host*);
 typedef Event* (*SchedulerPolicyPopFunc)(SchedulerPolicy*, SimulationTime);
 typedef SimulationTime (*SchedulerPolicyGetNextTimeFunc)(SchedulerPolicy*);
 typedef void (*SchedulerPolicyFreeFunc)(SchedulerPolicy*);
@@ -26,6 +28,9 @@ struct _SchedulerPolicy {
     SchedulerPolicyAddHostFunc addHost;
     SchedulerPolicyGetHostsFunc getAssignedHosts;
     SchedulerPolicyPushFunc push;
+    /* move or remove a queued host-local event (one whose src and dst host are the same) */
+    SchedulerPolicyRescheduleFunc reschedule;
+    SchedulerPolicyCancelFunc cancel;
     SchedulerPolicyPopFunc pop;
     SchedulerPolicyGetNextTimeFunc getNextTime;
     SchedulerPolicyFreeFunc free;
@@ -219,6 +219,45 @@ static void _schedulerpolicyhostsingle_push(SchedulerPolicy* policy, Event* even
     g_mutex_unlock(&(qdata->lock));
 }
 
+static gboolean _schedulerpolicyhostsingle_reschedule(SchedulerPolicy* policy, Event* event, Host* host, SimulationTime newTime) {
+    MAGIC_ASSERT(policy);
+    HostSinglePolicyData* data = policy->data;
+
+    /* host-local events always live in the host's own queue */
+    HostSingleQueueData* qdata = g_hash_table_lookup(data->hostToQueueDataMap, host);
+    utility_assert(qdata);
+
+    g_mutex_lock(&(qdata->lock));
+    gboolean isQueued = priorityqueue_find(qdata->pq, event) != NULL;
+    if(isQueued) {
+        /* pushing an event that is already in the queue restores heap order in place */
+        event_setTime(event, newTime);
+        priorityqueue_push(qdata->pq, event);
+    }
+    g_mutex_unlock(&(qdata->lock));
+
+    return isQueued;
+}
+
+static gboolean _schedulerpolicyhostsingle_cancel(SchedulerPolicy* policy, Event* event, Host* host) {
+    MAGIC_ASSERT(policy);
+    HostSinglePolicyData* data = policy->data;
+
+    /* host-local events always live in the host's own queue */
+    HostSingleQueueData* qdata = g_hash_table_lookup(data->hostToQueueDataMap, host);
+    utility_assert(qdata);
+
+    g_mutex_lock(&(qdata->lock));
+    gboolean isQueued = priorityqueue_remove(qdata->pq, event);
+    g_mutex_unlock(&(qdata->lock));
+
+    if(isQueued) {
+        /* drop the reference that the queue held */
+        event_unref(event);
+    }
+    return isQueued;
+}
+
 static Event* _schedulerpolicyhostsingle_pop(SchedulerPolicy* policy, SimulationTime barrier) {
     MAGIC_ASSERT(policy);
     HostSinglePolicyData* data = policy->data;
@@ -344,6 +383,8 @@ SchedulerPolicy* schedulerpolicyhostsingle_new() {
     policy->addHost = _schedulerpolicyhostsingle_addHost;
     policy->getAssignedHosts = _schedulerpolicyhostsingle_getHosts;
     policy->push = _schedulerpolicyhostsingle_push;
+    policy->reschedule = _schedulerpolicyhostsingle_reschedule;
+    policy->cancel = _schedulerpolicyhostsingle_cancel;
     policy->pop = _schedulerpolicyhostsingle_pop;
     policy->getNextTime = _schedulerpolicyhostsingle_getNextTime;
     policy->free = _schedulerpolicyhostsingle_free;
@@ -293,6 +293,49 @@ static void _schedulerpolicyhoststeal_push(SchedulerPolicy* policy, Event* event
     }
 }
 
+static gboolean _schedulerpolicyhoststeal_reschedule(SchedulerPolicy* policy, Event* event, Host* host, SimulationTime newTime) {
+    MAGIC_ASSERT(policy);
+    HostStealPolicyData* data = policy->data;
+
+    /* host-local events always live in the host's own queue */
+    g_rw_lock_reader_lock(&data->lock);
+    HostStealQueueData* qdata = g_hash_table_lookup(data->hostToQueueDataMap, host);
+    g_rw_lock_reader_unlock(&data->lock);
+    utility_assert(qdata);
+
+    g_mutex_lock(&(qdata->lock));
+    gboolean isQueued = priorityqueue_find(qdata->pq, event) != NULL;
+    if(isQueued) {
+        /* pushing an event that is already in the queue restores heap order in place */
+        event_setTime(event, newTime);
+        priorityqueue_push(qdata->pq, event);
+    }
+    g_mutex_unlock(&(qdata->lock));
+
+    return isQueued;
+}
+
+static gboolean _schedulerpolicyhoststeal_cancel(SchedulerPolicy* policy, Event* event, Host* host) {
+    MAGIC_ASSERT(policy);
+    HostStealPolicyData* data = policy->data;
+
+    /* host-local events always live in the host's own queue */
+    g_rw_lock_reader_lock(&data->lock);
+    HostStealQueueData* qdata = g_hash_table_lookup(data->hostToQueueDataMap, host);
+    g_rw_lock_reader_unlock(&data->lock);
+    utility_assert(qdata);
+
+    g_mutex_lock(&(qdata->lock));
+    gboolean isQueued = priorityqueue_remove(qdata->pq, event);
+    g_mutex_unlock(&(qdata->lock));
+
+    if(isQueued) {
+        /* drop the reference that the queue held */
+        event_unref(event);
+    }
+    return isQueued;
+}
+
 static Event* _schedulerpolicyhoststeal_popFromThread(SchedulerPolicy* policy, HostStealThreadData* tdata, GQueue* assignedHosts, SimulationTime barrier) {
     /* if there is no tdata, that means this thread didn't get any hosts assigned to it */
     if(!tdata) {
@@ -550,6 +593,8 @@ SchedulerPolicy* schedulerpolicyhoststeal_new() {
     policy->addHost = _schedulerpolicyhoststeal_addHost;
     policy->getAssignedHosts = _schedulerpolicyhoststeal_getHosts;
     policy->push = _schedulerpolicyhoststeal_push;
+    policy->reschedule = _schedulerpolicyhoststeal_reschedule;
+    policy->cancel = _schedulerpolicyhoststeal_cancel;
     policy->pop = _schedulerpolicyhoststeal_pop;
     policy->getNextTime = _schedulerpolicyhoststeal_getNextTime;
     policy->free = _schedulerpolicyhoststeal_free;
@@ -155,6 +155,43 @@ static void _schedulerpolicythreadperhost_push(SchedulerPolicy* policy, Event* e
     }
 }
 
+static gboolean _schedulerpolicythreadperhost_reschedule(SchedulerPolicy* policy, Event* event, Host* host, SimulationTime newTime) {
+    MAGIC_ASSERT(policy);
+    ThreadPerHostPolicyData* data = policy->data;
+
+    /* host-local events are pushed directly to the main queue of the host's thread, which
+     * is the thread calling us, so no locking is needed */
+    pthread_t dstThread = (pthread_t)GPOINTER_TO_UINT(g_hash_table_lookup(data->hostToThreadMap, host));
+    ThreadPerHostThreadData* tdata = g_hash_table_lookup(data->threadToThreadDataMap, GUINT_TO_POINTER(dstThread));
+    utility_assert(tdata);
+
+    gboolean isQueued = priorityqueue_find(tdata->qdata->pq, event) != NULL;
+    if(isQueued) {
+        /* pushing an event that is already in the queue restores heap order in place */
+        event_setTime(event, newTime);
+        priorityqueue_push(tdata->qdata->pq, event);
+    }
+    return isQueued;
+}
+
+static gboolean _schedulerpolicythreadperhost_cancel(SchedulerPolicy* policy, Event* event, Host* host) {
+    MAGIC_ASSERT(policy);
+    ThreadPerHostPolicyData* data = policy->data;
+
+    /* host-local events are pushed directly to the main queue of the host's thread, which
+     * is the thread calling us, so no locking is needed */
+    pthread_t dstThread = (pthread_t)GPOINTER_TO_UINT(g_hash_table_lookup(data->hostToThreadMap, host));
+    ThreadPerHostThreadData* tdata = g_hash_table_lookup(data->threadToThreadDataMap, GUINT_TO_POINTER(dstThread));
+    utility_assert(tdata);
+
+    gboolean isQueued = priorityqueue_remove(tdata->qdata->pq, event);
+    if(isQueued) {
+        /* drop the reference that the queue held */
+        event_unref(event);
+    }
+    return isQueued;
+}
+
 static Event* _schedulerpolicythreadperhost_pop(SchedulerPolicy* policy, SimulationTime barrier) {
     MAGIC_ASSERT(policy);
     ThreadPerHostPolicyData* data = policy->data;
@@ -246,6 +283,8 @@ SchedulerPolicy* schedulerpolicythreadperhost_new() {
     policy->addHost = _schedulerpolicythreadperhost_addHost;
     policy->getAssignedHosts = _schedulerpolicythreadperhost_getHosts;
     policy->push = _schedulerpolicythreadperhost_push;
+    policy->reschedule = _schedulerpolicythreadperhost_reschedule;
+    policy->cancel = _schedulerpolicythreadperhost_cancel;
     policy->pop = _schedulerpolicythreadperhost_pop;
     policy->getNextTime = _schedulerpolicythreadperhost_getNextTime;
     policy->free = _schedulerpolicythreadperhost_free;
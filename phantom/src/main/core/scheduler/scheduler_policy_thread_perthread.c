@@ -155,6 +155,43 @@ static void _schedulerpolicythreadperthread_push(SchedulerPolicy* policy, Event*
     }
 }
 
+static gboolean _schedulerpolicythreadperthread_reschedule(SchedulerPolicy* policy, Event* event, Host* host, SimulationTime newTime) {
+    MAGIC_ASSERT(policy);
+    ThreadPerThreadPolicyData* data = policy->data;
+
+    /* host-local events are pushed directly to the main queue of the host's thread, which
+     * is the thread calling us, so no locking is needed */
+    pthread_t dstThread = GPOINTER_TO_UINT(g_hash_table_lookup(data->hostToThreadMap, host));
+    ThreadPerThreadThreadData* tdata = g_hash_table_lookup(data->threadToThreadDataMap, GUINT_TO_POINTER(dstThread));
+    utility_assert(tdata);
+
+    gboolean isQueued = priorityqueue_find(tdata->qdata->pq, event) != NULL;
+    if(isQueued) {
+        /* pushing an event that is already in the queue restores heap order in place */
+        event_setTime(event, newTime);
+        priorityqueue_push(tdata->qdata->pq, event);
+    }
+    return isQueued;
+}
+
+static gboolean _schedulerpolicythreadperthread_cancel(SchedulerPolicy* policy, Event* event, Host* host) {
+    MAGIC_ASSERT(policy);
+    ThreadPerThreadPolicyData* data = policy->data;
+
+    /* host-local events are pushed directly to the main queue of the host's thread, which
+     * is the thread calling us, so no locking is needed */
+    pthread_t dstThread = GPOINTER_TO_UINT(g_hash_table_lookup(data->hostToThreadMap, host));
+    ThreadPerThreadThreadData* tdata = g_hash_table_lookup(data->threadToThreadDataMap, GUINT_TO_POINTER(dstThread));
+    utility_assert(tdata);
+
+    gboolean isQueued = priorityqueue_remove(tdata->qdata->pq, event);
+    if(isQueued) {
+        /* drop the reference that the queue held */
+        event_unref(event);
+    }
+    return isQueued;
+}
+
 static Event* _schedulerpolicythreadperthread_pop(SchedulerPolicy* policy, SimulationTime barrier) {
     MAGIC_ASSERT(policy);
     ThreadPerThreadPolicyData* data = policy->data;
@@ -247,6 +284,8 @@ SchedulerPolicy* schedulerpolicythreadperthread_new() {
     policy->addHost = _schedulerpolicythreadperthread_addHost;
     policy->getAssignedHosts = _schedulerpolicythreadperthread_getHosts;
     policy->push = _schedulerpolicythreadperthread_push;
+    policy->reschedule = _schedulerpolicythreadperthread_reschedule;
+    policy->cancel = _schedulerpolicythreadperthread_cancel;
     policy->pop = _schedulerpolicythreadperthread_pop;
     policy->getNextTime = _schedulerpolicythreadperthread_getNextTime;
     policy->free = _schedulerpolicythreadperthread_free;
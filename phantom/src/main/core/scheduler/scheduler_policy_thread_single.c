@@ -108,6 +108,45 @@ static void _schedulerpolicythreadsingle_push(SchedulerPolicy* policy, Event* ev
     g_mutex_unlock(&(tdata->lock));
 }
 
+static gboolean _schedulerpolicythreadsingle_reschedule(SchedulerPolicy* policy, Event* event, Host* host, SimulationTime newTime) {
+    MAGIC_ASSERT(policy);
+    ThreadSinglePolicyData* data = policy->data;
+
+    pthread_t dstThread = GPOINTER_TO_UINT(g_hash_table_lookup(data->hostToThreadMap, host));
+    ThreadSingleThreadData* tdata = g_hash_table_lookup(data->threadToThreadDataMap, GUINT_TO_POINTER(dstThread));
+    utility_assert(tdata);
+
+    g_mutex_lock(&(tdata->lock));
+    gboolean isQueued = priorityqueue_find(tdata->pq, event) != NULL;
+    if(isQueued) {
+        /* pushing an event that is already in the queue restores heap order in place */
+        event_setTime(event, newTime);
+        priorityqueue_push(tdata->pq, event);
+    }
+    g_mutex_unlock(&(tdata->lock));
+
+    return isQueued;
+}
+
+static gboolean _schedulerpolicythreadsingle_cancel(SchedulerPolicy* policy, Event* event, Host* host) {
+    MAGIC_ASSERT(policy);
+    ThreadSinglePolicyData* data = policy->data;
+
+    pthread_t dstThread = GPOINTER_TO_UINT(g_hash_table_lookup(data->hostToThreadMap, host));
+    ThreadSingleThreadData* tdata = g_hash_table_lookup(data->threadToThreadDataMap, GUINT_TO_POINTER(dstThread));
+    utility_assert(tdata);
+
+    g_mutex_lock(&(tdata->lock));
+    gboolean isQueued = priorityqueue_remove(tdata->pq, event);
+    g_mutex_unlock(&(tdata->lock));
+
+    if(isQueued) {
+        /* drop the reference that the queue held */
+        event_unref(event);
+    }
+    return isQueued;
+}
+
 static Event* _schedulerpolicythreadsingle_pop(SchedulerPolicy* policy, SimulationTime barrier) {
     MAGIC_ASSERT(policy);
     ThreadSinglePolicyData* data = policy->data;
@@ -181,6 +220,8 @@ SchedulerPolicy* schedulerpolicythreadsingle_new() {
     policy->addHost = _schedulerpolicythreadsingle_addHost;
     policy->getAssignedHosts = _schedulerpolicythreadsingle_getHosts;
     policy->push = _schedulerpolicythreadsingle_push;
+    policy->reschedule = _schedulerpolicythreadsingle_reschedule;
+    policy->cancel = _schedulerpolicythreadsingle_cancel;
     policy->pop = _schedulerpolicythreadsingle_pop;
     policy->getNextTime = _schedulerpolicythreadsingle_getNextTime;
     policy->free = _schedulerpolicythreadsingle_free;
@@ -250,6 +250,58 @@ pub struct ExperimentalOptions {
     #[clap(about = EXP_HELP.get("use_seccomp").unwrap())]
     use_seccomp: Option<bool>,
 
+    /// Rewrite syscall instructions that trap into the seccomp handler so that later calls from
+    /// the same site skip the signal. Only has an effect when seccomp is used.
+    #[clap(long, value_name = "bool")]
+    #[clap(about = EXP_HELP.get("use_syscall_rewriting").unwrap())]
+    use_syscall_rewriting: Option<bool>,
+
+    /// Rewrite rdtsc and rdtscp instructions that trap into the shim so that later executions
+    /// skip the signal. Unsafe if the managed code branches to one of the few instructions
+    /// following an rdtsc.
+    #[clap(long, value_name = "bool")]
+    #[clap(about = EXP_HELP.get("use_rdtsc_rewriting").unwrap())]
+    use_rdtsc_rewriting: Option<bool>,
+
+    /// In ptrace mode, service syscalls made through the shim over the same shared-memory channel
+    /// that preload mode uses, and only fall back to ptrace for syscalls the shim doesn't see
+    #[clap(long, value_name = "bool")]
+    #[clap(about = EXP_HELP.get("use_ptrace_ipc").unwrap())]
+    use_ptrace_ipc: Option<bool>,
+
+    /// Start each managed process by forking it from a zygote process that has already loaded
+    /// and initialized the same binary, rather than executing it from scratch. Only has an
+    /// effect in preload mode.
+    #[clap(long, value_name = "bool")]
+    #[clap(about = EXP_HELP.get("use_zygote").unwrap())]
+    use_zygote: Option<bool>,
+
+    /// Start each host's managed processes while the host boots, rather than at the processes'
+    /// start times, so that loading them overlaps with booting other hosts and running the
+    /// simulation. Only has an effect in preload mode.
+    #[clap(long, value_name = "bool")]
+    #[clap(about = EXP_HELP.get("use_process_prespawn").unwrap())]
+    use_process_prespawn: Option<bool>,
+
+    /// Write log records in a compact binary format, formatting their messages later with
+    /// src/tools/decode_binary_log.py rather than while the simulation runs
+    #[clap(long, value_name = "bool")]
+    #[clap(about = EXP_HELP.get("use_binary_log").unwrap())]
+    use_binary_log: Option<bool>,
+
+    /// Write host heartbeats as binary rows to a file per worker thread in the data directory,
+    /// rather than logging them; convert them with src/tools/convert_heartbeats.py
+    #[clap(long, value_name = "bool")]
+    #[clap(about = EXP_HELP.get("use_binary_heartbeats").unwrap())]
+    use_binary_heartbeats: Option<bool>,
+
+    /// Advise the kernel to back Shadow's shared memory, and the plugin memory that the memory
+    /// manager maps into Shadow, with transparent huge pages. Only has an effect if /dev/shm
+    /// is mounted with huge pages allowed
+    #[clap(long, value_name = "bool")]
+    #[clap(about = EXP_HELP.get("use_shmem_huge_pages").unwrap())]
+    use_shmem_huge_pages: Option<bool>,
+
     /// Count the number of occurrences for individual syscalls
     #[clap(long, value_name = "bool")]
     #[clap(about = EXP_HELP.get("use_syscall_counters").unwrap())]
@@ -270,12 +322,31 @@ pub struct ExperimentalOptions {
     #[clap(about = EXP_HELP.get("preload_spin_max").unwrap())]
     preload_spin_max: Option<i32>,
 
+    /// Number of MemoryManager misses on a private read-write region before it's remapped into
+    /// shared memory (0 to disable)
+    #[clap(long, value_name = "misses")]
+    #[clap(about = EXP_HELP.get("memory_manager_remap_threshold").unwrap())]
+    memory_manager_remap_threshold: Option<u32>,
+
+    /// Number of Shadow processes to split the hosts between. Each process runs its own
+    /// manager and workers for its share of the hosts, and packets between processes are
+    /// exchanged through shared memory at the end of each round
+    #[clap(long, value_name = "processes")]
+    #[clap(about = EXP_HELP.get("manager_processes").unwrap())]
+    manager_processes: Option<u32>,
+
     /// Use the MemoryManager. It can be useful to disable for debugging, but will hurt performance in
     /// most cases
     #[clap(long, value_name = "bool")]
     #[clap(about = EXP_HELP.get("use_memory_manager").unwrap())]
     use_memory_manager: Option<bool>,
 
+    /// Open regular files under a host's data directory natively in the plugin, so that I/O on
+    /// them runs as native syscalls instead of being emulated
+    #[clap(long, value_name = "bool")]
+    #[clap(about = EXP_HELP.get("use_native_private_files").unwrap())]
+    use_native_private_files: Option<bool>,
+
     /// Use shim-side syscall handler to force hot-path syscalls to be handled via an inter-process syscall with Shadow
     #[clap(long, value_name = "bool")]
     #[clap(about = EXP_HELP.get("use_shim_syscall_handler").unwrap())]
@@ -360,11 +431,22 @@ impl Default for ExperimentalOptions {
             use_o_n_waitpid_workarounds: Some(false),
             use_explicit_block_message: Some(false),
             use_seccomp: None,
+            use_syscall_rewriting: Some(false),
+            use_rdtsc_rewriting: Some(false),
+            use_ptrace_ipc: Some(false),
+            use_zygote: Some(false),
+            use_process_prespawn: Some(false),
+            use_binary_log: Some(false),
+            use_binary_heartbeats: Some(false),
+            use_shmem_huge_pages: Some(false),
             use_syscall_counters: Some(false),
             use_object_counters: Some(true),
             use_openssl_rng_preload: Some(true),
             preload_spin_max: Some(0),
+            memory_manager_remap_threshold: Some(0),
+            manager_processes: Some(1),
             use_memory_manager: Some(true),
+            use_native_private_files: Some(false),
             use_shim_syscall_handler: Some(true),
             use_cpu_pinning: Some(true),
             interpose_method: Some(InterposeMethod::Ptrace),
@@ -421,6 +503,16 @@ pub struct HostDefaultOptions {
     #[clap(about = HOST_HELP.get("pcap_directory").unwrap())]
     pcap_directory: Option<String>,
 
+    /// How many bytes of each packet to save in the pcap files; unset saves whole packets
+    #[clap(long, value_name = "bytes")]
+    #[clap(about = HOST_HELP.get("pcap_capture_size").unwrap())]
+    pcap_capture_size: Option<units::Bytes<units::SiPrefixUpper>>,
+
+    /// File format of the pcap files
+    #[clap(long, value_name = "format")]
+    #[clap(about = HOST_HELP.get("pcap_format").unwrap())]
+    pcap_format: Option<PcapFormat>,
+
     /// IPv4 address hint for Shadow's name and routing system (ex: "100.0.0.1")
     #[clap(long, value_name = "ip")]
     #[clap(about = HOST_HELP.get("ip_address_hint").unwrap())]
@@ -445,6 +537,8 @@ impl HostDefaultOptions {
             heartbeat_log_info: None,
             heartbeat_interval: None,
             pcap_directory: None,
+            pcap_capture_size: None,
+            pcap_format: None,
             ip_address_hint: None,
             country_code_hint: None,
             city_code_hint: None,
@@ -466,6 +560,8 @@ impl Default for HostDefaultOptions {
             heartbeat_log_info: Some(std::array::IntoIter::new([LogInfoFlag::Node]).collect()),
             heartbeat_interval: Some(units::Time::new(1, units::TimePrefixUpper::Sec)),
             pcap_directory: None,
+            pcap_capture_size: None,
+            pcap_format: Some(PcapFormat::Pcap),
             ip_address_hint: None,
             country_code_hint: None,
             city_code_hint: None,
@@ -655,6 +751,21 @@ impl std::str::FromStr for QDiscMode {
     }
 }
 
+#[derive(Debug, Clone, Copy, Hash, PartialEq, Eq, ArgEnum, Serialize, Deserialize, JsonSchema)]
+#[serde(rename_all = "lowercase")]
+pub enum PcapFormat {
+    Pcap,
+    PcapNg,
+}
+
+impl std::str::FromStr for PcapFormat {
+    type Err = serde_yaml::Error;
+
+    fn from_str(s: &str) -> Result<Self, Self::Err> {
+        serde_yaml::from_str(s)
+    }
+}
+
 #[derive(Debug, Clone, Serialize, Deserialize, JsonSchema)]
 #[serde(rename_all = "lowercase")]
 enum CustomGraph {
@@ -1143,6 +1254,62 @@ mod export {
         }
     }
 
+    #[no_mangle]
+    pub extern "C" fn config_getUseSyscallRewriting(config: *const ConfigOptions) -> bool {
+        assert!(!config.is_null());
+        let config = unsafe { &*config };
+        config.experimental.use_syscall_rewriting.unwrap()
+    }
+
+    #[no_mangle]
+    pub extern "C" fn config_getUseRdtscRewriting(config: *const ConfigOptions) -> bool {
+        assert!(!config.is_null());
+        let config = unsafe { &*config };
+        config.experimental.use_rdtsc_rewriting.unwrap()
+    }
+
+    #[no_mangle]
+    pub extern "C" fn config_getUsePtraceIpc(config: *const ConfigOptions) -> bool {
+        assert!(!config.is_null());
+        let config = unsafe { &*config };
+        config.experimental.use_ptrace_ipc.unwrap()
+    }
+
+    #[no_mangle]
+    pub extern "C" fn config_getUseZygote(config: *const ConfigOptions) -> bool {
+        assert!(!config.is_null());
+        let config = unsafe { &*config };
+        config.experimental.use_zygote.unwrap()
+    }
+
+    #[no_mangle]
+    pub extern "C" fn config_getUseProcessPrespawn(config: *const ConfigOptions) -> bool {
+        assert!(!config.is_null());
+        let config = unsafe { &*config };
+        config.experimental.use_process_prespawn.unwrap()
+    }
+
+    #[no_mangle]
+    pub extern "C" fn config_getUseBinaryLog(config: *const ConfigOptions) -> bool {
+        assert!(!config.is_null());
+        let config = unsafe { &*config };
+        config.experimental.use_binary_log.unwrap()
+    }
+
+    #[no_mangle]
+    pub extern "C" fn config_getUseBinaryHeartbeats(config: *const ConfigOptions) -> bool {
+        assert!(!config.is_null());
+        let config = unsafe { &*config };
+        config.experimental.use_binary_heartbeats.unwrap()
+    }
+
+    #[no_mangle]
+    pub extern "C" fn config_getUseShmemHugePages(config: *const ConfigOptions) -> bool {
+        assert!(!config.is_null());
+        let config = unsafe { &*config };
+        config.experimental.use_shmem_huge_pages.unwrap()
+    }
+
     #[no_mangle]
     pub extern "C" fn config_getUseSyscallCounters(config: *const ConfigOptions) -> bool {
         assert!(!config.is_null());
@@ -1171,6 +1338,27 @@ mod export {
         config.experimental.use_memory_manager.unwrap()
     }
 
+    #[no_mangle]
+    pub extern "C" fn config_getMemoryManagerRemapThreshold(config: *const ConfigOptions) -> u32 {
+        assert!(!config.is_null());
+        let config = unsafe { &*config };
+        config.experimental.memory_manager_remap_threshold.unwrap()
+    }
+
+    #[no_mangle]
+    pub extern "C" fn config_getManagerProcesses(config: *const ConfigOptions) -> u32 {
+        assert!(!config.is_null());
+        let config = unsafe { &*config };
+        config.experimental.manager_processes.unwrap()
+    }
+
+    #[no_mangle]
+    pub extern "C" fn config_getUseNativePrivateFiles(config: *const ConfigOptions) -> bool {
+        assert!(!config.is_null());
+        let config = unsafe { &*config };
+        config.experimental.use_native_private_files.unwrap()
+    }
+
     #[no_mangle]
     pub extern "C" fn config_getUseShimSyscallHandler(config: *const ConfigOptions) -> bool {
         assert!(!config.is_null());
@@ -1494,6 +1682,29 @@ mod export {
         }
     }
 
+    #[no_mangle]
+    pub extern "C" fn hostoptions_getPcapCaptureSize(host: *const HostOptions) -> u32 {
+        assert!(!host.is_null());
+        let host = unsafe { &*host };
+
+        match host.options.pcap_capture_size {
+            Some(size) => {
+                let size = size.convert(units::SiPrefixUpper::Base).unwrap().value();
+                std::cmp::min(size, u32::MAX as u64) as u32
+            }
+            // zero means that we store whole packets
+            None => 0,
+        }
+    }
+
+    #[no_mangle]
+    pub extern "C" fn hostoptions_getPcapUseNg(host: *const HostOptions) -> bool {
+        assert!(!host.is_null());
+        let host = unsafe { &*host };
+
+        host.options.pcap_format == Some(PcapFormat::PcapNg)
+    }
+
     #[no_mangle]
     pub extern "C" fn hostoptions_getIpAddressHint(host: *const HostOptions) -> *mut libc::c_char {
         assert!(!host.is_null());
@@ -78,8 +78,13 @@ void event_execute(Event* event) {
         /* track the event delay time */
         tracker_addVirtualProcessingDelay(host_getTracker(event->dstHost), cpuDelay);
 
-        /* this event is delayed due to cpu, so reschedule it to ourselves */
-        worker_scheduleTask(event->task, event->dstHost, cpuDelay);
+        /* this event is delayed due to cpu, so reschedule it to ourselves. we requeue this
+         * same event instead of a copy so that handles to it stay valid while it waits. */
+        event->srcHost = event->dstHost;
+        event->srcHostEventID = host_getNewEventID(event->dstHost);
+        event->time += cpuDelay;
+        event_ref(event);
+        worker_requeueEvent(event, event->dstHost);
     } else {
         /* cpu is not blocked, its ok to execute the event */
         host_continueExecutionTimer(event->dstHost);
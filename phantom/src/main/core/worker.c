@@ -14,6 +14,7 @@
 #include <pthread.h>
 #include <semaphore.h>
 #include <stddef.h>
+#include <string.h>
 #include <sys/syscall.h>
 #include <sys/types.h>
 
@@ -29,9 +30,11 @@
 #include "main/host/affinity.h"
 #include "main/host/host.h"
 #include "main/host/process.h"
+#include "main/host/tracker_output.h"
 #include "main/routing/address.h"
 #include "main/routing/dns.h"
 #include "main/routing/packet.h"
+#include "main/routing/path.h"
 #include "main/routing/router.h"
 #include "main/routing/topology.h"
 #include "main/utility/count_down_latch.h"
@@ -46,6 +49,24 @@ static void* _worker_run(void* voidWorker);
 static void _worker_freeHostProcesses(Host* host, void* _unused);
 static void _worker_shutdownHost(Host* host, void* _unused);
 static void _workerpool_setLogicalProcessorIdx(WorkerPool* workerpool, int workerID, int cpuId);
+static void _worker_closePacketBatch();
+
+/* Packets that a source host sends at the same instant to the same destination address,
+ * and that will arrive at the same time, are delivered together in one event. A worker only
+ * runs one host at a time, so it only needs to remember the last delivery it scheduled. The
+ * event cannot run before the next round, so we can keep appending to it during this one. */
+typedef struct _WorkerPacketBatch WorkerPacketBatch;
+struct _WorkerPacketBatch {
+    Host* srcHost;
+    Host* dstHost;
+    in_addr_t dstIP;
+    SimulationTime sendTime;
+    SimulationTime deliverTime;
+    /* the packets carried by the scheduled delivery event; we hold an extra ref */
+    GPtrArray* packets;
+};
+
+static __thread WorkerPacketBatch _worker_packetBatch = {0};
 
 struct _WorkerPool {
     /* Unowned pointer to the object that communicates with the controller
@@ -186,10 +207,7 @@ WorkerPool* workerpool_new(Manager* manager, Scheduler* scheduler, int nWorkers,
 
 // Find and return a Worker to run the current or next task on `toLpi`. Prefers
 // a Worker that last ran on `toLpi`, but if none is available will take one
-// from another logical processor.
-//
-// TODO: Take locality into account when finding another LogicalProcessor to
-// migrate from, when needed.
+// from another logical processor, preferring those on the same NUMA node.
 static int _workerpool_getNextWorkerForLogicalProcessorIdx(WorkerPool* pool, int toLpi) {
     int nextWorker = lps_popWorkerToRunOn(pool->logicalProcessors, toLpi);
     if (nextWorker >= 0) {
@@ -386,6 +404,10 @@ ChildPidWatcher* worker_getChildPidWatcher() {
 
 const ConfigOptions* worker_getConfig() { return manager_getConfig(_worker_pool()->manager); }
 
+const gchar* worker_getDataPath() { return manager_getDataPath(_worker_pool()->manager); }
+
+guint worker_getPartition() { return manager_getPartition(_worker_pool()->manager); }
+
 /* this is the entry point for worker threads when running in parallel mode,
  * and otherwise is the main event loop when running in serial mode */
 void* _worker_run(void* voidWorkerThreadInfo) {
@@ -475,6 +497,8 @@ void worker_runEvent(Event* event) {
 }
 
 void worker_finish(GQueue* hosts) {
+    _worker_closePacketBatch();
+
     if (hosts) {
         guint nHosts = g_queue_get_length(hosts);
         info("starting to shut down %u hosts", nHosts);
@@ -483,6 +507,8 @@ void worker_finish(GQueue* hosts) {
         info("%u hosts are shut down", nHosts);
     }
 
+    trackeroutput_closeForThisThread();
+
     /* cleanup is all done, send counters to manager */
     WorkerPool* pool = _worker_pool();
 
@@ -492,87 +518,238 @@ void worker_finish(GQueue* hosts) {
 
     // Send syscall counts to manager
     manager_add_syscall_counts(pool->manager, _worker_syscallCounter());
+
+    // Send MemoryManager access counts to manager
+    manager_add_memory_manager_counts(pool->manager, _worker_memoryManagerCounter());
 }
 
-gboolean worker_scheduleTask(Task* task, Host* host, SimulationTime nanoDelay) {
+Event* worker_scheduleTaskWithHandle(Task* task, Host* host, SimulationTime nanoDelay) {
     utility_assert(task);
     utility_assert(host);
 
     if (!manager_schedulerIsRunning(_worker_pool()->manager)) {
-        return FALSE;
+        return NULL;
     }
 
     SimulationTime clock_now = worker_getCurrentTime();
     utility_assert(clock_now != SIMTIME_INVALID);
 
     Event* event = event_new_(task, clock_now + nanoDelay, host, host);
+    if (!scheduler_push(_worker_pool()->scheduler, event, host, host)) {
+        /* the scheduler already dropped the event */
+        return NULL;
+    }
+
+    /* the queue owns the event; the handle is borrowed until the task runs */
+    return event;
+}
+
+gboolean worker_scheduleTask(Task* task, Host* host, SimulationTime nanoDelay) {
+    return worker_scheduleTaskWithHandle(task, host, nanoDelay) != NULL;
+}
+
+gboolean worker_rescheduleTask(Event* handle, SimulationTime nanoDelay) {
+    utility_assert(handle);
+
+    if (!manager_schedulerIsRunning(_worker_pool()->manager)) {
+        return FALSE;
+    }
+
+    SimulationTime clock_now = worker_getCurrentTime();
+    utility_assert(clock_now != SIMTIME_INVALID);
+
+    return scheduler_reschedule(_worker_pool()->scheduler, handle, clock_now + nanoDelay);
+}
+
+gboolean worker_cancelTask(Event* handle) {
+    utility_assert(handle);
+
+    if (!manager_schedulerIsRunning(_worker_pool()->manager)) {
+        return FALSE;
+    }
+
+    return scheduler_cancel(_worker_pool()->scheduler, handle);
+}
+
+gboolean worker_requeueEvent(Event* event, Host* host) {
+    utility_assert(event);
+    utility_assert(host);
+
+    if (!manager_schedulerIsRunning(_worker_pool()->manager)) {
+        event_unref(event);
+        return FALSE;
+    }
+
     return scheduler_push(_worker_pool()->scheduler, event, host, host);
 }
 
-static void _worker_runDeliverPacketTask(Host* host, gpointer voidPacket, gpointer userData) {
-    Packet* packet = voidPacket;
-    in_addr_t ip = packet_getDestinationIP(packet);
+static void _worker_runDeliverPacketTask(Host* host, gpointer voidPackets, gpointer userData) {
+    GPtrArray* packets = voidPackets;
+    utility_assert(packets->len > 0);
+
+    /* all packets in the batch have the same destination ip */
+    in_addr_t ip = packet_getDestinationIP(g_ptr_array_index(packets, 0));
     Router* router = host_getUpstreamRouter(host, ip);
     utility_assert(router != NULL);
-    router_enqueue(router, host, packet);
+
+    if(packets->len == 1) {
+        router_enqueue(router, host, g_ptr_array_index(packets, 0));
+    } else {
+        router_enqueueBatch(router, host, packets);
+    }
 }
 
-void worker_sendPacket(Host* srcHost, Packet* packet) {
-    utility_assert(packet != NULL);
+Task* worker_newDeliverPacketsTask(GPtrArray* packets) {
+    return task_new(_worker_runDeliverPacketTask, packets, NULL,
+                    (TaskObjectFreeFunc)g_ptr_array_unref, NULL);
+}
+
+static void _worker_closePacketBatch() {
+    if(_worker_packetBatch.packets) {
+        g_ptr_array_unref(_worker_packetBatch.packets);
+    }
+    memset(&_worker_packetBatch, 0, sizeof(WorkerPacketBatch));
+}
+
+/* returns the still-open delivery batch that a packet with these properties can join */
+static GPtrArray* _worker_getOpenPacketBatch(Host* srcHost, Host* dstHost, in_addr_t dstIP,
+                                            SimulationTime deliverTime) {
+    WorkerPacketBatch* batch = &_worker_packetBatch;
+    if(batch->packets && batch->srcHost == srcHost && batch->dstHost == dstHost &&
+       batch->dstIP == dstIP && batch->deliverTime == deliverTime &&
+       batch->sendTime == worker_getCurrentTime()) {
+        return batch->packets;
+    }
+    return NULL;
+}
+
+gboolean worker_resolveRoute(in_addr_t srcIP, in_addr_t dstIP, WorkerRoute* route) {
+    utility_assert(route != NULL);
 
     if (!manager_schedulerIsRunning(_worker_pool()->manager)) {
         /* the simulation is over, don't bother */
-        return;
+        return FALSE;
     }
 
-    in_addr_t srcIP = packet_getSourceIP(packet);
-    in_addr_t dstIP = packet_getDestinationIP(packet);
-
     Address* srcAddress = worker_resolveIPToAddress(srcIP);
     Address* dstAddress = worker_resolveIPToAddress(dstIP);
 
     if (!srcAddress || !dstAddress) {
         utility_panic("unable to schedule packet because of null addresses");
+        return FALSE;
+    }
+
+    Path* path = topology_getPath(worker_getTopology(), srcAddress, dstAddress);
+    if (!path) {
+        utility_panic("unable to find path between node %s and node %s",
+                      address_toString(srcAddress), address_toString(dstAddress));
+        return FALSE;
+    }
+
+    GQuark dstID = (GQuark)address_getID(dstAddress);
+    Host* dstHost = scheduler_getHost(_worker_pool()->scheduler, dstID);
+    gint dstPartition = -1;
+    if (!dstHost) {
+        /* the host is run by the manager of another partition */
+        dstPartition = manager_getRemoteHostPartition(_worker_pool()->manager, dstID);
+        utility_assert(dstPartition >= 0);
+    }
+
+    *route = (WorkerRoute){
+        .srcIP = srcIP,
+        .dstIP = dstIP,
+        .dstHost = dstHost,
+        .dstPartition = dstPartition,
+        .delay = (SimulationTime)ceil(path_getLatency(path) * SIMTIME_ONE_MILLISECOND),
+        .reliability = path_getReliability(path),
+        .path = path,
+    };
+
+    return TRUE;
+}
+
+void worker_sendPacket(Host* srcHost, Packet* packet) {
+    utility_assert(packet != NULL);
+
+    WorkerRoute route;
+    if (worker_resolveRoute(
+            packet_getSourceIP(packet), packet_getDestinationIP(packet), &route)) {
+        worker_sendPacketOnRoute(srcHost, packet, &route);
+    }
+}
+
+void worker_sendPacketOnRoute(Host* srcHost, Packet* packet, const WorkerRoute* route) {
+    utility_assert(packet != NULL);
+    utility_assert(route != NULL);
+
+    if (!manager_schedulerIsRunning(_worker_pool()->manager)) {
+        /* the simulation is over, don't bother */
         return;
     }
 
+    in_addr_t dstIP = route->dstIP;
+    Host* dstHost = route->dstHost;
+    utility_assert(packet_getDestinationIP(packet) == dstIP);
+
     gboolean bootstrapping = worker_isBootstrapActive();
 
     /* check if network reliability forces us to 'drop' the packet */
-    gdouble reliability = topology_getReliability(worker_getTopology(), srcAddress, dstAddress);
     Random* random = host_getRandom(srcHost);
     gdouble chance = random_nextDouble(random);
 
     /* don't drop control packets with length 0, otherwise congestion
      * control has problems responding to packet loss */
-    if (bootstrapping || chance <= reliability || packet_getPayloadLength(packet) == 0) {
-        /* the sender's packet will make it through, find latency */
-        gdouble latency = topology_getLatency(worker_getTopology(), srcAddress, dstAddress);
-        SimulationTime delay = (SimulationTime)ceil(latency * SIMTIME_ONE_MILLISECOND);
-        SimulationTime deliverTime = worker_getCurrentTime() + delay;
+    if (bootstrapping || chance <= route->reliability || packet_getPayloadLength(packet) == 0) {
+        /* the sender's packet will make it through after the path latency */
+        SimulationTime deliverTime = worker_getCurrentTime() + route->delay;
 
-        topology_incrementPathPacketCounter(worker_getTopology(), srcAddress, dstAddress);
+        path_incrementPacketCount(route->path);
 
-        /* TODO this should change for sending to remote manager (on a different machine)
-         * this is the only place where tasks are sent between separate hosts */
+        /* this is the only place where tasks are sent between separate hosts */
 
         Scheduler* scheduler = _worker_pool()->scheduler;
-        GQuark dstID = (GQuark)address_getID(dstAddress);
-        Host* dstHost = scheduler_getHost(scheduler, dstID);
-        utility_assert(dstHost);
 
         packet_addDeliveryStatus(packet, PDS_INET_SENT);
 
-        /* the packetCopy starts with 1 ref, which will be held by the packet task
+        if (!dstHost) {
+            /* the other partition only gets the packet once every partition finishes this
+             * round, so it can't arrive any earlier than that */
+            deliverTime = MAX(deliverTime, _worker_getRoundEndTime());
+            manager_sendRemotePacket(
+                _worker_pool()->manager, (guint)route->dstPartition, deliverTime, packet);
+            worker_setMinEventTimeNextRound(deliverTime);
+            return;
+        }
+
+        /* the packetCopy starts with 1 ref, which will be held by the packet batch
          * and unreffed after the task is finished executing. */
         Packet* packetCopy = packet_copy(packet);
 
-        Task* packetTask = task_new(
-            _worker_runDeliverPacketTask, packetCopy, NULL, (TaskObjectFreeFunc)packet_unref, NULL);
+        /* if this is part of a burst, ride along with the earlier packets */
+        GPtrArray* packets = _worker_getOpenPacketBatch(srcHost, dstHost, dstIP, deliverTime);
+        if (packets) {
+            g_ptr_array_add(packets, packetCopy);
+            return;
+        }
+
+        packets = g_ptr_array_new_with_free_func((GDestroyNotify)packet_unref);
+        g_ptr_array_add(packets, packetCopy);
+
+        Task* packetTask = worker_newDeliverPacketsTask(packets);
         Event* packetEvent = event_new_(packetTask, deliverTime, srcHost, dstHost);
         task_unref(packetTask);
 
-        scheduler_push(scheduler, packetEvent, srcHost, dstHost);
+        _worker_closePacketBatch();
+        if (scheduler_push(scheduler, packetEvent, srcHost, dstHost)) {
+            _worker_packetBatch = (WorkerPacketBatch){
+                .srcHost = srcHost,
+                .dstHost = dstHost,
+                .dstIP = dstIP,
+                .sendTime = worker_getCurrentTime(),
+                .deliverTime = deliverTime,
+                .packets = g_ptr_array_ref(packets),
+            };
+        }
     } else {
         packet_addDeliveryStatus(packet, PDS_INET_DROPPED);
     }
@@ -668,4 +845,14 @@ void worker_add_syscall_counts(Counter* syscall_counts) {
         // No live worker; fall back to the shared manager counter.
         manager_add_syscall_counts_global(syscall_counts);
     }
+}
+
+void worker_add_memory_manager_counts(Counter* memory_manager_counts) {
+    Counter* counter = _worker_memoryManagerCounter();
+    if (counter) {
+        counter_add_counter(counter, memory_manager_counts);
+    } else {
+        // No live worker; fall back to the shared manager counter.
+        manager_add_memory_manager_counts_global(memory_manager_counts);
+    }
 }
\ No newline at end of file
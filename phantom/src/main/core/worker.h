@@ -16,6 +16,8 @@ typedef struct _WorkerPool WorkerPool;
 // Task to be executed on a worker thread.
 typedef void (*WorkerPoolTaskFn)(void*);
 
+typedef struct _WorkerRoute WorkerRoute;
+
 #include "lib/logger/log_level.h"
 #include "main/core/manager.h"
 #include "main/core/scheduler/scheduler.h"
@@ -27,11 +29,25 @@ typedef void (*WorkerPoolTaskFn)(void*);
 #include "main/routing/address.h"
 #include "main/routing/dns.h"
 #include "main/routing/packet.minimal.h"
+#include "main/routing/path.h"
 #include "main/routing/topology.h"
 #include "main/utility/count_down_latch.h"
 
 #include "main/bindings/c/bindings.h"
 
+// Everything worker_sendPacket needs to know about the path between two IPs. None of it
+// changes while the topology is static, so callers can resolve it once and reuse it.
+struct _WorkerRoute {
+    in_addr_t srcIP;
+    in_addr_t dstIP;
+    // NULL if the destination is run by another partition, in which case dstPartition is it.
+    Host* dstHost;
+    gint dstPartition;
+    SimulationTime delay;
+    gdouble reliability;
+    Path* path;
+};
+
 // To be called by scheduler. Consumes `event`
 void worker_runEvent(Event* event);
 // To be called by worker thread
@@ -75,8 +91,28 @@ DNS* worker_getDNS();
 Topology* worker_getTopology();
 ChildPidWatcher* worker_getChildPidWatcher();
 const ConfigOptions* worker_getConfig();
+const gchar* worker_getDataPath();
+guint worker_getPartition();
 gboolean worker_scheduleTask(Task* task, Host* host, SimulationTime nanoDelay);
+// Like worker_scheduleTask, but returns a handle to the scheduled event, or NULL if the
+// event was not scheduled. The handle is only valid until the task runs or is cancelled, and
+// lets the caller move the event in place instead of scheduling another one.
+Event* worker_scheduleTaskWithHandle(Task* task, Host* host, SimulationTime nanoDelay);
+// Move the event behind `handle` to `nanoDelay` from now. Returns FALSE if it is no longer queued.
+gboolean worker_rescheduleTask(Event* handle, SimulationTime nanoDelay);
+// Remove the event behind `handle` from the queue. Returns FALSE if it is no longer queued.
+gboolean worker_cancelTask(Event* handle);
+// Push a host-local event that was already popped back onto the queue. Consumes `event`.
+gboolean worker_requeueEvent(Event* event, Host* host);
 void worker_sendPacket(Host* src, Packet* packet);
+// Fill `route` with the routing info for packets from srcIP to dstIP. Returns FALSE without
+// touching `route` if the simulation is over.
+gboolean worker_resolveRoute(in_addr_t srcIP, in_addr_t dstIP, WorkerRoute* route);
+// Like worker_sendPacket, but uses the previously resolved `route` instead of looking it up.
+void worker_sendPacketOnRoute(Host* src, Packet* packet, const WorkerRoute* route);
+// Create a task that passes `packets`, which all have the same destination IP, to the upstream
+// router of the host it runs on. Takes ownership of `packets`.
+Task* worker_newDeliverPacketsTask(GPtrArray* packets);
 bool worker_isAlive(void);
 
 SimulationTime worker_getCurrentTime();
@@ -120,4 +156,7 @@ void __worker_increment_object_dealloc_counter(const char* object_name);
 // Aggregate the given syscall counts in a worker syscall counter.
 void worker_add_syscall_counts(Counter* syscall_counts);
 
+// Aggregate the given MemoryManager access counts in a worker counter.
+void worker_add_memory_manager_counts(Counter* memory_manager_counts);
+
 #endif /* SHD_WORKER_H_ */
@@ -54,6 +54,8 @@ pub struct Worker {
 
     // A counter for all syscalls made by processes freed by this worker.
     syscall_counter: Counter,
+    // A counter for MemoryManager accesses by plugin memory region.
+    memory_manager_counter: Counter,
     // A counter for objects allocated by this worker.
     object_alloc_counter: Counter,
     // A counter for objects deallocated by this worker.
@@ -90,6 +92,7 @@ impl Worker {
                 object_alloc_counter: Counter::new(),
                 object_dealloc_counter: Counter::new(),
                 syscall_counter: Counter::new(),
+                memory_manager_counter: Counter::new(),
                 worker_pool: notnull_mut(worker_pool),
             }));
             assert!(res.is_ok(), "Worker already initialized");
@@ -270,6 +273,13 @@ mod export {
         Worker::with_mut(|w| &mut w.syscall_counter as *mut Counter).unwrap_or(std::ptr::null_mut())
     }
 
+    /// Returns NULL if there is no live Worker.
+    #[no_mangle]
+    pub extern "C" fn _worker_memoryManagerCounter() -> *mut Counter {
+        Worker::with_mut(|w| &mut w.memory_manager_counter as *mut Counter)
+            .unwrap_or(std::ptr::null_mut())
+    }
+
     /// ID of the current thread's Worker. Panics if the thread has no Worker.
     #[no_mangle]
     pub extern "C" fn worker_threadID() -> i32 {
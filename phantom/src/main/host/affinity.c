@@ -86,8 +86,8 @@ static int _cpuinfo_compare(const CPUInfo* lhs, const CPUInfo* rhs) {
 
     {
         // Always prefer a CPU with lower load
-        int cpu_load_lhs = _hash_table_lookup(_global_platform_info.core_loads, _cpu_key(lhs));
-        int cpu_load_rhs = _hash_table_lookup(_global_platform_info.core_loads, _cpu_key(rhs));
+        int cpu_load_lhs = _hash_table_lookup(_global_platform_info.cpu_loads, _cpu_key(lhs));
+        int cpu_load_rhs = _hash_table_lookup(_global_platform_info.cpu_loads, _cpu_key(rhs));
         if (cpu_load_lhs != cpu_load_rhs) {
             return cpu_load_lhs < cpu_load_rhs ? -1 : 1;
         }
@@ -186,6 +186,28 @@ int affinity_getGoodWorkerAffinity() {
     return p_best_cpu->logical_cpu_num;
 }
 
+int affinity_getNodeOfCPU(int cpu_num) {
+    if (!_affinity_enabled || cpu_num == AFFINITY_UNINIT) {
+        return AFFINITY_UNINIT;
+    }
+
+    for (size_t idx = 0; idx < _global_platform_info.n_cpus; ++idx) {
+        const CPUInfo* p_info = &_global_platform_info.p_cpus[idx];
+        if (p_info->logical_cpu_num == cpu_num) {
+            return p_info->node;
+        }
+    }
+
+    return AFFINITY_UNINIT;
+}
+
+int affinity_getNNodes() {
+    if (!_affinity_enabled) {
+        return 1;
+    }
+    return MAX(1, (int)g_hash_table_size(_global_platform_info.node_loads));
+}
+
 /*
  * Read the output of the lscpu command, allocates a buffer, and sets contents
  * to point to the buffer.
@@ -20,6 +20,22 @@ enum { AFFINITY_UNINIT = -1 };
  */
 int affinity_getGoodWorkerAffinity();
 
+/*
+ * Returns the NUMA node of the logical CPU cpu_num, or AFFINITY_UNINIT if
+ * affinity is disabled or the CPU is unknown.
+ *
+ * THREAD SAFETY: Thread-safe once affinity_initPlatformInfo() has returned.
+ */
+int affinity_getNodeOfCPU(int cpu_num);
+
+/*
+ * Returns the number of NUMA nodes of the online CPUs, or 1 if affinity is
+ * disabled.
+ *
+ * THREAD SAFETY: Thread-safe once affinity_initPlatformInfo() has returned.
+ */
+int affinity_getNNodes();
+
 /*
  * Try to parse platform CPU orientation information from the host machine.
  *
@@ -181,7 +181,7 @@ static gssize channel_receiveUserData(Transport* transport, Thread* thread, Plug
 }
 
 TransportFunctionTable channel_functions = {
-    channel_close, channel_free, channel_sendUserData, channel_receiveUserData,
+    channel_close, channel_free, channel_sendUserData, channel_receiveUserData, NULL, NULL,
     MAGIC_VALUE};
 
 Channel* channel_new(ChannelType type, LegacyDescriptorType dtype) {
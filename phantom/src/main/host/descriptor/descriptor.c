@@ -27,8 +27,7 @@ void descriptor_init(LegacyDescriptor* descriptor, LegacyDescriptorType type,
     descriptor->funcTable = funcTable;
     descriptor->type = type;
     descriptor->handle = -1;
-    descriptor->listeners = g_hash_table_new_full(
-        g_direct_hash, g_direct_equal, NULL, (GDestroyNotify)statuslistener_unref);
+    descriptor->listeners = g_ptr_array_new();
     descriptor->referenceCount = 1;
 
     trace("Descriptor %i has been initialized now", descriptor->handle);
@@ -39,7 +38,14 @@ void descriptor_init(LegacyDescriptor* descriptor, LegacyDescriptorType type,
 void descriptor_clear(LegacyDescriptor* descriptor) {
     MAGIC_ASSERT(descriptor);
     if (descriptor->listeners) {
-        g_hash_table_destroy(descriptor->listeners);
+        for (guint i = 0; i < descriptor->listeners->len; i++) {
+            StatusListener* listener = g_ptr_array_index(descriptor->listeners, i);
+            if (listener) {
+                statuslistener_unref(listener);
+            }
+        }
+        g_ptr_array_free(descriptor->listeners, TRUE);
+        descriptor->listeners = NULL;
     }
     MAGIC_CLEAR(descriptor);
 }
@@ -147,6 +153,33 @@ static gchar* _descriptor_statusToString(Status ds) {
 }
 #endif
 
+/* Returns the index of the listener in the listener array, or -1. */
+static gint _descriptor_findListener(LegacyDescriptor* descriptor, StatusListener* listener) {
+    for (guint i = 0; i < descriptor->listeners->len; i++) {
+        if (g_ptr_array_index(descriptor->listeners, i) == listener) {
+            return (gint)i;
+        }
+    }
+    return -1;
+}
+
+/* Drop the slots of listeners that were removed during a notification. */
+static void _descriptor_compactListeners(LegacyDescriptor* descriptor) {
+    GPtrArray* listeners = descriptor->listeners;
+
+    guint numKept = 0;
+    for (guint i = 0; i < listeners->len; i++) {
+        gpointer listener = g_ptr_array_index(listeners, i);
+        if (listener) {
+            g_ptr_array_index(listeners, numKept++) = listener;
+        }
+    }
+
+    if (numKept < listeners->len) {
+        g_ptr_array_set_size(listeners, numKept);
+    }
+}
+
 static void _descriptor_handleStatusChange(LegacyDescriptor* descriptor, Status oldStatus) {
     MAGIC_ASSERT(descriptor);
 
@@ -165,29 +198,32 @@ static void _descriptor_handleStatusChange(LegacyDescriptor* descriptor, Status
     g_free(after);
 #endif
 
-    /* Tell our listeners there was some activity on this descriptor.
-     * We can't use an iterator here, because the listener table may
-     * be modified in the body of the while loop below, in the onStatusChanged
-     * callback. Instead we get a list of the keys and do lookups on those.*/
-    GList* listenerList = g_hash_table_get_keys(descriptor->listeners);
+    /* Tell our listeners there was some activity on this descriptor. The
+     * onStatusChanged callback may add or remove listeners (or change the status
+     * again, recursively notifying). Removed listeners are only cleared from
+     * their slot until the outermost notification finishes, so the indices stay
+     * valid, and listeners added during the loop are not notified. */
+    descriptor->listenersNotifyDepth++;
 
-    /* Iterate the listeners. */
-    GList* item = g_list_first(listenerList);
-    while (statusesChanged && item) {
-        StatusListener* listener = item->data;
+    guint numListeners = descriptor->listeners->len;
+    for (guint i = 0; statusesChanged && i < numListeners; i++) {
+        StatusListener* listener = g_ptr_array_index(descriptor->listeners, i);
 
-        /* Call only if the listener is still in the table. */
-        if (g_hash_table_contains(descriptor->listeners, listener)) {
+        /* Call only if the listener wasn't removed. */
+        if (listener) {
             statuslistener_onStatusChanged(listener, descriptor->status, statusesChanged);
         }
 
         /* The above callback may have changes status again,
          * so make sure we consider the latest status state. */
         statusesChanged = descriptor->status ^ oldStatus;
-        item = g_list_next(item);
     }
 
-    g_list_free(listenerList);
+    descriptor->listenersNotifyDepth--;
+
+    if (descriptor->listenersNotifyDepth == 0) {
+        _descriptor_compactListeners(descriptor);
+    }
 }
 
 void descriptor_adjustStatus(LegacyDescriptor* descriptor, Status status, gboolean doSetBits) {
@@ -215,15 +251,35 @@ Status descriptor_getStatus(LegacyDescriptor* descriptor) {
 
 void descriptor_addListener(LegacyDescriptor* descriptor, StatusListener* listener) {
     MAGIC_ASSERT(descriptor);
+    utility_assert(listener);
+
+    /* A listener is only stored once. */
+    if (_descriptor_findListener(descriptor, listener) >= 0) {
+        return;
+    }
+
     /* We are storing a listener instance, so count the ref. */
     statuslistener_ref(listener);
-    g_hash_table_insert(descriptor->listeners, listener, listener);
+    g_ptr_array_add(descriptor->listeners, listener);
 }
 
 void descriptor_removeListener(LegacyDescriptor* descriptor, StatusListener* listener) {
     MAGIC_ASSERT(descriptor);
-    /* This will automatically call descriptorlistener_unref on the instance. */
-    g_hash_table_remove(descriptor->listeners, listener);
+    utility_assert(listener);
+
+    gint index = _descriptor_findListener(descriptor, listener);
+    if (index < 0) {
+        return;
+    }
+
+    if (descriptor->listenersNotifyDepth > 0) {
+        /* Keep the indices stable for the notification loop. */
+        g_ptr_array_index(descriptor->listeners, index) = NULL;
+    } else {
+        g_ptr_array_remove_index(descriptor->listeners, index);
+    }
+
+    statuslistener_unref(listener);
 }
 
 gint descriptor_getFlags(LegacyDescriptor* descriptor) {
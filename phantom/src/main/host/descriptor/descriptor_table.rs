@@ -2,83 +2,103 @@ use super::CompatDescriptor;
 use crate::cshadow;
 use crate::utility::notnull::*;
 use log::*;
-use std::collections::{BTreeSet, HashMap};
 use std::convert::TryInto;
 
+const BITS_PER_WORD: usize = 64;
+
 /// Table of (file) descriptors. Typically owned by a Process.
 pub struct DescriptorTable {
-    descriptors: HashMap<u32, CompatDescriptor>,
+    // Descriptors indexed by their handle. Never ends with a `None`.
+    descriptors: Vec<Option<CompatDescriptor>>,
 
-    // Indices less than `next_index` known to be available.
-    available_indices: BTreeSet<u32>,
+    // Bitmap of the indices in `descriptors` that are in use, one bit per index.
+    used: Vec<u64>,
 
-    // Lowest index not in `available_indices` that *might* be available. We still need to verify
-    // availability in `descriptors`, though.
-    next_index: u32,
+    // Index into `used` of the lowest word that *might* have a clear bit. All words before it are
+    // known to be full.
+    first_free_word: usize,
 }
 
 impl DescriptorTable {
     pub fn new() -> Self {
         DescriptorTable {
-            descriptors: HashMap::new(),
-            available_indices: BTreeSet::new(),
-            next_index: 0,
+            descriptors: Vec::new(),
+            used: Vec::new(),
+            first_free_word: 0,
         }
     }
 
-    /// Add the descriptor at an unused index, and return the index.
-    pub fn add(&mut self, mut descriptor: CompatDescriptor) -> u32 {
-        let idx = if let Some(idx) = self.available_indices.iter().next() {
-            // Un-borrow from `available_indices`.
-            let idx = *idx;
-            // Take from `available_indices`
-            trace!("Reusing available index {}", idx);
-            self.available_indices.remove(&idx);
-            idx
-        } else {
-            // Skip past any indexes that are in use. This can happen after
-            // calling `set` with a value greater than `next_index`.
-            while self.descriptors.contains_key(&self.next_index) {
-                trace!("Skipping past in-use index {}", self.next_index);
-                self.next_index += 1;
-            }
-            // Take the next index.
-            let idx = self.next_index;
-            trace!("Using index {}", idx);
-            self.next_index += 1;
-            idx
-        };
+    fn is_used(&self, idx: usize) -> bool {
+        self.used
+            .get(idx / BITS_PER_WORD)
+            .map_or(false, |w| w & (1 << (idx % BITS_PER_WORD)) != 0)
+    }
 
-        descriptor.set_handle(idx);
-        let prev = self.descriptors.insert(idx, descriptor);
-        debug_assert!(prev.is_none(), "Already a descriptor at {}", idx);
+    fn mark_used(&mut self, idx: usize) {
+        let word = idx / BITS_PER_WORD;
+        if word >= self.used.len() {
+            self.used.resize(word + 1, 0);
+        }
+        self.used[word] |= 1 << (idx % BITS_PER_WORD);
+    }
 
-        idx
+    fn mark_unused(&mut self, idx: usize) {
+        let word = idx / BITS_PER_WORD;
+        self.used[word] &= !(1 << (idx % BITS_PER_WORD));
+        self.first_free_word = std::cmp::min(self.first_free_word, word);
     }
 
-    // Call after inserting to `available_indices`, to free any that are contiguous
-    // with `next_index`.
-    fn trim_tail(&mut self) {
-        loop {
-            let last_in_available = match self.available_indices.iter().next_back() {
-                Some(i) => *i,
-                None => break,
-            };
-            if (last_in_available + 1) == self.next_index {
-                // Last entry in available_indices is adjacent to next_index.
-                // We can merge them, freeing an entry in `available_indices`.
-                self.next_index -= 1;
-                self.available_indices.remove(&last_in_available);
-            } else {
-                break;
+    /// The lowest index that isn't in use.
+    fn lowest_free_index(&mut self) -> usize {
+        while let Some(w) = self.used.get(self.first_free_word) {
+            if *w != u64::MAX {
+                return self.first_free_word * BITS_PER_WORD + w.trailing_ones() as usize;
             }
+            self.first_free_word += 1;
+        }
+        self.used.len() * BITS_PER_WORD
+    }
+
+    // Drop unused slots from the end of the table, so that it doesn't stay large after a burst of
+    // descriptors is closed.
+    fn trim_tail(&mut self) {
+        while let Some(None) = self.descriptors.last() {
+            self.descriptors.pop();
         }
+        let words = (self.descriptors.len() + BITS_PER_WORD - 1) / BITS_PER_WORD;
+        self.used.truncate(words);
+        self.first_free_word = std::cmp::min(self.first_free_word, words);
+    }
+
+    fn insert_at(&mut self, idx: usize, descriptor: CompatDescriptor) -> Option<CompatDescriptor> {
+        if idx >= self.descriptors.len() {
+            self.descriptors.resize_with(idx + 1, || None);
+        }
+        self.mark_used(idx);
+        self.descriptors[idx].replace(descriptor)
+    }
+
+    /// Add the descriptor at the lowest unused index, and return the index.
+    pub fn add(&mut self, mut descriptor: CompatDescriptor) -> u32 {
+        let idx = self.lowest_free_index();
+        trace!("Using index {}", idx);
+
+        descriptor.set_handle(idx.try_into().unwrap());
+        let prev = self.insert_at(idx, descriptor);
+        debug_assert!(prev.is_none(), "Already a descriptor at {}", idx);
+
+        idx.try_into().unwrap()
     }
 
     /// Remove the descriptor at the given index and return it.
     pub fn remove(&mut self, idx: u32) -> Option<CompatDescriptor> {
-        let mut maybe_descriptor = self.descriptors.remove(&idx);
-        self.available_indices.insert(idx);
+        let idx = idx as usize;
+        if !self.is_used(idx) {
+            return None;
+        }
+
+        let mut maybe_descriptor = self.descriptors[idx].take();
+        self.mark_unused(idx);
         self.trim_tail();
         if let Some(descriptor) = &mut maybe_descriptor {
             descriptor.set_handle(0);
@@ -87,8 +107,17 @@ impl DescriptorTable {
     }
 
     /// Get the descriptor at `idx`, if any.
+    #[inline]
     pub fn get(&self, idx: u32) -> Option<&CompatDescriptor> {
-        self.descriptors.get(&idx)
+        match self.descriptors.get(idx as usize) {
+            Some(Some(d)) => Some(d),
+            _ => None,
+        }
+    }
+
+    /// Iterate over the descriptors in the table, in index order.
+    pub fn iter_mut(&mut self) -> impl Iterator<Item = &mut CompatDescriptor> {
+        self.descriptors.iter_mut().flatten()
     }
 
     /// Insert a descriptor at `index`. If a descriptor is already present at
@@ -100,13 +129,7 @@ impl DescriptorTable {
     ) -> Option<CompatDescriptor> {
         descriptor.set_handle(index);
 
-        // We ensure the index is no longer in `self.available_indices`. We *don't* ensure
-        // `self.next_index` is > `index`, since that'd require adding the indices in between to
-        // `self.available_indices`. It uses less memory and is no more expensive to iterate when
-        // *using* `self.available_indices` instead.
-        self.available_indices.remove(&index);
-
-        if let Some(mut prev) = self.descriptors.insert(index, descriptor) {
+        if let Some(mut prev) = self.insert_at(index as usize, descriptor) {
             trace!("Overwriting index {}", index);
             prev.set_handle(0);
             Some(prev)
@@ -122,7 +145,7 @@ impl DescriptorTable {
     /// freed. Otherwise the circular reference will prevent the free operation.
     /// TODO: remove this once the TCP layer is better designed.
     pub fn shutdown_helper(&mut self) {
-        for descriptor in self.descriptors.values() {
+        for descriptor in self.descriptors.iter().flatten() {
             match descriptor {
                 CompatDescriptor::New(_) => continue,
                 CompatDescriptor::Legacy(d) => unsafe {
@@ -159,7 +182,7 @@ mod export {
     ) {
         let table = unsafe { table.as_mut().unwrap() };
 
-        for desc in table.descriptors.values_mut() {
+        for desc in table.iter_mut() {
             unsafe { f(desc as *mut _, data) };
         }
     }
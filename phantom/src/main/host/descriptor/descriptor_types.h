@@ -51,7 +51,11 @@ struct _LegacyDescriptor {
     gint handle;
     LegacyDescriptorType type;
     Status status;
-    GHashTable* listeners;
+    /* How many status change notifications are currently iterating the listeners. */
+    guint listenersNotifyDepth;
+    /* StatusListener objects in the order they were added. Listeners removed
+     * during a notification are set to NULL and compacted away afterwards. */
+    GPtrArray* listeners;
     gint referenceCount;
     gint flags;
     // Since this structure is shared with Rust, we should always include the magic struct
@@ -87,6 +87,10 @@ struct _EpollWatch {
     /* The last time we reported an event on this watch.
      * This is used to ensure fairness across watches when reporting events. */
     SimulationTime last_reported_event_time;
+    /* true while the watch is stored in the epoll's ready tree */
+    gboolean isInReadyTree;
+    /* the epoll update generation in which the watch was last kept (see epoll_beginUpdate) */
+    uint64_t updateGeneration;
     gint referenceCount;
     MAGIC_DECLARE;
 };
@@ -108,12 +112,19 @@ struct _Epoll {
     /* holds the wrappers for the descriptors we are watching for events */
     GHashTable* watching;
 
-    /* holds the descriptors that we are watching that have events */
-    GHashTable* ready;
+    /* holds the watches that have events to report, in the order that they should be
+     * reported. A watch is in this tree if and only if it is ready. */
+    GTree* ready;
+    /* scratch space for the watches that are being reported by epoll_getEvents */
+    GPtrArray* reporting;
 
     /* A counter for sorting watches, for guaranteeing determinism when reporting events. */
     uint64_t watch_id_counter;
 
+    /* The current update generation, and how many watches were kept in it. */
+    uint64_t updateGeneration;
+    guint numUpdated;
+
     MAGIC_DECLARE;
 };
 
@@ -156,6 +167,10 @@ static gint _epollwatch_compare(gconstpointer ptr_1, gconstpointer ptr_2) {
     }
 }
 
+static gint _epollwatch_compareData(gconstpointer ptr_1, gconstpointer ptr_2, gpointer unused) {
+    return _epollwatch_compare(ptr_1, ptr_2);
+}
+
 /* forward declaration */
 static void _epoll_descriptorStatusChanged(Epoll* epoll, const EpollKey* key);
 
@@ -240,7 +255,8 @@ static void _epoll_free(LegacyDescriptor* descriptor) {
 
     /* this unrefs all of the remaining watches */
     g_hash_table_destroy(epoll->watching);
-    g_hash_table_destroy(epoll->ready);
+    g_tree_destroy(epoll->ready);
+    g_ptr_array_free(epoll->reporting, TRUE);
 
     descriptor_clear((LegacyDescriptor*)epoll);
     MAGIC_CLEAR(epoll);
@@ -288,11 +304,22 @@ void epoll_clearWatchListeners(Epoll* epoll) {
     }
 }
 
+static GTree* _epoll_newReadyTree() {
+    /* The watch is both the key and the value, and the tree holds a ref to it. */
+    return g_tree_new_full(_epollwatch_compareData, NULL, NULL, (GDestroyNotify)_epollwatch_unref);
+}
+
+static void _epoll_clearReadyTreeFlag(gpointer key, gpointer value, gpointer unused) {
+    ((EpollWatch*)value)->isInReadyTree = FALSE;
+}
+
 void epoll_reset(Epoll* epoll) {
     MAGIC_ASSERT(epoll);
     epoll_clearWatchListeners(epoll);
     // Removing will also unref previously stored descriptors
-    g_hash_table_remove_all(epoll->ready);
+    g_hash_table_foreach(epoll->watching, _epoll_clearReadyTreeFlag, NULL);
+    g_tree_destroy(epoll->ready);
+    epoll->ready = _epoll_newReadyTree();
     g_hash_table_remove_all(epoll->watching);
 }
 
@@ -314,7 +341,8 @@ Epoll* epoll_new() {
 
     /* allocate backend needed for managing events for this descriptor */
     epoll->watching = g_hash_table_new_full(_epollkey_hash, _epollkey_equal, g_free, (GDestroyNotify)_epollwatch_unref);
-    epoll->ready = g_hash_table_new_full(_epollkey_hash, _epollkey_equal, g_free, (GDestroyNotify)_epollwatch_unref);
+    epoll->ready = _epoll_newReadyTree();
+    epoll->reporting = g_ptr_array_new();
 
     /* the epoll descriptor itself is always able to be epolled */
     descriptor_adjustStatus(&(epoll->super), STATUS_DESCRIPTOR_ACTIVE, TRUE);
@@ -439,6 +467,46 @@ static void _getWatchObject(const CompatDescriptor* descriptor, EpollWatchTypes*
     }
 }
 
+/* Remove the watch from the ready tree if it's there, dropping the tree's ref. */
+static void _epoll_removeReady(Epoll* epoll, EpollWatch* watch) {
+    if (watch->isInReadyTree) {
+        watch->isInReadyTree = FALSE;
+        g_tree_remove(epoll->ready, watch);
+    }
+}
+
+static void _epoll_modifyWatch(Epoll* epoll, EpollWatch* watch, const EpollKey* key,
+                               const struct epoll_event* event) {
+    MAGIC_ASSERT(watch);
+    utility_assert(event && (watch->flags & EWF_WATCHING));
+
+    /* the user set new events */
+    watch->event = *event;
+    /* we would need to report the new event again if in ET or ONESHOT modes */
+    watch->flags &= ~EWF_EDGETRIGGER_REPORTED;
+    watch->flags &= ~EWF_ONESHOT_REPORTED;
+
+    /* initiate a callback if the new event type on the watched object is ready */
+    _epoll_descriptorStatusChanged(epoll, key);
+}
+
+/* Stop listening on the watched object and drop the watch from the ready tree. The caller
+ * still needs to remove it from the watching table. */
+static void _epoll_stopWatch(Epoll* epoll, EpollWatch* watch) {
+    MAGIC_ASSERT(watch);
+    watch->flags &= ~EWF_WATCHING;
+
+    /* its deleted, so stop listening for updates */
+    statuslistener_setMonitorStatus(watch->listener, STATUS_NONE, SLF_NEVER);
+    if (watch->watchType == EWT_LEGACY_DESCRIPTOR) {
+        descriptor_removeListener(watch->watchObject.as_descriptor, watch->listener);
+    } else if (watch->watchType == EWT_POSIX_FILE) {
+        posixfile_removeListener(watch->watchObject.as_file, watch->listener);
+    }
+
+    _epoll_removeReady(epoll, watch);
+}
+
 gint epoll_control(Epoll* epoll, gint operation, int fd, const CompatDescriptor* descriptor,
                    const struct epoll_event* event) {
     MAGIC_ASSERT(epoll);
@@ -508,18 +576,7 @@ gint epoll_control(Epoll* epoll, gint operation, int fd, const CompatDescriptor*
                 return -ENOENT;
             }
 
-            MAGIC_ASSERT(watch);
-            utility_assert(event && (watch->flags & EWF_WATCHING));
-
-            /* the user set new events */
-            watch->event = *event;
-            /* we would need to report the new event again if in ET or ONESHOT modes */
-            watch->flags &= ~EWF_EDGETRIGGER_REPORTED;
-            watch->flags &= ~EWF_ONESHOT_REPORTED;
-
-            /* initiate a callback if the new event type on the watched object is ready */
-            _epoll_descriptorStatusChanged(epoll, &key);
-
+            _epoll_modifyWatch(epoll, watch, &key, event);
             break;
         }
 
@@ -529,19 +586,8 @@ gint epoll_control(Epoll* epoll, gint operation, int fd, const CompatDescriptor*
                 return -ENOENT;
             }
 
-            MAGIC_ASSERT(watch);
-            watch->flags &= ~EWF_WATCHING;
-
-            /* its deleted, so stop listening for updates */
-            statuslistener_setMonitorStatus(watch->listener, STATUS_NONE, SLF_NEVER);
-            if (watch->watchType == EWT_LEGACY_DESCRIPTOR) {
-                descriptor_removeListener(watch->watchObject.as_descriptor, watch->listener);
-            } else if (watch->watchType == EWT_POSIX_FILE) {
-                posixfile_removeListener(watch->watchObject.as_file, watch->listener);
-            }
-
-            /* unref gets called on the watch when it is removed from these tables */
-            g_hash_table_remove(epoll->ready, &key);
+            _epoll_stopWatch(epoll, watch);
+            /* unref gets called on the watch when it is removed from the table */
             g_hash_table_remove(epoll->watching, &key);
             /* if that was the last watch, this epoll is not readable to its parents */
             _epoll_descriptorStatusChanged(epoll, NULL);
@@ -558,9 +604,82 @@ gint epoll_control(Epoll* epoll, gint operation, int fd, const CompatDescriptor*
     return 0;
 }
 
+void epoll_beginUpdate(Epoll* epoll) {
+    MAGIC_ASSERT(epoll);
+    epoll->updateGeneration++;
+    epoll->numUpdated = 0;
+}
+
+void epoll_updateWatch(Epoll* epoll, int fd, const CompatDescriptor* descriptor,
+                       const struct epoll_event* event) {
+    MAGIC_ASSERT(epoll);
+    utility_assert(event);
+
+    /* borrow the object only to build the lookup key */
+    EpollKey key = {.fd = fd};
+    LegacyDescriptor* legacyDescriptor = compatdescriptor_asLegacy(descriptor);
+    if (legacyDescriptor) {
+        key.objectPtr = (uintptr_t)(void*)legacyDescriptor;
+    } else {
+        key.objectPtr = (uintptr_t)(void*)compatdescriptor_borrowPosixFile(descriptor);
+    }
+
+    EpollWatch* watch = g_hash_table_lookup(epoll->watching, &key);
+
+    if (watch == NULL) {
+        epoll_control(epoll, EPOLL_CTL_ADD, fd, descriptor, event);
+        watch = g_hash_table_lookup(epoll->watching, &key);
+        utility_assert(watch);
+    } else if (watch->updateGeneration == epoll->updateGeneration) {
+        /* the same object was given twice in this update; the first one wins */
+        return;
+    } else if (watch->event.events != event->events || watch->event.data.u64 != event->data.u64) {
+        _epoll_modifyWatch(epoll, watch, &key, event);
+    }
+
+    watch->updateGeneration = epoll->updateGeneration;
+    epoll->numUpdated++;
+}
+
+void epoll_endUpdate(Epoll* epoll) {
+    MAGIC_ASSERT(epoll);
+
+    /* nothing to do if every watch was kept */
+    if (epoll->numUpdated == g_hash_table_size(epoll->watching)) {
+        return;
+    }
+
+    GHashTableIter iter;
+    gpointer value = NULL;
+    g_hash_table_iter_init(&iter, epoll->watching);
+    while (g_hash_table_iter_next(&iter, NULL, &value)) {
+        EpollWatch* watch = value;
+        if (watch->updateGeneration != epoll->updateGeneration) {
+            _epoll_stopWatch(epoll, watch);
+            /* unrefs the watch */
+            g_hash_table_iter_remove(&iter);
+        }
+    }
+
+    _epoll_descriptorStatusChanged(epoll, NULL);
+}
+
 guint epoll_getNumReadyEvents(Epoll* epoll) {
     MAGIC_ASSERT(epoll);
-    return g_hash_table_size(epoll->ready);
+    return g_tree_nnodes(epoll->ready);
+}
+
+typedef struct _EpollReadyCollector EpollReadyCollector;
+struct _EpollReadyCollector {
+    GPtrArray* watches;
+    guint limit;
+};
+
+static gboolean _epoll_collectReadyWatch(gpointer key, gpointer value, gpointer data) {
+    EpollReadyCollector* collector = data;
+    g_ptr_array_add(collector->watches, value);
+    /* returning TRUE stops the traversal */
+    return collector->watches->len >= collector->limit;
 }
 
 gint epoll_getEvents(Epoll* epoll, struct epoll_event* eventArray, gint eventArrayLength, gint* nEvents) {
@@ -571,76 +690,75 @@ gint epoll_getEvents(Epoll* epoll, struct epoll_event* eventArray, gint eventArr
      * overflow. the number of actual events is returned in nEvents. */
     gint eventIndex = 0;
 
-    /*
-     * We need to guarantee that the events are returned in a deterministic order when the
-     * simulation is run multiple times, so we cannot use hash table iterator.
-     * Using a list here has some potential performance implications:
-     * - O(n) to loop the hash table and create the list of values
-     * - O(n) to sort the list
-     * - O(n) for our iteration of the list
-     * We think that the ready list is typically small and so 3*O(n) will be small in practice.
-     * If this turns out not to be the case, we could consider maintaining a sorted object of the
-     * ready watch values alongside the epoll->ready hash table instead, which may allow us
-     * to improve the performance of this function. One option is to use binary trees, e.g.,
-     * https://developer.gnome.org/glib/2.68/glib-Balanced-Binary-Trees.html
-     * We should test the performance before and after such a change.
-     */
-    GList* ready_list = g_hash_table_get_values(epoll->ready);
-    GList* next_item = NULL;
-
-    /* Prepare the list for deterministic iteration. */
-    if (ready_list != NULL) {
-        ready_list = g_list_sort(ready_list, _epollwatch_compare);
-        next_item = g_list_first(ready_list);
+    /* The ready tree is ordered the way we need to report events: watches whose last events
+     * were reported longest ago come first, with ties broken by the watch id. We can't modify
+     * the tree while traversing it, so we first take the watches we will report. This visits
+     * only as many watches as we return. */
+    g_ptr_array_set_size(epoll->reporting, 0);
+    if (eventArrayLength > 0) {
+        EpollReadyCollector collector = {.watches = epoll->reporting, .limit = eventArrayLength};
+        g_tree_foreach(epoll->ready, _epoll_collectReadyWatch, &collector);
     }
 
-    /* Iterate the list. */
-    while ((next_item != NULL) && (eventIndex < eventArrayLength)) {
-        EpollWatch* watch = next_item->data;
+    for (guint i = 0; i < epoll->reporting->len; i++) {
+        EpollWatch* watch = g_ptr_array_index(epoll->reporting, i);
         MAGIC_ASSERT(watch);
 
-        if(_epollwatch_isReady(watch)) {
-            /* report the event */
-            eventArray[eventIndex] = watch->event;
-            eventArray[eventIndex].events = 0;
+        /* The sort key is about to change, so take the watch out of the tree first. The tree's
+         * ref is kept while the watch is out. */
+        g_tree_steal(epoll->ready, watch);
 
-            if((watch->flags & EWF_READABLE) && (watch->flags & EWF_WAITINGREAD)) {
-                eventArray[eventIndex].events |= EPOLLIN;
-            }
-            if((watch->flags & EWF_WRITEABLE) && (watch->flags & EWF_WAITINGWRITE)) {
-                eventArray[eventIndex].events |= EPOLLOUT;
-            }
-            if(watch->flags & EWF_EDGETRIGGER) {
-                eventArray[eventIndex].events |= EPOLLET;
-            }
+        if (!_epollwatch_isReady(watch)) {
+            /* shouldn't happen, since the tree only holds ready watches */
+            watch->isInReadyTree = FALSE;
+            _epollwatch_unref(watch);
+            continue;
+        }
 
-            /* Record that we are reporting the event now. */
-            watch->last_reported_event_time = worker_getCurrentTime();
+        /* report the event */
+        eventArray[eventIndex] = watch->event;
+        eventArray[eventIndex].events = 0;
 
-            /* event was just collected, unset the change status */
-            watch->flags &= ~EWF_READCHANGED;
-            watch->flags &= ~EWF_WRITECHANGED;
+        if((watch->flags & EWF_READABLE) && (watch->flags & EWF_WAITINGREAD)) {
+            eventArray[eventIndex].events |= EPOLLIN;
+        }
+        if((watch->flags & EWF_WRITEABLE) && (watch->flags & EWF_WAITINGWRITE)) {
+            eventArray[eventIndex].events |= EPOLLOUT;
+        }
+        if(watch->flags & EWF_EDGETRIGGER) {
+            eventArray[eventIndex].events |= EPOLLET;
+        }
 
-            eventIndex++;
-            utility_assert(eventIndex <= eventArrayLength);
+        /* Record that we are reporting the event now. */
+        watch->last_reported_event_time = worker_getCurrentTime();
 
-            if(watch->flags & EWF_EDGETRIGGER) {
-                /* tag that an event was collected in ET mode */
-                watch->flags |= EWF_EDGETRIGGER_REPORTED;
-            }
-            if(watch->flags & EWF_ONESHOT) {
-                /* they collected the event, dont report any more */
-                watch->flags |= EWF_ONESHOT_REPORTED;
-            }
+        /* event was just collected, unset the change status */
+        watch->flags &= ~EWF_READCHANGED;
+        watch->flags &= ~EWF_WRITECHANGED;
+
+        eventIndex++;
+        utility_assert(eventIndex <= eventArrayLength);
+
+        if(watch->flags & EWF_EDGETRIGGER) {
+            /* tag that an event was collected in ET mode */
+            watch->flags |= EWF_EDGETRIGGER_REPORTED;
+        }
+        if(watch->flags & EWF_ONESHOT) {
+            /* they collected the event, dont report any more */
+            watch->flags |= EWF_ONESHOT_REPORTED;
         }
 
-        next_item = g_list_next(next_item);
+        if (_epollwatch_isReady(watch)) {
+            /* level-triggered events stay ready, behind the watches reported less recently */
+            g_tree_insert(epoll->ready, watch, watch);
+        } else {
+            /* edge-triggered and oneshot watches wait for their next status change */
+            watch->isInReadyTree = FALSE;
+            _epollwatch_unref(watch);
+        }
     }
 
-    /* Cleanup just the list but not the list values, which are owned by the hash table. */
-    if (ready_list) {
-        g_list_free(ready_list);
-    }
+    g_ptr_array_set_size(epoll->reporting, 0);
 
     *nEvents = eventIndex;
 
@@ -670,14 +788,14 @@ static void _epoll_descriptorStatusChanged(Epoll* epoll, const EpollKey* key) {
 
             /* check if its ready (has an event to report) now */
             if (_epollwatch_isReady(watch)) {
-                if (!g_hash_table_contains(epoll->ready, key)) {
+                if (!watch->isInReadyTree) {
                     _epollwatch_ref(watch);
-                    gpointer keyCopy = _epollkey_new(key->fd, key->objectPtr);
-                    g_hash_table_replace(epoll->ready, keyCopy, watch);
+                    watch->isInReadyTree = TRUE;
+                    g_tree_insert(epoll->ready, watch, watch);
                 }
             } else {
-                /* this calls unref on the watch if its in the table */
-                g_hash_table_remove(epoll->ready, key);
+                /* this calls unref on the watch if its in the tree */
+                _epoll_removeReady(epoll, watch);
             }
         }
     }
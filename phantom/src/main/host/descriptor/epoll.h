@@ -22,6 +22,15 @@ gint epoll_control(Epoll* epoll, gint operation, int fd, const CompatDescriptor*
 gint epoll_getEvents(Epoll* epoll, struct epoll_event* eventArray,
         gint eventArrayLength, gint* nEvents);
 
+/* Replace the set of watches incrementally. Every watch that should remain is passed to
+ * epoll_updateWatch between epoll_beginUpdate and epoll_endUpdate. Watches whose events
+ * didn't change are left untouched, and epoll_endUpdate removes the watches that were not
+ * passed. */
+void epoll_beginUpdate(Epoll* epoll);
+void epoll_updateWatch(Epoll* epoll, int fd, const CompatDescriptor* descriptor,
+                       const struct epoll_event* event);
+void epoll_endUpdate(Epoll* epoll);
+
 void epoll_clearWatchListeners(Epoll* epoll);
 guint epoll_getNumReadyEvents(Epoll* epoll);
 
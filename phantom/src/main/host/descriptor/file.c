@@ -14,6 +14,7 @@
 #include <string.h>
 #include <sys/file.h>
 #include <sys/ioctl.h>
+#include <sys/sendfile.h>
 #include <sys/stat.h>
 #include <sys/syscall.h>
 #include <sys/time.h>
@@ -54,6 +55,9 @@ struct _File {
         mode_t mode;
         char* abspath;
     } osfile;
+    /* The plugin holds its own native fd for this file at the same handle, and
+     * I/O on the handle is executed natively instead of through osfile. */
+    bool isPluginNative;
     MAGIC_DECLARE;
 };
 
@@ -67,6 +71,43 @@ mode_t file_getMode(File* file) {
     return file->osfile.mode;
 }
 
+bool file_isPluginNative(File* file) {
+    MAGIC_ASSERT(file);
+    return file->isPluginNative;
+}
+
+void file_setPluginNative(File* file, bool isPluginNative) {
+    MAGIC_ASSERT(file);
+    file->isPluginNative = isPluginNative;
+}
+
+bool file_isRegularFileUnder(File* file, const char* dirPath) {
+    MAGIC_ASSERT(file);
+    utility_assert(dirPath);
+
+    if (file->type != FILE_TYPE_REGULAR || file->osfile.fd < 0 || !file->osfile.abspath) {
+        return false;
+    }
+
+    struct stat statbuf = {0};
+    if (fstat(file->osfile.fd, &statbuf) < 0 || !S_ISREG(statbuf.st_mode)) {
+        return false;
+    }
+
+    char* realFilePath = realpath(file->osfile.abspath, NULL);
+    char* realDirPath = realpath(dirPath, NULL);
+
+    bool isUnder = false;
+    if (realFilePath && realDirPath) {
+        size_t dirLen = strlen(realDirPath);
+        isUnder = strncmp(realFilePath, realDirPath, dirLen) == 0 && realFilePath[dirLen] == '/';
+    }
+
+    free(realFilePath);
+    free(realDirPath);
+    return isUnder;
+}
+
 static inline File* _file_descriptorToFile(LegacyDescriptor* desc) {
     utility_assert(descriptor_getType(desc) == DT_FILE);
     File* file = (File*)desc;
@@ -520,6 +561,57 @@ ssize_t file_pwritev2(File* file, const struct iovec* iov, int iovcnt,
 }
 #endif
 
+ssize_t file_sendfile(File* outFile, File* inFile, off_t* offset, size_t count) {
+    MAGIC_ASSERT(outFile);
+    MAGIC_ASSERT(inFile);
+
+    if (!_file_getOSBackedFD(outFile) || !_file_getOSBackedFD(inFile)) {
+        return -EBADF;
+    }
+
+    if (inFile->type == FILE_TYPE_RANDOM) {
+        /* The random bytes have to come from the host, not the os-backed file. */
+        return -EINVAL;
+    }
+
+    trace("File %i will sendfile %zu bytes from os-backed file %i at path '%s' to "
+          "os-backed file %i",
+          _file_getFD(inFile), count, _file_getOSBackedFD(inFile), inFile->osfile.abspath,
+          _file_getOSBackedFD(outFile));
+
+    /* TODO: this may block the shadow thread until we properly handle
+     * os-backed files in non-blocking mode. */
+    ssize_t result =
+        sendfile(_file_getOSBackedFD(outFile), _file_getOSBackedFD(inFile), offset, count);
+    return (result < 0) ? -errno : result;
+}
+
+#ifdef SYS_copy_file_range
+ssize_t file_copyFileRange(File* inFile, off64_t* inOffset, File* outFile,
+                           off64_t* outOffset, size_t len, unsigned int flags) {
+    MAGIC_ASSERT(inFile);
+    MAGIC_ASSERT(outFile);
+
+    if (!_file_getOSBackedFD(inFile) || !_file_getOSBackedFD(outFile)) {
+        return -EBADF;
+    }
+
+    if (inFile->type == FILE_TYPE_RANDOM) {
+        return -EINVAL;
+    }
+
+    trace("File %i will copy_file_range %zu bytes from os-backed file %i at path '%s' "
+          "to os-backed file %i",
+          _file_getFD(inFile), len, _file_getOSBackedFD(inFile), inFile->osfile.abspath,
+          _file_getOSBackedFD(outFile));
+
+    /* Use the syscall directly since older glibc versions have no wrapper. */
+    ssize_t result = syscall(SYS_copy_file_range, _file_getOSBackedFD(inFile), inOffset,
+                             _file_getOSBackedFD(outFile), outOffset, len, flags);
+    return (result < 0) ? -errno : result;
+}
+#endif
+
 int file_fstat(File* file, struct stat* statbuf) {
     MAGIC_ASSERT(file);
 
@@ -7,6 +7,7 @@
 #define SRC_MAIN_HOST_DESCRIPTOR_FILE_H_
 
 #include <poll.h>
+#include <stdbool.h>
 #include <stddef.h>
 #include <sys/stat.h>
 #include <sys/statfs.h>
@@ -58,6 +59,15 @@ mode_t file_getMode(File* file);
 /* Returns the linux-backed fd that shadow uses to perform the file operations.  */
 int file_getOSBackedFD(File* file);
 
+/* Returns true if the file is a plain regular file whose real path is below
+ * dirPath. Special files such as /etc/hosts never match. */
+bool file_isRegularFileUnder(File* file, const char* dirPath);
+
+/* Whether the plugin also has this file open natively at the same handle,
+ * in which case I/O on the handle bypasses the osfile. */
+bool file_isPluginNative(File* file);
+void file_setPluginNative(File* file, bool isPluginNative);
+
 // ****************************************
 // Operations that require a non-null File*
 // ****************************************
@@ -76,6 +86,13 @@ ssize_t file_pwritev(File* file, const struct iovec* iov, int iovcnt, off_t offs
 ssize_t file_pwritev2(File* file, const struct iovec* iov, int iovcnt,
                       off_t offset, int flags);
 #endif
+/* Copy data between two os-backed files inside the kernel, without passing it
+ * through shadow's or the plugin's memory. */
+ssize_t file_sendfile(File* outFile, File* inFile, off_t* offset, size_t count);
+#ifdef SYS_copy_file_range
+ssize_t file_copyFileRange(File* inFile, off64_t* inOffset, File* outFile,
+                           off64_t* outOffset, size_t len, unsigned int flags);
+#endif
 int file_fstat(File* file, struct stat* statbuf);
 int file_fstatfs(File* file, struct statfs* statbuf);
 int file_fsync(File* file);
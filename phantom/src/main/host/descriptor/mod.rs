@@ -105,13 +105,15 @@ impl Drop for LegacyStatusListener {
 
 /// Stores event listener handles so that `c::StatusListener` objects can subscribe to events.
 struct LegacyListenerHelper {
-    handle_map: std::collections::HashMap<usize, Handle<(FileStatus, FileStatus)>>,
+    // A file has very few legacy listeners, so a list is cheaper than a map and keeps them in the
+    // order they were added.
+    handles: Vec<(usize, Handle<(FileStatus, FileStatus)>)>,
 }
 
 impl LegacyListenerHelper {
     fn new() -> Self {
         Self {
-            handle_map: std::collections::HashMap::new(),
+            handles: Vec::new(),
         }
     }
 
@@ -123,7 +125,7 @@ impl LegacyListenerHelper {
         assert!(!ptr.is_null());
 
         // if it's already listening, don't add a second time
-        if self.handle_map.contains_key(&(ptr as usize)) {
+        if self.handles.iter().any(|(key, _)| *key == ptr as usize) {
             return;
         }
 
@@ -135,12 +137,13 @@ impl LegacyListenerHelper {
         });
 
         // use a usize as the key so we don't accidentally deref the pointer
-        self.handle_map.insert(ptr as usize, handle);
+        self.handles.push((ptr as usize, handle));
     }
 
     fn remove_listener(&mut self, ptr: *mut c::StatusListener) {
         assert!(!ptr.is_null());
-        self.handle_map.remove(&(ptr as usize));
+        // dropping the handle stops the listener
+        self.handles.retain(|(key, _)| *key != ptr as usize);
     }
 }
 
@@ -4,6 +4,7 @@
  * See LICENSE for licensing information
  */
 
+#include <errno.h>
 #include <glib.h>
 #include <netinet/in.h>
 #include <sys/un.h>
@@ -94,9 +95,36 @@ static gssize _socket_receiveUserData(Transport* transport, Thread* thread, Plug
     return socket->vtable->receive((Transport*)socket, thread, buffer, nBytes, ip, port);
 }
 
-TransportFunctionTable socket_functions = {
-    _socket_close, _socket_free, _socket_sendUserData, _socket_receiveUserData,
-    MAGIC_VALUE};
+static gssize _socket_sendUserDataShadow(Transport* transport, Thread* thread,
+                                         const void* buffer, gsize nBytes, in_addr_t ip,
+                                         in_port_t port) {
+    Socket* socket = _socket_fromLegacyDescriptor((LegacyDescriptor*)transport);
+    MAGIC_ASSERT(socket);
+    MAGIC_ASSERT(socket->vtable);
+    if (!socket->vtable->sendShadow) {
+        return -ENOTSUP;
+    }
+    return socket->vtable->sendShadow((Transport*)socket, thread, buffer, nBytes, ip, port);
+}
+
+static gssize _socket_receiveUserDataShadow(Transport* transport, Thread* thread, void* buffer,
+                                            gsize nBytes, in_addr_t* ip, in_port_t* port) {
+    Socket* socket = _socket_fromLegacyDescriptor((LegacyDescriptor*)transport);
+    MAGIC_ASSERT(socket);
+    MAGIC_ASSERT(socket->vtable);
+    if (!socket->vtable->receiveShadow) {
+        return -ENOTSUP;
+    }
+    return socket->vtable->receiveShadow((Transport*)socket, thread, buffer, nBytes, ip, port);
+}
+
+TransportFunctionTable socket_functions = {_socket_close,
+                                           _socket_free,
+                                           _socket_sendUserData,
+                                           _socket_receiveUserData,
+                                           _socket_sendUserDataShadow,
+                                           _socket_receiveUserDataShadow,
+                                           MAGIC_VALUE};
 
 void socket_init(Socket* socket, Host* host, SocketFunctionTable* vtable, LegacyDescriptorType type,
                  guint receiveBufferSize, guint sendBufferSize) {
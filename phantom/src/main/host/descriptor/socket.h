@@ -31,6 +31,8 @@ struct _SocketFunctionTable {
     DescriptorFreeFunc free;
     TransportSendFunc send;
     TransportReceiveFunc receive;
+    TransportSendShadowFunc sendShadow;
+    TransportReceiveShadowFunc receiveShadow;
     SocketProcessFunc process;
     SocketIsFamilySupportedFunc isFamilySupported;
     SocketConnectToPeerFunc connectToPeer;
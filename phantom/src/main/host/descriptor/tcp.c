@@ -141,7 +141,6 @@ struct _TCP {
         guint32 lastWindow;
         guint32 lastAcknowledgment;
         guint32 lastSequence;
-        gboolean windowUpdatePending;
         GList* lastSelectiveACKs;
     } receive;
 
@@ -165,7 +164,6 @@ struct _TCP {
         guint32 packetsSent;
         /* total number of quick acknowledgments sent */
         guint32 numQuickACKsSent;
-        gboolean delayedACKIsScheduled;
         guint32 delayedACKCounter;
         /* list of selective ACKs, packets received after a missing packet */
         GList* selectiveACKs;
@@ -178,9 +176,7 @@ struct _TCP {
         gsize queueLength;
         /* retransmission timeout value (rto), in milliseconds */
         gint timeout;
-        /* when the scheduled timer events will expire; empty if no retransmit is scheduled */
-        PriorityQueue* scheduledTimerExpirations;
-        /* our updated expiration time, to determine if previous events are still valid */
+        /* when the retransmit timer expires; 0 if it is not running */
         SimulationTime desiredTimerExpiration;
         /* number of times we backed off due to congestion */
         guint backoffCount;
@@ -188,6 +184,21 @@ struct _TCP {
         void *tally;
     } retransmit;
 
+    /* all of our timers share one deadline slot: a single scheduled event that is moved
+     * in place whenever the earliest timer expiration changes, so that stale expirations
+     * never sit in the host's event queue */
+    struct {
+        /* handle to our pending timer event; NULL if no event is scheduled */
+        Event* event;
+        /* when the pending timer event fires */
+        SimulationTime eventExpiration;
+        /* when each timer expires; 0 if the timer is not armed. the
+         * retransmit timer is tracked in retransmit.desiredTimerExpiration */
+        SimulationTime delayedACKExpiration;
+        SimulationTime windowUpdateExpiration;
+        SimulationTime closeExpiration;
+    } timer;
+
     /* tcp autotuning for the send and recv buffers */
     struct {
         gboolean isEnabled;
@@ -604,8 +615,9 @@ void tcp_disableReceiveBufferAutotuning(TCP* tcp) {
 }
 
 // XXX declaration
-static void _tcp_runCloseTimerExpiredTask(Host* host, gpointer tcp, gpointer userData);
 static void _tcp_clearRetransmit(TCP* tcp, guint sequence);
+static void _tcp_updateTimer(TCP* tcp, Host* host);
+static void _tcp_clearTimers(TCP* tcp, Host* host);
 
 static void _tcp_setState(TCP* tcp, Host* host, enum TCPState state) {
     MAGIC_ASSERT(tcp);
@@ -643,6 +655,9 @@ static void _tcp_setState(TCP* tcp, Host* host, enum TCPState state) {
         case TCPS_CLOSED: {
             _tcp_clearRetransmit(tcp, (guint)-1);
 
+            /* nothing is left to time out, so don't leave our timer event in the queue */
+            _tcp_clearTimers(tcp, host);
+
             /* user can no longer use socket */
             descriptor_adjustStatus((LegacyDescriptor*)tcp, STATUS_DESCRIPTOR_ACTIVE, FALSE);
 
@@ -680,10 +695,7 @@ static void _tcp_setState(TCP* tcp, Host* host, enum TCPState state) {
             break;
         }
         case TCPS_TIMEWAIT: {
-            /* schedule a close timer self-event to finish out the closing process */
-            descriptor_ref(tcp);
-            Task* closeTask =
-                task_new(_tcp_runCloseTimerExpiredTask, tcp, NULL, descriptor_unref, NULL);
+            /* arm the close timer to finish out the closing process */
             SimulationTime delay = CONFIG_TCPCLOSETIMER_DELAY;
 
             /* if a child of a server initiated the close, close more quickly */
@@ -691,8 +703,11 @@ static void _tcp_setState(TCP* tcp, Host* host, enum TCPState state) {
                 delay = SIMTIME_ONE_SECOND;
             }
 
-            worker_scheduleTask(closeTask, host, delay);
-            task_unref(closeTask);
+            /* the first close timer wins if we get here more than once */
+            if(tcp->timer.closeExpiration == 0) {
+                tcp->timer.closeExpiration = worker_getCurrentTime() + delay;
+                _tcp_updateTimer(tcp, host);
+            }
             break;
         }
         default:
@@ -700,12 +715,6 @@ static void _tcp_setState(TCP* tcp, Host* host, enum TCPState state) {
     }
 }
 
-static void _tcp_runCloseTimerExpiredTask(Host* host, gpointer voidTcp, gpointer userData) {
-    TCP* tcp = voidTcp;
-    MAGIC_ASSERT(tcp);
-    _tcp_setState(tcp, host, TCPS_CLOSED);
-}
-
 /* returns the total amount of buffered data in this TCP socket, including TCP-specific buffers */
 gsize tcp_getOutputBufferLength(TCP* tcp) {
     MAGIC_ASSERT(tcp);
@@ -850,15 +859,21 @@ static Packet* _tcp_createPacketWithoutPayload(TCP* tcp, Host* host, enum Protoc
     return packet;
 }
 
+/* the payload is read from shadowPayload if it is non-NULL, or from the plugin otherwise */
 static Packet* _tcp_createDataPacket(TCP* tcp, Thread* thread, enum ProtocolTCPFlags flags,
-                                     PluginVirtualPtr payload, gsize payloadLength) {
+                                     PluginVirtualPtr payload, const guchar* shadowPayload,
+                                     gsize payloadLength) {
     MAGIC_ASSERT(tcp);
 
     Host* host = thread_getHost(thread);
     bool isEmpty = payloadLength == 0;
     Packet* packet = _tcp_createPacketWithoutPayload(tcp, host, flags, isEmpty);
     if (!isEmpty) {
-        packet_setPayload(packet, thread, payload, payloadLength);
+        if (shadowPayload) {
+            packet_setPayloadShadow(packet, host, shadowPayload, payloadLength);
+        } else {
+            packet_setPayload(packet, thread, payload, payloadLength);
+        }
     }
     return packet;
 }
@@ -978,45 +993,80 @@ static void _tcp_clearRetransmitRange(TCP* tcp, guint begin, guint end) {
 }
 
 // XXX forward declaration
-static void _tcp_runRetransmitTimerExpiredTask(Host* host, gpointer /*TCP*/ tcp,
-                                               gpointer /*Thread*/ thread);
+static void _tcp_runTimerExpiredTask(Host* host, gpointer /*TCP*/ tcp, gpointer unused);
 
-static void _tcp_scheduleRetransmitTimer(TCP* tcp, Host* host, SimulationTime now,
-                                         SimulationTime delay) {
+static SimulationTime _tcp_getNextTimerExpiration(TCP* tcp) {
     MAGIC_ASSERT(tcp);
 
-    SimulationTime* expireTimePtr = g_new0(SimulationTime, 1);
-    *expireTimePtr = now + delay;
-    gboolean success = priorityqueue_push(tcp->retransmit.scheduledTimerExpirations, expireTimePtr);
+    SimulationTime expirations[] = {
+        tcp->retransmit.desiredTimerExpiration,
+        tcp->timer.delayedACKExpiration,
+        tcp->timer.windowUpdateExpiration,
+        tcp->timer.closeExpiration,
+    };
 
-    if(success) {
-        descriptor_ref(tcp);
-        Task* retexpTask =
-            task_new(_tcp_runRetransmitTimerExpiredTask, tcp, NULL, descriptor_unref, NULL);
-        worker_scheduleTask(retexpTask, host, delay);
-        task_unref(retexpTask);
-
-        trace("%s retransmit timer scheduled for %"G_GUINT64_FORMAT" ns",
-                tcp->super.boundString, *expireTimePtr);
-    } else {
-        warning("%s could not schedule a retransmit timer for %"G_GUINT64_FORMAT" ns",
-                tcp->super.boundString, *expireTimePtr);
-        g_free(expireTimePtr);
+    /* disarmed timers are 0; returns 0 if no timer is armed */
+    SimulationTime next = 0;
+    for(gsize i = 0; i < G_N_ELEMENTS(expirations); i++) {
+        if(expirations[i] != 0 && (next == 0 || expirations[i] < next)) {
+            next = expirations[i];
+        }
     }
+    return next;
 }
 
-static void _tcp_scheduleRetransmitTimerIfNeeded(TCP* tcp, Host* host, SimulationTime now) {
-    /* logic for scheduling retransmission events. we only need to schedule one if
-     * we have no events that will allow us to schedule one later. */
-    SimulationTime* nextTimePtr = priorityqueue_peek(tcp->retransmit.scheduledTimerExpirations);
-    if(nextTimePtr && *nextTimePtr <= tcp->retransmit.desiredTimerExpiration) {
-        /* another event will fire before the RTO expires, check again then */
+/* make our single timer event fire at the earliest armed timer expiration, moving
+ * the pending event in place if we have one, or cancelling it if nothing is armed */
+static void _tcp_updateTimer(TCP* tcp, Host* host) {
+    MAGIC_ASSERT(tcp);
+
+    SimulationTime next = _tcp_getNextTimerExpiration(tcp);
+
+    if(tcp->timer.event && next == tcp->timer.eventExpiration) {
+        /* already scheduled exactly when we need it */
+        return;
+    }
+
+    if(next == 0) {
+        if(tcp->timer.event) {
+            worker_cancelTask(tcp->timer.event);
+            tcp->timer.event = NULL;
+            tcp->timer.eventExpiration = 0;
+            trace("%s timer event cancelled", tcp->super.boundString);
+        }
+        return;
+    }
+
+    SimulationTime now = worker_getCurrentTime();
+    SimulationTime delay = (next > now) ? next - now : 0;
+
+    if(tcp->timer.event && worker_rescheduleTask(tcp->timer.event, delay)) {
+        tcp->timer.eventExpiration = next;
+        trace("%s timer event moved to %"G_GUINT64_FORMAT" ns", tcp->super.boundString, next);
         return;
     }
 
-    /* no existing timer will expire as early as desired */
-    SimulationTime delay = tcp->retransmit.desiredTimerExpiration - now;
-    _tcp_scheduleRetransmitTimer(tcp, host, now, delay);
+    /* we don't have an event in the queue, so we need a new one. the task does not hold a
+     * reference to us, since we cancel the event in _tcp_free */
+    Task* timerTask = task_new(_tcp_runTimerExpiredTask, tcp, NULL, NULL, NULL);
+    tcp->timer.event = worker_scheduleTaskWithHandle(timerTask, host, delay);
+    task_unref(timerTask);
+
+    if(tcp->timer.event) {
+        tcp->timer.eventExpiration = next;
+        trace("%s timer event scheduled for %"G_GUINT64_FORMAT" ns", tcp->super.boundString, next);
+    } else {
+        tcp->timer.eventExpiration = 0;
+    }
+}
+
+static void _tcp_clearTimers(TCP* tcp, Host* host) {
+    MAGIC_ASSERT(tcp);
+    tcp->retransmit.desiredTimerExpiration = 0;
+    tcp->timer.delayedACKExpiration = 0;
+    tcp->timer.windowUpdateExpiration = 0;
+    tcp->timer.closeExpiration = 0;
+    _tcp_updateTimer(tcp, host);
 }
 
 static void _tcp_setRetransmitTimer(TCP* tcp, Host* host, SimulationTime now) {
@@ -1027,14 +1077,13 @@ static void _tcp_setRetransmitTimer(TCP* tcp, Host* host, SimulationTime now) {
     SimulationTime delay = tcp->retransmit.timeout * SIMTIME_ONE_MILLISECOND;
     tcp->retransmit.desiredTimerExpiration = now + delay;
 
-    _tcp_scheduleRetransmitTimerIfNeeded(tcp, host, now);
+    _tcp_updateTimer(tcp, host);
 }
 
-static void _tcp_stopRetransmitTimer(TCP* tcp) {
+static void _tcp_stopRetransmitTimer(TCP* tcp, Host* host) {
     MAGIC_ASSERT(tcp);
-    /* we want to stop the timer. since there may be an event already scheduled,
-     * lets mark our desired time as 0 so we know to cancel when the event fires. */
     tcp->retransmit.desiredTimerExpiration = 0;
+    _tcp_updateTimer(tcp, host);
 
     trace("%s retransmit timer disabled", tcp->super.boundString);
 }
@@ -1337,37 +1386,20 @@ static void _tcp_flush(TCP* tcp, Host* host) {
     }
 }
 
-static void _tcp_runRetransmitTimerExpiredTask(Host* host, gpointer voidTcp, gpointer unused) {
-    TCP* tcp = voidTcp;
+static void _tcp_runRetransmitTimerExpired(TCP* tcp, Host* host, SimulationTime now) {
     MAGIC_ASSERT(tcp);
 
-    /* a timer expired, update our timer tracking state */
-    SimulationTime now = worker_getCurrentTime();
-    SimulationTime* scheduledTimerExpirationPtr = priorityqueue_pop(tcp->retransmit.scheduledTimerExpirations);
-    utility_assert(scheduledTimerExpirationPtr);
-    g_free(scheduledTimerExpirationPtr);
-
     trace("%s a scheduled retransmit timer expired", tcp->super.boundString);
 
     /* if we are closed, we don't care */
     if(tcp->state == TCPS_CLOSED) {
-        _tcp_stopRetransmitTimer(tcp);
+        _tcp_stopRetransmitTimer(tcp, host);
         _tcp_clearRetransmit(tcp, (guint)-1);
         return;
     }
 
     if(g_hash_table_size(tcp->retransmit.queue) == 0) {
-        _tcp_stopRetransmitTimer(tcp);
-        return;
-    }
-
-    /* if the timer should be off or was reset, ignore this event */
-    if(tcp->retransmit.desiredTimerExpiration == 0) {
-        return;
-    } else if(tcp->retransmit.desiredTimerExpiration > now) {
-        /* the timer was reset after this event was scheduled, check if we need to
-         * schedule another event, or if we can do it when the next event fires instead */
-        _tcp_scheduleRetransmitTimerIfNeeded(tcp, host, now);
+        _tcp_stopRetransmitTimer(tcp, host);
         return;
     }
 
@@ -1824,7 +1856,7 @@ TCPProcessFlags _tcp_ackProcessing(TCP* tcp, Host* host, Packet* packet, PacketT
     /* update retransmit state (rfc 6298, section 5.2-5.3) */
     if(tcp->retransmit.queueLength == 0) {
         /* all outstanding data has been acked */
-        _tcp_stopRetransmitTimer(tcp);
+        _tcp_stopRetransmitTimer(tcp, host);
     } else if(nPacketsAcked > 0) {
         /* new data has been acked */
         _tcp_setRetransmitTimer(tcp, host, now);
@@ -1853,10 +1885,8 @@ static void _tcp_logCongestionInfo(TCP* tcp) {
           tcp->super.super.super.handle);
 }
 
-static void _tcp_sendACKTaskCallback(Host* host, gpointer voidTcp, gpointer userData) {
-    TCP* tcp = voidTcp;
+static void _tcp_sendDelayedACK(TCP* tcp, Host* host) {
     MAGIC_ASSERT(tcp);
-    tcp->send.delayedACKIsScheduled = FALSE;
     if(tcp->send.delayedACKCounter > 0) {
         trace("sending a delayed ACK now");
         _tcp_sendControlPacket(tcp, host, PTCP_ACK);
@@ -2175,13 +2205,9 @@ static void _tcp_processPacket(Socket* socket, Host* host, Packet* packet) {
             _tcp_sendControlPacket(tcp, host, responseFlags);
         } else {
             trace("waiting for delayed ACK control packet");
-            if(tcp->send.delayedACKIsScheduled == FALSE) {
-                /* we need to send an ACK, lets schedule a task so we don't send an ACK
+            if(tcp->timer.delayedACKExpiration == 0) {
+                /* we need to send an ACK, lets arm a timer so we don't send an ACK
                  * for all packets that are received during this same simtime receiving round. */
-                Task* sendACKTask =
-                    task_new(_tcp_sendACKTaskCallback, tcp, NULL, descriptor_unref, NULL);
-                /* taks holds a ref to tcp */
-                descriptor_ref(tcp);
 
                 /* figure out what we should use as delay */
                 SimulationTime delay = 0;
@@ -2194,10 +2220,8 @@ static void _tcp_processPacket(Socket* socket, Host* host, Packet* packet) {
                     delay = 5*SIMTIME_ONE_MILLISECOND;
                 }
 
-                worker_scheduleTask(sendACKTask, host, delay);
-                task_unref(sendACKTask);
-
-                tcp->send.delayedACKIsScheduled = TRUE;
+                tcp->timer.delayedACKExpiration = worker_getCurrentTime() + delay;
+                _tcp_updateTimer(tcp, host);
             }
             tcp->send.delayedACKCounter++;
         }
@@ -2238,8 +2262,10 @@ static void _tcp_endOfFileSignalled(TCP* tcp, enum TCPFlags flags) {
     }
 }
 
-static gssize _tcp_sendUserData(Transport* transport, Thread* thread, PluginVirtualPtr buffer,
-                                gsize nBytes, in_addr_t ip, in_port_t port) {
+/* sends from shadowBuffer if it is non-NULL, or from the plugin's buffer otherwise */
+static gssize _tcp_sendUserDataHelper(Transport* transport, Thread* thread,
+                                      PluginVirtualPtr buffer, const guchar* shadowBuffer,
+                                      gsize nBytes) {
     TCP* tcp = _tcp_fromLegacyDescriptor((LegacyDescriptor*)transport);
     MAGIC_ASSERT(tcp);
 
@@ -2256,7 +2282,7 @@ static gssize _tcp_sendUserData(Transport* transport, Thread* thread, PluginVirt
     }
 
     /* maximum data we can send network, o/w tcp truncates and only sends 65536*/
-    gsize acceptable = MIN(nBytes, 65535);
+    gsize acceptable = MIN(nBytes, TCP_MAX_SEND_SIZE);
     gsize space = _tcp_getBufferSpaceOut(tcp);
     gsize remaining = MIN(acceptable, space);
 
@@ -2269,8 +2295,10 @@ static gssize _tcp_sendUserData(Transport* transport, Thread* thread, PluginVirt
         gsize copyLength = MIN(maxPacketLength, remaining);
 
         /* use helper to create the packet */
-        Packet* packet = _tcp_createDataPacket(
-            tcp, thread, PTCP_ACK, (PluginVirtualPtr){.val = buffer.val + bytesCopied}, copyLength);
+        Packet* packet =
+            _tcp_createDataPacket(tcp, thread, PTCP_ACK,
+                                  (PluginVirtualPtr){.val = buffer.val + bytesCopied},
+                                  shadowBuffer ? shadowBuffer + bytesCopied : NULL, copyLength);
         if(copyLength > 0) {
             /* we are sending more user data */
             tcp->send.end++;
@@ -2294,8 +2322,17 @@ static gssize _tcp_sendUserData(Transport* transport, Thread* thread, PluginVirt
     return (gssize)(bytesCopied == 0 && nBytes != 0 ? -EWOULDBLOCK : bytesCopied);
 }
 
-static void _tcp_sendWindowUpdate(Host* host, gpointer voidTcp, gpointer data) {
-    TCP* tcp = voidTcp;
+static gssize _tcp_sendUserData(Transport* transport, Thread* thread, PluginVirtualPtr buffer,
+                                gsize nBytes, in_addr_t ip, in_port_t port) {
+    return _tcp_sendUserDataHelper(transport, thread, buffer, NULL, nBytes);
+}
+
+static gssize _tcp_sendUserDataShadow(Transport* transport, Thread* thread, const void* buffer,
+                                      gsize nBytes, in_addr_t ip, in_port_t port) {
+    return _tcp_sendUserDataHelper(transport, thread, (PluginVirtualPtr){0}, buffer, nBytes);
+}
+
+static void _tcp_sendWindowUpdate(TCP* tcp, Host* host) {
     MAGIC_ASSERT(tcp);
     trace("%s <-> %s: receive window opened, advertising the new "
             "receive window %"G_GUINT32_FORMAT" as an ACK control packet",
@@ -2303,12 +2340,61 @@ static void _tcp_sendWindowUpdate(Host* host, gpointer voidTcp, gpointer data) {
 
     // XXX we may be in trouble if this packet gets dropped
     _tcp_sendControlPacket(tcp, host, PTCP_ACK);
+}
+
+static void _tcp_runTimerExpiredTask(Host* host, gpointer voidTcp, gpointer unused) {
+    TCP* tcp = voidTcp;
+    MAGIC_ASSERT(tcp);
+
+    /* our event is running, so it's no longer in the queue */
+    tcp->timer.event = NULL;
+    tcp->timer.eventExpiration = 0;
 
-    tcp->receive.windowUpdatePending = FALSE;
+    /* don't let a close free us while we are still running timers */
+    descriptor_ref(tcp);
+
+    SimulationTime now = worker_getCurrentTime();
+
+    /* run every timer that expired, in a fixed order so that we stay deterministic */
+    if(tcp->retransmit.desiredTimerExpiration && tcp->retransmit.desiredTimerExpiration <= now) {
+        _tcp_runRetransmitTimerExpired(tcp, host, now);
+    }
+    if(tcp->timer.delayedACKExpiration && tcp->timer.delayedACKExpiration <= now) {
+        tcp->timer.delayedACKExpiration = 0;
+        _tcp_sendDelayedACK(tcp, host);
+    }
+    if(tcp->timer.windowUpdateExpiration && tcp->timer.windowUpdateExpiration <= now) {
+        tcp->timer.windowUpdateExpiration = 0;
+        _tcp_sendWindowUpdate(tcp, host);
+    }
+    if(tcp->timer.closeExpiration && tcp->timer.closeExpiration <= now) {
+        tcp->timer.closeExpiration = 0;
+        /* this clears all remaining timers */
+        _tcp_setState(tcp, host, TCPS_CLOSED);
+    }
+
+    /* wait for whatever timers are still armed */
+    _tcp_updateTimer(tcp, host);
+    descriptor_unref(tcp);
 }
 
-static gssize _tcp_receiveUserData(Transport* transport, Thread* thread, PluginVirtualPtr buffer,
-                                   gsize nBytes, in_addr_t* ip, in_port_t* port) {
+/* copy payload bytes to shadowBuffer + bufferOffset if shadowBuffer is non-NULL, or to
+ * the plugin's buffer + bufferOffset otherwise */
+static gssize _tcp_copyPayloadOut(const Packet* packet, Thread* thread, gsize payloadOffset,
+                                  PluginVirtualPtr buffer, guchar* shadowBuffer,
+                                  gsize bufferOffset, gsize copyLength) {
+    if (shadowBuffer) {
+        return (gssize)packet_copyPayloadShadow(
+            (Packet*)packet, payloadOffset, shadowBuffer + bufferOffset, copyLength);
+    }
+    return packet_copyPayload(packet, thread, payloadOffset,
+                              (PluginVirtualPtr){.val = buffer.val + bufferOffset}, copyLength);
+}
+
+/* receives into shadowBuffer if it is non-NULL, or into the plugin's buffer otherwise */
+static gssize _tcp_receiveUserDataHelper(Transport* transport, Thread* thread,
+                                         PluginVirtualPtr buffer, guchar* shadowBuffer,
+                                         gsize nBytes) {
     TCP* tcp = _tcp_fromLegacyDescriptor((LegacyDescriptor*)transport);
     MAGIC_ASSERT(tcp);
 
@@ -2336,7 +2422,7 @@ static gssize _tcp_receiveUserData(Transport* transport, Thread* thread, PluginV
         return -EWOULDBLOCK;
     }
 
-    if (buffer.val == 0 && nBytes > 0) {
+    if (buffer.val == 0 && shadowBuffer == NULL && nBytes > 0) {
         debug("Can't recv >0 bytes into NULL buffer on socket");
         return -EFAULT;
     }
@@ -2348,8 +2434,9 @@ static gssize _tcp_receiveUserData(Transport* transport, Thread* thread, PluginV
         utility_assert(partialBytes > 0);
 
         copyLength = MIN(partialBytes, remaining);
-        gssize bytesCopied = packet_copyPayload(
-            tcp->partialUserDataPacket, thread, tcp->partialOffset, buffer, copyLength);
+        gssize bytesCopied = _tcp_copyPayloadOut(tcp->partialUserDataPacket, thread,
+                                                 tcp->partialOffset, buffer, shadowBuffer, 0,
+                                                 copyLength);
         if (bytesCopied < 0) {
             // Error writing to PluginVirtualPtr
             return bytesCopied;
@@ -2387,8 +2474,8 @@ static gssize _tcp_receiveUserData(Transport* transport, Thread* thread, PluginV
 
         guint packetLength = packet_getPayloadLength(nextPacket);
         copyLength = MIN(packetLength, remaining);
-        gssize bytesCopied = packet_copyPayload(
-            nextPacket, thread, 0, (PluginVirtualPtr){.val = buffer.val + offset}, copyLength);
+        gssize bytesCopied =
+            _tcp_copyPayloadOut(nextPacket, thread, 0, buffer, shadowBuffer, offset, copyLength);
         if (bytesCopied < 0) {
             // Error writing to PluginVirtualPtr
             if (totalCopied > 0) {
@@ -2456,17 +2543,12 @@ static gssize _tcp_receiveUserData(Transport* transport, Thread* thread, PluginV
     /* if we have advertised a 0 window because the application wasn't reading,
      * we now have to update the window and let the sender know */
     _tcp_updateReceiveWindow(tcp);
-    if(tcp->receive.window > tcp->send.lastWindow && !tcp->receive.windowUpdatePending) {
+    if(tcp->receive.window > tcp->send.lastWindow && tcp->timer.windowUpdateExpiration == 0) {
         /* our receive window just opened, make sure the sender knows it can
          * send more. otherwise we get into a deadlock situation!
-         * make sure we don't send multiple events when read is called many times per instant */
-        descriptor_ref(tcp);
-
-        Task* updateWindowTask = task_new(_tcp_sendWindowUpdate, tcp, NULL, descriptor_unref, NULL);
-        worker_scheduleTask(updateWindowTask, thread_getHost(thread), 1);
-        task_unref(updateWindowTask);
-
-        tcp->receive.windowUpdatePending = TRUE;
+         * make sure we don't send multiple updates when read is called many times per instant */
+        tcp->timer.windowUpdateExpiration = worker_getCurrentTime() + 1;
+        _tcp_updateTimer(tcp, host);
     }
 
     trace("%s <-> %s: receiving %" G_GSIZE_FORMAT " user bytes", tcp->super.boundString,
@@ -2481,6 +2563,16 @@ static gssize _tcp_receiveUserData(Transport* transport, Thread* thread, PluginV
     return totalCopied;
 }
 
+static gssize _tcp_receiveUserData(Transport* transport, Thread* thread, PluginVirtualPtr buffer,
+                                   gsize nBytes, in_addr_t* ip, in_port_t* port) {
+    return _tcp_receiveUserDataHelper(transport, thread, buffer, NULL, nBytes);
+}
+
+static gssize _tcp_receiveUserDataShadow(Transport* transport, Thread* thread, void* buffer,
+                                         gsize nBytes, in_addr_t* ip, in_port_t* port) {
+    return _tcp_receiveUserDataHelper(transport, thread, (PluginVirtualPtr){0}, buffer, nBytes);
+}
+
 static void _tcp_free(LegacyDescriptor* descriptor) {
     TCP* tcp = _tcp_fromLegacyDescriptor(descriptor);
     MAGIC_ASSERT(tcp);
@@ -2488,7 +2580,12 @@ static void _tcp_free(LegacyDescriptor* descriptor) {
     priorityqueue_free(tcp->throttledOutput);
     priorityqueue_free(tcp->unorderedInput);
     g_hash_table_destroy(tcp->retransmit.queue);
-    priorityqueue_free(tcp->retransmit.scheduledTimerExpirations);
+
+    if(tcp->timer.event) {
+        /* the event's task points to us without a reference */
+        worker_cancelTask(tcp->timer.event);
+        tcp->timer.event = NULL;
+    }
 
     if (tcp->partialUserDataPacket != NULL) {
         packet_unref(tcp->partialUserDataPacket);
@@ -2608,8 +2705,9 @@ gint tcp_shutdown(TCP* tcp, Host* host, gint how) {
 /* we implement the socket interface, this describes our function suite */
 SocketFunctionTable tcp_functions = {
     _tcp_close,           _tcp_free,          _tcp_sendUserData,
-    _tcp_receiveUserData, _tcp_processPacket, _tcp_isFamilySupported,
-    _tcp_connectToPeer,   _tcp_dropPacket,    MAGIC_VALUE};
+    _tcp_receiveUserData, _tcp_sendUserDataShadow, _tcp_receiveUserDataShadow,
+    _tcp_processPacket,   _tcp_isFamilySupported, _tcp_connectToPeer,
+    _tcp_dropPacket,      MAGIC_VALUE};
 
 TCP* tcp_new(Host* host, guint receiveBufferSize, guint sendBufferSize) {
     TCP* tcp = g_new0(TCP, 1);
@@ -2654,9 +2752,6 @@ TCP* tcp_new(Host* host, guint receiveBufferSize, guint sendBufferSize) {
 
     retransmit_tally_init(&tcp->retransmit.tally);
 
-    tcp->retransmit.scheduledTimerExpirations =
-            priorityqueue_new((GCompareDataFunc)utility_simulationTimeCompare, NULL, g_free);
-
     /* initialize tcp retransmission timeout */
     _tcp_setRetransmitTimeout(tcp, CONFIG_TCP_RTO_INIT);
 
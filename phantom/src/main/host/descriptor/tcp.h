@@ -16,6 +16,8 @@
 #include "main/routing/packet.minimal.h"
 
 #define TCP_MIN_CWND 10
+/* the most user data that a single send call will accept */
+#define TCP_MAX_SEND_SIZE 65535
 
 typedef struct _TCP TCP;
 struct TCPCong_;
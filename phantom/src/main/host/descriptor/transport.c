@@ -4,6 +4,7 @@
  * See LICENSE for licensing information
  */
 
+#include <errno.h>
 #include <glib.h>
 #include <netinet/in.h>
 
@@ -68,3 +69,23 @@ gssize transport_receiveUserData(Transport* transport, Thread* thread, PluginVir
     MAGIC_ASSERT(transport->vtable);
     return transport->vtable->receive(transport, thread, buffer, nBytes, ip, port);
 }
+
+gssize transport_sendUserDataShadow(Transport* transport, Thread* thread, const void* buffer,
+                                    gsize nBytes, in_addr_t ip, in_port_t port) {
+    MAGIC_ASSERT(transport);
+    MAGIC_ASSERT(transport->vtable);
+    if (!transport->vtable->sendShadow) {
+        return -ENOTSUP;
+    }
+    return transport->vtable->sendShadow(transport, thread, buffer, nBytes, ip, port);
+}
+
+gssize transport_receiveUserDataShadow(Transport* transport, Thread* thread, void* buffer,
+                                       gsize nBytes, in_addr_t* ip, in_port_t* port) {
+    MAGIC_ASSERT(transport);
+    MAGIC_ASSERT(transport->vtable);
+    if (!transport->vtable->receiveShadow) {
+        return -ENOTSUP;
+    }
+    return transport->vtable->receiveShadow(transport, thread, buffer, nBytes, ip, port);
+}
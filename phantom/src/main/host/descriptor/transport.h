@@ -24,12 +24,23 @@ typedef gssize (*TransportSendFunc)(Transport* transport, Thread* thread, Plugin
 typedef gssize (*TransportReceiveFunc)(Transport* transport, Thread* thread,
                                        PluginVirtualPtr buffer, gsize nBytes, in_addr_t* ip,
                                        in_port_t* port);
+/* Like TransportSendFunc and TransportReceiveFunc, but the user data is in a buffer
+ * in shadow's memory, which the syscall layer gathered from or will scatter to
+ * plugin memory. These are optional; transports that don't implement them set
+ * them to NULL. */
+typedef gssize (*TransportSendShadowFunc)(Transport* transport, Thread* thread,
+                                          const void* buffer, gsize nBytes, in_addr_t ip,
+                                          in_port_t port);
+typedef gssize (*TransportReceiveShadowFunc)(Transport* transport, Thread* thread, void* buffer,
+                                             gsize nBytes, in_addr_t* ip, in_port_t* port);
 
 struct _TransportFunctionTable {
     DescriptorCloseFunc close;
     DescriptorFreeFunc free;
     TransportSendFunc send;
     TransportReceiveFunc receive;
+    TransportSendShadowFunc sendShadow;
+    TransportReceiveShadowFunc receiveShadow;
     MAGIC_DECLARE_ALWAYS;
 };
 
@@ -47,5 +58,10 @@ gssize transport_sendUserData(Transport* transport, Thread* thread, PluginVirtua
                               gsize nBytes, in_addr_t ip, in_port_t port);
 gssize transport_receiveUserData(Transport* transport, Thread* thread, PluginVirtualPtr buffer,
                                  gsize nBytes, in_addr_t* ip, in_port_t* port);
+/* Returns -ENOTSUP if the transport can't send from or receive into shadow's memory. */
+gssize transport_sendUserDataShadow(Transport* transport, Thread* thread, const void* buffer,
+                                    gsize nBytes, in_addr_t ip, in_port_t port);
+gssize transport_receiveUserDataShadow(Transport* transport, Thread* thread, void* buffer,
+                                       gsize nBytes, in_addr_t* ip, in_port_t* port);
 
 #endif /* SHD_TRANSPORT_H_ */
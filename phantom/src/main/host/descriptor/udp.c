@@ -105,9 +105,11 @@ static void _udp_dropPacket(Socket* socket, Host* host, Packet* packet) {
  * this function builds a UDP packet and sends to the virtual node given by the
  * ip and port parameters. this function assumes that the socket is already
  * bound to a local port, no matter if that happened explicitly or implicitly.
+ * the payload comes from shadowBuffer if it is non-NULL, or from the plugin's buffer otherwise.
  */
-static gssize _udp_sendUserData(Transport* transport, Thread* thread, PluginVirtualPtr buffer,
-                                gsize nBytes, in_addr_t ip, in_port_t port) {
+static gssize _udp_sendUserDataHelper(Transport* transport, Thread* thread,
+                                      PluginVirtualPtr buffer, const void* shadowBuffer,
+                                      gsize nBytes, in_addr_t ip, in_port_t port) {
     UDP* udp = _udp_fromLegacyDescriptor((LegacyDescriptor*)transport);
     MAGIC_ASSERT(udp);
 
@@ -144,7 +146,11 @@ static gssize _udp_sendUserData(Transport* transport, Thread* thread, PluginVirt
 
     /* create the UDP packet */
     Packet* packet = packet_new(host);
-    packet_setPayload(packet, thread, buffer, nBytes);
+    if (shadowBuffer) {
+        packet_setPayloadShadow(packet, host, shadowBuffer, nBytes);
+    } else {
+        packet_setPayload(packet, thread, buffer, nBytes);
+    }
     packet_setUDP(packet, PUDP_NONE, sourceIP, sourcePort, destinationIP, destinationPort);
     packet_addDeliveryStatus(packet, PDS_SND_CREATED);
 
@@ -169,8 +175,21 @@ static gssize _udp_sendUserData(Transport* transport, Thread* thread, PluginVirt
     return bytes_sent;
 }
 
-static gssize _udp_receiveUserData(Transport* transport, Thread* thread, PluginVirtualPtr buffer,
-                                   gsize nBytes, in_addr_t* ip, in_port_t* port) {
+static gssize _udp_sendUserData(Transport* transport, Thread* thread, PluginVirtualPtr buffer,
+                                gsize nBytes, in_addr_t ip, in_port_t port) {
+    return _udp_sendUserDataHelper(transport, thread, buffer, NULL, nBytes, ip, port);
+}
+
+static gssize _udp_sendUserDataShadow(Transport* transport, Thread* thread, const void* buffer,
+                                      gsize nBytes, in_addr_t ip, in_port_t port) {
+    return _udp_sendUserDataHelper(
+        transport, thread, (PluginVirtualPtr){0}, buffer, nBytes, ip, port);
+}
+
+/* receives into shadowBuffer if it is non-NULL, or into the plugin's buffer otherwise */
+static gssize _udp_receiveUserDataHelper(Transport* transport, Thread* thread,
+                                         PluginVirtualPtr buffer, void* shadowBuffer,
+                                         gsize nBytes, in_addr_t* ip, in_port_t* port) {
     UDP* udp = _udp_fromLegacyDescriptor((LegacyDescriptor*)transport);
     MAGIC_ASSERT(udp);
 
@@ -178,7 +197,7 @@ static gssize _udp_receiveUserData(Transport* transport, Thread* thread, PluginV
         return -EWOULDBLOCK;
     }
 
-    if (buffer.val == 0 && nBytes > 0) {
+    if (buffer.val == 0 && shadowBuffer == NULL && nBytes > 0) {
         return -EFAULT;
     }
 
@@ -190,7 +209,13 @@ static gssize _udp_receiveUserData(Transport* transport, Thread* thread, PluginV
     /* copy lesser of requested and available amount to application buffer */
     guint packetLength = packet_getPayloadLength(nextPacket);
     gsize copyLength = MIN(nBytes, packetLength);
-    gssize bytesCopied = packet_copyPayload(nextPacket, thread, 0, buffer, copyLength);
+    gssize bytesCopied = 0;
+    if (shadowBuffer) {
+        bytesCopied =
+            (gssize)packet_copyPayloadShadow((Packet*)nextPacket, 0, shadowBuffer, copyLength);
+    } else {
+        bytesCopied = packet_copyPayload(nextPacket, thread, 0, buffer, copyLength);
+    }
     if (bytesCopied < 0) {
         // Error writing to PluginVirtualPtr
         return bytesCopied;
@@ -217,6 +242,17 @@ static gssize _udp_receiveUserData(Transport* transport, Thread* thread, PluginV
     return bytesCopied;
 }
 
+static gssize _udp_receiveUserData(Transport* transport, Thread* thread, PluginVirtualPtr buffer,
+                                   gsize nBytes, in_addr_t* ip, in_port_t* port) {
+    return _udp_receiveUserDataHelper(transport, thread, buffer, NULL, nBytes, ip, port);
+}
+
+static gssize _udp_receiveUserDataShadow(Transport* transport, Thread* thread, void* buffer,
+                                         gsize nBytes, in_addr_t* ip, in_port_t* port) {
+    return _udp_receiveUserDataHelper(
+        transport, thread, (PluginVirtualPtr){0}, buffer, nBytes, ip, port);
+}
+
 static void _udp_free(LegacyDescriptor* descriptor) {
     UDP* udp = _udp_fromLegacyDescriptor(descriptor);
     MAGIC_ASSERT(udp);
@@ -249,8 +285,9 @@ gint udp_shutdown(UDP* udp, gint how) {
 /* we implement the socket interface, this describes our function suite */
 SocketFunctionTable udp_functions = {
     _udp_close,           _udp_free,          _udp_sendUserData,
-    _udp_receiveUserData, _udp_processPacket, _udp_isFamilySupported,
-    _udp_connectToPeer,   _udp_dropPacket,    MAGIC_VALUE};
+    _udp_receiveUserData, _udp_sendUserDataShadow, _udp_receiveUserDataShadow,
+    _udp_processPacket,   _udp_isFamilySupported, _udp_connectToPeer,
+    _udp_dropPacket,      MAGIC_VALUE};
 
 UDP* udp_new(Host* host, guint receiveBufferSize, guint sendBufferSize) {
     UDP* udp = g_new0(UDP, 1);
@@ -184,9 +184,11 @@ void host_setup(Host* host, DNS* dns, Topology* topology, guint rawCPUFreq, cons
     /* virtual addresses and interfaces for managing network I/O */
     NetworkInterface* loopback =
         networkinterface_new(host, loopbackAddress, G_MAXUINT32, G_MAXUINT32, host->params.pcapDir,
+                             host->params.pcapCaptureSize, host->params.pcapUseNg,
                              host->params.qdisc, host->params.interfaceBufSize);
     NetworkInterface* ethernet =
         networkinterface_new(host, ethernetAddress, bwDownKiBps, bwUpKiBps, host->params.pcapDir,
+                             host->params.pcapCaptureSize, host->params.pcapUseNg,
                              host->params.qdisc, host->params.interfaceBufSize);
 
     g_hash_table_replace(host->interfaces, GUINT_TO_POINTER((guint)address_toNetworkIP(ethernetAddress)), ethernet);
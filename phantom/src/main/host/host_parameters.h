@@ -37,6 +37,8 @@ struct _HostParameters {
     guint64 sendBufSize;
     gboolean autotuneSendBuf;
     guint64 interfaceBufSize;
+    guint32 pcapCaptureSize;
+    gboolean pcapUseNg;
 };
 
 #endif
\ No newline at end of file
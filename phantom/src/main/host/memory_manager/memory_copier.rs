@@ -106,6 +106,24 @@ impl MemoryCopier {
         Ok(())
     }
 
+    /// Gather `srcs`, in order, into `dst`, with a single `process_vm_readv`.
+    /// The total length of `srcs` must equal the length of `dst`.
+    /// SAFETY: A mutable reference to the process memory must not exist.
+    pub unsafe fn gather_from_ptrs(
+        &self,
+        dst: &mut [u8],
+        srcs: &[TypedPluginPtr<u8>],
+    ) -> Result<(), Errno> {
+        assert_eq!(dst.len(), srcs.iter().map(|s| s.len()).sum::<usize>());
+        let len = dst.len();
+        let bytes_read = unsafe { self.readv_ptrs(&mut [dst], srcs)? };
+        if bytes_read != len {
+            warn!("Tried to read {} bytes but only got {}", len, bytes_read);
+            return Err(Errno::EFAULT);
+        }
+        Ok(())
+    }
+
     // Low level helper for reading directly from `srcs` to `dsts`.
     // Returns the number of bytes read. Panics if the
     // MemoryManager's process isn't currently active.
@@ -198,4 +216,48 @@ impl MemoryCopier {
         assert_eq!(nwritten, towrite);
         Ok(())
     }
+
+    /// Scatter `src` across `dsts`, in order, with a single `process_vm_writev`.
+    /// The total length of `dsts` must equal the length of `src`. Panics if the
+    /// MemoryManager's process isn't currently active.
+    /// SAFETY: A reference to the process memory must not exist.
+    pub unsafe fn scatter_to_ptrs(
+        &self,
+        dsts: &[TypedPluginPtr<u8>],
+        src: &[u8],
+    ) -> Result<(), Errno> {
+        assert_eq!(src.len(), dsts.iter().map(|d| d.len()).sum::<usize>());
+        trace!(
+            "scatter_to_ptrs writing {} bytes to {} iovecs",
+            src.len(),
+            dsts.len()
+        );
+        let local = [nix::sys::uio::IoVec::from_slice(src)];
+        let remote: Vec<_> = dsts
+            .iter()
+            .map(|dst| nix::sys::uio::RemoteIoVec {
+                base: usize::from(dst.ptr()),
+                len: dst.len(),
+            })
+            .collect();
+
+        let active_tid = Worker::active_thread_native_tid().unwrap();
+        let active_pid = Worker::active_process_native_pid().unwrap();
+
+        // Don't access another process's memory.
+        assert_eq!(active_pid, self.pid);
+
+        // Unlike with a single remote iovec, the write stops early at the first
+        // remote iovec that isn't writable.
+        let nwritten = nix::sys::uio::process_vm_writev(active_tid, &local, &remote)?;
+        if nwritten != src.len() {
+            warn!(
+                "Tried to write {} bytes but only wrote {}",
+                src.len(),
+                nwritten
+            );
+            return Err(Errno::EFAULT);
+        }
+        Ok(())
+    }
 }
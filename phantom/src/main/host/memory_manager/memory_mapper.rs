@@ -1,6 +1,8 @@
+use crate::cshadow;
 use crate::host::memory_manager::{page_size, MemoryCopier, MemoryManager};
 use crate::host::syscall_types::{PluginPtr, SyscallResult, TypedPluginPtr};
 use crate::host::thread::Thread;
+use crate::utility::counter::Counter;
 use crate::utility::interval_map::{Interval, IntervalMap, Mutation};
 use crate::utility::notnull::*;
 use crate::utility::pod::Pod;
@@ -9,7 +11,7 @@ use crate::utility::proc_maps::{MappingPath, Sharing};
 use log::*;
 use nix::unistd::Pid;
 use nix::{fcntl, sys};
-use std::cell::RefCell;
+use std::cell::{Cell, RefCell};
 use std::collections::HashMap;
 use std::fmt::Debug;
 use std::fs::File;
@@ -18,10 +20,105 @@ use std::os::raw::c_void;
 use std::os::unix::io::AsRawFd;
 use std::path::PathBuf;
 use std::process;
+use std::rc::Rc;
 
 const HEAP_PROT: i32 = libc::PROT_READ | libc::PROT_WRITE;
 const STACK_PROT: i32 = libc::PROT_READ | libc::PROT_WRITE;
 
+// Mappings shorter than a huge page can't be backed by one, so we don't advise them.
+const HUGE_PAGE_LEN: usize = 2 << 20;
+
+// Regions larger than this are never remapped adaptively, since copying them in would be
+// expensive and they are most likely sparse reservations rather than hot buffers.
+const MAX_ADAPTIVE_REMAP_LEN: usize = 64 * (1 << 20);
+
+// File name of the shim library, whose mappings we never remap adaptively.
+const SHIM_LIB_NAME: &str = "libshadow-shim.so";
+
+/// Access counters for a region. Shared by all the pieces the region gets split into, so that
+/// splitting a region doesn't double count.
+#[derive(Debug)]
+struct RegionStats {
+    path: String,
+    hits: Cell<u64>,
+    misses: Cell<u64>,
+    remaps: Cell<u64>,
+    // Set once the region has been queued for adaptive remapping, so that we only try once.
+    remap_queued: Cell<bool>,
+}
+
+#[derive(Debug, Default, Clone, Copy)]
+struct RegionCounts {
+    hits: u64,
+    misses: u64,
+    remaps: u64,
+}
+
+impl RegionCounts {
+    fn add(&mut self, stats: &RegionStats) {
+        self.hits += stats.hits.get();
+        self.misses += stats.misses.get();
+        self.remaps += stats.remaps.get();
+    }
+}
+
+/// Keeps track of the stats of every region, so that we can report them at shutdown.
+#[derive(Debug, Default)]
+struct RegionStatsRegistry {
+    live: Vec<Rc<RegionStats>>,
+    // Totals by path of regions that no longer exist.
+    retired: HashMap<String, RegionCounts>,
+}
+
+impl RegionStatsRegistry {
+    fn register(&mut self, path: &Option<MappingPath>) -> Rc<RegionStats> {
+        if self.live.len() >= 64 && self.live.len() == self.live.capacity() {
+            self.retire_unused();
+        }
+        let stats = Rc::new(RegionStats {
+            path: describe_path(path),
+            hits: Cell::new(0),
+            misses: Cell::new(0),
+            remaps: Cell::new(0),
+            remap_queued: Cell::new(false),
+        });
+        self.live.push(stats.clone());
+        stats
+    }
+
+    // Fold the stats that are no longer referenced by any region into the per-path totals.
+    fn retire_unused(&mut self) {
+        let retired = &mut self.retired;
+        self.live.retain(|stats| {
+            if Rc::strong_count(stats) > 1 {
+                return true;
+            }
+            retired.entry(stats.path.clone()).or_default().add(stats);
+            false
+        });
+    }
+
+    fn totals(&self) -> HashMap<String, RegionCounts> {
+        let mut totals = self.retired.clone();
+        for stats in &self.live {
+            totals.entry(stats.path.clone()).or_default().add(stats);
+        }
+        totals
+    }
+}
+
+fn describe_path(path: &Option<MappingPath>) -> String {
+    match path {
+        None => "[anonymous]".to_string(),
+        Some(MappingPath::InitialStack) => "[stack]".to_string(),
+        Some(MappingPath::ThreadStack(tid)) => format!("[stack:{}]", tid),
+        Some(MappingPath::Vdso) => "[vdso]".to_string(),
+        Some(MappingPath::Heap) => "[heap]".to_string(),
+        Some(MappingPath::OtherSpecial(name)) => format!("[{}]", name),
+        Some(MappingPath::Path(path)) => path.display().to_string(),
+    }
+}
+
 // Represents a region of plugin memory.
 #[derive(Clone, Debug)]
 struct Region {
@@ -31,6 +128,29 @@ struct Region {
     sharing: proc_maps::Sharing,
     // The *original* path. Not the path to our mem file.
     original_path: Option<proc_maps::MappingPath>,
+    stats: Rc<RegionStats>,
+}
+
+impl Region {
+    /// Whether we may move this region into the shared mem file after the fact. We only do this
+    /// for private read-write data, where nothing outside the process can observe the move, and
+    /// never for the shim's own data. The shim's TLS, which holds the stack it runs on while
+    /// we remap, is in there, and overwriting it with a copy would clobber live frames.
+    fn is_adaptively_remappable(&self, interval: &Interval, shim_range: &Option<Interval>) -> bool {
+        let overlaps_shim = match shim_range {
+            Some(shim) => interval.start < shim.end && shim.start < interval.end,
+            None => false,
+        };
+        !overlaps_shim
+            && self.shadow_base.is_null()
+            && self.sharing == Sharing::Private
+            && self.prot == (libc::PROT_READ | libc::PROT_WRITE)
+            && interval.len() <= MAX_ADAPTIVE_REMAP_LEN
+            && matches!(
+                self.original_path,
+                None | Some(MappingPath::ThreadStack(_)) | Some(MappingPath::Path(_))
+            )
+    }
 }
 
 #[allow(dead_code)]
@@ -68,7 +188,17 @@ pub struct MemoryMapper {
     shm_file: ShmFile,
     regions: IntervalMap<Region>,
 
-    misses_by_path: RefCell<HashMap<String, u32>>,
+    stats: RegionStatsRegistry,
+    // Misses on addresses that aren't in any region we know about.
+    unknown_misses: Cell<u64>,
+
+    /// Regions that reach this many misses are moved into the shared mem file the next time we
+    /// have a thread to do it with. Zero disables adaptive remapping.
+    remap_threshold: u32,
+    /// Start addresses of regions that crossed `remap_threshold`.
+    pending_remaps: RefCell<Vec<usize>>,
+    /// The shim's mappings, which are never remapped adaptively.
+    shim_range: Option<Interval>,
 
     /// The bounds of the heap. Note that before the plugin's first `brk` syscall this will be a
     /// zero-sized interval (though in the case of thread-preload that'll have already happened
@@ -82,6 +212,10 @@ struct ShmFile {
     shm_file: File,
     shm_plugin_fd: i32,
     len: libc::off_t,
+    /// Whether to advise transparent huge pages for mappings of the file. Since each region is
+    /// mapped at the file offset equal to its address in the plugin, the 2 MiB-aligned parts of
+    /// large regions line up with huge pages of the file in both address spaces.
+    huge_pages: bool,
 }
 
 impl ShmFile {
@@ -112,7 +246,7 @@ impl ShmFile {
 
     /// Map the given interval of the file into shadow's address space.
     fn mmap_into_shadow(&self, interval: &Interval, prot: i32) -> *mut c_void {
-        unsafe {
+        let p = unsafe {
             sys::mman::mmap(
                 std::ptr::null_mut(),
                 interval.len(),
@@ -122,7 +256,16 @@ impl ShmFile {
                 interval.start as i64,
             )
         }
-        .unwrap()
+        .unwrap();
+        if self.huge_pages && interval.len() >= HUGE_PAGE_LEN {
+            // Best effort; fails if the kernel doesn't support transparent huge pages.
+            if let Err(e) = unsafe {
+                sys::mman::madvise(p, interval.len(), sys::mman::MmapAdvise::MADV_HUGEPAGE)
+            } {
+                debug!("madvise(MADV_HUGEPAGE) in shadow: {}", e);
+            }
+        }
+        p
     }
 
     /// Copy data from the plugin's address space into the file. `interval` must be contained within
@@ -169,11 +312,48 @@ impl ShmFile {
                 interval.start as i64,
             )
             .unwrap();
+        if self.huge_pages && interval.len() >= HUGE_PAGE_LEN {
+            if let Err(e) = thread.native_madvise(
+                PluginPtr::from(interval.start),
+                interval.len(),
+                libc::MADV_HUGEPAGE,
+            ) {
+                debug!("madvise(MADV_HUGEPAGE) in plugin: {}", e);
+            }
+        }
+    }
+}
+
+/// Get the range spanning the shim library's mappings, extended through the anonymous mapping that
+/// directly follows them, which holds the rest of its .bss. None if the shim isn't loaded.
+fn get_shim_range(regions: &IntervalMap<Region>) -> Option<Interval> {
+    let mut range: Option<Interval> = None;
+    for (interval, region) in regions.iter() {
+        let is_shim = match &region.original_path {
+            Some(MappingPath::Path(path)) => {
+                path.file_name().map_or(false, |name| name == SHIM_LIB_NAME)
+            }
+            _ => false,
+        };
+        if is_shim {
+            range = Some(match range {
+                Some(r) => r.start.min(interval.start)..r.end.max(interval.end),
+                None => interval,
+            });
+        }
+    }
+
+    let mut range = range?;
+    if let Some((interval, region)) = regions.get(range.end) {
+        if interval.start == range.end && region.original_path.is_none() {
+            range.end = interval.end;
+        }
     }
+    Some(range)
 }
 
 /// Get the current mapped regions of the process.
-fn get_regions(pid: Pid) -> IntervalMap<Region> {
+fn get_regions(pid: Pid, stats: &mut RegionStatsRegistry) -> IntervalMap<Region> {
     let mut regions = IntervalMap::new();
     for mapping in proc_maps::mappings_for_pid(pid.as_raw()).unwrap() {
         let mut prot = 0;
@@ -192,6 +372,7 @@ fn get_regions(pid: Pid) -> IntervalMap<Region> {
                 shadow_base: std::ptr::null_mut(),
                 prot,
                 sharing: mapping.sharing,
+                stats: stats.register(&mapping.path),
                 original_path: mapping.path,
             },
         );
@@ -303,15 +484,33 @@ fn map_stack(
 
 impl Drop for MemoryMapper {
     fn drop(&mut self) {
-        let misses = self.misses_by_path.borrow();
-        if misses.is_empty() {
-            debug!("MemoryManager misses: None");
-        } else {
-            debug!("MemoryManager misses: (consider extending MemoryManager to remap regions with a high miss count)");
-            for (path, count) in misses.iter() {
-                debug!("\t{} in {}", count, path);
+        let totals = self.stats.totals();
+        let mut counter = Counter::new();
+        debug!("MemoryManager accesses by region (hits, misses, remaps):");
+        for (path, counts) in totals.iter() {
+            if counts.hits == 0 && counts.misses == 0 {
+                continue;
+            }
+            debug!(
+                "\t{} {} {} in {}",
+                counts.hits, counts.misses, counts.remaps, path
+            );
+            counter.add_value(&format!("{} hits", path), counts.hits as i64);
+            counter.add_value(&format!("{} misses", path), counts.misses as i64);
+            if counts.remaps > 0 {
+                counter.add_value(&format!("{} remaps", path), counts.remaps as i64);
             }
         }
+        if self.unknown_misses.get() > 0 {
+            debug!("\t0 {} 0 in unknown regions", self.unknown_misses.get());
+            counter.add_value("[unknown] misses", self.unknown_misses.get() as i64);
+        }
+        // The worker copies the counts before this returns.
+        unsafe {
+            cshadow::worker_add_memory_manager_counts(
+                &mut counter as *mut Counter as *mut cshadow::Counter,
+            )
+        };
 
         // Mappings are no longer valid. Clear out our map, and unmap those regions from Shadow's
         // address space.
@@ -328,7 +527,12 @@ impl Drop for MemoryMapper {
 }
 
 impl MemoryMapper {
-    pub fn new(memory_manager: &mut MemoryManager, thread: &mut impl Thread) -> MemoryMapper {
+    pub fn new(
+        memory_manager: &mut MemoryManager,
+        thread: &mut impl Thread,
+        remap_threshold: u32,
+        huge_pages: bool,
+    ) -> MemoryMapper {
         let memory_copier = MemoryCopier::new(thread.system_pid());
 
         let shm_path = format!(
@@ -377,8 +581,11 @@ impl MemoryMapper {
             shm_file,
             shm_plugin_fd,
             len: 0,
+            huge_pages,
         };
-        let mut regions = get_regions(memory_manager.pid);
+        let mut stats = RegionStatsRegistry::default();
+        let mut regions = get_regions(memory_manager.pid, &mut stats);
+        let shim_range = get_shim_range(&regions);
         let heap = get_heap(&mut shm_file, thread, memory_manager, &mut regions);
         map_stack(memory_manager, thread, &mut shm_file, &mut regions);
 
@@ -386,7 +593,11 @@ impl MemoryMapper {
             memory_copier,
             shm_file,
             regions,
-            misses_by_path: RefCell::new(HashMap::new()),
+            stats,
+            unknown_misses: Cell::new(0),
+            remap_threshold,
+            pending_remaps: RefCell::new(Vec::new()),
+            shim_range,
             heap,
         }
     }
@@ -531,6 +742,7 @@ impl MemoryMapper {
             shadow_base: std::ptr::null_mut(),
             prot,
             sharing,
+            stats: self.stats.register(&original_path),
             original_path,
         };
 
@@ -635,9 +847,13 @@ impl MemoryMapper {
         }
 
         if !region.shadow_base.is_null() {
-            // We currently only map in anonymous mmap'd regions, stack, and heap.  We don't bother
-            // implementing mremap for stack or heap regions for now; that'd be pretty weird.
-            assert_eq!(region.original_path, None);
+            // We currently only map in anonymous mmap'd regions, stack, heap, and private data
+            // regions that we remapped adaptively. We don't bother implementing mremap for stack
+            // or heap regions for now; that'd be pretty weird.
+            assert!(!matches!(
+                region.original_path,
+                Some(MappingPath::Heap) | Some(MappingPath::InitialStack)
+            ));
 
             if new_interval.start != old_interval.start {
                 // region has moved
@@ -732,6 +948,10 @@ impl MemoryMapper {
 
         if requested_brk > self.heap.end {
             // Grow the heap.
+            let stats = match opt_heap_interval_and_region {
+                Some((_, heap_region)) => heap_region.stats.clone(),
+                None => self.stats.register(&Some(MappingPath::Heap)),
+            };
             let shadow_base = match opt_heap_interval_and_region {
                 None => {
                     // Initialize heap region.
@@ -775,6 +995,7 @@ impl MemoryMapper {
                     prot: HEAP_PROT,
                     sharing: Sharing::Private,
                     original_path: Some(MappingPath::Heap),
+                    stats,
                 },
             );
         } else {
@@ -992,6 +1213,8 @@ impl MemoryMapper {
         // Base pointer + offset won't wrap around, by construction.
         let ptr = unsafe { shadow_base.add(offset) } as *mut T;
 
+        region.stats.hits.set(region.stats.hits.get() + 1);
+
         Some(ptr)
     }
 
@@ -1019,16 +1242,132 @@ impl MemoryMapper {
         Some(unsafe { std::slice::from_raw_parts_mut(notnull_mut_debug(ptr), src.len()) })
     }
 
-    /// Counts accesses where we had to fall back to the thread's (slow) apis.
+    /// Counts accesses where we had to fall back to the thread's (slow) apis, and queues the
+    /// region for remapping if it has missed often enough.
     fn inc_misses<T: Debug + Pod>(&self, src: TypedPluginPtr<T>) {
-        let key = match self.regions.get(usize::from(src.ptr())) {
-            Some((_, original_path)) => format!("{:?}", original_path),
-            None => "not found".to_string(),
+        let (interval, region) = match self.regions.get(usize::from(src.ptr())) {
+            Some(x) => x,
+            None => {
+                self.unknown_misses.set(self.unknown_misses.get() + 1);
+                return;
+            }
         };
-        let mut misses = self.misses_by_path.borrow_mut();
-        let counter = misses.entry(key).or_insert(0);
-        *counter += 1;
+
+        let misses = region.stats.misses.get() + 1;
+        region.stats.misses.set(misses);
+
+        if self.remap_threshold > 0
+            && misses >= u64::from(self.remap_threshold)
+            && !region.stats.remap_queued.get()
+            && region.is_adaptively_remappable(&interval, &self.shim_range)
+        {
+            trace!(
+                "Queueing {:x}-{:x} ({}) for remapping after {} misses",
+                interval.start,
+                interval.end,
+                region.stats.path,
+                misses
+            );
+            region.stats.remap_queued.set(true);
+            self.pending_remaps.borrow_mut().push(interval.start);
+        }
+    }
+
+    /// Whether any regions are waiting for `remap_pending`.
+    pub fn has_pending_remaps(&self) -> bool {
+        !self.pending_remaps.borrow().is_empty()
+    }
+
+    /// Moves the regions that crossed the miss threshold into the shared mem file and maps them
+    /// into both address spaces, so that future accesses are zero-copy. `memory_manager` must not
+    /// be using this mapper, since we read the current contents through its copier.
+    pub fn remap_pending(&mut self, memory_manager: &MemoryManager, thread: &mut dyn Thread) {
+        let pending = std::mem::take(self.pending_remaps.get_mut());
+        for start in pending {
+            // The region may have been unmapped or changed since we queued it.
+            let (interval, region) = match self.regions.get(start) {
+                Some((interval, region)) => (interval, region.clone()),
+                None => continue,
+            };
+            if interval.start != start
+                || !region.is_adaptively_remappable(&interval, &self.shim_range)
+            {
+                continue;
+            }
+            self.remap_region(memory_manager, thread, interval, region);
+        }
     }
+
+    fn remap_region(
+        &mut self,
+        memory_manager: &MemoryManager,
+        thread: &mut dyn Thread,
+        interval: Interval,
+        mut region: Region,
+    ) {
+        self.shm_file.alloc(&interval);
+        let shadow_base = self.shm_file.mmap_into_shadow(&interval, region.prot);
+
+        if let Err(e) = copy_nonzero_pages(memory_manager, &interval, shadow_base) {
+            debug!(
+                "Couldn't remap {:x}-{:x} ({}): {:?}",
+                interval.start, interval.end, region.stats.path, e
+            );
+            unsafe { sys::mman::munmap(shadow_base, interval.len()) }
+                .unwrap_or_else(|e| warn!("munmap: {}", e));
+            self.shm_file.dealloc(&interval);
+            return;
+        }
+
+        self.shm_file
+            .mmap_into_plugin(thread, &interval, region.prot);
+
+        debug!(
+            "Remapped {:x}-{:x} ({}) after {} misses",
+            interval.start,
+            interval.end,
+            region.stats.path,
+            region.stats.misses.get()
+        );
+        region.shadow_base = shadow_base;
+        region.stats.remaps.set(region.stats.remaps.get() + 1);
+
+        // This only replaces our own metadata for the region, which wasn't mapped into Shadow.
+        let mutations = self.regions.insert(interval, region);
+        debug_assert_eq!(mutations.len(), 1);
+    }
+}
+
+/// Copy the current contents of `interval` in the plugin to `shadow_base`, skipping pages that
+/// are all zero. The mem file reads as zero wherever it hasn't been written, so this avoids
+/// allocating file space for the untouched parts of the region.
+fn copy_nonzero_pages(
+    memory_manager: &MemoryManager,
+    interval: &Interval,
+    shadow_base: *mut c_void,
+) -> Result<(), nix::errno::Errno> {
+    const CHUNK_LEN: usize = 64 * 1024;
+    let mut buf = vec![0u8; std::cmp::min(CHUNK_LEN, interval.len())];
+    let mut offset = 0;
+
+    while offset < interval.len() {
+        let len = std::cmp::min(CHUNK_LEN, interval.len() - offset);
+        let chunk = &mut buf[..len];
+        memory_manager.copy_from_ptr(
+            chunk,
+            TypedPluginPtr::new(PluginPtr::from(interval.start + offset), len),
+        )?;
+
+        for (i, page) in chunk.chunks(page_size()).enumerate() {
+            if page.iter().any(|b| *b != 0) {
+                let dst = unsafe { (shadow_base as *mut u8).add(offset + i * page_size()) };
+                unsafe { std::ptr::copy_nonoverlapping(page.as_ptr(), dst, page.len()) };
+            }
+        }
+        offset += len;
+    }
+
+    Ok(())
 }
 
 #[cfg(test)]
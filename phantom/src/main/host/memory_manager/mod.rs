@@ -423,6 +423,55 @@ impl MemoryManager {
         unsafe { self.memory_copier.copy_from_ptr(dst, src) }
     }
 
+    /// Gather the plugin buffers `srcs`, in order, into `dst`. Buffers that are
+    /// mapped into Shadow are copied directly; the rest are read together with a
+    /// single syscall.
+    pub fn gather_from_ptrs(
+        &self,
+        dst: &mut [u8],
+        srcs: &[TypedPluginPtr<u8>],
+    ) -> Result<(), Errno> {
+        assert_eq!(dst.len(), srcs.iter().map(|s| s.len()).sum::<usize>());
+        let mut unmapped_dsts = Vec::new();
+        let mut unmapped_srcs = Vec::new();
+        let mut rest = dst;
+        for src in srcs {
+            let (chunk, tail) = std::mem::take(&mut rest).split_at_mut(src.len());
+            rest = tail;
+            match self.mapped_ref(*src) {
+                Some(mapped) => chunk.copy_from_slice(mapped),
+                None => {
+                    unmapped_dsts.push(chunk);
+                    unmapped_srcs.push(*src);
+                }
+            }
+        }
+        match unmapped_srcs.len() {
+            0 => Ok(()),
+            // SAFETY: No mutable refs to process memory exist by preconditions of
+            // MemoryManager::new + we have a reference.
+            1 => unsafe {
+                self.memory_copier
+                    .copy_from_ptr(unmapped_dsts.pop().unwrap(), unmapped_srcs[0])
+            },
+            _ => {
+                // Read the unmapped buffers contiguously, then distribute them.
+                let len = unmapped_srcs.iter().map(|s| s.len()).sum();
+                let mut buf = vec![0u8; len];
+                unsafe {
+                    self.memory_copier
+                        .gather_from_ptrs(&mut buf, &unmapped_srcs)?
+                };
+                let mut offset = 0;
+                for chunk in unmapped_dsts {
+                    chunk.copy_from_slice(&buf[offset..offset + chunk.len()]);
+                    offset += chunk.len();
+                }
+                Ok(())
+            }
+        }
+    }
+
     // Copies memory from the beginning of the given pointer to the last address
     // in the pointer that's accessible. Not exposed as a public interface
     // because this is generally only useful for strings, and
@@ -534,16 +583,75 @@ impl MemoryManager {
         unsafe { self.memory_copier.copy_to_ptr(dst, src) }
     }
 
+    /// Scatter `src`, in order, across the plugin buffers `dsts`. Buffers that
+    /// are mapped into Shadow are written directly; the rest are written
+    /// together with a single syscall.
+    pub fn scatter_to_ptrs(
+        &mut self,
+        dsts: &[TypedPluginPtr<u8>],
+        src: &[u8],
+    ) -> Result<(), Errno> {
+        assert_eq!(src.len(), dsts.iter().map(|d| d.len()).sum::<usize>());
+        let mut unmapped_dsts = Vec::new();
+        let mut unmapped_src = Vec::new();
+        let mut offset = 0;
+        for dst in dsts {
+            let chunk = &src[offset..offset + dst.len()];
+            offset += dst.len();
+            match self.mapped_mut(*dst) {
+                Some(mapped) => mapped.copy_from_slice(chunk),
+                None => {
+                    unmapped_dsts.push(*dst);
+                    unmapped_src.extend_from_slice(chunk);
+                }
+            }
+        }
+        if unmapped_dsts.is_empty() {
+            return Ok(());
+        }
+        // SAFETY: No other refs to process memory exist by preconditions of
+        // MemoryManager::new + we have an exclusive reference.
+        unsafe {
+            self.memory_copier
+                .scatter_to_ptrs(&unmapped_dsts, &unmapped_src)
+        }
+    }
+
     /// Which process's address space this MemoryManager manages.
     pub fn pid(&self) -> Pid {
         self.pid
     }
 
     /// Initialize the MemoryMapper, allowing for more efficient access. Needs a
-    /// running thread.
-    pub fn init_mapper(&mut self, thread: &mut impl Thread) {
+    /// running thread. Regions that miss `remap_threshold` times are later moved
+    /// into the mapper's shared memory by `remap_hot_regions`; zero disables this.
+    /// If `huge_pages` is set, the mapper advises transparent huge pages for its
+    /// mappings.
+    pub fn init_mapper(
+        &mut self,
+        thread: &mut impl Thread,
+        remap_threshold: u32,
+        huge_pages: bool,
+    ) {
         assert!(self.memory_mapper.is_none());
-        self.memory_mapper = Some(MemoryMapper::new(self, thread));
+        self.memory_mapper = Some(MemoryMapper::new(self, thread, remap_threshold, huge_pages));
+    }
+
+    /// Remap the regions that the MemoryMapper has flagged as frequently missed.
+    /// Needs a running thread.
+    pub fn remap_hot_regions(&mut self, thread: &mut dyn Thread) {
+        if !self
+            .memory_mapper
+            .as_ref()
+            .map_or(false, |mm| mm.has_pending_remaps())
+        {
+            return;
+        }
+        // Take the mapper out while remapping, so that the current contents of the
+        // regions are read through the copier.
+        let mut mm = self.memory_mapper.take().unwrap();
+        mm.remap_pending(self, thread);
+        self.memory_mapper = Some(mm);
     }
 
     /// Whether the internal MemoryMapper has been initialized.
@@ -768,14 +876,28 @@ mod export {
     pub unsafe extern "C" fn memorymanager_initMapperIfNeeded(
         memory_manager: *mut MemoryManager,
         thread: *mut c::Thread,
+        remap_threshold: u32,
+        huge_pages: bool,
     ) {
         let memory_manager = unsafe { memory_manager.as_mut().unwrap() };
         if !memory_manager.has_mapper() {
             let mut thread = unsafe { CThread::new(notnull_mut_debug(thread)) };
-            memory_manager.init_mapper(&mut thread)
+            memory_manager.init_mapper(&mut thread, remap_threshold, huge_pages)
         }
     }
 
+    /// Move regions with frequent misses into shared memory. `thread` must be
+    /// running and ready to make native syscalls.
+    #[no_mangle]
+    pub unsafe extern "C" fn memorymanager_remapHotRegions(
+        memory_manager: *mut MemoryManager,
+        thread: *mut c::Thread,
+    ) {
+        let memory_manager = unsafe { memory_manager.as_mut().unwrap() };
+        let mut thread = unsafe { CThread::new(notnull_mut_debug(thread)) };
+        memory_manager.remap_hot_regions(&mut thread)
+    }
+
     #[no_mangle]
     pub unsafe extern "C" fn memorymanager_freeRef<'a>(memory_ref: *mut ProcessMemoryRef<'a, u8>) {
         unsafe { Box::from_raw(notnull_mut_debug(memory_ref)) };
@@ -871,6 +993,90 @@ mod export {
         }
     }
 
+    /// The first `n` bytes described by the plugin iovecs `iov`, as plugin
+    /// pointers. Fails if the iovecs are shorter than `n` bytes.
+    unsafe fn plugin_iovecs_prefix(
+        iov: *const libc::iovec,
+        iovcnt: usize,
+        n: usize,
+    ) -> Result<Vec<TypedPluginPtr<u8>>, Errno> {
+        let iov = unsafe { std::slice::from_raw_parts(notnull_debug(iov), iovcnt) };
+        let mut ptrs = Vec::with_capacity(iovcnt);
+        let mut remaining = n;
+        for v in iov {
+            if remaining == 0 {
+                break;
+            }
+            let len = std::cmp::min(v.iov_len, remaining);
+            ptrs.push(TypedPluginPtr::new(
+                PluginPtr::from(v.iov_base as usize),
+                len,
+            ));
+            remaining -= len;
+        }
+        if remaining > 0 {
+            return Err(Errno::EFAULT);
+        }
+        Ok(ptrs)
+    }
+
+    /// Copy the first `n` bytes of the plugin buffers described by `src` into
+    /// `dst`.
+    #[no_mangle]
+    pub unsafe extern "C" fn memorymanager_readPtrv(
+        memory_manager: *const MemoryManager,
+        dst: *mut c_void,
+        src: *const libc::iovec,
+        iovcnt: usize,
+        n: usize,
+    ) -> i32 {
+        if n == 0 {
+            return 0;
+        }
+        let memory_manager = unsafe { memory_manager.as_ref().unwrap() };
+        let dst = unsafe { std::slice::from_raw_parts_mut(notnull_mut_debug(dst) as *mut u8, n) };
+        let res = unsafe { plugin_iovecs_prefix(src, iovcnt, n) }
+            .and_then(|srcs| memory_manager.gather_from_ptrs(dst, &srcs));
+        match res {
+            Ok(_) => 0,
+            Err(e) => {
+                trace!(
+                    "Couldn't gather {} bytes from {} iovecs: {:?}",
+                    n,
+                    iovcnt,
+                    e
+                );
+                -(e as i32)
+            }
+        }
+    }
+
+    /// Copy `n` bytes from `src` into the plugin buffers described by `dst`,
+    /// filling them in order.
+    #[no_mangle]
+    pub unsafe extern "C" fn memorymanager_writePtrv(
+        memory_manager: *mut MemoryManager,
+        dst: *const libc::iovec,
+        iovcnt: usize,
+        src: *const c_void,
+        n: usize,
+    ) -> i32 {
+        if n == 0 {
+            return 0;
+        }
+        let memory_manager = unsafe { memory_manager.as_mut().unwrap() };
+        let src = unsafe { std::slice::from_raw_parts(notnull_debug(src) as *const u8, n) };
+        let res = unsafe { plugin_iovecs_prefix(dst, iovcnt, n) }
+            .and_then(|dsts| memory_manager.scatter_to_ptrs(&dsts, src));
+        match res {
+            Ok(_) => 0,
+            Err(e) => {
+                trace!("Couldn't scatter {} bytes to {} iovecs: {:?}", n, iovcnt, e);
+                -(e as i32)
+            }
+        }
+    }
+
     /// Write data to this writer's memory.
     #[no_mangle]
     pub unsafe extern "C" fn memorymanager_writePtr(
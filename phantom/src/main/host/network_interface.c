@@ -30,6 +30,9 @@
 #include "main/utility/tagged_ptr.h"
 #include "main/utility/utility.h"
 
+/* the number of packets we pull from the upstream router per dequeue call */
+#define NETWORKINTERFACE_RECEIVE_BATCH_SIZE 64
+
 typedef struct _NetworkInterfaceTokenBucket NetworkInterfaceTokenBucket;
 struct _NetworkInterfaceTokenBucket {
     /* The maximum number of bytes the bucket can hold */
@@ -339,41 +342,27 @@ void networkinterface_disassociate(NetworkInterface* interface, const CompatSock
 }
 
 static void _networkinterface_capturePacket(NetworkInterface* interface, Packet* packet) {
-    PCapPacket* pcapPacket = g_new0(PCapPacket, 1);
-
-    pcapPacket->headerSize = packet_getHeaderSize(packet);
-    pcapPacket->payloadLength = packet_getPayloadLength(packet);
-
-    if(pcapPacket->payloadLength > 0) {
-        pcapPacket->payload = g_new0(guchar, pcapPacket->payloadLength);
-        packet_copyPayloadShadow(packet, 0, pcapPacket->payload, pcapPacket->payloadLength);
-    }
-
     PacketTCPHeader* tcpHeader = packet_getTCPHeader(packet);
 
-    pcapPacket->srcIP = tcpHeader->sourceIP;
-    pcapPacket->dstIP = tcpHeader->destinationIP;
-    pcapPacket->srcPort = tcpHeader->sourcePort;
-    pcapPacket->dstPort = tcpHeader->destinationPort;
-
-    if(tcpHeader->flags & PTCP_RST) pcapPacket->rstFlag = TRUE;
-    if(tcpHeader->flags & PTCP_SYN) pcapPacket->synFlag = TRUE;
-    if(tcpHeader->flags & PTCP_ACK) pcapPacket->ackFlag = TRUE;
-    if(tcpHeader->flags & PTCP_FIN) pcapPacket->finFlag = TRUE;
-
-    pcapPacket->seq = (guint32)tcpHeader->sequence;
-    pcapPacket->win = (guint16)tcpHeader->window;
-    if(tcpHeader->flags & PTCP_ACK) {
-        pcapPacket->ack = (guint32)tcpHeader->acknowledgment;
-    }
-
-    pcapwriter_writePacket(interface->pcap, pcapPacket);
-
-    if(pcapPacket->payloadLength > 0) {
-        g_free(pcapPacket->payload);
-    }
-
-    g_free(pcapPacket);
+    /* the writer copies only as much payload as it keeps, straight out of the packet */
+    PCapPacket pcapPacket = {
+        .srcIP = tcpHeader->sourceIP,
+        .dstIP = tcpHeader->destinationIP,
+        .srcPort = tcpHeader->sourcePort,
+        .dstPort = tcpHeader->destinationPort,
+        .rstFlag = (tcpHeader->flags & PTCP_RST) ? TRUE : FALSE,
+        .synFlag = (tcpHeader->flags & PTCP_SYN) ? TRUE : FALSE,
+        .ackFlag = (tcpHeader->flags & PTCP_ACK) ? TRUE : FALSE,
+        .finFlag = (tcpHeader->flags & PTCP_FIN) ? TRUE : FALSE,
+        .seq = (guint32)tcpHeader->sequence,
+        .ack = (tcpHeader->flags & PTCP_ACK) ? (guint32)tcpHeader->acknowledgment : 0,
+        .win = (guint16)tcpHeader->window,
+        .payloadLength = packet_getPayloadLength(packet),
+        .copyPayload = (PCapPayloadCopyFunc)packet_copyPayloadShadow,
+        .payloadSource = packet,
+    };
+
+    pcapwriter_writePacket(interface->pcap, &pcapPacket);
 }
 
 static CompatSocket _boundsockets_lookup(GHashTable* table, gchar* key) {
@@ -458,27 +447,33 @@ void networkinterface_receivePackets(NetworkInterface* interface, Host* host) {
     /* get the bootstrapping mode */
     gboolean bootstrapping = worker_isBootstrapActive();
 
-    while(bootstrapping || interface->receiveBucket.bytesRemaining >= CONFIG_MTU) {
-        /* we are now the owner of the packet reference from the router */
-        Packet* packet = router_dequeue(interface->router);
-        if(!packet) {
-            break;
-        }
+    Packet* packets[NETWORKINTERFACE_RECEIVE_BATCH_SIZE];
+    guint count = 0;
 
-        guint64 length = (guint64)(packet_getPayloadLength(packet) + packet_getHeaderSize(packet));
+    do {
+        /* drain everything the token bucket allows in one pass over the router queue.
+         * we are now the owner of the packet references from the router. */
+        guint64 budget = bootstrapping ? G_MAXUINT64 : interface->receiveBucket.bytesRemaining;
+        count = router_dequeueBatch(
+            interface->router, packets, NETWORKINTERFACE_RECEIVE_BATCH_SIZE, budget);
 
-        _networkinterface_receivePacket(host, interface, packet);
+        for (guint i = 0; i < count; i++) {
+            Packet* packet = packets[i];
+            guint64 length =
+                (guint64)(packet_getPayloadLength(packet) + packet_getHeaderSize(packet));
 
-        /* release reference from router */
-        packet_unref(packet);
+            _networkinterface_receivePacket(host, interface, packet);
 
-        /* update bandwidth accounting when not in infinite bandwidth mode */
-        if(!bootstrapping) {
-            _networkinterface_consumeTokenBucket(&interface->receiveBucket,
-                                                 length);
-            _networkinterface_scheduleNextRefillIfNeeded(interface, host);
+            /* release reference from router */
+            packet_unref(packet);
+
+            /* update bandwidth accounting when not in infinite bandwidth mode */
+            if (!bootstrapping) {
+                _networkinterface_consumeTokenBucket(&interface->receiveBucket, length);
+                _networkinterface_scheduleNextRefillIfNeeded(interface, host);
+            }
         }
-    }
+    } while (count == NETWORKINTERFACE_RECEIVE_BATCH_SIZE);
 }
 
 static void _networkinterface_updatePacketHeader(Host* host, const CompatSocket* socket,
@@ -679,7 +674,8 @@ Router* networkinterface_getRouter(NetworkInterface* interface) {
 }
 
 NetworkInterface* networkinterface_new(Host* host, Address* address, guint64 bwDownKiBps,
-                                       guint64 bwUpKiBps, gchar* pcapDir, QDiscMode qdisc,
+                                       guint64 bwUpKiBps, gchar* pcapDir, guint32 pcapCaptureSize,
+                                       gboolean pcapUseNg, QDiscMode qdisc,
                                        guint64 interfaceReceiveLength) {
     NetworkInterface* interface = g_new0(NetworkInterface, 1);
     MAGIC_INIT(interface);
@@ -703,7 +699,8 @@ NetworkInterface* networkinterface_new(Host* host, Address* address, guint64 bwD
         g_string_printf(filename, "%s-%s",
                 address_toHostName(interface->address),
                 address_toHostIPString(interface->address));
-        interface->pcap = pcapwriter_new(host, pcapDir, filename->str);
+        interface->pcap =
+            pcapwriter_new(host, pcapDir, filename->str, pcapCaptureSize, pcapUseNg);
         g_string_free(filename, TRUE);
     }
 
@@ -20,7 +20,8 @@
 typedef struct _NetworkInterface NetworkInterface;
 
 NetworkInterface* networkinterface_new(Host* host, Address* address, guint64 bwDownKiBps,
-                                       guint64 bwUpKiBps, gchar* pcapDir, QDiscMode qdisc,
+                                       guint64 bwUpKiBps, gchar* pcapDir, guint32 pcapCaptureSize,
+                                       gboolean pcapUseNg, QDiscMode qdisc,
                                        guint64 interfaceReceiveLength);
 void networkinterface_free(NetworkInterface* interface);
 
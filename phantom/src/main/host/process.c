@@ -61,6 +61,7 @@
 #include "main/utility/utility.h"
 
 #include "main/host/thread_ptrace.h"
+#include "main/host/zygote.h"
 
 // We normally attempt to serve hot-path syscalls on the shim-side to avoid a
 // more expensive inter-process syscall. This option disables the optimization.
@@ -74,6 +75,24 @@ ADD_CONFIG_HANDLER(config_getUseShimSyscallHandler, _use_shim_syscall_handler)
 static bool _use_legacy_working_dir = false;
 ADD_CONFIG_HANDLER(config_getUseLegacyWorkingDir, _use_legacy_working_dir)
 
+// In ptrace mode, service syscalls made through the shim over the IPC channel
+// rather than with a ptrace-stop per syscall.
+static bool _use_ptrace_ipc = false;
+ADD_CONFIG_HANDLER(config_getUsePtraceIpc, _use_ptrace_ipc)
+
+// Start the native processes of preload-mode processes while their host
+// boots, and only let them run `main` at their start time.
+static bool _use_process_prespawn = false;
+ADD_CONFIG_HANDLER(config_getUseProcessPrespawn, _use_process_prespawn)
+
+// Have the shim write binary log records instead of text.
+static bool _use_binary_log = false;
+ADD_CONFIG_HANDLER(config_getUseBinaryLog, _use_binary_log)
+
+// Have the shim advise huge pages for its mappings of Shadow's shared memory.
+static bool _use_shmem_huge_pages = false;
+ADD_CONFIG_HANDLER(config_getUseShmemHugePages, _use_shmem_huge_pages)
+
 static gchar* _process_outputFileName(Process* proc, const char* type);
 static void _process_check(Process* proc);
 static void _disassociateCompatDescriptor(CompatDescriptor* compatDesc, Host* host);
@@ -91,6 +110,9 @@ struct _Process {
 
     /* All of the descriptors opened by this process. */
     DescriptorTable* descTable;
+    /* The legacy descriptors in descTable indexed by handle, so that looking
+     * them up from C is a plain array index. Does not hold references. */
+    GPtrArray* legacyDescs;
 
     /* the shadow plugin executable */
     struct {
@@ -128,6 +150,10 @@ struct _Process {
     // int thread_id -> Thread*.
     GHashTable* threads;
 
+    // The main thread of a process that was spawned when its host booted,
+    // until the process is started. Not yet in `threads`.
+    Thread* prespawnedThread;
+
     // Owned exclusively by the process.
     MemoryManager* memoryManager;
 
@@ -309,7 +335,7 @@ static void _process_getAndLogReturnCode(Process* proc) {
         proc->returnCode = EXIT_FAILURE;
 
         int wstatus = 0;
-        int rv = waitpid(proc->nativePid, &wstatus, __WALL);
+        int rv = zygote_waitpid(proc->nativePid, &wstatus);
         if (rv < 0) {
             // Getting here is a bug, but since the process is exiting anyway
             // not serious enough to merit `error`ing out.
@@ -426,6 +452,20 @@ static gchar* _process_outputFileName(Process* proc, const char* type) {
         "%s/%s.%s", host_getDataPath(proc->host), proc->processName->str, type);
 }
 
+/* Keep the legacy descriptor lookup array in sync with the descriptor table. */
+static void _process_setCachedLegacyDescriptor(Process* proc, int handle,
+                                               LegacyDescriptor* legacyDesc) {
+    utility_assert(handle >= 0);
+
+    if ((guint)handle >= proc->legacyDescs->len) {
+        if (!legacyDesc) {
+            return;
+        }
+        g_ptr_array_set_size(proc->legacyDescs, handle + 1);
+    }
+    g_ptr_array_index(proc->legacyDescs, handle) = legacyDesc;
+}
+
 static File* _process_openStdIOFileHelper(Process* proc, int fd, gchar* fileName) {
     MAGIC_ASSERT(proc);
     utility_assert(fileName != NULL);
@@ -434,6 +474,7 @@ static File* _process_openStdIOFileHelper(Process* proc, int fd, gchar* fileName
 
     CompatDescriptor* compatDesc = compatdescriptor_fromLegacy((LegacyDescriptor*)stdfile);
     descriptortable_set(proc->descTable, fd, compatDesc);
+    _process_setCachedLegacyDescriptor(proc, fd, (LegacyDescriptor*)stdfile);
 
     char* cwd = getcwd(NULL, 0);
     if (!cwd) {
@@ -454,6 +495,84 @@ static File* _process_openStdIOFileHelper(Process* proc, int fd, gchar* fileName
     return stdfile;
 }
 
+static Thread* _process_newMainThread(Process* proc) {
+    // tid of first thread of a process is equal to the pid.
+    int tid = proc->processID;
+    Thread* mainThread = NULL;
+
+    switch (proc->interposeMethod) {
+        case INTERPOSE_METHOD_PTRACE:
+            mainThread = _use_ptrace_ipc ? threadptrace_new(proc->host, proc, tid)
+                                         : threadptraceonly_new(proc->host, proc, tid);
+            break;
+        case INTERPOSE_METHOD_PRELOAD: mainThread = threadpreload_new(proc->host, proc, tid); break;
+    }
+
+    if (mainThread == NULL) {
+        utility_panic("Bad interposeMethod %d", proc->interposeMethod);
+    }
+
+    return mainThread;
+}
+
+/* Exec the native process ahead of its start time. The shim in a preload-mode
+ * process initializes and then waits for the start event, which isn't sent
+ * until the process is started, so the process doesn't run any of its own code
+ * before then. Ptrace-mode processes have to be started by the thread that
+ * traces them, so they aren't spawned early. */
+static void _process_prespawn(Process* proc) {
+    MAGIC_ASSERT(proc);
+    utility_assert(proc->interposeMethod == INTERPOSE_METHOD_PRELOAD);
+    utility_assert(proc->prespawnedThread == NULL);
+
+    Thread* mainThread = _process_newMainThread(proc);
+
+    worker_setActiveProcess(proc);
+    worker_setActiveThread(mainThread);
+
+#ifdef USE_PERF_TIMERS
+    g_timer_start(proc->cpuDelayTimer);
+#endif
+
+    thread_run(mainThread, proc->argv, proc->envv, proc->workingDir);
+    proc->nativePid = thread_getNativePid(mainThread);
+    proc->prespawnedThread = mainThread;
+
+#ifdef USE_PERF_TIMERS
+    gdouble elapsed = g_timer_elapsed(proc->cpuDelayTimer, NULL);
+    _process_handleTimerResult(proc, elapsed);
+    info("process '%s' spawned in %f seconds", process_getName(proc), elapsed);
+#else
+    info("process '%s' spawned", process_getName(proc));
+#endif
+
+    worker_setActiveProcess(NULL);
+    worker_setActiveThread(NULL);
+}
+
+/* Kill and reap a process that was spawned early but never started. */
+static void _process_killPrespawned(Process* proc) {
+    MAGIC_ASSERT(proc);
+
+    Thread* mainThread = proc->prespawnedThread;
+    if (mainThread == NULL) {
+        return;
+    }
+    proc->prespawnedThread = NULL;
+
+    debug("killing process '%s', which never started", process_getName(proc));
+
+    if (kill(proc->nativePid, SIGKILL)) {
+        warning("kill(pid=%d) error %d: %s", proc->nativePid, errno, g_strerror(errno));
+    }
+    int wstatus = 0;
+    if (zygote_waitpid(proc->nativePid, &wstatus) < 0) {
+        warning("waitpid(pid=%d) error %d: %s", proc->nativePid, errno, g_strerror(errno));
+    }
+
+    thread_unref(mainThread);
+}
+
 static void _process_start(Process* proc) {
     MAGIC_ASSERT(proc);
 
@@ -477,22 +596,14 @@ static void _process_start(Process* proc) {
     descriptor_ref((LegacyDescriptor*)proc->stderrFile);
     g_free(stderrFileName);
 
-    // tid of first thread of a process is equal to the pid.
-    int tid = proc->processID;
-    Thread* mainThread = NULL;
-
-    switch (proc->interposeMethod) {
-        case INTERPOSE_METHOD_PTRACE:
-            mainThread = threadptraceonly_new(proc->host, proc, tid);
-            break;
-        case INTERPOSE_METHOD_PRELOAD: mainThread = threadpreload_new(proc->host, proc, tid); break;
+    Thread* mainThread = proc->prespawnedThread;
+    proc->prespawnedThread = NULL;
+    gboolean wasPrespawned = mainThread != NULL;
+    if (!wasPrespawned) {
+        mainThread = _process_newMainThread(proc);
     }
 
-    if (mainThread == NULL) {
-        utility_panic("Bad interposeMethod %d", proc->interposeMethod);
-    }
-
-    g_hash_table_insert(proc->threads, GUINT_TO_POINTER(tid), mainThread);
+    g_hash_table_insert(proc->threads, GUINT_TO_POINTER(proc->processID), mainThread);
 
     info("starting process '%s'", process_getName(proc));
 
@@ -506,9 +617,11 @@ static void _process_start(Process* proc) {
 #endif
 
     proc->plugin.isExecuting = TRUE;
-    /* exec the process */
-    thread_run(mainThread, proc->argv, proc->envv, proc->workingDir);
-    proc->nativePid = thread_getNativePid(mainThread);
+    /* exec the process, unless that was already done at boot */
+    if (!wasPrespawned) {
+        thread_run(mainThread, proc->argv, proc->envv, proc->workingDir);
+        proc->nativePid = thread_getNativePid(mainThread);
+    }
     proc->memoryManager = memorymanager_new(proc->nativePid);
 
 #ifdef USE_PERF_TIMERS
@@ -660,6 +773,10 @@ void process_schedule(Process* proc, gpointer nothing) {
             task_new(_process_runStartTask, proc, NULL, (TaskObjectFreeFunc)process_unref, NULL);
         worker_scheduleTask(startProcessTask, proc->host, startDelay);
         task_unref(startProcessTask);
+
+        if (_use_process_prespawn && proc->interposeMethod == INTERPOSE_METHOD_PRELOAD) {
+            _process_prespawn(proc);
+        }
     }
 
     if(proc->stopTime > 0 && proc->stopTime > proc->startTime) {
@@ -752,11 +869,20 @@ Process* process_new(Host* host, guint processID, SimulationTime startTime, Simu
         envv = g_environ_setenv(envv, "SHADOW_DISABLE_SHIM_SYSCALL", "TRUE", TRUE);
     }
 
+    if (_use_binary_log) {
+        envv = g_environ_setenv(envv, "SHADOW_LOG_BINARY", "", TRUE);
+    }
+
+    if (_use_shmem_huge_pages) {
+        envv = g_environ_setenv(envv, "SHADOW_SHM_HUGE_PAGES", "", TRUE);
+    }
+
     /* save args and env */
     proc->argv = g_strdupv(argv);
     proc->envv = envv;
 
     proc->descTable = descriptortable_new();
+    proc->legacyDescs = g_ptr_array_new();
 
     proc->threads =
         g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, _thread_gpointer_unref);
@@ -779,6 +905,7 @@ static void _process_free(Process* proc) {
     g_array_free(proc->memoryRefs, false);
 
     _process_terminate_threads(proc);
+    _process_killPrespawned(proc);
     if (proc->threads) {
         g_hash_table_destroy(proc->threads);
         proc->threads = NULL;
@@ -827,6 +954,9 @@ static void _process_free(Process* proc) {
     if (proc->descTable) {
         descriptortable_free(proc->descTable);
     }
+    if (proc->legacyDescs) {
+        g_ptr_array_free(proc->legacyDescs, TRUE);
+    }
 
     /* And we no longer need to access the host. */
     if (proc->host) {
@@ -920,6 +1050,15 @@ int process_readPtr(Process* proc, void* dst, PluginVirtualPtr src, size_t n) {
     return memorymanager_readPtr(proc->memoryManager, dst, src, n);
 }
 
+int process_readPtrv(Process* proc, void* dst, const struct iovec* src, size_t iovcnt, size_t n) {
+    MAGIC_ASSERT(proc);
+
+    // Disallow additional references while there's a mutable reference.
+    utility_assert(!proc->memoryMutRef);
+
+    return memorymanager_readPtrv(proc->memoryManager, dst, src, iovcnt, n);
+}
+
 int process_writePtr(Process* proc, PluginVirtualPtr dst, const void* src, size_t n) {
     MAGIC_ASSERT(proc);
 
@@ -930,6 +1069,17 @@ int process_writePtr(Process* proc, PluginVirtualPtr dst, const void* src, size_
     return memorymanager_writePtr(proc->memoryManager, dst, src, n);
 }
 
+int process_writePtrv(Process* proc, const struct iovec* dst, size_t iovcnt, const void* src,
+                      size_t n) {
+    MAGIC_ASSERT(proc);
+
+    // Disallow additional references when trying to get a mutable reference.
+    utility_assert(!proc->memoryMutRef);
+    utility_assert(proc->memoryRefs->len == 0);
+
+    return memorymanager_writePtrv(proc->memoryManager, dst, iovcnt, src, n);
+}
+
 const void* process_getReadablePtr(Process* proc, PluginPtr plugin_src, size_t n) {
     MAGIC_ASSERT(proc);
 
@@ -1092,12 +1242,18 @@ static void _disassociateCompatDescriptor(CompatDescriptor* compatDesc, Host* ho
 int process_registerCompatDescriptor(Process* proc, CompatDescriptor* compatDesc) {
     MAGIC_ASSERT(proc);
     utility_assert(compatDesc);
-    return descriptortable_add(proc->descTable, compatDesc);
+    LegacyDescriptor* legacyDesc = compatdescriptor_asLegacy(compatDesc);
+    int handle = descriptortable_add(proc->descTable, compatDesc);
+    _process_setCachedLegacyDescriptor(proc, handle, legacyDesc);
+    return handle;
 }
 
 CompatDescriptor* process_deregisterCompatDescriptor(Process* proc, int handle) {
     MAGIC_ASSERT(proc);
     CompatDescriptor* compatDesc = descriptortable_remove(proc->descTable, handle);
+    if (compatDesc) {
+        _process_setCachedLegacyDescriptor(proc, handle, NULL);
+    }
     _disassociateCompatDescriptor(compatDesc, proc->host);
     return compatDesc;
 }
@@ -1133,6 +1289,13 @@ void process_deregisterLegacyDescriptor(Process* proc, LegacyDescriptor* desc) {
 LegacyDescriptor* process_getRegisteredLegacyDescriptor(Process* proc, int handle) {
     MAGIC_ASSERT(proc);
 
+    if (handle >= 0 && (guint)handle < proc->legacyDescs->len) {
+        LegacyDescriptor* legacyDesc = g_ptr_array_index(proc->legacyDescs, handle);
+        if (legacyDesc) {
+            return legacyDesc;
+        }
+    }
+
     const CompatDescriptor* compatDesc = process_getRegisteredCompatDescriptor(proc, handle);
     if (compatDesc == NULL) {
         return NULL;
@@ -25,6 +25,7 @@
 #include <sys/file.h>
 #include <sys/statfs.h>
 #include <sys/statvfs.h>
+#include <sys/uio.h>
 #include <time.h>
 #include <unistd.h>
 #include <wchar.h>
@@ -109,6 +110,12 @@ PluginPhysicalPtr process_getPhysicalAddress(Process* proc, PluginVirtualPtr vPt
 // the specified range couldn't be accessed. Always succeeds with n==0.
 int process_readPtr(Process* proc, void* dst, PluginVirtualPtr src, size_t n);
 
+// Copy the first `n` bytes of the plugin buffers described by the `iovcnt`
+// iovecs in `src` into `dst`, using as few native syscalls as possible. The
+// iovecs themselves must be in shadow's memory. Returns 0 on success or EFAULT
+// if the buffers are shorter than `n` or couldn't be accessed.
+int process_readPtrv(Process* proc, void* dst, const struct iovec* src, size_t iovcnt, size_t n);
+
 // Make the data starting at plugin_src, and extending until the first NULL
 // byte, up at most `n` bytes, available in shadow's address space.
 //
@@ -135,6 +142,13 @@ ssize_t process_readString(Process* proc, char* str, PluginVirtualPtr src, size_
 // the specified range couldn't be accessed. The write is flushed immediately.
 int process_writePtr(Process* proc, PluginVirtualPtr dst, const void* src, size_t n);
 
+// Copy `n` bytes from `src` into the plugin buffers described by the `iovcnt`
+// iovecs in `dst`, filling them in order. The iovecs themselves must be in
+// shadow's memory. Returns 0 on success or EFAULT if the buffers are shorter
+// than `n` or couldn't be accessed. The write is flushed immediately.
+int process_writePtrv(Process* proc, const struct iovec* dst, size_t iovcnt, const void* src,
+                      size_t n);
+
 // Make the data at plugin_src available in shadow's address space.
 //
 // The returned pointer is read-only, and is automatically invalidated when the
@@ -16,6 +16,14 @@ static bool _useSeccomp = true;
 ADD_CONFIG_HANDLER(config_getUseSeccomp, _useSeccomp)
 bool shimipc_getUseSeccomp() { return _useSeccomp; }
 
+static bool _useSyscallRewriting = false;
+ADD_CONFIG_HANDLER(config_getUseSyscallRewriting, _useSyscallRewriting)
+bool shimipc_getUseSyscallRewriting() { return _useSyscallRewriting; }
+
+static bool _useRdtscRewriting = false;
+ADD_CONFIG_HANDLER(config_getUseRdtscRewriting, _useRdtscRewriting)
+bool shimipc_getUseRdtscRewriting() { return _useRdtscRewriting; }
+
 static int _spinMax = -1;
 ADD_CONFIG_HANDLER(config_getPreloadSpinMax, _spinMax)
 
@@ -21,4 +21,12 @@ ssize_t shimipc_spinMax();
 
 // Whether to use a seccomp filter in the shim to catch syscalls that would
 // otherwise not be interposed.
-bool shimipc_getUseSeccomp();
\ No newline at end of file
+bool shimipc_getUseSeccomp();
+
+// Whether the shim should rewrite syscall sites caught by the seccomp filter so
+// that later calls from them don't trap.
+bool shimipc_getUseSyscallRewriting();
+
+// Whether the shim should rewrite rdtsc and rdtscp instructions it emulates so
+// that later executions don't trap.
+bool shimipc_getUseRdtscRewriting();
\ No newline at end of file
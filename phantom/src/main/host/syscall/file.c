@@ -7,16 +7,27 @@
 
 #include <errno.h>
 #include <fcntl.h>
+#include <stdlib.h>
 #include <sys/stat.h>
+#include <sys/syscall.h>
 #include <sys/types.h>
 #include <unistd.h>
 
 #include "lib/logger/logger.h"
+#include "main/bindings/c/bindings.h"
+#include "main/core/support/config_handlers.h"
 #include "main/host/descriptor/descriptor.h"
 #include "main/host/descriptor/file.h"
+#include "main/host/host.h"
 #include "main/host/process.h"
 #include "main/host/syscall/kernel_types.h"
+#include "main/host/syscall/mman.h"
 #include "main/host/syscall/protected.h"
+#include "main/host/thread.h"
+#include "main/utility/syscall.h"
+
+static bool _useNativePrivateFiles = false;
+ADD_CONFIG_HANDLER(config_getUseNativePrivateFiles, _useNativePrivateFiles)
 
 ///////////////////////////////////////////////////////////
 // Helpers
@@ -46,6 +57,49 @@ static int _syscallhandler_validateFileHelper(SysCallHandler* sys, int filefd,
     return 0;
 }
 
+bool _syscallhandler_movePluginFD(SysCallHandler* sys, int pluginFD, int handle, bool cloexec) {
+    if (pluginFD == handle) {
+        return true;
+    }
+
+    /* The shim keeps a few native fds of its own; never clobber one. */
+    bool moved = false;
+    long result = thread_nativeSyscall(sys->thread, SYS_fcntl, handle, F_GETFD);
+    if (syscall_rawReturnValueToErrno(result) == EBADF) {
+        result = thread_nativeSyscall(
+            sys->thread, SYS_dup3, pluginFD, handle, cloexec ? O_CLOEXEC : 0);
+        moved = syscall_rawReturnValueToErrno(result) == 0;
+    }
+
+    _syscallhandler_closePluginFile(sys, pluginFD);
+
+    if (!moved) {
+        trace("Native fd %i is not available in the plugin", handle);
+    }
+    return moved;
+}
+
+void _syscallhandler_passThroughFile(SysCallHandler* sys, File* file) {
+    utility_assert(file);
+
+    if (!_useNativePrivateFiles ||
+        !file_isRegularFileUnder(file, host_getDataPath(sys->host))) {
+        return;
+    }
+
+    int handle = descriptor_getHandle((LegacyDescriptor*)file);
+    int pluginFD = _syscallhandler_openPluginFile(sys, file);
+    if (pluginFD < 0) {
+        return;
+    }
+
+    if (_syscallhandler_movePluginFD(
+            sys, pluginFD, handle, (file_getFlags(file) & O_CLOEXEC) != 0)) {
+        trace("File %i is now handled natively by the plugin", handle);
+        file_setPluginNative(file, true);
+    }
+}
+
 static SysCallReturn _syscallhandler_openHelper(SysCallHandler* sys,
                                                 PluginPtr pathnamePtr,
                                                 int flags, mode_t mode) {
@@ -74,6 +128,7 @@ static SysCallReturn _syscallhandler_openHelper(SysCallHandler* sys,
         descriptor_close((LegacyDescriptor*)filed, sys->host);
     } else {
         utility_assert(errcode == handle);
+        _syscallhandler_passThroughFile(sys, filed);
     }
 
     return (SysCallReturn){.state = SYSCALL_DONE, .retval.as_i64 = errcode};
@@ -6,6 +6,9 @@
 #ifndef SRC_MAIN_HOST_SYSCALL_FILE_H_
 #define SRC_MAIN_HOST_SYSCALL_FILE_H_
 
+#include <stdbool.h>
+
+#include "main/host/descriptor/file.h"
 #include "main/host/syscall/protected.h"
 
 SYSCALL_HANDLER(creat);
@@ -31,4 +34,12 @@ SYSCALL_HANDLER(readahead);
 SYSCALL_HANDLER(sync_file_range);
 SYSCALL_HANDLER(syncfs);
 
+/* If native private files are enabled and the newly opened file is a regular
+ * file under the host's data directory, also open it natively in the plugin
+ * at the same fd so that later I/O on it can run natively. */
+void _syscallhandler_passThroughFile(SysCallHandler* sys, File* file);
+/* Moves the plugin's native pluginFD to handle if handle is not already open
+ * natively in the plugin. pluginFD is always closed. Returns true on success. */
+bool _syscallhandler_movePluginFD(SysCallHandler* sys, int pluginFD, int handle, bool cloexec);
+
 #endif /* SRC_MAIN_HOST_SYSCALL_FILE_H_ */
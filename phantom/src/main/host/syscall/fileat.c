@@ -17,6 +17,7 @@
 #include "main/host/descriptor/descriptor.h"
 #include "main/host/descriptor/file.h"
 #include "main/host/process.h"
+#include "main/host/syscall/file.h"
 #include "main/host/syscall/kernel_types.h"
 #include "main/host/syscall/protected.h"
 
@@ -136,6 +137,7 @@ SysCallReturn syscallhandler_openat(SysCallHandler* sys,
         descriptor_close((LegacyDescriptor*)file_desc, sys->host);
     } else {
         utility_assert(errcode == handle);
+        _syscallhandler_passThroughFile(sys, file_desc);
     }
 
     return (SysCallReturn){.state = SYSCALL_DONE, .retval.as_i64 = errcode};
@@ -113,7 +113,7 @@ static char* _file_createPersistentMMapPath(int file_fd, int osfile_fd) {
     return NULL;
 }
 
-static int _syscallhandler_openPluginFile(SysCallHandler* sys, File* file) {
+int _syscallhandler_openPluginFile(SysCallHandler* sys, File* file) {
     utility_assert(file);
 
     int fd = descriptor_getHandle((LegacyDescriptor*)file);
@@ -150,8 +150,9 @@ static int _syscallhandler_openPluginFile(SysCallHandler* sys, File* file) {
     process_flushPtrs(sys->process);
 
     /* Get original flags that were used to open the file,
-       but be careful not to try re-creating or truncating it. */
-    int flags = file_getFlags(file) & ~(O_CREAT|O_EXCL|O_TMPFILE|O_TRUNC);
+       but be careful not to try re-creating or truncating it. The procfs
+       path is a symlink, so it must be followed. */
+    int flags = file_getFlags(file) & ~(O_CREAT|O_EXCL|O_TMPFILE|O_TRUNC|O_NOFOLLOW);
 
     /* Instruct the plugin to open the file at the path we sent. */
     int result = thread_nativeSyscall(sys->thread, SYS_open, pluginBufPtr.val,
@@ -170,7 +171,7 @@ static int _syscallhandler_openPluginFile(SysCallHandler* sys, File* file) {
     return result;
 }
 
-static void _syscallhandler_closePluginFile(SysCallHandler* sys, int pluginFD) {
+void _syscallhandler_closePluginFile(SysCallHandler* sys, int pluginFD) {
     /* Instruct the plugin to close the file at given fd. */
     int result = thread_nativeSyscall(sys->thread, SYS_close, pluginFD);
     int err = syscall_rawReturnValueToErrno(result);
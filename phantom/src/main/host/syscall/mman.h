@@ -6,6 +6,7 @@
 #ifndef SRC_MAIN_HOST_SYSCALL_MMAN_H_
 #define SRC_MAIN_HOST_SYSCALL_MMAN_H_
 
+#include "main/host/descriptor/file.h"
 #include "main/host/syscall/protected.h"
 
 SYSCALL_HANDLER(brk);
@@ -15,4 +16,9 @@ SYSCALL_HANDLER(mprotect);
 SYSCALL_HANDLER(mremap);
 SYSCALL_HANDLER(munmap);
 
+/* Opens the os-backed file in the plugin through procfs, and returns the
+ * plugin's new fd or a negative errno. */
+int _syscallhandler_openPluginFile(SysCallHandler* sys, File* file);
+void _syscallhandler_closePluginFile(SysCallHandler* sys, int pluginFD);
+
 #endif /* SRC_MAIN_HOST_SYSCALL_MMAN_H_ */
@@ -92,8 +92,10 @@ static int _syscallhandler_getPollEvents(SysCallHandler* sys, struct pollfd* fds
 }
 
 static void _syscallhandler_registerPollFDs(SysCallHandler* sys, struct pollfd* fds, nfds_t nfds) {
-    // Epoll should already be clear, but let's make sure
-    epoll_reset(sys->epoll);
+    // The epoll still holds the watches from this thread's previous poll, which are usually
+    // for the same fds. Only the watches that changed since then are added, modified, or
+    // removed, instead of tearing down and re-creating a listener for every fd.
+    epoll_beginUpdate(sys->epoll);
 
     for (nfds_t i = 0; i < nfds; i++) {
         struct pollfd* pfd = &fds[i];
@@ -115,9 +117,11 @@ static void _syscallhandler_registerPollFDs(SysCallHandler* sys, struct pollfd*
         }
 
         if (epev.events) {
-            epoll_control(sys->epoll, EPOLL_CTL_ADD, pfd->fd, cdesc, &epev);
+            epoll_updateWatch(sys->epoll, pfd->fd, cdesc, &epev);
         }
     }
+
+    epoll_endUpdate(sys->epoll);
 }
 
 static SysCallReturn _syscallhandler_pollHelper(SysCallHandler* sys, PluginPtr fds_ptr, nfds_t nfds,
@@ -163,8 +167,7 @@ static SysCallReturn _syscallhandler_pollHelper(SysCallHandler* sys, PluginPtr f
     // We have events now and we've already written them to fds_ptr
     trace("poll returning %i ready events now", num_ready);
 done:
-    // Clear epoll for the next poll
-    epoll_reset(sys->epoll);
+    // Keep the epoll watches, so that the next poll on the same fds can reuse them
     return (SysCallReturn){.state = SYSCALL_DONE, .retval.as_i64 = num_ready};
 }
 
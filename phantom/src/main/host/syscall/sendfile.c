@@ -0,0 +1,282 @@
+/*
+ * The Shadow Simulator
+ * See LICENSE for licensing information
+ */
+
+#include "main/host/syscall/sendfile.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <glib.h>
+#include <stdbool.h>
+#include <sys/syscall.h>
+#include <sys/types.h>
+
+#include "lib/logger/logger.h"
+#include "main/bindings/c/bindings.h"
+#include "main/core/support/definitions.h"
+#include "main/host/descriptor/descriptor.h"
+#include "main/host/descriptor/file.h"
+#include "main/host/descriptor/tcp.h"
+#include "main/host/process.h"
+#include "main/host/syscall/protected.h"
+#include "main/host/syscall/socket.h"
+#include "main/host/syscall_condition.h"
+#include "main/host/thread.h"
+
+///////////////////////////////////////////////////////////
+// Helpers
+///////////////////////////////////////////////////////////
+
+/* Gets the legacy descriptor for one end of a transfer. */
+static int _syscallhandler_getTransferDescriptorHelper(SysCallHandler* sys, int fd,
+                                                       LegacyDescriptor** desc_out) {
+    const CompatDescriptor* compatDesc = process_getRegisteredCompatDescriptor(sys->process, fd);
+    if (!compatDesc) {
+        return -EBADF;
+    }
+
+    LegacyDescriptor* desc = compatdescriptor_asLegacy(compatDesc);
+    if (!desc) {
+        /* Descriptors that were moved to rust (e.g. pipes) can't be used here yet. */
+        debug("Data transfer with non-legacy descriptor %d is not supported", fd);
+        return -EINVAL;
+    }
+
+    *desc_out = desc;
+    return 0;
+}
+
+/* Returns 1 if both files are open natively in the plugin, so the transfer can
+ * run natively, 0 if neither is, or -EINVAL if only one of them is. */
+static int _syscallhandler_checkPluginNativeFilesHelper(File* inFile, File* outFile) {
+    bool inNative = file_isPluginNative(inFile);
+    bool outNative = file_isPluginNative(outFile);
+
+    if (inNative && outNative) {
+        return 1;
+    } else if (inNative || outNative) {
+        warning("Data transfer between a native private file and an emulated file is not "
+                "supported");
+        return -EINVAL;
+    }
+    return 0;
+}
+
+/* Seeks the input file, using the plugin's own file offset if the file is open
+ * natively in the plugin. */
+static off_t _syscallhandler_seekInputHelper(SysCallHandler* sys, int fd, File* file,
+                                             off_t offset, int whence) {
+    if (file_isPluginNative(file)) {
+        return thread_nativeSyscall(sys->thread, SYS_lseek, fd, offset, whence);
+    }
+    return file_lseek(file, offset, whence);
+}
+
+/* Sends up to count bytes of the file starting at offset on the socket. The data
+ * goes from the os-backed file into a buffer in shadow's memory, and from there
+ * into packet payloads, so it never passes through the plugin's memory. */
+static ssize_t _syscallhandler_sendfileToSocketHelper(SysCallHandler* sys, int sockfd,
+                                                      LegacyDescriptor* sockDesc, File* inFile,
+                                                      off_t offset, size_t count) {
+    /* Read no more than a single call to the transport can accept. */
+    size_t chunkSize = (descriptor_getType(sockDesc) == DT_TCPSOCKET) ? TCP_MAX_SEND_SIZE
+                                                                      : CONFIG_DATAGRAM_MAX_SIZE;
+    void* buf = g_malloc(MIN(count, chunkSize));
+
+    size_t totalSent = 0;
+    ssize_t result = 0;
+
+    while (totalSent < count) {
+        size_t nBytes = MIN(count - totalSent, chunkSize);
+
+        /* Read at an explicit offset, so that nothing is consumed from the file
+         * if the socket can't take the data and we need to try again later. */
+        result = file_pread(inFile, sys->host, buf, nBytes, offset + totalSent);
+        if (result <= 0) {
+            break;
+        }
+        nBytes = (size_t)result;
+
+        result = _syscallhandler_sendShadowHelper(sys, sockfd, buf, nBytes);
+        if (result <= 0) {
+            break;
+        }
+        totalSent += (size_t)result;
+
+        if ((size_t)result < nBytes) {
+            /* The socket buffer is full. */
+            break;
+        }
+    }
+
+    g_free(buf);
+
+    trace("sendfile sent %zu of %zu bytes on socket %d, last result %zd", totalSent, count,
+          sockfd, result);
+
+    return (totalSent > 0) ? (ssize_t)totalSent : result;
+}
+
+///////////////////////////////////////////////////////////
+// System Calls
+///////////////////////////////////////////////////////////
+
+#ifdef SYS_copy_file_range
+SysCallReturn syscallhandler_copy_file_range(SysCallHandler* sys, const SysCallArgs* args) {
+    int inFd = args->args[0].as_i64;
+    PluginPtr inOffsetPtr = args->args[1].as_ptr;
+    int outFd = args->args[2].as_i64;
+    PluginPtr outOffsetPtr = args->args[3].as_ptr;
+    size_t len = args->args[4].as_u64;
+    unsigned int flags = args->args[5].as_u64;
+
+    trace("Trying to copy_file_range %zu bytes from fd %d to fd %d", len, inFd, outFd);
+
+    LegacyDescriptor* inDesc = NULL;
+    LegacyDescriptor* outDesc = NULL;
+    int errcode = _syscallhandler_getTransferDescriptorHelper(sys, inFd, &inDesc);
+    if (errcode == 0) {
+        errcode = _syscallhandler_getTransferDescriptorHelper(sys, outFd, &outDesc);
+    }
+    if (errcode < 0) {
+        return (SysCallReturn){.state = SYSCALL_DONE, .retval.as_i64 = errcode};
+    }
+
+    /* Both ends need to be files. */
+    if (descriptor_getType(inDesc) != DT_FILE || descriptor_getType(outDesc) != DT_FILE) {
+        return (SysCallReturn){.state = SYSCALL_DONE, .retval.as_i64 = -EINVAL};
+    }
+
+    errcode = _syscallhandler_checkPluginNativeFilesHelper((File*)inDesc, (File*)outDesc);
+    if (errcode > 0) {
+        return (SysCallReturn){.state = SYSCALL_NATIVE};
+    } else if (errcode < 0) {
+        return (SysCallReturn){.state = SYSCALL_DONE, .retval.as_i64 = errcode};
+    }
+
+    off64_t inOffset = 0;
+    off64_t outOffset = 0;
+    if (inOffsetPtr.val &&
+        process_readPtr(sys->process, &inOffset, inOffsetPtr, sizeof(inOffset)) != 0) {
+        return (SysCallReturn){.state = SYSCALL_DONE, .retval.as_i64 = -EFAULT};
+    }
+    if (outOffsetPtr.val &&
+        process_readPtr(sys->process, &outOffset, outOffsetPtr, sizeof(outOffset)) != 0) {
+        return (SysCallReturn){.state = SYSCALL_DONE, .retval.as_i64 = -EFAULT};
+    }
+
+    /* The kernel copies between the os-backed files, and updates their file
+     * offsets if the plugin didn't give us explicit ones. */
+    ssize_t result = file_copyFileRange((File*)inDesc, inOffsetPtr.val ? &inOffset : NULL,
+                                        (File*)outDesc, outOffsetPtr.val ? &outOffset : NULL,
+                                        len, flags);
+
+    if (result > 0 && inOffsetPtr.val &&
+        process_writePtr(sys->process, inOffsetPtr, &inOffset, sizeof(inOffset)) != 0) {
+        return (SysCallReturn){.state = SYSCALL_DONE, .retval.as_i64 = -EFAULT};
+    }
+    if (result > 0 && outOffsetPtr.val &&
+        process_writePtr(sys->process, outOffsetPtr, &outOffset, sizeof(outOffset)) != 0) {
+        return (SysCallReturn){.state = SYSCALL_DONE, .retval.as_i64 = -EFAULT};
+    }
+
+    return (SysCallReturn){.state = SYSCALL_DONE, .retval.as_i64 = result};
+}
+#endif
+
+SysCallReturn syscallhandler_sendfile(SysCallHandler* sys, const SysCallArgs* args) {
+    int outFd = args->args[0].as_i64;
+    int inFd = args->args[1].as_i64;
+    PluginPtr offsetPtr = args->args[2].as_ptr;
+    size_t count = args->args[3].as_u64;
+
+    trace("Trying to sendfile %zu bytes from fd %d to fd %d", count, inFd, outFd);
+
+    LegacyDescriptor* inDesc = NULL;
+    LegacyDescriptor* outDesc = NULL;
+    int errcode = _syscallhandler_getTransferDescriptorHelper(sys, inFd, &inDesc);
+    if (errcode == 0) {
+        errcode = _syscallhandler_getTransferDescriptorHelper(sys, outFd, &outDesc);
+    }
+    if (errcode < 0) {
+        return (SysCallReturn){.state = SYSCALL_DONE, .retval.as_i64 = errcode};
+    }
+
+    /* We can only read from files. */
+    if (descriptor_getType(inDesc) != DT_FILE) {
+        return (SysCallReturn){.state = SYSCALL_DONE, .retval.as_i64 = -EINVAL};
+    }
+    File* inFile = (File*)inDesc;
+    if ((file_getFlags(inFile) & O_ACCMODE) == O_WRONLY) {
+        return (SysCallReturn){.state = SYSCALL_DONE, .retval.as_i64 = -EBADF};
+    }
+
+    off_t offset = 0;
+    if (offsetPtr.val) {
+        if (process_readPtr(sys->process, &offset, offsetPtr, sizeof(offset)) != 0) {
+            return (SysCallReturn){.state = SYSCALL_DONE, .retval.as_i64 = -EFAULT};
+        }
+        if (offset < 0) {
+            return (SysCallReturn){.state = SYSCALL_DONE, .retval.as_i64 = -EINVAL};
+        }
+    }
+
+    if (count == 0) {
+        return (SysCallReturn){.state = SYSCALL_DONE, .retval.as_i64 = 0};
+    }
+
+    LegacyDescriptorType outType = descriptor_getType(outDesc);
+    ssize_t result = 0;
+
+    if (outType == DT_FILE) {
+        errcode = _syscallhandler_checkPluginNativeFilesHelper(inFile, (File*)outDesc);
+        if (errcode > 0) {
+            return (SysCallReturn){.state = SYSCALL_NATIVE};
+        } else if (errcode < 0) {
+            return (SysCallReturn){.state = SYSCALL_DONE, .retval.as_i64 = errcode};
+        }
+
+        /* The kernel copies between the os-backed files, and updates the input
+         * file offset if the plugin didn't give us an explicit one. */
+        result = file_sendfile((File*)outDesc, inFile, offsetPtr.val ? &offset : NULL, count);
+    } else if (outType == DT_TCPSOCKET || outType == DT_UDPSOCKET) {
+        if (!offsetPtr.val) {
+            offset = _syscallhandler_seekInputHelper(sys, inFd, inFile, 0, SEEK_CUR);
+            if (offset < 0) {
+                return (SysCallReturn){.state = SYSCALL_DONE, .retval.as_i64 = offset};
+            }
+        }
+
+        result = _syscallhandler_sendfileToSocketHelper(sys, outFd, outDesc, inFile, offset, count);
+
+        if (result == -EWOULDBLOCK && !(descriptor_getFlags(outDesc) & O_NONBLOCK)) {
+            /* Nothing was sent, so we can start over once the socket is writable. */
+            Trigger trigger = (Trigger){
+                .type = TRIGGER_DESCRIPTOR, .object = outDesc, .status = STATUS_DESCRIPTOR_WRITABLE};
+            return (SysCallReturn){
+                .state = SYSCALL_BLOCK, .cond = syscallcondition_new(trigger, NULL)};
+        }
+
+        if (result > 0) {
+            offset += result;
+            if (!offsetPtr.val) {
+                /* Consume what we sent from the file. */
+                if (_syscallhandler_seekInputHelper(sys, inFd, inFile, offset, SEEK_SET) !=
+                    offset) {
+                    warning("Unable to advance the offset of fd %d after sendfile", inFd);
+                }
+            }
+        }
+    } else {
+        warning("sendfile() not yet implemented for descriptor type %i", (int)outType);
+        result = -EINVAL;
+    }
+
+    if (result > 0 && offsetPtr.val &&
+        process_writePtr(sys->process, offsetPtr, &offset, sizeof(offset)) != 0) {
+        return (SysCallReturn){.state = SYSCALL_DONE, .retval.as_i64 = -EFAULT};
+    }
+
+    return (SysCallReturn){.state = SYSCALL_DONE, .retval.as_i64 = result};
+}
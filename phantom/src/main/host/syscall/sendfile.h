@@ -0,0 +1,18 @@
+/*
+ * The Shadow Simulator
+ * See LICENSE for licensing information
+ */
+
+#ifndef SRC_MAIN_HOST_SYSCALL_SENDFILE_H_
+#define SRC_MAIN_HOST_SYSCALL_SENDFILE_H_
+
+#include <sys/syscall.h>
+
+#include "main/host/syscall/protected.h"
+
+#ifdef SYS_copy_file_range
+SYSCALL_HANDLER(copy_file_range);
+#endif
+SYSCALL_HANDLER(sendfile);
+
+#endif /* SRC_MAIN_HOST_SYSCALL_SENDFILE_H_ */
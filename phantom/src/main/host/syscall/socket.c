@@ -9,8 +9,10 @@
 #include <glib.h>
 #include <netinet/in.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 
 #include "lib/logger/logger.h"
 #include "main/core/worker.h"
@@ -428,15 +430,244 @@ static int _syscallhandler_setSocketOptHelper(SysCallHandler* sys, Socket* sock,
     return 0;
 }
 
+/* Makes sure that the socket has somewhere to send data to. UDP sockets fall back
+ * to the peer set with connect() and are implicitly bound, and TCP sockets must
+ * be connected. Returns 0 or a negative errno, which is -EWOULDBLOCK while a TCP
+ * connection is in progress. */
+static int _syscallhandler_prepareSendHelper(SysCallHandler* sys, Socket* socket_desc,
+                                             in_addr_t* dest_ip, in_port_t* dest_port) {
+    LegacyDescriptor* desc = (LegacyDescriptor*)socket_desc;
+    int errcode = 0;
+
+    if (descriptor_getType(desc) == DT_UDPSOCKET) {
+        /* make sure that we have somewhere to send it */
+        if (*dest_ip == 0 || *dest_port == 0) {
+            /* its ok if they setup a default destination with connect() */
+            socket_getPeerName(socket_desc, dest_ip, dest_port);
+            if (*dest_ip == 0 || *dest_port == 0) {
+                /* we have nowhere to send it */
+                return -EDESTADDRREQ;
+            }
+        }
+
+        /* if this socket is not bound, do an implicit bind to a random port */
+        if (!socket_isBound(socket_desc)) {
+            ProtocolType ptype = socket_getProtocol(socket_desc);
+
+            /* We don't bind to peer ip/port since that might change later. */
+            in_addr_t bindAddr =
+                (*dest_ip == htonl(INADDR_LOOPBACK))
+                    ? htonl(INADDR_LOOPBACK)
+                    : address_toNetworkIP(host_getDefaultAddress(sys->host));
+            in_port_t bindPort =
+                host_getRandomFreePort(sys->host, ptype, bindAddr, 0, 0);
+
+            if (!bindPort) {
+                return -EADDRNOTAVAIL;
+            }
+
+            /* connect up socket layer */
+            socket_setPeerName(socket_desc, 0, 0);
+            socket_setSocketName(socket_desc, bindAddr, bindPort);
+
+            /* set netiface->socket associations */
+            CompatSocket compat_socket = compatsocket_fromLegacySocket(socket_desc);
+            host_associateInterface(sys->host, &compat_socket, bindAddr);
+        }
+    } else if (descriptor_getType(desc) == DT_TCPSOCKET) {
+        errcode = tcp_getConnectionError((TCP*)socket_desc);
+
+        trace("connection error state is currently %i", errcode);
+
+        if (errcode > 0) {
+            /* connect() was not called yet.
+             * TODO: Can they can piggy back a connect() on sendto() if they
+             * provide an address for the connection? */
+            return -ENOTCONN;
+        } else if (errcode == 0) {
+            /* They connected, but never read the success code with a second
+             * call to connect(). That's OK, proceed to send as usual. */
+        } else if (errcode == -EISCONN) {
+            /* They are connected, and we can send now. */
+            errcode = 0;
+        } else if (errcode == -EALREADY) {
+            /* Connection in progress.
+             * TODO: should we wait, or just return -EALREADY? */
+            errcode = -EWOULDBLOCK;
+        }
+    }
+
+    return errcode;
+}
+
+/* Copies the iovec array of the message header into shadow's memory. On success the
+ * caller must g_free the array stored in iovOut. */
+static int _syscallhandler_readMsgIovecs(SysCallHandler* sys, const struct msghdr* msg,
+                                         struct iovec** iovOut) {
+    *iovOut = NULL;
+
+    if (msg->msg_iovlen > UIO_MAXIOV) {
+        return -EMSGSIZE;
+    } else if (msg->msg_iovlen == 0) {
+        return 0;
+    } else if (!msg->msg_iov) {
+        return -EFAULT;
+    }
+
+    struct iovec* iov = g_new(struct iovec, msg->msg_iovlen);
+    PluginPtr iovPtr = (PluginPtr){.val = (uint64_t)msg->msg_iov};
+    if (process_readPtr(sys->process, iov, iovPtr, msg->msg_iovlen * sizeof(*iov)) != 0) {
+        g_free(iov);
+        return -EFAULT;
+    }
+
+    *iovOut = iov;
+    return 0;
+}
+
+/* Receives one message into the buffers described by msg, which is a copy of the
+ * plugin's header at msgPtr. The fields the kernel would update are changed in msg,
+ * and it is up to the caller to write it back to the plugin. */
+static SysCallReturn _syscallhandler_recvmsgHelper(SysCallHandler* sys, int sockfd,
+                                                   PluginPtr msgPtr, struct msghdr* msg,
+                                                   int flags) {
+    struct iovec* iov = NULL;
+    int errcode = _syscallhandler_readMsgIovecs(sys, msg, &iov);
+    if (errcode < 0) {
+        return (SysCallReturn){.state = SYSCALL_DONE, .retval.as_i64 = errcode};
+    }
+
+    /* As on Linux, only datagram sockets return the source address; connected
+     * stream sockets leave msg_name alone and set msg_namelen to 0. The address
+     * length is read from and written to the plugin's header. */
+    LegacyDescriptor* desc = process_getRegisteredLegacyDescriptor(sys->process, sockfd);
+    bool wantAddr = msg->msg_name && desc && descriptor_getType(desc) == DT_UDPSOCKET;
+    PluginPtr srcAddrPtr = (PluginPtr){.val = wantAddr ? (uint64_t)msg->msg_name : 0};
+    PluginPtr addrlenPtr =
+        (PluginPtr){.val = wantAddr ? msgPtr.val + offsetof(struct msghdr, msg_namelen) : 0};
+
+    SysCallReturn ret = _syscallhandler_recvvHelper(
+        sys, sockfd, iov, msg->msg_iovlen, flags, srcAddrPtr, addrlenPtr);
+    g_free(iov);
+
+    if (ret.state == SYSCALL_DONE && ret.retval.as_i64 >= 0) {
+        /* The recv helper only fills in the address (and its length in the
+         * plugin's header) when it returned data. Our copy is written back over
+         * the plugin's header, so it must say the same thing. */
+        if (msg->msg_name) {
+            msg->msg_namelen =
+                (wantAddr && ret.retval.as_i64 > 0) ? sizeof(struct sockaddr_in) : 0;
+        }
+        /* We don't support ancillary data or any of the message flags. */
+        msg->msg_controllen = 0;
+        msg->msg_flags = 0;
+    }
+
+    return ret;
+}
+
+/* Sends one message from the buffers described by msg, which is a copy of the
+ * plugin's header. */
+static SysCallReturn _syscallhandler_sendmsgHelper(SysCallHandler* sys, int sockfd,
+                                                   const struct msghdr* msg, int flags) {
+    if (msg->msg_control && msg->msg_controllen > 0) {
+        warning("Ignoring unsupported ancillary data on socket %i", sockfd);
+    }
+
+    struct iovec* iov = NULL;
+    int errcode = _syscallhandler_readMsgIovecs(sys, msg, &iov);
+    if (errcode < 0) {
+        return (SysCallReturn){.state = SYSCALL_DONE, .retval.as_i64 = errcode};
+    }
+
+    PluginPtr destAddrPtr = (PluginPtr){.val = (uint64_t)msg->msg_name};
+    SysCallReturn ret = _syscallhandler_sendvHelper(
+        sys, sockfd, iov, msg->msg_iovlen, flags, destAddrPtr, msg->msg_namelen);
+    g_free(iov);
+
+    return ret;
+}
+
+/* Sends or receives up to vlen messages described by the plugin's mmsghdr array.
+ * The headers are copied in, and the updated headers copied back out, all at once.
+ * Only the first message may block; after that we handle the messages that can
+ * be handled right away, and return how many there were. */
+static SysCallReturn _syscallhandler_mmsgHelper(SysCallHandler* sys, int sockfd,
+                                                PluginPtr msgvecPtr, unsigned int vlen,
+                                                int flags, bool doSend) {
+    /* Linux silently truncates the vector. */
+    vlen = MIN(vlen, UIO_MAXIOV);
+    if (vlen == 0) {
+        return (SysCallReturn){.state = SYSCALL_DONE, .retval.as_i64 = 0};
+    }
+
+    struct mmsghdr* msgvec = g_new(struct mmsghdr, vlen);
+    if (!msgvecPtr.val ||
+        process_readPtr(sys->process, msgvec, msgvecPtr, vlen * sizeof(*msgvec)) != 0) {
+        g_free(msgvec);
+        return (SysCallReturn){.state = SYSCALL_DONE, .retval.as_i64 = -EFAULT};
+    }
+
+    SysCallReturn ret = {0};
+    unsigned int count = 0;
+
+    for (; count < vlen; count++) {
+        int msgFlags = (count == 0) ? flags : (flags | MSG_DONTWAIT);
+
+        if (doSend) {
+            ret = _syscallhandler_sendmsgHelper(sys, sockfd, &msgvec[count].msg_hdr, msgFlags);
+        } else {
+            PluginPtr msgPtr = (PluginPtr){.val = msgvecPtr.val + count * sizeof(*msgvec) +
+                                                  offsetof(struct mmsghdr, msg_hdr)};
+            ret = _syscallhandler_recvmsgHelper(
+                sys, sockfd, msgPtr, &msgvec[count].msg_hdr, msgFlags);
+        }
+
+        if (ret.state != SYSCALL_DONE || ret.retval.as_i64 < 0) {
+            break;
+        }
+
+        msgvec[count].msg_len = (unsigned int)ret.retval.as_i64;
+    }
+
+    if (count == 0) {
+        /* Nothing was transferred, so report the first message's result. */
+        g_free(msgvec);
+        return ret;
+    }
+
+    if (count < vlen) {
+        trace("stopping after %u of %u messages on socket %i with result %ld", count, vlen,
+              sockfd, (long)ret.retval.as_i64);
+    }
+
+    int err = process_writePtr(sys->process, msgvecPtr, msgvec, count * sizeof(*msgvec));
+    g_free(msgvec);
+    if (err) {
+        return (SysCallReturn){.state = SYSCALL_DONE, .retval.as_i64 = err};
+    }
+
+    return (SysCallReturn){.state = SYSCALL_DONE, .retval.as_i64 = count};
+}
+
 ///////////////////////////////////////////////////////////
 // Protected helpers
 ///////////////////////////////////////////////////////////
 
-SysCallReturn _syscallhandler_recvfromHelper(SysCallHandler* sys, int sockfd,
-                                             PluginPtr bufPtr, size_t bufSize,
-                                             int flags, PluginPtr srcAddrPtr,
-                                             PluginPtr addrlenPtr) {
-    trace("trying to recv %zu bytes on socket %i", bufSize, sockfd);
+static size_t _syscallhandler_iovecTotalLength(const struct iovec* iov, size_t iovlen) {
+    size_t total = 0;
+    for (size_t i = 0; i < iovlen; i++) {
+        total += iov[i].iov_len;
+    }
+    return total;
+}
+
+SysCallReturn _syscallhandler_recvvHelper(SysCallHandler* sys, int sockfd,
+                                          const struct iovec* iov, size_t iovlen, int flags,
+                                          PluginPtr srcAddrPtr, PluginPtr addrlenPtr) {
+    size_t bufSize = _syscallhandler_iovecTotalLength(iov, iovlen);
+
+    trace("trying to recv %zu bytes into %zu buffers on socket %i", bufSize, iovlen, sockfd);
 
     /* Get and validate the socket. */
     Socket* socket_desc = NULL;
@@ -490,8 +721,28 @@ SysCallReturn _syscallhandler_recvfromHelper(SysCallHandler* sys, int sockfd,
             sizeNeeded = MIN(sizeNeeded, CONFIG_DATAGRAM_MAX_SIZE + 1);
         }
 
-        retval = transport_receiveUserData((Transport*)socket_desc, sys->thread, bufPtr, sizeNeeded,
-                                           &inet_addr.sin_addr.s_addr, &inet_addr.sin_port);
+        if (iovlen == 1) {
+            PluginPtr bufPtr = (PluginPtr){.val = (uint64_t)iov[0].iov_base};
+            retval = transport_receiveUserData((Transport*)socket_desc, sys->thread, bufPtr,
+                                               sizeNeeded, &inet_addr.sin_addr.s_addr,
+                                               &inet_addr.sin_port);
+        } else {
+            /* Receive into one contiguous buffer, so that TCP copies out whole
+             * packets, then scatter it into the plugin's buffers all at once. */
+            void* buf = g_malloc(MAX(sizeNeeded, 1));
+            retval = transport_receiveUserDataShadow((Transport*)socket_desc, sys->thread, buf,
+                                                     sizeNeeded, &inet_addr.sin_addr.s_addr,
+                                                     &inet_addr.sin_port);
+            if (retval > 0) {
+                int err = process_writePtrv(sys->process, iov, iovlen, buf, retval);
+                if (err) {
+                    warning("Returning error %s, but already received %zd bytes which will be lost",
+                            g_strerror(-err), retval);
+                    retval = err;
+                }
+            }
+            g_free(buf);
+        }
 
         trace("recv returned %zd", retval);
     }
@@ -516,11 +767,20 @@ SysCallReturn _syscallhandler_recvfromHelper(SysCallHandler* sys, int sockfd,
         .state = SYSCALL_DONE, .retval.as_i64 = (int64_t)retval};
 }
 
-SysCallReturn _syscallhandler_sendtoHelper(SysCallHandler* sys, int sockfd,
-                                           PluginPtr bufPtr, size_t bufSize,
-                                           int flags, PluginPtr destAddrPtr,
-                                           socklen_t addrlen) {
-    trace("trying to send %zu bytes on socket %i", bufSize, sockfd);
+SysCallReturn _syscallhandler_recvfromHelper(SysCallHandler* sys, int sockfd,
+                                             PluginPtr bufPtr, size_t bufSize,
+                                             int flags, PluginPtr srcAddrPtr,
+                                             PluginPtr addrlenPtr) {
+    struct iovec iov = {.iov_base = (void*)bufPtr.val, .iov_len = bufSize};
+    return _syscallhandler_recvvHelper(sys, sockfd, &iov, 1, flags, srcAddrPtr, addrlenPtr);
+}
+
+SysCallReturn _syscallhandler_sendvHelper(SysCallHandler* sys, int sockfd,
+                                          const struct iovec* iov, size_t iovlen, int flags,
+                                          PluginPtr destAddrPtr, socklen_t addrlen) {
+    size_t bufSize = _syscallhandler_iovecTotalLength(iov, iovlen);
+
+    trace("trying to send %zu bytes from %zu buffers on socket %i", bufSize, iovlen, sockfd);
 
     /* Get and validate the socket. */
     Socket* socket_desc = NULL;
@@ -530,10 +790,12 @@ SysCallReturn _syscallhandler_sendtoHelper(SysCallHandler* sys, int sockfd,
         return (SysCallReturn){.state = SYSCALL_DONE, .retval.as_i64 = errcode};
     }
 
-    /* Need non-NULL buffer. */
-    if (!bufPtr.val) {
-        debug("Can't send from NULL buffer on socket %i", sockfd);
-        return (SysCallReturn){.state = SYSCALL_DONE, .retval.as_i64 = -EFAULT};
+    /* Need non-NULL buffers. */
+    for (size_t i = 0; i < iovlen; i++) {
+        if (!iov[i].iov_base) {
+            debug("Can't send from NULL buffer on socket %i", sockfd);
+            return (SysCallReturn){.state = SYSCALL_DONE, .retval.as_i64 = -EFAULT};
+        }
     }
 
     /* TODO: when we support AF_UNIX this could be sockaddr_un */
@@ -569,68 +831,7 @@ SysCallReturn _syscallhandler_sendtoHelper(SysCallHandler* sys, int sockfd,
     }
 
     LegacyDescriptor* desc = (LegacyDescriptor*)socket_desc;
-    errcode = 0;
-
-    if (descriptor_getType(desc) == DT_UDPSOCKET) {
-        /* make sure that we have somewhere to send it */
-        if (dest_ip == 0 || dest_port == 0) {
-            /* its ok if they setup a default destination with connect() */
-            socket_getPeerName(socket_desc, &dest_ip, &dest_port);
-            if (dest_ip == 0 || dest_port == 0) {
-                /* we have nowhere to send it */
-                return (SysCallReturn){
-                    .state = SYSCALL_DONE, .retval.as_i64 = -EDESTADDRREQ};
-            }
-        }
-
-        /* if this socket is not bound, do an implicit bind to a random port */
-        if (!socket_isBound(socket_desc)) {
-            ProtocolType ptype = socket_getProtocol(socket_desc);
-
-            /* We don't bind to peer ip/port since that might change later. */
-            in_addr_t bindAddr =
-                (dest_ip == htonl(INADDR_LOOPBACK))
-                    ? htonl(INADDR_LOOPBACK)
-                    : address_toNetworkIP(host_getDefaultAddress(sys->host));
-            in_port_t bindPort =
-                host_getRandomFreePort(sys->host, ptype, bindAddr, 0, 0);
-
-            if (!bindPort) {
-                return (SysCallReturn){
-                    .state = SYSCALL_DONE, .retval.as_i64 = -EADDRNOTAVAIL};
-            }
-
-            /* connect up socket layer */
-            socket_setPeerName(socket_desc, 0, 0);
-            socket_setSocketName(socket_desc, bindAddr, bindPort);
-
-            /* set netiface->socket associations */
-            CompatSocket compat_socket = compatsocket_fromLegacySocket(socket_desc);
-            host_associateInterface(sys->host, &compat_socket, bindAddr);
-        }
-    } else if (descriptor_getType(desc) == DT_TCPSOCKET) {
-        errcode = tcp_getConnectionError((TCP*)socket_desc);
-
-        trace("connection error state is currently %i", errcode);
-
-        if (errcode > 0) {
-            /* connect() was not called yet.
-             * TODO: Can they can piggy back a connect() on sendto() if they
-             * provide an address for the connection? */
-            return (SysCallReturn){
-                .state = SYSCALL_DONE, .retval.as_i64 = -ENOTCONN};
-        } else if (errcode == 0) {
-            /* They connected, but never read the success code with a second
-             * call to connect(). That's OK, proceed to send as usual. */
-        } else if (errcode == -EISCONN) {
-            /* They are connected, and we can send now. */
-            errcode = 0;
-        } else if (errcode == -EALREADY) {
-            /* Connection in progress.
-             * TODO: should we wait, or just return -EALREADY? */
-            errcode = -EWOULDBLOCK;
-        }
-    }
+    errcode = _syscallhandler_prepareSendHelper(sys, socket_desc, &dest_ip, &dest_port);
 
     gssize retval = (gssize)errcode;
 
@@ -647,8 +848,28 @@ SysCallReturn _syscallhandler_sendtoHelper(SysCallHandler* sys, int sockfd,
             sizeNeeded = MIN(sizeNeeded, CONFIG_DATAGRAM_MAX_SIZE + 1);
         }
 
-        retval = transport_sendUserData(
-            (Transport*)socket_desc, sys->thread, bufPtr, sizeNeeded, dest_ip, dest_port);
+        if (iovlen == 1) {
+            PluginPtr bufPtr = (PluginPtr){.val = (uint64_t)iov[0].iov_base};
+            retval = transport_sendUserData(
+                (Transport*)socket_desc, sys->thread, bufPtr, sizeNeeded, dest_ip, dest_port);
+        } else {
+            /* Gather the plugin's buffers all at once, and hand them to the
+             * transport as one chunk so that TCP segments it at the MSS and
+             * UDP sends it as a single datagram. */
+            if (descriptor_getType(desc) == DT_TCPSOCKET) {
+                /* Don't gather data that TCP won't accept in this call. */
+                sizeNeeded = MIN(sizeNeeded, TCP_MAX_SEND_SIZE);
+            }
+            void* buf = g_malloc(MAX(sizeNeeded, 1));
+            int err = process_readPtrv(sys->process, buf, iov, iovlen, sizeNeeded);
+            if (err) {
+                retval = err;
+            } else {
+                retval = transport_sendUserDataShadow(
+                    (Transport*)socket_desc, sys->thread, buf, sizeNeeded, dest_ip, dest_port);
+            }
+            g_free(buf);
+        }
 
         trace("send returned %zd", retval);
     }
@@ -670,6 +891,33 @@ SysCallReturn _syscallhandler_sendtoHelper(SysCallHandler* sys, int sockfd,
         .state = SYSCALL_DONE, .retval.as_i64 = (int64_t)retval};
 }
 
+SysCallReturn _syscallhandler_sendtoHelper(SysCallHandler* sys, int sockfd,
+                                           PluginPtr bufPtr, size_t bufSize,
+                                           int flags, PluginPtr destAddrPtr,
+                                           socklen_t addrlen) {
+    struct iovec iov = {.iov_base = (void*)bufPtr.val, .iov_len = bufSize};
+    return _syscallhandler_sendvHelper(sys, sockfd, &iov, 1, flags, destAddrPtr, addrlen);
+}
+
+ssize_t _syscallhandler_sendShadowHelper(SysCallHandler* sys, int sockfd, const void* buf,
+                                         size_t bufSize) {
+    Socket* socket_desc = NULL;
+    int errcode = _syscallhandler_validateSocketHelper(sys, sockfd, &socket_desc);
+    if (errcode < 0) {
+        return errcode;
+    }
+
+    in_addr_t dest_ip = 0;
+    in_port_t dest_port = 0;
+    errcode = _syscallhandler_prepareSendHelper(sys, socket_desc, &dest_ip, &dest_port);
+    if (errcode < 0) {
+        return errcode;
+    }
+
+    return transport_sendUserDataShadow(
+        (Transport*)socket_desc, sys->thread, buf, bufSize, dest_ip, dest_port);
+}
+
 ///////////////////////////////////////////////////////////
 // System Calls
 ///////////////////////////////////////////////////////////
@@ -1105,6 +1353,60 @@ SysCallReturn syscallhandler_recvfrom(SysCallHandler* sys,
         args->args[3].as_i64, args->args[4].as_ptr, args->args[5].as_ptr);
 }
 
+SysCallReturn syscallhandler_recvmmsg(SysCallHandler* sys, const SysCallArgs* args) {
+    int sockfd = args->args[0].as_i64;
+    PluginPtr msgvecPtr = args->args[1].as_ptr;
+    unsigned int vlen = args->args[2].as_u64;
+    int flags = args->args[3].as_i64;
+    /* The timeout (args[4]) is only checked by Linux after each message is
+     * received. We never block after the first message, so it doesn't apply. */
+
+    /* We already return early once a message has been received. */
+    flags &= ~MSG_WAITFORONE;
+
+    return _syscallhandler_mmsgHelper(sys, sockfd, msgvecPtr, vlen, flags, false);
+}
+
+SysCallReturn syscallhandler_recvmsg(SysCallHandler* sys, const SysCallArgs* args) {
+    int sockfd = args->args[0].as_i64;
+    PluginPtr msgPtr = args->args[1].as_ptr;
+    int flags = args->args[2].as_i64;
+
+    struct msghdr msg;
+    if (!msgPtr.val || process_readPtr(sys->process, &msg, msgPtr, sizeof(msg)) != 0) {
+        return (SysCallReturn){.state = SYSCALL_DONE, .retval.as_i64 = -EFAULT};
+    }
+
+    SysCallReturn ret = _syscallhandler_recvmsgHelper(sys, sockfd, msgPtr, &msg, flags);
+
+    if (ret.state == SYSCALL_DONE && ret.retval.as_i64 >= 0) {
+        int err = process_writePtr(sys->process, msgPtr, &msg, sizeof(msg));
+        if (err) {
+            return (SysCallReturn){.state = SYSCALL_DONE, .retval.as_i64 = err};
+        }
+    }
+
+    return ret;
+}
+
+SysCallReturn syscallhandler_sendmmsg(SysCallHandler* sys, const SysCallArgs* args) {
+    return _syscallhandler_mmsgHelper(sys, args->args[0].as_i64, args->args[1].as_ptr,
+                                      args->args[2].as_u64, args->args[3].as_i64, true);
+}
+
+SysCallReturn syscallhandler_sendmsg(SysCallHandler* sys, const SysCallArgs* args) {
+    int sockfd = args->args[0].as_i64;
+    PluginPtr msgPtr = args->args[1].as_ptr;
+    int flags = args->args[2].as_i64;
+
+    struct msghdr msg;
+    if (!msgPtr.val || process_readPtr(sys->process, &msg, msgPtr, sizeof(msg)) != 0) {
+        return (SysCallReturn){.state = SYSCALL_DONE, .retval.as_i64 = -EFAULT};
+    }
+
+    return _syscallhandler_sendmsgHelper(sys, sockfd, &msg, flags);
+}
+
 SysCallReturn syscallhandler_sendto(SysCallHandler* sys,
                                     const SysCallArgs* args) {
     return _syscallhandler_sendtoHelper(
@@ -6,6 +6,8 @@
 #ifndef SRC_MAIN_HOST_SYSCALL_SOCKET_H_
 #define SRC_MAIN_HOST_SYSCALL_SOCKET_H_
 
+#include <sys/uio.h>
+
 #include "main/host/syscall/protected.h"
 
 SYSCALL_HANDLER(accept);
@@ -17,12 +19,36 @@ SYSCALL_HANDLER(getsockname);
 SYSCALL_HANDLER(getsockopt);
 SYSCALL_HANDLER(listen);
 SYSCALL_HANDLER(recvfrom);
+SYSCALL_HANDLER(recvmmsg);
+SYSCALL_HANDLER(recvmsg);
+SYSCALL_HANDLER(sendmmsg);
+SYSCALL_HANDLER(sendmsg);
 SYSCALL_HANDLER(sendto);
 SYSCALL_HANDLER(setsockopt);
 SYSCALL_HANDLER(shutdown);
 SYSCALL_HANDLER(socket);
 SYSCALL_HANDLER(socketpair);
 
+/* Protected helper to receive into the plugin buffers described by the iovecs in
+ * `iov`, which are in shadow's memory. Multiple buffers are filled with a single
+ * receive from the transport. */
+SysCallReturn _syscallhandler_recvvHelper(SysCallHandler* sys, int sockfd,
+                                          const struct iovec* iov, size_t iovlen, int flags,
+                                          PluginPtr srcAddrPtr, PluginPtr addrlenPtr);
+
+/* Protected helper to send from the plugin buffers described by the iovecs in
+ * `iov`, which are in shadow's memory. Multiple buffers are gathered and sent
+ * as a single chunk. */
+SysCallReturn _syscallhandler_sendvHelper(SysCallHandler* sys, int sockfd,
+                                          const struct iovec* iov, size_t iovlen, int flags,
+                                          PluginPtr destAddrPtr, socklen_t addrlen);
+
+/* Protected helper to send bytes that are already in shadow's memory on a socket
+ * that has a destination, e.g. for sendfile(). It never blocks: it returns the
+ * number of bytes sent or a negative errno, and the caller handles -EWOULDBLOCK. */
+ssize_t _syscallhandler_sendShadowHelper(SysCallHandler* sys, int sockfd, const void* buf,
+                                         size_t bufSize);
+
 /* Protected helper to allow read(sockfd) to redirect here. */
 SysCallReturn _syscallhandler_recvfromHelper(SysCallHandler* sys, int sockfd,
                                              PluginPtr bufPtr, size_t bufSize,
@@ -6,6 +6,7 @@
 #include "main/host/syscall/uio.h"
 
 #include <errno.h>
+#include <glib.h>
 #include <sys/syscall.h>
 #include <sys/uio.h>
 
@@ -22,11 +23,12 @@
 // Helpers
 ///////////////////////////////////////////////////////////
 
+/* On success, *iov_out is a copy of the plugin's iovecs that the caller must g_free. */
 static int _syscallhandler_validateVecParams(SysCallHandler* sys, int fd,
                                              PluginPtr iovPtr,
                                              unsigned long iovlen, off_t offset,
                                              LegacyDescriptor** desc_out,
-                                             const struct iovec** iov_out) {
+                                             struct iovec** iov_out) {
     /* Get the descriptor. */
     LegacyDescriptor* desc = process_getRegisteredLegacyDescriptor(sys->process, fd);
     if (!desc) {
@@ -50,10 +52,12 @@ static int _syscallhandler_validateVecParams(SysCallHandler* sys, int fd,
         return -ESPIPE;
     }
 
-    /* Get the vector of pointers. */
-    const struct iovec* iov = process_getReadablePtr(sys->process, iovPtr, iovlen * sizeof(*iov));
-    if (!iov) {
+    /* Copy the vector of pointers, rather than referencing it in place, so that
+     * we can still write to the plugin's buffers while using it. */
+    struct iovec* iov = g_new(struct iovec, iovlen);
+    if (process_readPtr(sys->process, iov, iovPtr, iovlen * sizeof(*iov)) != 0) {
         warning("Got unreadable pointer [%p..+%zu]", (void*)iovPtr.val, iovlen * sizeof(*iov));
+        g_free(iov);
         return -EFAULT;
     }
 
@@ -64,11 +68,13 @@ static int _syscallhandler_validateVecParams(SysCallHandler* sys, int fd,
 
         if (!bufPtr.val) {
             debug("Invalid NULL pointer in iovec[%ld]", i);
+            g_free(iov);
             return -EFAULT;
         }
 
         if (!bufSize) {
             debug("Invalid size 0 in iovec[%ld]", i);
+            g_free(iov);
             return -EINVAL;
         }
     }
@@ -78,6 +84,8 @@ static int _syscallhandler_validateVecParams(SysCallHandler* sys, int fd,
     }
     if (iov_out) {
         *iov_out = iov;
+    } else {
+        g_free(iov);
     }
     return 0;
 }
@@ -94,7 +102,7 @@ _syscallhandler_readvHelper(SysCallHandler* sys, int fd, PluginPtr iovPtr,
           fd, (void*)iovPtr.val, iovlen, pos_l, pos_h, offset, flags);
 
     LegacyDescriptor* desc = NULL;
-    const struct iovec* iov;
+    struct iovec* iov = NULL;
     int errcode = _syscallhandler_validateVecParams(
         sys, fd, iovPtr, iovlen, offset, &desc, &iov);
     if (errcode < 0 || iovlen == 0) {
@@ -104,6 +112,15 @@ _syscallhandler_readvHelper(SysCallHandler* sys, int fd, PluginPtr iovPtr,
     /* Some logic depends on the descriptor type. */
     LegacyDescriptorType dType = descriptor_getType(desc);
 
+    if (dType == DT_TCPSOCKET || dType == DT_UDPSOCKET) {
+        /* Receive once for all of the buffers, and scatter the data into them
+         * with a single copy. The helper handles blocking. */
+        SysCallReturn scr =
+            _syscallhandler_recvvHelper(sys, fd, iov, iovlen, 0, (PluginPtr){0}, (PluginPtr){0});
+        g_free(iov);
+        return scr;
+    }
+
     ssize_t result = 0;
 
     /* Now we can perform the write operations. */
@@ -152,10 +169,8 @@ _syscallhandler_readvHelper(SysCallHandler* sys, int fd, PluginPtr iovPtr,
                 }
                 case DT_TCPSOCKET:
                 case DT_UDPSOCKET: {
-                    SysCallReturn scr = _syscallhandler_recvfromHelper(
-                        sys, fd, bufPtr, bufSize, 0, (PluginPtr){0},
-                        (PluginPtr){0});
-                    result = scr.retval.as_i64;
+                    /* Handled above. */
+                    utility_assert(0);
                     break;
                 }
                 case DT_TIMER:
@@ -184,6 +199,7 @@ _syscallhandler_readvHelper(SysCallHandler* sys, int fd, PluginPtr iovPtr,
     if (result == -EWOULDBLOCK && !(descriptor_getFlags(desc) & O_NONBLOCK)) {
         /* Blocking for file io will lock up the plugin because we don't
          * yet have a way to wait on file descriptors. */
+        g_free(iov);
         if (dType == DT_FILE) {
             error("Indefinitely blocking a readv of vector length %lu on "
                   "file %i at offset %li",
@@ -196,6 +212,7 @@ _syscallhandler_readvHelper(SysCallHandler* sys, int fd, PluginPtr iovPtr,
         return (SysCallReturn){.state = SYSCALL_BLOCK, .cond = syscallcondition_new(trigger, NULL)};
     }
 
+    g_free(iov);
     return (SysCallReturn){.state = SYSCALL_DONE, .retval.as_i64 = result};
 }
 
@@ -211,7 +228,7 @@ _syscallhandler_writevHelper(SysCallHandler* sys, int fd, PluginPtr iovPtr,
           fd, (void*)iovPtr.val, iovlen, pos_l, pos_h, offset, flags);
 
     LegacyDescriptor* desc = NULL;
-    const struct iovec* iov;
+    struct iovec* iov = NULL;
     int errcode = _syscallhandler_validateVecParams(
         sys, fd, iovPtr, iovlen, offset, &desc, &iov);
     if (errcode < 0 || iovlen == 0) {
@@ -221,6 +238,15 @@ _syscallhandler_writevHelper(SysCallHandler* sys, int fd, PluginPtr iovPtr,
     /* Some logic depends on the descriptor type. */
     LegacyDescriptorType dType = descriptor_getType(desc);
 
+    if (dType == DT_TCPSOCKET || dType == DT_UDPSOCKET) {
+        /* Gather all of the buffers into a single send, so that TCP segments
+         * them at the MSS rather than sending at least one packet per buffer,
+         * and UDP sends one datagram. The helper handles blocking. */
+        SysCallReturn scr = _syscallhandler_sendvHelper(sys, fd, iov, iovlen, 0, (PluginPtr){0}, 0);
+        g_free(iov);
+        return scr;
+    }
+
     ssize_t result = 0;
 
     /* Now we can perform the write operations. */
@@ -269,9 +295,8 @@ _syscallhandler_writevHelper(SysCallHandler* sys, int fd, PluginPtr iovPtr,
                 }
                 case DT_TCPSOCKET:
                 case DT_UDPSOCKET: {
-                    SysCallReturn scr = _syscallhandler_sendtoHelper(
-                        sys, fd, bufPtr, bufSize, 0, (PluginPtr){0}, 0);
-                    result = scr.retval.as_i64;
+                    /* Handled above. */
+                    utility_assert(0);
                     break;
                 }
                 case DT_TIMER:
@@ -300,6 +325,7 @@ _syscallhandler_writevHelper(SysCallHandler* sys, int fd, PluginPtr iovPtr,
     if (result == -EWOULDBLOCK && !(descriptor_getFlags(desc) & O_NONBLOCK)) {
         /* Blocking for file io will lock up the plugin because we don't
          * yet have a way to wait on file descriptors. */
+        g_free(iov);
         if (dType == DT_FILE) {
             error("Indefinitely blocking a writev of vector length %lu on "
                   "file %i at offset %li",
@@ -312,6 +338,7 @@ _syscallhandler_writevHelper(SysCallHandler* sys, int fd, PluginPtr iovPtr,
         return (SysCallReturn){.state = SYSCALL_BLOCK, .cond = syscallcondition_new(trigger, NULL)};
     }
 
+    g_free(iov);
     return (SysCallReturn){.state = SYSCALL_DONE, .retval.as_i64 = result};
 }
 
@@ -6,7 +6,9 @@
 #include "main/host/syscall/unistd.h"
 
 #include <errno.h>
+#include <fcntl.h>
 #include <stdio.h>
+#include <sys/syscall.h>
 #include <sys/utsname.h>
 
 #include "lib/logger/logger.h"
@@ -18,6 +20,8 @@
 #include "main/host/descriptor/timer.h"
 #include "main/host/host.h"
 #include "main/host/process.h"
+#include "main/host/syscall/file.h"
+#include "main/host/syscall/mman.h"
 #include "main/host/syscall/protected.h"
 #include "main/host/syscall/socket.h"
 #include "main/host/syscall_condition.h"
@@ -290,6 +294,10 @@ SysCallReturn syscallhandler_close(SysCallHandler* sys,
 
     if (descriptor && !errorCode) {
         trace("Closing descriptor %i", descriptor_getHandle(descriptor));
+        if (descriptor_getType(descriptor) == DT_FILE &&
+            file_isPluginNative((File*)descriptor)) {
+            _syscallhandler_closePluginFile(sys, fd);
+        }
         descriptor_close(descriptor, sys->host);
         return (SysCallReturn){.state = SYSCALL_DONE};
     }
@@ -324,6 +332,19 @@ SysCallReturn syscallhandler_dup(SysCallHandler* sys,
     }
 
     int handle = process_registerLegacyDescriptor(sys->process, (LegacyDescriptor*)newFile);
+
+    if (file_isPluginNative((File*)desc)) {
+        /* Keep the new handle native too, sharing the plugin's file offset. */
+        int pluginFD = thread_nativeSyscall(sys->thread, SYS_fcntl, fd, F_DUPFD, 0);
+        if (pluginFD >= 0 && _syscallhandler_movePluginFD(sys, pluginFD, handle, false)) {
+            file_setPluginNative(newFile, true);
+        } else {
+            warning("Could not dup native file %i in the plugin", fd);
+            descriptor_close((LegacyDescriptor*)newFile, sys->host);
+            return (SysCallReturn){.state = SYSCALL_DONE, .retval.as_i64 = -EMFILE};
+        }
+    }
+
     return (SysCallReturn){.state = SYSCALL_DONE, .retval.as_i64 = handle};
 }
 
@@ -19,6 +19,8 @@
 #include "main/core/support/config_handlers.h"
 #include "main/core/worker.h"
 #include "main/host/descriptor/descriptor.h"
+#include "main/host/descriptor/epoll.h"
+#include "main/host/descriptor/file.h"
 #include "main/host/descriptor/timer.h"
 #include "main/host/host.h"
 #include "main/host/process.h"
@@ -35,6 +37,7 @@
 #include "main/host/syscall/process.h"
 #include "main/host/syscall/protected.h"
 #include "main/host/syscall/random.h"
+#include "main/host/syscall/sendfile.h"
 #include "main/host/syscall/shadow.h"
 #include "main/host/syscall/signal.h"
 #include "main/host/syscall/socket.h"
@@ -52,6 +55,12 @@
 static bool _useMM = true;
 ADD_CONFIG_HANDLER(config_getUseMemoryManager, _useMM)
 
+static guint _mmRemapThreshold = 0;
+ADD_CONFIG_HANDLER(config_getMemoryManagerRemapThreshold, _mmRemapThreshold)
+
+static bool _mmUseHugePages = false;
+ADD_CONFIG_HANDLER(config_getUseShmemHugePages, _mmUseHugePages)
+
 static bool _countSyscalls = false;
 ADD_CONFIG_HANDLER(config_getUseSyscallCounters, _countSyscalls)
 
@@ -100,6 +109,12 @@ SysCallHandler* syscallhandler_new(Host* host, Process* process,
 static void _syscallhandler_free(SysCallHandler* sys) {
     MAGIC_ASSERT(sys);
 
+    if (sys->epoll) {
+        // Our epoll may still be watching descriptors from the last poll call,
+        // and they must not notify it after it's freed.
+        epoll_reset(sys->epoll);
+    }
+
 #ifdef USE_PERF_TIMERS
     info("handled %li syscalls in %f seconds", sys->numSyscalls, sys->perfSecondsTotal);
 #else
@@ -244,6 +259,57 @@ static void _syscallhandler_post_syscall(SysCallHandler* sys, long number,
         break
 #endif
 
+/* Returns true if the syscall operates only on the file in its first argument,
+ * and that file is open natively in the plugin, so the syscall can be run
+ * natively without involving the emulated descriptor. */
+static bool _syscallhandler_isPluginNativeFileSyscall(SysCallHandler* sys,
+                                                      const SysCallArgs* args) {
+    switch (args->number) {
+        case SYS_read:
+        case SYS_write:
+        case SYS_pread64:
+        case SYS_pwrite64:
+        case SYS_readv:
+        case SYS_writev:
+        case SYS_preadv:
+        case SYS_pwritev:
+#ifdef SYS_preadv2
+        case SYS_preadv2:
+#endif
+#ifdef SYS_pwritev2
+        case SYS_pwritev2:
+#endif
+        case SYS_lseek:
+        case SYS_fstat:
+        case SYS_fstatfs:
+        case SYS_fsync:
+        case SYS_fdatasync:
+        case SYS_ftruncate:
+        case SYS_fallocate:
+        case SYS_fadvise64:
+        case SYS_flock:
+        case SYS_fchmod:
+        case SYS_fchown:
+        case SYS_getdents:
+        case SYS_getdents64:
+        case SYS_sync_file_range:
+        case SYS_readahead:
+        case SYS_fgetxattr:
+        case SYS_fsetxattr:
+        case SYS_flistxattr:
+        case SYS_fremovexattr: break;
+        default: return false;
+    }
+
+    int fd = args->args[0].as_i64;
+    if (fd < 0) {
+        return false;
+    }
+
+    LegacyDescriptor* desc = process_getRegisteredLegacyDescriptor(sys->process, fd);
+    return desc && descriptor_getType(desc) == DT_FILE && file_isPluginNative((File*)desc);
+}
+
 SysCallReturn syscallhandler_make_syscall(SysCallHandler* sys,
                                           const SysCallArgs* args) {
     MAGIC_ASSERT(sys);
@@ -254,7 +320,11 @@ SysCallReturn syscallhandler_make_syscall(SysCallHandler* sys,
     // here because the MemoryManager needs a plugin thread that's ready to
     // make syscalls in order to perform its initialization.
     if (_useMM) {
-        memorymanager_initMapperIfNeeded(process_getMemoryManager(sys->process), sys->thread);
+        MemoryManager* mm = process_getMemoryManager(sys->process);
+        memorymanager_initMapperIfNeeded(mm, sys->thread, _mmRemapThreshold, _mmUseHugePages);
+        // Move any regions that the previous syscalls missed on often into the
+        // mapper's shared memory, now that we have a thread to do it with.
+        memorymanager_remapHotRegions(mm, sys->thread);
     }
     SysCallReturn scr;
 
@@ -267,6 +337,12 @@ SysCallReturn syscallhandler_make_syscall(SysCallHandler* sys,
                       sys->blockedSyscallNR, args->number);
     }
 
+    if (_syscallhandler_isPluginNativeFileSyscall(sys, args)) {
+        trace("native syscall %ld on plugin-native file %i", args->number,
+              (int)args->args[0].as_i64);
+        return (SysCallReturn){.state = SYSCALL_NATIVE};
+    }
+
     switch (args->number) {
         HANDLE(accept);
         HANDLE(accept4);
@@ -276,6 +352,9 @@ SysCallReturn syscallhandler_make_syscall(SysCallHandler* sys,
         HANDLE(clone);
         HANDLE_RUST(close);
         HANDLE(connect);
+#ifdef SYS_copy_file_range
+        HANDLE(copy_file_range);
+#endif
         HANDLE(creat);
         HANDLE_RUST(dup);
         HANDLE(epoll_create);
@@ -364,12 +443,17 @@ SysCallReturn syscallhandler_make_syscall(SysCallHandler* sys,
         HANDLE(readlinkat);
         HANDLE(readv);
         HANDLE(recvfrom);
+        HANDLE(recvmmsg);
+        HANDLE(recvmsg);
         HANDLE(renameat);
         HANDLE(renameat2);
         HANDLE(shadow_set_ptrace_allow_native_syscalls);
         HANDLE(shadow_get_ipc_blk);
         HANDLE(shadow_get_shm_blk);
         HANDLE(shadow_hostname_to_addr_ipv4);
+        HANDLE(sendfile);
+        HANDLE(sendmmsg);
+        HANDLE(sendmsg);
         HANDLE(sendto);
         HANDLE(setsockopt);
 #ifdef SYS_sigaction
@@ -430,18 +514,10 @@ SysCallReturn syscallhandler_make_syscall(SysCallHandler* sys,
         // NATIVE(pselect6);
 
         //// copying data between various types of fds
-        // NATIVE(copy_file_range);
-        // NATIVE(sendfile);
         // NATIVE(splice);
         // NATIVE(vmsplice);
         // NATIVE(tee);
 
-        //// additional socket io
-        // NATIVE(recvmsg);
-        // NATIVE(sendmsg);
-        // NATIVE(recvmmsg);
-        // NATIVE(sendmmsg);
-
         // ***************************************
         // We think we don't need to handle these
         // (because the plugin can natively):
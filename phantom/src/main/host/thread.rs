@@ -87,6 +87,19 @@ pub trait Thread {
         Ok(())
     }
 
+    /// Natively execute madvise(2) on the given thread.
+    fn native_madvise(&mut self, addr: PluginPtr, len: usize, advice: i32) -> nix::Result<()> {
+        self.native_syscall(
+            libc::SYS_madvise,
+            &[
+                SysCallReg::from(addr),
+                SysCallReg::from(len),
+                SysCallReg::from(advice),
+            ],
+        )?;
+        Ok(())
+    }
+
     /// Natively execute open(2) on the given thread.
     fn native_open(&mut self, pathname: PluginPtr, flags: i32, mode: i32) -> nix::Result<i32> {
         let res = self.native_syscall(
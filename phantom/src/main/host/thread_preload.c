@@ -16,13 +16,21 @@
 #include "lib/logger/logger.h"
 #include "lib/shim/ipc.h"
 #include "lib/shim/shim_event.h"
+#include "main/bindings/c/bindings.h"
+#include "main/core/support/config_handlers.h"
 #include "main/core/worker.h"
 #include "main/host/shimipc.h"
 #include "main/host/thread_protected.h"
+#include "main/host/zygote.h"
 #include "main/shmem/shmem_allocator.h"
 
 #define THREADPRELOAD_TYPE_ID 13357
 
+// Start processes by forking them from a zygote per binary rather than
+// executing each one from scratch.
+static bool _useZygote = false;
+ADD_CONFIG_HANDLER(config_getUseZygote, _useZygote)
+
 struct _ThreadPreload {
     Thread base;
 
@@ -167,6 +175,12 @@ pid_t threadpreload_run(Thread* base, gchar** argv, gchar** envv, const char* wo
     /* Tell the shim in the managed process whether to enable seccomp */
     if (shimipc_getUseSeccomp()) {
         myenvv = g_environ_setenv(myenvv, "SHADOW_USE_SECCOMP", "", TRUE);
+        if (shimipc_getUseSyscallRewriting()) {
+            myenvv = g_environ_setenv(myenvv, "SHADOW_REWRITE_SYSCALLS", "", TRUE);
+        }
+    }
+    if (shimipc_getUseRdtscRewriting()) {
+        myenvv = g_environ_setenv(myenvv, "SHADOW_REWRITE_RDTSC", "", TRUE);
     }
 
     // set shadow's PID in the env so the child can run get_ppid
@@ -179,7 +193,13 @@ pid_t threadpreload_run(Thread* base, gchar** argv, gchar** envv, const char* wo
     g_free(envStr);
     g_free(argStr);
 
-    pid_t child_pid = _threadpreload_fork_exec(thread, argv[0], argv, myenvv, workingDir);
+    pid_t child_pid = -1;
+    if (_useZygote) {
+        child_pid = zygote_forkExec(argv[0], argv, myenvv, workingDir);
+    }
+    if (child_pid < 0) {
+        child_pid = _threadpreload_fork_exec(thread, argv[0], argv, myenvv, workingDir);
+    }
     childpidwatcher_watch(
         worker_getChildPidWatcher(), child_pid, _markPluginExited, thread->ipc_data);
 
@@ -250,7 +250,6 @@ static ShimSharedMem* _threadptrace_sharedMem(ThreadPtrace* thread) {
 static void _threadptrace_ensureStopped(ThreadPtrace* thread);
 static void _threadptrace_doAttach(ThreadPtrace* thread);
 static void _threadptrace_doDetach(ThreadPtrace* thread);
-static Thread* _threadptrace_new(Host* host, Process* process, int threadID);
 
 static ThreadPtrace* _threadToThreadPtrace(Thread* thread) {
     utility_assert(thread->type_id == THREADPTRACE_TYPE_ID);
@@ -400,9 +399,27 @@ static void _threadptrace_enterStateTraceMe(ThreadPtrace* thread) {
     }
 }
 
+// The shim waits for this event before making syscalls over the IPC channel.
+static void _threadptrace_sendStartEvent(ThreadPtrace* thread) {
+    ShimEvent startEvent = {
+        .event_id = SHD_SHIM_EVENT_START,
+        .event_data.start =
+            {
+                .simulation_nanos = worker_getEmulatedTime(),
+            },
+    };
+    shimevent_sendEventToPlugin(_threadptrace_ipcData(thread), &startEvent);
+}
+
 static void _threadptrace_enterStateExecve(ThreadPtrace* thread) {
     // Previous cached address is no longer valid.
     thread->syscall_rip = 0;
+
+    if (thread->enableIpc) {
+        // The shim in the new image starts over, and waits for a new start
+        // event before using the IPC channel.
+        _threadptrace_sendStartEvent(thread);
+    }
 }
 
 static void _threadptrace_getregs(ThreadPtrace* thread) {
@@ -749,13 +766,7 @@ pid_t threadptrace_run(Thread* base, gchar** argv, gchar** envv, const char* wor
     thread->base.nativePid = thread->base.nativeTid;
 
     if (thread->enableIpc) {
-        // Send 'start' event.
-        ShimEvent startEvent = {
-            .event_id = SHD_SHIM_EVENT_START,
-            .event_data.start = {
-                .simulation_nanos = worker_getEmulatedTime(),
-            }};
-        shimevent_sendEventToPlugin(_threadptrace_ipcData(thread), &startEvent);
+        _threadptrace_sendStartEvent(thread);
     }
 
     return thread->base.nativePid;
@@ -1304,7 +1315,7 @@ int threadptrace_clone(Thread* base, unsigned long flags, PluginPtr child_stack,
 
     *childp =
         thread->enableIpc
-            ? _threadptrace_new(base->host, base->process, host_getNewProcessID(base->host))
+            ? threadptrace_new(base->host, base->process, host_getNewProcessID(base->host))
             : threadptraceonly_new(base->host, base->process, host_getNewProcessID(base->host));
 
     ThreadPtrace* child = _threadToThreadPtrace(*childp);
@@ -1326,21 +1337,14 @@ int threadptrace_clone(Thread* base, unsigned long flags, PluginPtr child_stack,
     child->childState = THREAD_PTRACE_CHILD_STATE_TRACE_ME;
     _threadptrace_enterStateTraceMe(child);
 
-    if (thread->enableIpc) {
-        // Send 'start' event.
-        ShimEvent startEvent = {
-            .event_id = SHD_SHIM_EVENT_START,
-            .event_data.start = {
-                .simulation_nanos = worker_getEmulatedTime(),
-            }};
-        shimevent_sendEventToPlugin(_threadptrace_ipcData(child), &startEvent);
+    if (child->enableIpc) {
+        _threadptrace_sendStartEvent(child);
     }
 
     return childNativeTid;
 }
 
-// Legacy entry point for "hybrid mode".
-static Thread* _threadptrace_new(Host* host, Process* process, int threadID) {
+Thread* threadptrace_new(Host* host, Process* process, int threadID) {
     ThreadPtrace* thread = (ThreadPtrace*)threadptraceonly_new(host, process, threadID);
 
     thread->ipcBlk = shmemallocator_globalAlloc(ipcData_nbytes());
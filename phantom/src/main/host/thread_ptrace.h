@@ -8,6 +8,10 @@
 // Create a thread managed via ptrace only.
 Thread* threadptraceonly_new(Host* host, Process* process, gint threadID);
 
+// Create a thread managed via ptrace that services syscalls made through the
+// shim over the IPC channel, falling back to ptrace for any others.
+Thread* threadptrace_new(Host* host, Process* process, gint threadID);
+
 void threadptrace_detach(Thread* base);
 
 // Set whether or not ptrace will allow the shim to perform native syscalls.
@@ -8,19 +8,28 @@
  * each packet is either a 'normal' packet or a 'retransmitted' packet. */
 #include <glib.h>
 #include <netinet/in.h>
+#include <stdbool.h>
 #include <string.h>
 
 #include "lib/logger/log_level.h"
 #include "lib/logger/logger.h"
+#include "main/bindings/c/bindings.h"
+#include "main/core/support/config_handlers.h"
 #include "main/core/support/definitions.h"
 #include "main/core/work/task.h"
 #include "main/core/worker.h"
+#include "main/host/host.h"
 #include "main/host/protocol.h"
 #include "main/host/tracker.h"
+#include "main/host/tracker_output.h"
 #include "main/routing/address.h"
 #include "main/routing/packet.h"
 #include "main/utility/utility.h"
 
+// Write heartbeats to the worker's binary output instead of logging them.
+static bool _useBinaryHeartbeats = false;
+ADD_CONFIG_HANDLER(config_getUseBinaryHeartbeats, _useBinaryHeartbeats)
+
 typedef struct {
     gsize control;
     gsize controlRetransmit;
@@ -415,6 +424,60 @@ static gchar* _tracker_getCounterString(Counters* c) {
     return g_string_free(buffer, FALSE);
 }
 
+/* fill the columns of `c` in the order of _tracker_getCounterHeaderString */
+static TrackerValue* _tracker_fillCounterValues(TrackerValue* dst, Counters* c) {
+    utility_assert(c);
+
+    gsize totalPackets = c->packets.control + c->packets.controlRetransmit +
+            c->packets.data + c->packets.dataRetransmit;
+
+    (dst++)->u = totalPackets;
+    (dst++)->u = _tracker_sumBytes(&c->bytes);
+    (dst++)->u = c->packets.control;
+    (dst++)->u = c->bytes.controlHeader;
+    (dst++)->u = c->packets.controlRetransmit;
+    (dst++)->u = c->bytes.controlHeaderRetransmit;
+    (dst++)->u = c->packets.data;
+    (dst++)->u = c->bytes.dataHeader;
+    (dst++)->u = c->bytes.dataPayload;
+    (dst++)->u = c->packets.dataRetransmit;
+    (dst++)->u = c->bytes.dataHeaderRetransmit;
+    (dst++)->u = c->bytes.dataPayloadRetransmit;
+    return dst;
+}
+
+/* fill the counter columns of a node or socket row */
+static void _tracker_fillIFaceValues(TrackerValue* dst, IFaceCounters* local,
+                                     IFaceCounters* remote) {
+    dst = _tracker_fillCounterValues(dst, &local->inCounters);
+    dst = _tracker_fillCounterValues(dst, &local->outCounters);
+    dst = _tracker_fillCounterValues(dst, &remote->inCounters);
+    _tracker_fillCounterValues(dst, &remote->outCounters);
+}
+
+static void _tracker_writeNode(Tracker* tracker, Host* host, SimulationTime interval) {
+    TrackerOutput* output = trackeroutput_getForThisThread();
+    gdouble avgdelayms = 0.0;
+
+    if(tracker->numDelayedLastInterval > 0) {
+        gdouble delayms = (gdouble) (((gdouble)tracker->delayTimeLastInterval) / ((gdouble)SIMTIME_ONE_MILLISECOND));
+        avgdelayms = (gdouble) (delayms / ((gdouble) tracker->numDelayedLastInterval));
+    }
+
+    TrackerValue row[TRACKER_NODE_NCOLUMNS];
+    row[0].u = worker_getCurrentTime();
+    row[1].u = trackeroutput_internString(output, host_getName(host));
+    row[2].u = interval / SIMTIME_ONE_SECOND;
+    row[3].u = _tracker_sumBytes(&tracker->remote.inCounters.bytes);
+    row[4].u = _tracker_sumBytes(&tracker->remote.outCounters.bytes);
+    row[5].f = ((gdouble)tracker->processingTimeLastInterval) / ((gdouble)interval);
+    row[6].u = tracker->numDelayedLastInterval;
+    row[7].f = avgdelayms;
+    _tracker_fillIFaceValues(&row[8], &tracker->local, &tracker->remote);
+
+    trackeroutput_appendRow(output, TRACKER_TABLE_NODE, row);
+}
+
 static void _tracker_logNode(Tracker* tracker, LogLevel level, SimulationTime interval) {
     guint seconds = (guint) (interval / SIMTIME_ONE_SECOND);
     gdouble cpuutil = (gdouble)(((gdouble)tracker->processingTimeLastInterval) / ((gdouble)interval));
@@ -463,8 +526,10 @@ static void _tracker_logNode(Tracker* tracker, LogLevel level, SimulationTime in
     g_string_free(buffer, TRUE);
 }
 
-static void _tracker_logSocket(Tracker* tracker, LogLevel level, SimulationTime interval) {
-    if(!tracker->didLogSocketHeader) {
+static void _tracker_logSocket(Tracker* tracker, Host* host, LogLevel level, SimulationTime interval) {
+    TrackerOutput* output = _useBinaryHeartbeats ? trackeroutput_getForThisThread() : NULL;
+
+    if(!output && !tracker->didLogSocketHeader) {
         tracker->didLogSocketHeader = TRUE;
         logger_log(logger_getDefault(), level, __FILE__, __FUNCTION__, __LINE__,
                 "[shadow-heartbeat] [socket-header] descriptor-number,protocol-string,hostname:port-peer;"
@@ -497,6 +562,33 @@ static void _tracker_logSocket(Tracker* tracker, LogLevel level, SimulationTime
         gsize totalSendBytes = _tracker_sumBytes(&ss->local.outCounters.bytes) +
                 _tracker_sumBytes(&ss->remote.outCounters.bytes);
 
+        const gchar* protocol = ss->type == PTCP ? "TCP" : ss->type == PUDP ? "UDP" :
+                    ss->type == PLOCAL ? "LOCAL" : "UNKNOWN";
+
+        /* check if we should remove the socket after iterating */
+        if(ss->removeAfterNextLog) {
+            g_queue_push_tail(handlesToRemove, GINT_TO_POINTER(ss->handle));
+        }
+
+        if(output) {
+            TrackerValue row[TRACKER_SOCKET_NCOLUMNS];
+            row[0].u = worker_getCurrentTime();
+            row[1].u = trackeroutput_internString(output, host_getName(host));
+            row[2].u = ss->handle;
+            row[3].u = trackeroutput_internString(output, protocol);
+            row[4].u = trackeroutput_internString(output, ss->peerHostname);
+            row[5].u = ss->peerPort;
+            row[6].u = ss->inputBufferLength;
+            row[7].u = ss->inputBufferSize;
+            row[8].u = ss->outputBufferLength;
+            row[9].u = ss->outputBufferSize;
+            row[10].u = totalRecvBytes;
+            row[11].u = totalSendBytes;
+            _tracker_fillIFaceValues(&row[12], &ss->local, &ss->remote);
+            trackeroutput_appendRow(output, TRACKER_TABLE_SOCKET, row);
+            continue;
+        }
+
         gchar* inLocal = _tracker_getCounterString(&ss->local.inCounters);
         gchar* outLocal = _tracker_getCounterString(&ss->local.outCounters);
         gchar* inRemote = _tracker_getCounterString(&ss->remote.inCounters);
@@ -513,9 +605,7 @@ static void _tracker_logSocket(Tracker* tracker, LogLevel level, SimulationTime
                 "%"G_GSIZE_FORMAT",%"G_GSIZE_FORMAT";"
                 "%s;%s;%s;%s",
                 ss->handle, /*inet_ntoa((struct in_addr){socket->peerIP})*/
-                ss->type == PTCP ? "TCP" : ss->type == PUDP ? "UDP" :
-                    ss->type == PLOCAL ? "LOCAL" : "UNKNOWN",
-                ss->peerHostname, ss->peerPort,
+                protocol, ss->peerHostname, ss->peerPort,
                 ss->inputBufferLength, ss->inputBufferSize,
                 ss->outputBufferLength, ss->outputBufferSize,
                 totalRecvBytes, totalSendBytes,
@@ -525,11 +615,6 @@ static void _tracker_logSocket(Tracker* tracker, LogLevel level, SimulationTime
         g_free(outLocal);
         g_free(inRemote);
         g_free(outRemote);
-
-        /* check if we should remove the socket after iterating */
-        if(ss->removeAfterNextLog) {
-            g_queue_push_tail(handlesToRemove, GINT_TO_POINTER(ss->handle));
-        }
     }
 
     if(socketLogCount > 0) {
@@ -546,6 +631,22 @@ static void _tracker_logSocket(Tracker* tracker, LogLevel level, SimulationTime
     g_string_free(msg, TRUE);
 }
 
+static void _tracker_writeRAM(Tracker* tracker, Host* host, SimulationTime interval) {
+    TrackerOutput* output = trackeroutput_getForThisThread();
+
+    TrackerValue row[TRACKER_RAM_NCOLUMNS];
+    row[0].u = worker_getCurrentTime();
+    row[1].u = trackeroutput_internString(output, host_getName(host));
+    row[2].u = interval / SIMTIME_ONE_SECOND;
+    row[3].u = tracker->allocatedBytesLastInterval;
+    row[4].u = tracker->deallocatedBytesLastInterval;
+    row[5].u = tracker->allocatedBytesTotal;
+    row[6].u = g_hash_table_size(tracker->allocatedLocations);
+    row[7].u = tracker->numFailedFrees;
+
+    trackeroutput_appendRow(output, TRACKER_TABLE_RAM, row);
+}
+
 static void _tracker_logRAM(Tracker* tracker, LogLevel level, SimulationTime interval) {
     guint seconds = (guint) (interval / SIMTIME_ONE_SECOND);
     guint numptrs = g_hash_table_size(tracker->allocatedLocations);
@@ -567,17 +668,25 @@ void tracker_heartbeat(Tracker* tracker, Host* host) {
 
     /* check to see if node info is being logged */
     if(tracker->loginfo & LOG_INFO_FLAGS_NODE) {
-        _tracker_logNode(tracker, tracker->loglevel, tracker->interval);
+        if(_useBinaryHeartbeats) {
+            _tracker_writeNode(tracker, host, tracker->interval);
+        } else {
+            _tracker_logNode(tracker, tracker->loglevel, tracker->interval);
+        }
     }
 
     /* check to see if socket buffer info is being logged */
     if(tracker->loginfo & LOG_INFO_FLAGS_SOCKET) {
-        _tracker_logSocket(tracker, tracker->loglevel, tracker->interval);
+        _tracker_logSocket(tracker, host, tracker->loglevel, tracker->interval);
     }
 
     /* check to see if ram info is being logged */
     if(tracker->loginfo & LOG_INFO_FLAGS_RAM) {
-        _tracker_logRAM(tracker, tracker->loglevel, tracker->interval);
+        if(_useBinaryHeartbeats) {
+            _tracker_writeRAM(tracker, host, tracker->interval);
+        } else {
+            _tracker_logRAM(tracker, tracker->loglevel, tracker->interval);
+        }
     }
 
     /* clear interval stats */
@@ -0,0 +1,313 @@
+/*
+ * The Shadow Simulator
+ * See LICENSE for licensing information
+ */
+
+#include "main/host/tracker_output.h"
+
+#include <errno.h>
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "lib/logger/logger.h"
+#include "main/bindings/c/bindings.h"
+#include "main/core/support/definitions.h"
+#include "main/core/worker.h"
+#include "main/utility/utility.h"
+
+// Shadow only runs on little-endian platforms, so values are written in native
+// byte order.
+
+// Rows of each table are buffered and written in blocks of this many rows.
+#define TRACKER_OUTPUT_BLOCK_NROWS 1024
+
+typedef struct _TrackerColumn TrackerColumn;
+struct _TrackerColumn {
+    char type;
+    const gchar* name;
+};
+
+static const TrackerColumn _node_columns[] = {
+    {'u', "time-nanos"},
+    {'s', "host"},
+    {'u', "interval-seconds"},
+    {'u', "recv-bytes"},
+    {'u', "send-bytes"},
+    {'f', "cpu-percent"},
+    {'u', "delayed-count"},
+    {'f', "avgdelay-milliseconds"},
+};
+
+static const TrackerColumn _socket_columns[] = {
+    {'u', "time-nanos"},
+    {'s', "host"},
+    {'u', "descriptor-number"},
+    {'s', "protocol-string"},
+    {'s', "hostname-peer"},
+    {'u', "port-peer"},
+    {'u', "inbuflen-bytes"},
+    {'u', "inbufsize-bytes"},
+    {'u', "outbuflen-bytes"},
+    {'u', "outbufsize-bytes"},
+    {'u', "recv-bytes"},
+    {'u', "send-bytes"},
+};
+
+static const TrackerColumn _ram_columns[] = {
+    {'u', "time-nanos"},
+    {'s', "host"},
+    {'u', "interval-seconds"},
+    {'u', "alloc-bytes"},
+    {'u', "dealloc-bytes"},
+    {'u', "total-bytes"},
+    {'u', "pointers-count"},
+    {'u', "failfree-count"},
+};
+
+// The node and socket tables end with a set of these for each of the inbound
+// and outbound localhost and remote counters, like the heartbeat messages.
+static const gchar* _counter_directions[] = {
+    "inbound-localhost", "outbound-localhost", "inbound-remote", "outbound-remote"};
+static const gchar* _counter_columns[] = {
+    "packets-total",
+    "bytes-total",
+    "packets-control",
+    "bytes-control-header",
+    "packets-control-retrans",
+    "bytes-control-header-retrans",
+    "packets-data",
+    "bytes-data-header",
+    "bytes-data-payload",
+    "packets-data-retrans",
+    "bytes-data-header-retrans",
+    "bytes-data-payload-retrans",
+};
+
+typedef struct _TrackerTableSchema TrackerTableSchema;
+struct _TrackerTableSchema {
+    const gchar* name;
+    const TrackerColumn* columns;
+    guint nColumns;
+    gboolean hasCounters;
+};
+
+static const TrackerTableSchema _schemas[TRACKER_TABLE_COUNT] = {
+    [TRACKER_TABLE_NODE] = {"node", _node_columns, G_N_ELEMENTS(_node_columns), TRUE},
+    [TRACKER_TABLE_SOCKET] = {"socket", _socket_columns, G_N_ELEMENTS(_socket_columns), TRUE},
+    [TRACKER_TABLE_RAM] = {"ram", _ram_columns, G_N_ELEMENTS(_ram_columns), FALSE},
+};
+
+G_STATIC_ASSERT(G_N_ELEMENTS(_node_columns) +
+                    G_N_ELEMENTS(_counter_directions) * G_N_ELEMENTS(_counter_columns) ==
+                TRACKER_NODE_NCOLUMNS);
+G_STATIC_ASSERT(G_N_ELEMENTS(_socket_columns) +
+                    G_N_ELEMENTS(_counter_directions) * G_N_ELEMENTS(_counter_columns) ==
+                TRACKER_SOCKET_NCOLUMNS);
+G_STATIC_ASSERT(G_N_ELEMENTS(_ram_columns) == TRACKER_RAM_NCOLUMNS);
+
+typedef struct _TrackerTableBuffer TrackerTableBuffer;
+struct _TrackerTableBuffer {
+    guint nColumns;
+    // Row-major; transposed when written.
+    TrackerValue* rows;
+    guint nRows;
+    gboolean wroteSchema;
+};
+
+struct _TrackerOutput {
+    gchar* path;
+    FILE* file;
+    // String -> id, starting at 1.
+    GHashTable* stringIDs;
+    TrackerTableBuffer tables[TRACKER_TABLE_COUNT];
+    // Scratch space for one column of a block.
+    TrackerValue column[TRACKER_OUTPUT_BLOCK_NROWS];
+    MAGIC_DECLARE;
+};
+
+static __thread TrackerOutput* _thread_output = NULL;
+
+static guint _trackeroutput_nColumns(TrackerTable table) {
+    const TrackerTableSchema* schema = &_schemas[table];
+    guint nColumns = schema->nColumns;
+    if (schema->hasCounters) {
+        nColumns += G_N_ELEMENTS(_counter_directions) * G_N_ELEMENTS(_counter_columns);
+    }
+    return nColumns;
+}
+
+static void _trackeroutput_write(TrackerOutput* output, const void* buf, gsize len) {
+    if (len > 0 && fwrite(buf, len, 1, output->file) != 1) {
+        utility_panic("writing heartbeats to %s: %s", output->path, g_strerror(errno));
+    }
+}
+
+static void _trackeroutput_writeBlockHeader(TrackerOutput* output, guint8 type, guint32 len) {
+    _trackeroutput_write(output, &type, sizeof(type));
+    _trackeroutput_write(output, &len, sizeof(len));
+}
+
+static void _trackeroutput_appendName(GByteArray* buf, const gchar* name) {
+    guint8 len = strlen(name);
+    g_byte_array_append(buf, &len, sizeof(len));
+    g_byte_array_append(buf, (const guint8*)name, len);
+}
+
+static void _trackeroutput_appendColumn(GByteArray* buf, char type, const gchar* name) {
+    guint8 t = type;
+    g_byte_array_append(buf, &t, sizeof(t));
+    _trackeroutput_appendName(buf, name);
+}
+
+static void _trackeroutput_writeSchema(TrackerOutput* output, TrackerTable table) {
+    const TrackerTableSchema* schema = &_schemas[table];
+
+    GByteArray* buf = g_byte_array_new();
+    guint8 tableID = table;
+    g_byte_array_append(buf, &tableID, sizeof(tableID));
+    _trackeroutput_appendName(buf, schema->name);
+    guint32 nColumns = _trackeroutput_nColumns(table);
+    g_byte_array_append(buf, (const guint8*)&nColumns, sizeof(nColumns));
+
+    for (guint i = 0; i < schema->nColumns; i++) {
+        _trackeroutput_appendColumn(buf, schema->columns[i].type, schema->columns[i].name);
+    }
+    if (schema->hasCounters) {
+        for (guint i = 0; i < G_N_ELEMENTS(_counter_directions); i++) {
+            for (guint j = 0; j < G_N_ELEMENTS(_counter_columns); j++) {
+                gchar* name = g_strdup_printf("%s-%s", _counter_directions[i], _counter_columns[j]);
+                _trackeroutput_appendColumn(buf, 'u', name);
+                g_free(name);
+            }
+        }
+    }
+
+    _trackeroutput_writeBlockHeader(output, TRACKER_OUTPUT_BLOCK_SCHEMA, buf->len);
+    _trackeroutput_write(output, buf->data, buf->len);
+    g_byte_array_unref(buf);
+}
+
+static void _trackeroutput_flushTable(TrackerOutput* output, TrackerTable table) {
+    TrackerTableBuffer* tb = &output->tables[table];
+    if (tb->nRows == 0) {
+        return;
+    }
+
+    guint8 tableID = table;
+    guint32 nRows = tb->nRows;
+    _trackeroutput_writeBlockHeader(output, TRACKER_OUTPUT_BLOCK_ROWS,
+                                    sizeof(tableID) + sizeof(nRows) +
+                                        tb->nColumns * nRows * sizeof(TrackerValue));
+    _trackeroutput_write(output, &tableID, sizeof(tableID));
+    _trackeroutput_write(output, &nRows, sizeof(nRows));
+
+    for (guint col = 0; col < tb->nColumns; col++) {
+        for (guint row = 0; row < nRows; row++) {
+            output->column[row] = tb->rows[row * tb->nColumns + col];
+        }
+        _trackeroutput_write(output, output->column, nRows * sizeof(TrackerValue));
+    }
+
+    tb->nRows = 0;
+}
+
+static TrackerOutput* _trackeroutput_new() {
+    TrackerOutput* output = g_new0(TrackerOutput, 1);
+    MAGIC_INIT(output);
+
+    gchar* dir = g_build_filename(worker_getDataPath(), "heartbeats", NULL);
+    if (g_mkdir_with_parents(dir, 0775) != 0) {
+        utility_panic("creating heartbeat directory %s: %s", dir, g_strerror(errno));
+    }
+    /* workers of other partitions write to the same directory */
+    gchar* name = worker_getPartition() > 0
+                      ? g_strdup_printf("partition-%u-worker-%d.hbt", worker_getPartition(),
+                                        worker_threadID())
+                      : g_strdup_printf("worker-%d.hbt", worker_threadID());
+    output->path = g_build_filename(dir, name, NULL);
+    g_free(name);
+    g_free(dir);
+
+    output->file = fopen(output->path, "w");
+    if (output->file == NULL) {
+        utility_panic("opening %s: %s", output->path, g_strerror(errno));
+    }
+    _trackeroutput_write(output, TRACKER_OUTPUT_MAGIC, TRACKER_OUTPUT_MAGIC_NBYTES);
+
+    output->stringIDs = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+    for (int i = 0; i < TRACKER_TABLE_COUNT; i++) {
+        TrackerTableBuffer* tb = &output->tables[i];
+        tb->nColumns = _trackeroutput_nColumns(i);
+        tb->rows = g_new(TrackerValue, tb->nColumns * TRACKER_OUTPUT_BLOCK_NROWS);
+    }
+
+    debug("writing heartbeats to %s", output->path);
+    return output;
+}
+
+static void _trackeroutput_free(TrackerOutput* output) {
+    MAGIC_ASSERT(output);
+
+    for (int i = 0; i < TRACKER_TABLE_COUNT; i++) {
+        _trackeroutput_flushTable(output, i);
+        g_free(output->tables[i].rows);
+    }
+    if (fclose(output->file) != 0) {
+        warning("closing %s: %s", output->path, g_strerror(errno));
+    }
+    g_hash_table_destroy(output->stringIDs);
+    g_free(output->path);
+
+    MAGIC_CLEAR(output);
+    g_free(output);
+}
+
+TrackerOutput* trackeroutput_getForThisThread() {
+    if (_thread_output == NULL) {
+        _thread_output = _trackeroutput_new();
+    }
+    return _thread_output;
+}
+
+guint64 trackeroutput_internString(TrackerOutput* output, const gchar* str) {
+    MAGIC_ASSERT(output);
+
+    gpointer id = g_hash_table_lookup(output->stringIDs, str);
+    if (id != NULL) {
+        return GPOINTER_TO_SIZE(id);
+    }
+
+    guint64 newID = g_hash_table_size(output->stringIDs) + 1;
+    g_hash_table_insert(output->stringIDs, g_strdup(str), GSIZE_TO_POINTER(newID));
+
+    gsize len = strlen(str);
+    _trackeroutput_writeBlockHeader(output, TRACKER_OUTPUT_BLOCK_STRING, sizeof(newID) + len);
+    _trackeroutput_write(output, &newID, sizeof(newID));
+    _trackeroutput_write(output, str, len);
+    return newID;
+}
+
+void trackeroutput_appendRow(TrackerOutput* output, TrackerTable table, const TrackerValue* row) {
+    MAGIC_ASSERT(output);
+    utility_assert(table < TRACKER_TABLE_COUNT);
+
+    TrackerTableBuffer* tb = &output->tables[table];
+    if (!tb->wroteSchema) {
+        _trackeroutput_writeSchema(output, table);
+        tb->wroteSchema = TRUE;
+    }
+
+    memcpy(&tb->rows[tb->nRows * tb->nColumns], row, tb->nColumns * sizeof(TrackerValue));
+    if (++tb->nRows == TRACKER_OUTPUT_BLOCK_NROWS) {
+        _trackeroutput_flushTable(output, table);
+    }
+}
+
+void trackeroutput_closeForThisThread() {
+    if (_thread_output != NULL) {
+        _trackeroutput_free(_thread_output);
+        _thread_output = NULL;
+    }
+}
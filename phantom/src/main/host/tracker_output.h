@@ -0,0 +1,79 @@
+/*
+ * The Shadow Simulator
+ * See LICENSE for licensing information
+ */
+
+#ifndef SHD_TRACKER_OUTPUT_H_
+#define SHD_TRACKER_OUTPUT_H_
+
+#include <glib.h>
+
+/*
+ * Binary heartbeat output, which the trackers write instead of heartbeat log
+ * messages when `experimental.use_binary_heartbeats` is enabled. Each worker
+ * thread writes the heartbeats of the hosts it runs to its own file,
+ * heartbeats/worker-<id>.hbt in the data directory (partition-<n>-worker-<id>.hbt
+ * for the workers of partition n > 0 when `experimental.manager_processes` is
+ * set), with one row per host (or per socket) per interval.
+ * src/tools/convert_heartbeats.py converts the files to the text format, or to
+ * the stats that parse-shadow.py produces.
+ *
+ * A file starts with TRACKER_OUTPUT_MAGIC, followed by blocks. Each block is a
+ * u8 type and a u32 payload length, followed by the payload. Integers are
+ * little-endian.
+ *
+ * TRACKER_OUTPUT_BLOCK_SCHEMA: u8 table id, u8 name length, name, u32 number
+ *   of columns, then for each column a u8 type ('u' for a u64, 'f' for an
+ *   IEEE-754 double, or 's' for the u64 id of a string), u8 name length, and
+ *   name. Precedes the rows of the table.
+ *
+ * TRACKER_OUTPUT_BLOCK_STRING: u64 id, then the bytes of the string, without a
+ *   nul. Precedes the rows that refer to the string.
+ *
+ * TRACKER_OUTPUT_BLOCK_ROWS: u8 table id, u32 number of rows, then each column
+ *   of the table in turn, as an array with a value for each row.
+ */
+
+#define TRACKER_OUTPUT_MAGIC "SHDHBT01"
+#define TRACKER_OUTPUT_MAGIC_NBYTES 8
+
+enum {
+    TRACKER_OUTPUT_BLOCK_SCHEMA = 1,
+    TRACKER_OUTPUT_BLOCK_STRING = 2,
+    TRACKER_OUTPUT_BLOCK_ROWS = 3,
+};
+
+typedef enum _TrackerTable TrackerTable;
+enum _TrackerTable {
+    TRACKER_TABLE_NODE,
+    TRACKER_TABLE_SOCKET,
+    TRACKER_TABLE_RAM,
+    TRACKER_TABLE_COUNT,
+};
+
+// Number of columns of each table; see tracker_output.c for the schemas.
+#define TRACKER_NODE_NCOLUMNS 56
+#define TRACKER_SOCKET_NCOLUMNS 60
+#define TRACKER_RAM_NCOLUMNS 8
+
+typedef union _TrackerValue TrackerValue;
+union _TrackerValue {
+    guint64 u;
+    gdouble f;
+};
+
+typedef struct _TrackerOutput TrackerOutput;
+
+// The output of the calling worker thread, which is opened on first use.
+TrackerOutput* trackeroutput_getForThisThread();
+
+// Returns the id of `str` in `output`, defining it first if needed.
+guint64 trackeroutput_internString(TrackerOutput* output, const gchar* str);
+
+// Append a row to `table`, with a value for each of its columns.
+void trackeroutput_appendRow(TrackerOutput* output, TrackerTable table, const TrackerValue* row);
+
+// Write any buffered rows and close the calling thread's output, if it has one.
+void trackeroutput_closeForThisThread();
+
+#endif /* SHD_TRACKER_OUTPUT_H_ */
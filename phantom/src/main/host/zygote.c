@@ -0,0 +1,255 @@
+/*
+ * The Shadow Simulator
+ * See LICENSE for licensing information
+ */
+
+#include "main/host/zygote.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <glib.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "lib/logger/logger.h"
+#include "lib/shim/shim_zygote.h"
+#include "main/utility/utility.h"
+
+typedef struct _Zygote Zygote;
+struct _Zygote {
+    // Held for the duration of each request, since a response has to be read
+    // before the next request can be sent.
+    GMutex lock;
+    pid_t pid;
+    // Our end of the socket to the zygote, or -1 if the zygote stopped
+    // responding.
+    int fd;
+};
+
+// Protects the tables below. The Zygote objects are never freed, since
+// instances may outlive the simulation of their host.
+static GMutex _zygotesLock;
+// Key from `_zygote_key` -> Zygote*.
+static GHashTable* _zygotes = NULL;
+// Instance pid -> Zygote*, until the instance is reaped.
+static GHashTable* _instances = NULL;
+
+// Instances of the same binary can only share a zygote if the dynamic linker
+// would have loaded them the same way.
+static gchar* _zygote_key(const char* file, char* const envp[]) {
+    const gchar* preload = g_environ_getenv((gchar**)envp, "LD_PRELOAD");
+    const gchar* libraryPath = g_environ_getenv((gchar**)envp, "LD_LIBRARY_PATH");
+    return g_strdup_printf(
+        "%s\n%s\n%s", file, preload ? preload : "", libraryPath ? libraryPath : "");
+}
+
+static Zygote* _zygote_start(const char* file, char* const argv[], char* const envp[],
+                             const char* workingDir) {
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) < 0) {
+        warning("socketpair: %s", g_strerror(errno));
+        return NULL;
+    }
+
+    // The zygote's end stays open across the exec below. It's close-on-exec
+    // until then so that processes started by other threads don't inherit it.
+    gchar* fdStr = g_strdup_printf("%d", fds[1]);
+    gchar** zygoteEnvv =
+        g_environ_setenv(g_strdupv((gchar**)envp), "SHADOW_ZYGOTE_FD", fdStr, TRUE);
+    g_free(fdStr);
+
+    pid_t pid = vfork();
+
+    // Beware! Unless you really know what you're doing, don't add any code
+    // between here and the execvpe below. The forked child process is sharing
+    // memory and control structures with the parent at this point. See
+    // `man 2 vfork`.
+
+    switch (pid) {
+        case -1:
+            utility_panic("fork failed");
+            return NULL;
+        case 0: {
+            // child
+            if (fcntl(fds[1], F_SETFD, 0) < 0) {
+                die_after_vfork();
+            }
+            if (chdir(workingDir) < 0) {
+                die_after_vfork();
+            }
+            execvpe(file, argv, zygoteEnvv);
+            die_after_vfork();
+        }
+        default: // parent
+            break;
+    }
+
+    g_strfreev(zygoteEnvv);
+    close(fds[1]);
+
+    debug("started zygote for %s with PID %d", file, pid);
+
+    Zygote* zygote = g_new0(Zygote, 1);
+    g_mutex_init(&zygote->lock);
+    zygote->pid = pid;
+    zygote->fd = fds[0];
+    return zygote;
+}
+
+// Send a request followed by `payload`, and read the response. Must be called
+// with the zygote's lock held. Returns false if the zygote can't be used.
+static gboolean _zygote_transact(Zygote* zygote, const ShimZygoteRequest* req,
+                                 const void* payload, size_t payloadLen,
+                                 ShimZygoteResponse* res) {
+    if (zygote->fd < 0) {
+        return FALSE;
+    }
+
+    // errno of the failed operation, or 0 if the zygote closed the socket.
+    int err = 0;
+
+    struct {
+        const void* buf;
+        size_t len;
+    } out[] = {{req, sizeof(*req)}, {payload, payloadLen}};
+    for (size_t i = 0; i < G_N_ELEMENTS(out); i++) {
+        const char* p = out[i].buf;
+        size_t len = out[i].len;
+        while (len > 0) {
+            // Don't get killed by SIGPIPE if the zygote died.
+            ssize_t rv = send(zygote->fd, p, len, MSG_NOSIGNAL);
+            if (rv < 0 && errno == EINTR) {
+                continue;
+            }
+            if (rv <= 0) {
+                err = rv < 0 ? errno : 0;
+                goto fail;
+            }
+            p += rv;
+            len -= rv;
+        }
+    }
+
+    char* p = (char*)res;
+    size_t len = sizeof(*res);
+    while (len > 0) {
+        ssize_t rv = read(zygote->fd, p, len);
+        if (rv < 0 && errno == EINTR) {
+            continue;
+        }
+        if (rv <= 0) {
+            err = rv < 0 ? errno : 0;
+            goto fail;
+        }
+        p += rv;
+        len -= rv;
+    }
+    return TRUE;
+
+fail:
+    warning("zygote %d stopped responding: %s", zygote->pid,
+            err ? g_strerror(err) : "connection closed");
+    close(zygote->fd);
+    zygote->fd = -1;
+    return FALSE;
+}
+
+pid_t zygote_forkExec(const char* file, char* const argv[], char* const envp[],
+                      const char* workingDir) {
+    gchar* key = _zygote_key(file, envp);
+
+    g_mutex_lock(&_zygotesLock);
+    if (_zygotes == NULL) {
+        _zygotes = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+        _instances = g_hash_table_new(g_direct_hash, g_direct_equal);
+    }
+    Zygote* zygote = g_hash_table_lookup(_zygotes, key);
+    if (zygote == NULL) {
+        zygote = _zygote_start(file, argv, envp, workingDir);
+        if (zygote == NULL) {
+            g_mutex_unlock(&_zygotesLock);
+            g_free(key);
+            return -1;
+        }
+        g_hash_table_insert(_zygotes, key, zygote);
+    } else {
+        g_free(key);
+    }
+    g_mutex_unlock(&_zygotesLock);
+
+    // The instance's shim checks that its parent is still around, which is
+    // now the zygote rather than Shadow.
+    gchar* pidStr = g_strdup_printf("%d", zygote->pid);
+    gchar** instanceEnvv =
+        g_environ_setenv(g_strdupv((gchar**)envp), "SHADOW_PID", pidStr, TRUE);
+    g_free(pidStr);
+
+    GByteArray* strings = g_byte_array_new();
+    g_byte_array_append(strings, (const guint8*)workingDir, strlen(workingDir) + 1);
+    ShimZygoteRequest req = {.type = SHIM_ZYGOTE_REQUEST_SPAWN};
+    for (; argv[req.argc] != NULL; req.argc++) {
+        g_byte_array_append(strings, (const guint8*)argv[req.argc], strlen(argv[req.argc]) + 1);
+    }
+    for (; instanceEnvv[req.envc] != NULL; req.envc++) {
+        g_byte_array_append(
+            strings, (const guint8*)instanceEnvv[req.envc], strlen(instanceEnvv[req.envc]) + 1);
+    }
+    req.nbytes = strings->len;
+    g_strfreev(instanceEnvv);
+
+    ShimZygoteResponse res;
+    g_mutex_lock(&zygote->lock);
+    gboolean ok = _zygote_transact(zygote, &req, strings->data, strings->len, &res);
+    g_mutex_unlock(&zygote->lock);
+    g_byte_array_unref(strings);
+
+    if (!ok) {
+        return -1;
+    }
+    if (res.pid < 0) {
+        warning("zygote %d couldn't fork: %s", zygote->pid, g_strerror(res.err));
+        return -1;
+    }
+
+    g_mutex_lock(&_zygotesLock);
+    g_hash_table_insert(_instances, GINT_TO_POINTER(res.pid), zygote);
+    g_mutex_unlock(&_zygotesLock);
+
+    debug("started process %s with PID %d from zygote %d", file, res.pid, zygote->pid);
+    return res.pid;
+}
+
+pid_t zygote_waitpid(pid_t pid, int* wstatus) {
+    Zygote* zygote = NULL;
+    g_mutex_lock(&_zygotesLock);
+    if (_instances != NULL) {
+        zygote = g_hash_table_lookup(_instances, GINT_TO_POINTER(pid));
+        g_hash_table_remove(_instances, GINT_TO_POINTER(pid));
+    }
+    g_mutex_unlock(&_zygotesLock);
+
+    if (zygote == NULL) {
+        return waitpid(pid, wstatus, __WALL);
+    }
+
+    ShimZygoteRequest req = {.type = SHIM_ZYGOTE_REQUEST_WAIT, .pid = pid};
+    ShimZygoteResponse res;
+    g_mutex_lock(&zygote->lock);
+    gboolean ok = _zygote_transact(zygote, &req, NULL, 0, &res);
+    g_mutex_unlock(&zygote->lock);
+
+    if (!ok) {
+        errno = ECHILD;
+        return -1;
+    }
+    if (res.pid < 0) {
+        errno = res.err;
+        return -1;
+    }
+    *wstatus = res.wstatus;
+    return res.pid;
+}
@@ -0,0 +1,35 @@
+/*
+ * The Shadow Simulator
+ * See LICENSE for licensing information
+ */
+
+#ifndef SRC_MAIN_HOST_SHD_ZYGOTE_H_
+#define SRC_MAIN_HOST_SHD_ZYGOTE_H_
+
+#include <sys/types.h>
+
+/*
+ * Starting managed processes from zygotes: one copy of each program that has
+ * been loaded, relocated and initialized up to its `main`, and that forks new
+ * instances of the program on request. See lib/shim/shim_zygote.h.
+ *
+ * Zygotes are shared by all worker threads, and are keyed by the binary along
+ * with the environment variables that affect how the dynamic linker loads it.
+ */
+
+// Start the program `file` with the given arguments, environment and working
+// directory by forking it from its zygote, starting the zygote first if needed.
+// The zygote itself runs with the environment of the first instance, and is
+// tied to the lifetime of the calling thread. Has the same signature as a
+// ForkProxy's `do_fork_exec`, so it can be run on a ForkProxy thread.
+//
+// Returns the new process's native pid, or -1 if the zygote couldn't be used,
+// in which case the caller should start the process normally.
+pid_t zygote_forkExec(const char* file, char* const argv[], char* const envp[],
+                      const char* workingDir);
+
+// Like `waitpid(pid, wstatus, __WALL)`, but also reaps processes started with
+// `zygote_forkExec`, which are children of their zygote rather than of Shadow.
+pid_t zygote_waitpid(pid_t pid, int* wstatus);
+
+#endif
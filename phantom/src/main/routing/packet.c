@@ -7,6 +7,7 @@
 #include <assert.h>
 #include <netinet/in.h>
 #include <stddef.h>
+#include <string.h>
 
 #include "lib/logger/log_level.h"
 #include "lib/logger/logger.h"
@@ -114,6 +115,19 @@ void packet_setPayload(Packet* packet, Thread* thread, PluginVirtualPtr payload,
     packet->priority = host_getNextPacketPriority(thread_getHost(thread));
 }
 
+void packet_setPayloadShadow(Packet* packet, Host* host, const void* payload,
+                             gsize payloadLength) {
+    MAGIC_ASSERT(packet);
+    utility_assert(host);
+    utility_assert(payload);
+    utility_assert(!packet->payload);
+
+    /* the payload starts with 1 ref, which we hold */
+    packet->payload = payload_newShadow(payload, payloadLength);
+    /* application data needs a priority ordering for FIFO onto the wire */
+    packet->priority = host_getNextPacketPriority(host);
+}
+
 /* copy everything except the payload.
  * the payload will point to the same payload as the original packet.
  * the payload is protected so it is safe to send the copied packet to a different host. */
@@ -180,6 +194,142 @@ Packet* packet_copy(Packet* packet) {
     return copy;
 }
 
+/* the fixed-size part of a packet as packet_serialize writes it. the protocol header,
+ * selective acks, ordered statuses, and payload follow it. */
+typedef struct _PacketSerialHeader PacketSerialHeader;
+struct _PacketSerialHeader {
+    guint hostID;
+    guint64 packetID;
+    ProtocolType protocol;
+    gdouble priority;
+    PacketDeliveryStatusFlags allStatus;
+    guint nSelectiveACKs;
+    guint nOrderedStatus;
+    guint payloadLength;
+};
+
+static gsize _packet_getHeaderStructSize(ProtocolType protocol) {
+    switch (protocol) {
+        case PNONE: return 0;
+        case PLOCAL: return sizeof(PacketLocalHeader);
+        case PUDP: return sizeof(PacketUDPHeader);
+        case PTCP: return sizeof(PacketTCPHeader);
+        default: {
+            utility_panic("unrecognized protocol");
+            return 0;
+        }
+    }
+}
+
+/* packets are only ever serialized to be recreated by another shadow process running the
+ * same binary, so structs are copied as they are laid out in memory */
+void packet_serialize(Packet* packet, GByteArray* buffer) {
+    MAGIC_ASSERT(packet);
+    utility_assert(buffer);
+
+    PacketTCPHeader* tcpHeader = packet->protocol == PTCP ? packet->header : NULL;
+
+    PacketSerialHeader serialHeader = {
+        .hostID = packet->hostID,
+        .packetID = packet->packetID,
+        .protocol = packet->protocol,
+        .priority = packet->priority,
+        .allStatus = packet->allStatus,
+        .nSelectiveACKs = tcpHeader ? g_list_length(tcpHeader->selectiveACKs) : 0,
+        .nOrderedStatus = packet->orderedStatus ? g_queue_get_length(packet->orderedStatus) : 0,
+        .payloadLength = packet_getPayloadLength(packet),
+    };
+    g_byte_array_append(buffer, (const guint8*)&serialHeader, sizeof(serialHeader));
+
+    if (packet->header) {
+        g_byte_array_append(
+            buffer, packet->header, _packet_getHeaderStructSize(packet->protocol));
+    }
+
+    if (tcpHeader) {
+        for (GList* iter = tcpHeader->selectiveACKs; iter; iter = iter->next) {
+            gint sequence = GPOINTER_TO_INT(iter->data);
+            g_byte_array_append(buffer, (const guint8*)&sequence, sizeof(sequence));
+        }
+    }
+
+    if (packet->orderedStatus) {
+        for (GList* iter = packet->orderedStatus->head; iter; iter = iter->next) {
+            guint status = GPOINTER_TO_UINT(iter->data);
+            g_byte_array_append(buffer, (const guint8*)&status, sizeof(status));
+        }
+    }
+
+    if (serialHeader.payloadLength > 0) {
+        guint offset = buffer->len;
+        g_byte_array_set_size(buffer, offset + serialHeader.payloadLength);
+        gsize copied = payload_getDataShadow(
+            packet->payload, 0, &buffer->data[offset], serialHeader.payloadLength);
+        utility_assert(copied == serialHeader.payloadLength);
+    }
+}
+
+Packet* packet_deserialize(const guint8* data, gsize length) {
+    utility_assert(data);
+    utility_assert(length >= sizeof(PacketSerialHeader));
+
+    PacketSerialHeader serialHeader;
+    memcpy(&serialHeader, data, sizeof(serialHeader));
+    gsize offset = sizeof(serialHeader);
+
+    gsize headerStructSize = _packet_getHeaderStructSize(serialHeader.protocol);
+    utility_assert(length == offset + headerStructSize +
+                                 serialHeader.nSelectiveACKs * sizeof(gint) +
+                                 serialHeader.nOrderedStatus * sizeof(guint) +
+                                 serialHeader.payloadLength);
+
+    Packet* packet = g_new0(Packet, 1);
+    MAGIC_INIT(packet);
+
+    packet->referenceCount = 1;
+    packet->hostID = serialHeader.hostID;
+    packet->packetID = serialHeader.packetID;
+    packet->protocol = serialHeader.protocol;
+    packet->priority = serialHeader.priority;
+    packet->allStatus = serialHeader.allStatus;
+
+    if (headerStructSize > 0) {
+        packet->header = g_malloc(headerStructSize);
+        memcpy(packet->header, &data[offset], headerStructSize);
+        offset += headerStructSize;
+    }
+
+    if (packet->protocol == PTCP) {
+        PacketTCPHeader* tcpHeader = packet->header;
+        /* the pointer is from the sending process */
+        tcpHeader->selectiveACKs = NULL;
+        for (guint i = 0; i < serialHeader.nSelectiveACKs; i++) {
+            gint sequence;
+            memcpy(&sequence, &data[offset], sizeof(sequence));
+            offset += sizeof(sequence);
+            tcpHeader->selectiveACKs =
+                g_list_prepend(tcpHeader->selectiveACKs, GINT_TO_POINTER(sequence));
+        }
+        tcpHeader->selectiveACKs = g_list_reverse(tcpHeader->selectiveACKs);
+    }
+
+    packet->orderedStatus = g_queue_new();
+    for (guint i = 0; i < serialHeader.nOrderedStatus; i++) {
+        guint status;
+        memcpy(&status, &data[offset], sizeof(status));
+        offset += sizeof(status);
+        g_queue_push_tail(packet->orderedStatus, GUINT_TO_POINTER(status));
+    }
+
+    if (serialHeader.payloadLength > 0) {
+        /* the payload starts with 1 ref, which we hold */
+        packet->payload = payload_newShadow(&data[offset], serialHeader.payloadLength);
+    }
+
+    worker_count_allocation(Packet);
+    return packet;
+}
+
 static void _packet_free(Packet* packet) {
     MAGIC_ASSERT(packet);
 
@@ -37,8 +37,16 @@ const gchar* protocol_toString(ProtocolType type);
 Packet* packet_new(Host* host);
 void packet_setPayload(Packet* packet, Thread* thread, PluginVirtualPtr payload,
                        gsize payloadLength);
+void packet_setPayloadShadow(Packet* packet, Host* host, const void* payload,
+                             gsize payloadLength);
 Packet* packet_copy(Packet* packet);
 
+/* Append everything about the packet, including a copy of its payload, to `buffer`, so
+ * that another shadow process can recreate it with packet_deserialize. */
+void packet_serialize(Packet* packet, GByteArray* buffer);
+/* Create a packet from the `length` bytes that packet_serialize wrote at `data`. */
+Packet* packet_deserialize(const guint8* data, gsize length);
+
 void packet_ref(Packet* packet);
 void packet_unref(Packet* packet);
 static inline void packet_unrefTaskFreeFunc(gpointer packet) { packet_unref(packet); }
@@ -15,6 +15,8 @@
 typedef struct _Payload Payload;
 
 Payload* payload_new(Thread* thread, PluginVirtualPtr data, gsize dataLength);
+/* like payload_new, but copies the data from shadow's memory */
+Payload* payload_newShadow(const void* data, gsize dataLength);
 
 void payload_ref(Payload* payload);
 void payload_unref(Payload* payload);
@@ -31,6 +31,12 @@ struct _Router {
     /* the interface that we deliver packets to */
     NetworkInterface* interface;
 
+    /* routes to the destinations we have sent to, keyed by destination IP */
+    GHashTable* routes;
+    /* the most recently used route, so that a stream of packets to the same
+     * destination does not even need the table lookup */
+    WorkerRoute* lastRoute;
+
     gint referenceCount;
     MAGIC_DECLARE;
 };
@@ -46,6 +52,8 @@ Router* router_new(QueueManagerMode queueMode, void* interface) {
 
     router->referenceCount = 1;
 
+    router->routes = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, g_free);
+
     if(router->queueMode == QUEUE_MANAGER_SINGLE) {
         router->queueHooks = routerqueuesingle_getHooks();
     } else if(router->queueMode == QUEUE_MANAGER_STATIC) {
@@ -61,6 +69,7 @@ Router* router_new(QueueManagerMode queueMode, void* interface) {
     utility_assert(router->queueHooks->enqueue);
     utility_assert(router->queueHooks->dequeue);
     utility_assert(router->queueHooks->peek);
+    utility_assert(router->queueHooks->dequeueBatch);
 
     router->queueManager = router->queueHooks->new();
 
@@ -72,6 +81,7 @@ static void _router_free(Router* router) {
     MAGIC_ASSERT(router);
 
     router->queueHooks->free(router->queueManager);
+    g_hash_table_destroy(router->routes);
 
     MAGIC_CLEAR(router);
     g_free(router);
@@ -92,12 +102,47 @@ void router_unref(Router* router) {
     }
 }
 
+static const WorkerRoute* _router_getRoute(Router* router, Packet* packet) {
+    in_addr_t srcIP = packet_getSourceIP(packet);
+    in_addr_t dstIP = packet_getDestinationIP(packet);
+
+    WorkerRoute* route = router->lastRoute;
+    if(route && route->dstIP == dstIP && route->srcIP == srcIP) {
+        return route;
+    }
+
+    route = g_hash_table_lookup(router->routes, GUINT_TO_POINTER(dstIP));
+    if(!route || route->srcIP != srcIP) {
+        /* first packet to this destination, look up the path the slow way */
+        route = g_new0(WorkerRoute, 1);
+        if(!worker_resolveRoute(srcIP, dstIP, route)) {
+            /* the simulation is over */
+            g_free(route);
+            return NULL;
+        }
+        g_hash_table_replace(router->routes, GUINT_TO_POINTER(dstIP), route);
+    }
+
+    router->lastRoute = route;
+    return route;
+}
+
 void router_forward(Router* router, Host* src, Packet* packet) {
     MAGIC_ASSERT(router);
-    /* just immediately forward the sending task to the worker, who will compute the
-     * path and the appropriate delays to the destination. The packet will arrive
-     * at the destination's router after a delay equal to the network latency.  */
-    worker_sendPacket(src, packet);
+
+    /* just immediately forward the sending task to the worker, who will use the
+     * cached path and delays to the destination. The packet will arrive at the
+     * destination's router after a delay equal to the network latency.  */
+    const WorkerRoute* route = _router_getRoute(router, packet);
+    if(route) {
+        worker_sendPacketOnRoute(src, packet, route);
+    }
+}
+
+void router_invalidateRoutes(Router* router) {
+    MAGIC_ASSERT(router);
+    router->lastRoute = NULL;
+    g_hash_table_remove_all(router->routes);
 }
 
 void router_enqueue(Router* router, Host* host, Packet* packet) {
@@ -120,6 +165,38 @@ void router_enqueue(Router* router, Host* host, Packet* packet) {
     }
 }
 
+void router_enqueueBatch(Router* router, Host* host, GPtrArray* packets) {
+    MAGIC_ASSERT(router);
+    utility_assert(packets);
+
+    gboolean wasEmpty = router->queueHooks->peek(router->queueManager) == NULL;
+
+    for(guint i = 0; i < packets->len; i++) {
+        Packet* packet = g_ptr_array_index(packets, i);
+        utility_assert(packet);
+
+        gboolean wasQueued = router->queueHooks->enqueue(router->queueManager, packet);
+
+        if(!wasQueued) {
+            /* the queue is full. when enqueuing one at a time, the interface would have
+             * been draining it as we went, so let it catch up before we give up. */
+            networkinterface_receivePackets(router->interface, host);
+            wasQueued = router->queueHooks->enqueue(router->queueManager, packet);
+        }
+
+        if(wasQueued) {
+            packet_addDeliveryStatus(packet, PDS_ROUTER_ENQUEUED);
+        } else {
+            packet_addDeliveryStatus(packet, PDS_ROUTER_DROPPED);
+        }
+    }
+
+    /* notify the netiface once for the whole burst so it can dequeue it in one pass. */
+    if(wasEmpty && router->queueHooks->peek(router->queueManager) != NULL) {
+        networkinterface_receivePackets(router->interface, host);
+    }
+}
+
 Packet* router_dequeue(Router* router) {
     MAGIC_ASSERT(router);
 
@@ -130,3 +207,16 @@ Packet* router_dequeue(Router* router) {
 
     return packet;
 }
+
+guint router_dequeueBatch(Router* router, Packet** packets, guint maxPackets, guint64 byteBudget) {
+    MAGIC_ASSERT(router);
+    utility_assert(packets);
+
+    guint count =
+        router->queueHooks->dequeueBatch(router->queueManager, packets, maxPackets, byteBudget);
+    for(guint i = 0; i < count; i++) {
+        packet_addDeliveryStatus(packets[i], PDS_ROUTER_DEQUEUED);
+    }
+
+    return count;
+}
@@ -28,6 +28,10 @@ typedef void (*QueueManagerFree)(void* queueManager);
 typedef gboolean (*QueueManagerEnqueue)(void* queueManager, Packet* packet);
 typedef Packet* (*QueueManagerDequeue)(void* queueManager);
 typedef Packet* (*QueueManagerPeek)(void* queueManager);
+/* dequeue up to maxPackets into packets, stopping early once less than CONFIG_MTU bytes
+ * of byteBudget remain. each returned packet is charged against the budget. */
+typedef guint (*QueueManagerDequeueBatch)(void* queueManager, Packet** packets, guint maxPackets,
+                                          guint64 byteBudget);
 
 struct _QueueManagerHooks {
     QueueManagerNew new;
@@ -35,6 +39,7 @@ struct _QueueManagerHooks {
     QueueManagerEnqueue enqueue;
     QueueManagerDequeue dequeue;
     QueueManagerPeek peek;
+    QueueManagerDequeueBatch dequeueBatch;
 };
 
 Router* router_new(QueueManagerMode queueMode, void* interface);
@@ -43,10 +48,21 @@ void router_unref(Router* router);
 
 /* forward an outgoing packet to the destination's upstream router */
 void router_forward(Router* router, Host* src, Packet* packet);
+/* forget all cached routes. the topology is currently static so nothing calls this yet,
+ * but anything that changes latencies or attachments at runtime must do so. */
+void router_invalidateRoutes(Router* router);
 
 /* enqueue a downstream packet, i.e., buffer it until the host can receive it */
 void router_enqueue(Router* router, Host* host, Packet* packet);
+/* enqueue a burst of downstream packets that arrive at the same time, in order. the outcome
+ * is the same as calling router_enqueue for each packet, but the interface is only asked to
+ * receive when the queue fills up or the burst is done. the caller keeps its references. */
+void router_enqueueBatch(Router* router, Host* host, GPtrArray* packets);
 /* dequeue a downstream packet, i.e., receive it from the network */
 Packet* router_dequeue(Router* router);
+/* dequeue as many downstream packets as fit in byteBudget (at most maxPackets) into the
+ * packets array, returning how many were stored. the caller owns the returned references.
+ * pass G_MAXUINT64 as the budget to drain the queue without a bandwidth limit. */
+guint router_dequeueBatch(Router* router, Packet** packets, guint maxPackets, guint64 byteBudget);
 
 #endif /* SRC_MAIN_ROUTING_SHD_ROUTER_H_ */
@@ -28,6 +28,7 @@
 #include "main/core/worker.h"
 #include "main/routing/packet.h"
 #include "main/routing/router.h"
+#include "main/routing/router_queue_ring.h"
 #include "main/utility/utility.h"
 
 /* hard limit of queue size, in number of packets. this is recommended to be
@@ -47,24 +48,19 @@
  * i.e., number of nanoseconds.*/
 #define CODEL_PARAM_INTERVAL_SIMTIME (100*SIMTIME_ONE_MILLISECOND)
 
+/* the number of records the ring holds before it first needs to grow. */
+#define CODEL_PARAM_INITIAL_CAPACITY 64
+
 typedef enum _CoDelMode CoDelMode;
 enum _CoDelMode {
     CODEL_MODE_STORE, // under good conditions, we store and forward packets
     CODEL_MODE_DROP, // under bad conditions, we occasionally drop packets
 };
 
-typedef struct _CoDelEntry CoDelEntry;
-struct _CoDelEntry {
-    Packet* packet;
-    SimulationTime enqueueTS;
-};
-
 typedef struct _QueueManagerCoDel QueueManagerCoDel;
 struct _QueueManagerCoDel {
-    /* the queue holding the packets and timestamps */
-    GQueue* entries;
-    /* total amount of bytes stored */
-    guint64 totalSize;
+    /* the ring holding the packets, their lengths, and timestamps */
+    RouterQueueRing ring;
 
     /* if we are in dropping mode or not */
     CoDelMode mode;
@@ -82,7 +78,8 @@ static QueueManagerCoDel* _routerqueuecodel_new() {
     QueueManagerCoDel* queueManager = g_new0(QueueManagerCoDel, 1);
 
     queueManager->mode = CODEL_MODE_STORE;
-    queueManager->entries = g_queue_new();
+    routerqueuering_init(&queueManager->ring, CODEL_PARAM_INITIAL_CAPACITY,
+                         CODEL_PARAM_QUEUE_SIZE_LIMIT);
 
     return queueManager;
 }
@@ -90,42 +87,17 @@ static QueueManagerCoDel* _routerqueuecodel_new() {
 static void _routerqueuecodel_free(QueueManagerCoDel* queueManager) {
     utility_assert(queueManager);
 
-    if(queueManager->entries) {
-        while(!g_queue_is_empty(queueManager->entries)) {
-            CoDelEntry* entry = g_queue_pop_head(queueManager->entries);
-            if(entry) {
-                if(entry->packet) {
-                    packet_unref(entry->packet);
-                }
-                g_free(entry);
-            }
-        }
-        g_queue_free(queueManager->entries);
-    }
+    routerqueuering_clear(&queueManager->ring);
 
     g_free(queueManager);
 }
 
-static inline guint64 _routerqueuecodel_getPacketLength(Packet* packet) {
-    return (guint64)(packet_getPayloadLength(packet) + packet_getHeaderSize(packet));
-}
-
 static gboolean _routerqueuecodel_enqueue(QueueManagerCoDel* queueManager, Packet* packet) {
     utility_assert(queueManager);
     utility_assert(packet);
 
-    if(g_queue_get_length(queueManager->entries) < CODEL_PARAM_QUEUE_SIZE_LIMIT) {
-        /* we will store the packet */
-        packet_ref(packet);
-
-        CoDelEntry* entry = g_new0(CoDelEntry, 1);
-        entry->packet = packet;
-        entry->enqueueTS = worker_getCurrentTime();
-        g_queue_push_tail(queueManager->entries, entry);
-
-        guint64 length = _routerqueuecodel_getPacketLength(packet);
-        queueManager->totalSize += length;
-
+    if(routerqueuering_push(&queueManager->ring, packet, worker_getCurrentTime())) {
+        /* we stored the packet */
         return TRUE;
     } else {
         /* we already have reached our hard packet limit, so we drop it */
@@ -146,53 +118,40 @@ static void _routerqueuecodel_drop(Packet* packet) {
 }
 
 static Packet* _routerqueuecodel_dequeueHelper(QueueManagerCoDel* queueManager,
-        SimulationTime now, gboolean* okToDrop) {
-    *okToDrop = FALSE;
-    Packet* packet = NULL;
-    SimulationTime ts = 0;
-
-    CoDelEntry* entry = g_queue_pop_head(queueManager->entries);
-    if(entry) {
-        packet = entry->packet;
-        ts = entry->enqueueTS;
-        g_free(entry);
-    }
+        SimulationTime now, gboolean* okToDrop, guint64* length) {
+    RouterQueueEntry entry;
 
-    if(packet == NULL) {
+    if(!routerqueuering_pop(&queueManager->ring, &entry)) {
         /* queue is empty, we cannot be above target.
          * reset the interval expiration */
         queueManager->intervalExpireTS = 0;
+        *okToDrop = FALSE;
         return NULL;
     }
 
-    guint64 length = _routerqueuecodel_getPacketLength(packet);
-    utility_assert(length <= queueManager->totalSize);
-    queueManager->totalSize -= length;
+    utility_assert(now >= entry.enqueueTS);
+    SimulationTime sojournTime = now - entry.enqueueTS;
+    *length = entry.length;
 
-    utility_assert(now >= ts);
-    SimulationTime sojournTime = now - ts;
+    /* We are in a good state if we are below the target delay, or if we don't even
+     * have a full packet left to send. */
+    gboolean isAboveTarget = sojournTime >= CODEL_PARAM_TARGET_DELAY_SIMTIME &&
+                             routerqueuering_getTotalSize(&queueManager->ring) >= CONFIG_MTU;
 
-    if(sojournTime < CODEL_PARAM_TARGET_DELAY_SIMTIME || queueManager->totalSize < CONFIG_MTU) {
-        /* We are in a good state, i.e., below the target delay. We reset the interval
-         * expiration, so that we wait for at least interval if the delay exceeds the
-         * target again. */
+    /* In a good state, we reset the interval expiration so that we wait for at least an
+     * interval if the delay exceeds the target again. If we just entered a bad state, we
+     * enter drop mode once we stay there for a full interval. If we were already in a bad
+     * state for a full interval worth of time, then we drop this packet. */
+    gboolean wasAboveTarget = queueManager->intervalExpireTS != 0;
+    *okToDrop = isAboveTarget && wasAboveTarget && now >= queueManager->intervalExpireTS;
+
+    if(!isAboveTarget) {
         queueManager->intervalExpireTS = 0;
-    } else {
-        /* We are in a bad state, i.e., at or above the target delay. */
-        if(queueManager->intervalExpireTS == 0) {
-            /* We were in a good state and just entered a bad state. If we stay in the
-             * bad state for a full interval, we enter drop mode. */
-            queueManager->intervalExpireTS = now + CODEL_PARAM_INTERVAL_SIMTIME;
-        } else {
-            /* We were already in a bad state and stayed in it. If we have been in it
-             * for a full interval worth of time, then we drop this packet. */
-            if(now >= queueManager->intervalExpireTS) {
-                *okToDrop = TRUE;
-            }
-        }
+    } else if(!wasAboveTarget) {
+        queueManager->intervalExpireTS = now + CODEL_PARAM_INTERVAL_SIMTIME;
     }
 
-    return packet;
+    return entry.packet;
 }
 
 static SimulationTime _routerqueuecodel_controlLaw(guint count, SimulationTime ts) {
@@ -204,13 +163,10 @@ static SimulationTime _routerqueuecodel_controlLaw(guint count, SimulationTime t
     return (SimulationTime) rounded;
 }
 
-static Packet* _routerqueuecodel_dequeue(QueueManagerCoDel* queueManager) {
-    utility_assert(queueManager);
-
-    SimulationTime now = worker_getCurrentTime();
-
+static Packet* _routerqueuecodel_dequeueAt(QueueManagerCoDel* queueManager, SimulationTime now,
+                                           guint64* length) {
     gboolean okToDrop = FALSE;
-    Packet* packet = _routerqueuecodel_dequeueHelper(queueManager, now, &okToDrop);
+    Packet* packet = _routerqueuecodel_dequeueHelper(queueManager, now, &okToDrop, length);
 
     /* If we have an empty queue, we exit dropping state. */
     if(packet == NULL) {
@@ -230,7 +186,7 @@ static Packet* _routerqueuecodel_dequeue(QueueManagerCoDel* queueManager) {
             queueManager->dropCount++;
 
             /* get the next one */
-            packet = _routerqueuecodel_dequeueHelper(queueManager, now, &okToDrop);
+            packet = _routerqueuecodel_dequeueHelper(queueManager, now, &okToDrop, length);
 
             if(okToDrop) {
                 /* schedule the next drop */
@@ -244,7 +200,7 @@ static Packet* _routerqueuecodel_dequeue(QueueManagerCoDel* queueManager) {
         _routerqueuecodel_drop(packet);
 
         /* get the next one */
-        packet = _routerqueuecodel_dequeueHelper(queueManager, now, &okToDrop);
+        packet = _routerqueuecodel_dequeueHelper(queueManager, now, &okToDrop, length);
 
         /* turn on dropping mode */
         queueManager->mode = CODEL_MODE_DROP;
@@ -266,16 +222,40 @@ static Packet* _routerqueuecodel_dequeue(QueueManagerCoDel* queueManager) {
     return packet;
 }
 
-static Packet* _routerqueuecodel_peek(QueueManagerCoDel* queueManager) {
+static Packet* _routerqueuecodel_dequeue(QueueManagerCoDel* queueManager) {
     utility_assert(queueManager);
 
-    CoDelEntry* entry = g_queue_peek_head(queueManager->entries);
+    guint64 length = 0;
+    return _routerqueuecodel_dequeueAt(queueManager, worker_getCurrentTime(), &length);
+}
 
-    if(entry && entry->packet) {
-        return entry->packet;
-    } else {
-        return NULL;
+static guint _routerqueuecodel_dequeueBatch(QueueManagerCoDel* queueManager, Packet** packets,
+                                            guint maxPackets, guint64 byteBudget) {
+    utility_assert(queueManager);
+
+    /* time does not advance while we drain, so we only need to look it up once */
+    SimulationTime now = worker_getCurrentTime();
+    guint count = 0;
+
+    while(count < maxPackets && byteBudget >= CONFIG_MTU) {
+        guint64 length = 0;
+        Packet* packet = _routerqueuecodel_dequeueAt(queueManager, now, &length);
+        if(!packet) {
+            break;
+        }
+
+        packets[count++] = packet;
+        byteBudget -= MIN(length, byteBudget);
     }
+
+    return count;
+}
+
+static Packet* _routerqueuecodel_peek(QueueManagerCoDel* queueManager) {
+    utility_assert(queueManager);
+
+    const RouterQueueEntry* entry = routerqueuering_peek(&queueManager->ring);
+    return entry ? entry->packet : NULL;
 }
 
 static const struct _QueueManagerHooks _routerqueuecodel_hooks = {
@@ -283,7 +263,8 @@ static const struct _QueueManagerHooks _routerqueuecodel_hooks = {
     .free = (QueueManagerFree) _routerqueuecodel_free,
     .enqueue = (QueueManagerEnqueue) _routerqueuecodel_enqueue,
     .dequeue = (QueueManagerDequeue) _routerqueuecodel_dequeue,
-    .peek = (QueueManagerPeek) _routerqueuecodel_peek
+    .peek = (QueueManagerPeek) _routerqueuecodel_peek,
+    .dequeueBatch = (QueueManagerDequeueBatch) _routerqueuecodel_dequeueBatch
 };
 
 const QueueManagerHooks* routerqueuecodel_getHooks() {
@@ -0,0 +1,108 @@
+/*
+ * router_queue_ring.c
+ *
+ *  Fixed-capacity ring storage for the router queue managers.
+ */
+
+#include "main/routing/router_queue_ring.h"
+
+#include <glib.h>
+#include <string.h>
+
+#include "main/routing/packet.h"
+#include "main/utility/utility.h"
+
+static guint _routerqueuering_roundCapacity(guint capacity) {
+    guint rounded = 1;
+    while(rounded < capacity && rounded <= G_MAXUINT / 2) {
+        rounded <<= 1;
+    }
+    return rounded;
+}
+
+void routerqueuering_init(RouterQueueRing* ring, guint initialCapacity, guint maxLength) {
+    utility_assert(ring);
+    utility_assert(maxLength > 0);
+
+    memset(ring, 0, sizeof(*ring));
+    ring->maxLength = maxLength;
+    ring->capacity = _routerqueuering_roundCapacity(MIN(MAX(initialCapacity, 1), maxLength));
+    ring->entries = g_new0(RouterQueueEntry, ring->capacity);
+}
+
+void routerqueuering_clear(RouterQueueRing* ring) {
+    utility_assert(ring);
+
+    RouterQueueEntry entry;
+    while(routerqueuering_pop(ring, &entry)) {
+        packet_unref(entry.packet);
+    }
+
+    g_free(ring->entries);
+    ring->entries = NULL;
+    ring->capacity = 0;
+}
+
+static gboolean _routerqueuering_grow(RouterQueueRing* ring) {
+    if(ring->capacity >= ring->maxLength || ring->capacity > G_MAXUINT / 2) {
+        return FALSE;
+    }
+
+    guint newCapacity = ring->capacity << 1;
+    RouterQueueEntry* newEntries = g_new(RouterQueueEntry, newCapacity);
+
+    /* copy the records out in order so the oldest one lands at index 0 */
+    guint firstRun = MIN(ring->length, ring->capacity - ring->head);
+    memcpy(newEntries, &ring->entries[ring->head], firstRun * sizeof(RouterQueueEntry));
+    memcpy(&newEntries[firstRun], ring->entries,
+           (ring->length - firstRun) * sizeof(RouterQueueEntry));
+
+    g_free(ring->entries);
+    ring->entries = newEntries;
+    ring->capacity = newCapacity;
+    ring->head = 0;
+
+    return TRUE;
+}
+
+gboolean routerqueuering_push(RouterQueueRing* ring, Packet* packet, SimulationTime now) {
+    utility_assert(ring);
+    utility_assert(packet);
+
+    if(ring->length >= ring->maxLength) {
+        return FALSE;
+    }
+    if(ring->length == ring->capacity && !_routerqueuering_grow(ring)) {
+        return FALSE;
+    }
+
+    packet_ref(packet);
+
+    RouterQueueEntry* entry = &ring->entries[(ring->head + ring->length) & (ring->capacity - 1)];
+    entry->packet = packet;
+    entry->enqueueTS = now;
+    entry->length = (guint64)(packet_getPayloadLength(packet) + packet_getHeaderSize(packet));
+
+    ring->length++;
+    ring->totalSize += entry->length;
+
+    return TRUE;
+}
+
+gboolean routerqueuering_pop(RouterQueueRing* ring, RouterQueueEntry* entry) {
+    utility_assert(ring);
+    utility_assert(entry);
+
+    if(ring->length == 0) {
+        return FALSE;
+    }
+
+    *entry = ring->entries[ring->head];
+    ring->head = (ring->head + 1) & (ring->capacity - 1);
+    ring->length--;
+
+    utility_assert(entry->length <= ring->totalSize);
+    ring->totalSize -= entry->length;
+
+    return TRUE;
+}
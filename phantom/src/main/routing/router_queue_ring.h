@@ -0,0 +1,62 @@
+/*
+ * router_queue_ring.h
+ *
+ *  A ring of compact packet records shared by the router queue managers.
+ *  Each record caches the packet length and enqueue time so that dequeue
+ *  paths do not have to chase the packet to recompute them.
+ */
+
+#ifndef SRC_MAIN_ROUTING_SHD_ROUTER_QUEUE_RING_H_
+#define SRC_MAIN_ROUTING_SHD_ROUTER_QUEUE_RING_H_
+
+#include <glib.h>
+
+#include "main/core/support/definitions.h"
+#include "main/routing/packet.minimal.h"
+
+typedef struct _RouterQueueEntry RouterQueueEntry;
+struct _RouterQueueEntry {
+    Packet* packet;
+    SimulationTime enqueueTS;
+    guint64 length;
+};
+
+typedef struct _RouterQueueRing RouterQueueRing;
+struct _RouterQueueRing {
+    /* record storage, always a power of two in size */
+    RouterQueueEntry* entries;
+    guint capacity;
+    /* index of the oldest record and number of stored records */
+    guint head;
+    guint length;
+    /* the ring grows by doubling until it holds this many records */
+    guint maxLength;
+    /* total amount of bytes stored */
+    guint64 totalSize;
+};
+
+/* initialize an embedded ring that starts with room for initialCapacity records
+ * and never holds more than maxLength records */
+void routerqueuering_init(RouterQueueRing* ring, guint initialCapacity, guint maxLength);
+/* release the references to all stored packets and the record storage */
+void routerqueuering_clear(RouterQueueRing* ring);
+
+/* append a packet, taking a new reference to it. returns FALSE if the ring is full. */
+gboolean routerqueuering_push(RouterQueueRing* ring, Packet* packet, SimulationTime now);
+/* remove the oldest record and copy it to entry. the reference we were holding
+ * on the packet is transferred to the caller. returns FALSE if the ring is empty. */
+gboolean routerqueuering_pop(RouterQueueRing* ring, RouterQueueEntry* entry);
+
+static inline const RouterQueueEntry* routerqueuering_peek(const RouterQueueRing* ring) {
+    return ring->length > 0 ? &ring->entries[ring->head] : NULL;
+}
+
+static inline guint routerqueuering_getLength(const RouterQueueRing* ring) {
+    return ring->length;
+}
+
+static inline guint64 routerqueuering_getTotalSize(const RouterQueueRing* ring) {
+    return ring->totalSize;
+}
+
+#endif /* SRC_MAIN_ROUTING_SHD_ROUTER_QUEUE_RING_H_ */
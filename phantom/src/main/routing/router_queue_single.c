@@ -8,53 +8,65 @@
 #include <glib.h>
 #include <stddef.h>
 
+#include "main/core/support/definitions.h"
+#include "main/core/worker.h"
 #include "main/routing/packet.h"
 #include "main/routing/router.h"
+#include "main/routing/router_queue_ring.h"
 #include "main/utility/utility.h"
 
 typedef struct _QueueManagerSingle QueueManagerSingle;
 struct _QueueManagerSingle {
-    Packet* currentPacket;
+    /* a ring with room for exactly one packet */
+    RouterQueueRing ring;
 };
 
 static QueueManagerSingle* _routerqueuesingle_new() {
     QueueManagerSingle* queueManager = g_new0(QueueManagerSingle, 1);
+    routerqueuering_init(&queueManager->ring, 1, 1);
     return queueManager;
 }
 
 static void _routerqueuesingle_free(QueueManagerSingle* queueManager) {
     utility_assert(queueManager);
-    if(queueManager->currentPacket) {
-        packet_unref(queueManager->currentPacket);
-    }
+    routerqueuering_clear(&queueManager->ring);
     g_free(queueManager);
 }
 
 static gboolean _routerqueuesingle_enqueue(QueueManagerSingle* queueManager, Packet* packet) {
     utility_assert(queueManager);
-
-    if(!queueManager->currentPacket) {
-        /* we will queue the packet */
-        packet_ref(packet);
-        queueManager->currentPacket = packet;
-        return TRUE;
-    } else {
-        /* we already queued a packet, so this one gets dropped */
-        return FALSE;
-    }
+    /* if we already queued a packet, the ring is full and this one gets dropped */
+    return routerqueuering_push(&queueManager->ring, packet, worker_getCurrentTime());
 }
 
 static Packet* _routerqueuesingle_dequeue(QueueManagerSingle* queueManager) {
     utility_assert(queueManager);
     /* this call transfers the reference that we were holding to the caller */
-    Packet* packet = queueManager->currentPacket;
-    queueManager->currentPacket = NULL;
-    return packet;
+    RouterQueueEntry entry;
+    return routerqueuering_pop(&queueManager->ring, &entry) ? entry.packet : NULL;
+}
+
+static guint _routerqueuesingle_dequeueBatch(QueueManagerSingle* queueManager, Packet** packets,
+                                             guint maxPackets, guint64 byteBudget) {
+    utility_assert(queueManager);
+
+    if(maxPackets == 0 || byteBudget < CONFIG_MTU) {
+        return 0;
+    }
+
+    Packet* packet = _routerqueuesingle_dequeue(queueManager);
+    if(!packet) {
+        return 0;
+    }
+
+    packets[0] = packet;
+    return 1;
 }
 
 static Packet* _routerqueuesingle_peek(QueueManagerSingle* queueManager) {
     utility_assert(queueManager);
-    return queueManager->currentPacket;
+    const RouterQueueEntry* entry = routerqueuering_peek(&queueManager->ring);
+    return entry ? entry->packet : NULL;
 }
 
 static const struct _QueueManagerHooks _routerqueuesingle_hooks = {
@@ -62,7 +74,8 @@ static const struct _QueueManagerHooks _routerqueuesingle_hooks = {
     .free = (QueueManagerFree) _routerqueuesingle_free,
     .enqueue = (QueueManagerEnqueue) _routerqueuesingle_enqueue,
     .dequeue = (QueueManagerDequeue) _routerqueuesingle_dequeue,
-    .peek = (QueueManagerPeek) _routerqueuesingle_peek
+    .peek = (QueueManagerPeek) _routerqueuesingle_peek,
+    .dequeueBatch = (QueueManagerDequeueBatch) _routerqueuesingle_dequeueBatch
 };
 
 const QueueManagerHooks* routerqueuesingle_getHooks() {
@@ -7,22 +7,27 @@
 
 #include <glib.h>
 
+#include "main/core/support/definitions.h"
+#include "main/core/worker.h"
 #include "main/routing/packet.h"
 #include "main/routing/router.h"
+#include "main/routing/router_queue_ring.h"
 #include "main/utility/utility.h"
 
 #define STATIC_PARAM_MAXSIZE 1024000
 
+/* the ring starts small and doubles as needed; the byte limit bounds it in practice */
+#define STATIC_PARAM_INITIAL_CAPACITY 64
+
 typedef struct _QueueManagerStatic QueueManagerStatic;
 struct _QueueManagerStatic {
-    GQueue* packets;
-    guint64 totalSize;
+    RouterQueueRing ring;
 };
 
 static QueueManagerStatic* _routerqueuestatic_new() {
     QueueManagerStatic* queueManager = g_new0(QueueManagerStatic, 1);
 
-    queueManager->packets = g_queue_new();
+    routerqueuering_init(&queueManager->ring, STATIC_PARAM_INITIAL_CAPACITY, G_MAXUINT);
 
     return queueManager;
 }
@@ -30,9 +35,7 @@ static QueueManagerStatic* _routerqueuestatic_new() {
 static void _routerqueuestatic_free(QueueManagerStatic* queueManager) {
     utility_assert(queueManager);
 
-    if(queueManager->packets) {
-        g_queue_free_full(queueManager->packets, (GDestroyNotify)packet_unref);
-    }
+    routerqueuering_clear(&queueManager->ring);
 
     g_free(queueManager);
 }
@@ -46,13 +49,11 @@ static gboolean _routerqueuestatic_enqueue(QueueManagerStatic* queueManager, Pac
     utility_assert(packet);
 
     guint64 length = _routerqueuestatic_getPacketLength(packet);
+    guint64 totalSize = routerqueuering_getTotalSize(&queueManager->ring);
 
-    if(queueManager->totalSize + length < (guint64)STATIC_PARAM_MAXSIZE) {
+    if(totalSize + length < (guint64)STATIC_PARAM_MAXSIZE) {
         /* we will queue the packet */
-        packet_ref(packet);
-        g_queue_push_tail(queueManager->packets, packet);
-        queueManager->totalSize += length;
-        return TRUE;
+        return routerqueuering_push(&queueManager->ring, packet, worker_getCurrentTime());
     } else {
         /* not enough space, this one gets dropped */
         return FALSE;
@@ -63,20 +64,30 @@ static Packet* _routerqueuestatic_dequeue(QueueManagerStatic* queueManager) {
     utility_assert(queueManager);
 
     /* this call transfers the reference that we were holding to the caller */
-    Packet* packet = g_queue_pop_head(queueManager->packets);
+    RouterQueueEntry entry;
+    return routerqueuering_pop(&queueManager->ring, &entry) ? entry.packet : NULL;
+}
+
+static guint _routerqueuestatic_dequeueBatch(QueueManagerStatic* queueManager, Packet** packets,
+                                             guint maxPackets, guint64 byteBudget) {
+    utility_assert(queueManager);
+
+    guint count = 0;
+    RouterQueueEntry entry;
 
-    if(packet) {
-        guint64 length = _routerqueuestatic_getPacketLength(packet);
-        utility_assert(length <= queueManager->totalSize);
-        queueManager->totalSize -= length;
+    while(count < maxPackets && byteBudget >= CONFIG_MTU &&
+          routerqueuering_pop(&queueManager->ring, &entry)) {
+        packets[count++] = entry.packet;
+        byteBudget -= MIN(entry.length, byteBudget);
     }
 
-    return packet;
+    return count;
 }
 
 static Packet* _routerqueuestatic_peek(QueueManagerStatic* queueManager) {
     utility_assert(queueManager);
-    return g_queue_peek_head(queueManager->packets);
+    const RouterQueueEntry* entry = routerqueuering_peek(&queueManager->ring);
+    return entry ? entry->packet : NULL;
 }
 
 static const struct _QueueManagerHooks _routerqueuestatic_hooks = {
@@ -84,7 +95,8 @@ static const struct _QueueManagerHooks _routerqueuestatic_hooks = {
     .free = (QueueManagerFree) _routerqueuestatic_free,
     .enqueue = (QueueManagerEnqueue) _routerqueuestatic_enqueue,
     .dequeue = (QueueManagerDequeue) _routerqueuestatic_dequeue,
-    .peek = (QueueManagerPeek) _routerqueuestatic_peek
+    .peek = (QueueManagerPeek) _routerqueuestatic_peek,
+    .dequeueBatch = (QueueManagerDequeueBatch) _routerqueuestatic_dequeueBatch
 };
 
 const QueueManagerHooks* routerqueuestatic_getHooks() {
@@ -1163,23 +1163,31 @@ static void _topology_clearCache(Topology* top) {
     g_mutex_unlock(&(top->topologyLock));
 }
 
-static Path* _topology_getPathFromCache(Topology* top, igraph_integer_t srcVertexIndex,
+/* the caller must hold the path cache lock */
+static Path* _topology_lookupPathInCache(Topology* top, igraph_integer_t srcVertexIndex,
         igraph_integer_t dstVertexIndex) {
     MAGIC_ASSERT(top);
 
-    Path* path = NULL;
-    g_rw_lock_reader_lock(&(top->pathCacheLock));
-
-    if(top->pathCache) {
-        /* look for the source first level cache */
-        gpointer sourceCache = g_hash_table_lookup(top->pathCache, GINT_TO_POINTER(srcVertexIndex));
+    if(!top->pathCache) {
+        return NULL;
+    }
 
-        if(sourceCache) {
-            /* check for the path to destination in source cache */
-            path = g_hash_table_lookup(sourceCache, GINT_TO_POINTER(dstVertexIndex));
-        }
+    /* look for the source first level cache */
+    gpointer sourceCache = g_hash_table_lookup(top->pathCache, GINT_TO_POINTER(srcVertexIndex));
+    if(!sourceCache) {
+        return NULL;
     }
 
+    /* check for the path to destination in source cache */
+    return g_hash_table_lookup(sourceCache, GINT_TO_POINTER(dstVertexIndex));
+}
+
+static Path* _topology_getPathFromCache(Topology* top, igraph_integer_t srcVertexIndex,
+        igraph_integer_t dstVertexIndex) {
+    MAGIC_ASSERT(top);
+
+    g_rw_lock_reader_lock(&(top->pathCacheLock));
+    Path* path = _topology_lookupPathInCache(top, srcVertexIndex, dstVertexIndex);
     g_rw_lock_reader_unlock(&(top->pathCacheLock));
 
     /* NULL if cache miss */
@@ -1230,6 +1238,14 @@ static void _topology_storePathInCache(Topology* top, gboolean isDirectPath,
 
     g_rw_lock_writer_lock(&(top->pathCacheLock));
 
+    /* another worker may have computed and stored the path since we checked above. routes hold
+     * on to cached paths, so we must keep the existing entry rather than replace (and free) it. */
+    if(_topology_lookupPathInCache(top, srcVertexIndex, dstVertexIndex) ||
+       _topology_lookupPathInCache(top, dstVertexIndex, srcVertexIndex)) {
+        g_rw_lock_writer_unlock(&(top->pathCacheLock));
+        return;
+    }
+
     /* create latency cache on the fly */
     if(!top->pathCache) {
         /* stores hash tables for source address caches */
@@ -1248,7 +1264,7 @@ static void _topology_storePathInCache(Topology* top, gboolean isDirectPath,
 
     /* store it in the cache. don't bother storing the path for the reverse direction,
      * because we can check both directions for this cached path later. */
-    g_hash_table_replace(srcCache, GINT_TO_POINTER(dstVertexIndex), path);
+    g_hash_table_insert(srcCache, GINT_TO_POINTER(dstVertexIndex), path);
 
     /* track the minimum network latency in the entire graph */
     if(top->minimumPathLatency == 0 || latencyMS < top->minimumPathLatency) {
@@ -1992,6 +2008,11 @@ void topology_incrementPathPacketCounter(Topology* top, Address* srcAddress, Add
     }
 }
 
+Path* topology_getPath(Topology* top, Address* srcAddress, Address* dstAddress) {
+    MAGIC_ASSERT(top);
+    return _topology_getPathEntry(top, srcAddress, dstAddress);
+}
+
 gdouble topology_getLatency(Topology* top, Address* srcAddress, Address* dstAddress) {
     MAGIC_ASSERT(top);
 
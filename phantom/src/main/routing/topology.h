@@ -10,6 +10,7 @@
 #include <glib.h>
 
 #include "main/routing/address.h"
+#include "main/routing/path.h"
 #include "main/utility/random.h"
 
 typedef struct _Topology Topology;
@@ -26,5 +27,8 @@ gboolean topology_isRoutable(Topology* top, Address* srcAddress, Address* dstAdd
 gdouble topology_getLatency(Topology* top, Address* srcAddress, Address* dstAddress);
 gdouble topology_getReliability(Topology* top, Address* srcAddress, Address* dstAddress);
 void topology_incrementPathPacketCounter(Topology* top, Address* srcAddress, Address* dstAddress);
+/* the cached path between the addresses. cached paths are never replaced or removed once
+ * stored, so the returned path stays valid until the topology is freed. */
+Path* topology_getPath(Topology* top, Address* srcAddress, Address* dstAddress);
 
 #endif /* SHD_TOPOLOGY_H_ */
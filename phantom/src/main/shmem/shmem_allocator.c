@@ -26,6 +26,19 @@ typedef struct _ShMemFileNode {
 
 static const char *SHMEM_BLOCK_SERIALIZED_STRFMT = "%zu,%zu,%zu,%s";
 
+// Whether new shared memory files are placed on the NUMA node of the thread
+// that allocates them. Set once at startup, before any allocator is used.
+static bool _node_local = false;
+
+static int _shmemallocator_fileAlloc(size_t nbytes, ShMemFile* shmf) {
+    int rc = shmemfile_alloc(nbytes, shmf);
+    if (rc == 0 && _node_local) {
+        // Best effort; the memory is usable either way.
+        shmemfile_bindToLocalNode(shmf);
+    }
+    return rc;
+}
+
 static const ShMemFileNode*
 _shmemfilenode_findPtr(const ShMemFileNode* file_nodes, uint8_t* p) {
 
@@ -70,7 +83,7 @@ typedef struct _ShMemPoolNode {
 static ShMemPoolNode* _shmempoolnode_create() {
 
     ShMemFile shmf;
-    int rc = shmemfile_alloc(SHD_SHMEM_ALLOCATOR_POOL_NBYTES, &shmf);
+    int rc = _shmemallocator_fileAlloc(SHD_SHMEM_ALLOCATOR_POOL_NBYTES, &shmf);
 
     if (rc == -1) {
         return NULL;
@@ -112,36 +125,65 @@ struct _ShMemSerializer {
     pthread_mutex_t mtx;
 };
 
-static ShMemAllocator* _global_allocator = NULL;
+// The global allocator is split into one arena per thread. Every arena is
+// also recorded in `_global_arenas`, so that blocks can be freed or serialized
+// by threads other than the one that allocated them, and so that the arenas can
+// be destroyed at exit.
+static __thread ShMemAllocator* _thread_allocator = NULL;
+static pthread_mutex_t _global_arenas_mtx = PTHREAD_MUTEX_INITIALIZER;
+static ShMemAllocator** _global_arenas = NULL;
+static size_t _global_arenas_len = 0;
 static ShMemSerializer* _global_serializer = NULL;
 
 /*
  * hook used to cleanup at exit.
  */
 static void _shmemallocator_destroyGlobal() {
-    assert(_global_allocator);
-    shmemallocator_destroy(_global_allocator);
+    pthread_mutex_lock(&_global_arenas_mtx);
+    for (size_t i = 0; i < _global_arenas_len; i++) {
+        shmemallocator_destroy(_global_arenas[i]);
+    }
+    free(_global_arenas);
+    _global_arenas = NULL;
+    _global_arenas_len = 0;
+    pthread_mutex_unlock(&_global_arenas_mtx);
 }
 
 ShMemAllocator* shmemallocator_getGlobal() {
-    static pthread_mutex_t mtx = PTHREAD_MUTEX_INITIALIZER;
-    pthread_mutex_lock(&mtx);
+    if (_thread_allocator) {
+        return _thread_allocator;
+    }
 
-    if (!_global_allocator) { // need to initialize
-        _global_allocator = shmemallocator_create();
+    ShMemAllocator* allocator = shmemallocator_create();
 
-        if (!_global_allocator) { // something bad happened, and we definitely can't continue
-            panic("error allocating global shared memory allocator");
-        }
+    if (!allocator) { // something bad happened, and we definitely can't continue
+        panic("error allocating global shared memory allocator");
+    }
+
+    pthread_mutex_lock(&_global_arenas_mtx);
+
+    ShMemAllocator** arenas =
+        realloc(_global_arenas, (_global_arenas_len + 1) * sizeof(*_global_arenas));
+    if (!arenas) {
+        panic("error registering global shared memory allocator");
+    }
 
-        // Destroy the allocator at exit, freeing the underlying shared memory storage.
+    if (_global_arenas_len == 0) {
+        // Destroy the arenas at exit, freeing the underlying shared memory storage.
         atexit(_shmemallocator_destroyGlobal);
     }
 
-    pthread_mutex_unlock(&mtx);
-    return _global_allocator;
+    _global_arenas = arenas;
+    _global_arenas[_global_arenas_len++] = allocator;
+
+    pthread_mutex_unlock(&_global_arenas_mtx);
+
+    _thread_allocator = allocator;
+    return allocator;
 }
 
+void shmemallocator_setNodeLocal(bool node_local) { _node_local = node_local; }
+
 ShMemSerializer* shmemserializer_getGlobal() {
     static pthread_mutex_t mtx = PTHREAD_MUTEX_INITIALIZER;
     pthread_mutex_lock(&mtx);
@@ -214,7 +256,7 @@ static ShMemBlock _shmemallocator_bigAlloc(ShMemAllocator* allocator,
 
     size_t good_size_nbytes = shmemfile_goodSizeNBytes(nbytes);
     ShMemFile shmf;
-    int rc = shmemfile_alloc(good_size_nbytes, &shmf);
+    int rc = _shmemallocator_fileAlloc(good_size_nbytes, &shmf);
 
     if (rc == 0) {
         ShMemFileNode* file_node = calloc(1, sizeof(ShMemFileNode));
@@ -433,6 +475,72 @@ ShMemBlock shmemallocator_blockDeserialize(ShMemAllocator* allocator,
     return ret;
 }
 
+static bool _shmemallocator_ownsPtr(ShMemAllocator* allocator, const void* arg) {
+    const ShMemBlock* blk = arg;
+    pthread_mutex_lock(&allocator->mtx);
+    bool owns = _shmemfilenode_findPtr(allocator->big_alloc_nodes, blk->p) ||
+                _shmemfilenode_findPtr((ShMemFileNode*)allocator->little_alloc_nodes, blk->p);
+    pthread_mutex_unlock(&allocator->mtx);
+    return owns;
+}
+
+static bool _shmemallocator_ownsName(ShMemAllocator* allocator, const void* arg) {
+    const ShMemBlockSerialized* serial = arg;
+    pthread_mutex_lock(&allocator->mtx);
+    bool owns =
+        _shmemfilenode_findName(allocator->big_alloc_nodes, serial->name) ||
+        _shmemfilenode_findName((ShMemFileNode*)allocator->little_alloc_nodes, serial->name);
+    pthread_mutex_unlock(&allocator->mtx);
+    return owns;
+}
+
+// Find the arena of the global allocator that satisfies `owns`, checking the
+// calling thread's arena first since it's almost always the owner.
+static ShMemAllocator*
+_shmemallocator_findGlobalOwner(bool (*owns)(ShMemAllocator*, const void*), const void* arg) {
+    if (_thread_allocator && owns(_thread_allocator, arg)) {
+        return _thread_allocator;
+    }
+
+    ShMemAllocator* owner = NULL;
+
+    pthread_mutex_lock(&_global_arenas_mtx);
+    for (size_t i = 0; i < _global_arenas_len && !owner; i++) {
+        if (_global_arenas[i] != _thread_allocator && owns(_global_arenas[i], arg)) {
+            owner = _global_arenas[i];
+        }
+    }
+    pthread_mutex_unlock(&_global_arenas_mtx);
+
+    if (!owner) {
+        panic("block does not belong to the global shared memory allocator");
+    }
+
+    return owner;
+}
+
+ShMemBlock shmemallocator_globalAlloc(size_t nbytes) {
+    return shmemallocator_alloc(shmemallocator_getGlobal(), nbytes);
+}
+
+void shmemallocator_globalFree(ShMemBlock* blk) {
+    assert(blk);
+    ShMemAllocator* owner = _shmemallocator_findGlobalOwner(_shmemallocator_ownsPtr, blk);
+    shmemallocator_free(owner, blk);
+}
+
+ShMemBlockSerialized shmemallocator_globalBlockSerialize(ShMemBlock* blk) {
+    assert(blk);
+    ShMemAllocator* owner = _shmemallocator_findGlobalOwner(_shmemallocator_ownsPtr, blk);
+    return shmemallocator_blockSerialize(owner, blk);
+}
+
+ShMemBlock shmemallocator_globalBlockDeserialize(ShMemBlockSerialized* serial) {
+    assert(serial);
+    ShMemAllocator* owner = _shmemallocator_findGlobalOwner(_shmemallocator_ownsName, serial);
+    return shmemallocator_blockDeserialize(owner, serial);
+}
+
 ShMemSerializer* shmemserializer_create() {
     ShMemSerializer* serializer = calloc(1, sizeof(ShMemSerializer));
 
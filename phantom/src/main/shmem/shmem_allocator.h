@@ -36,17 +36,33 @@ typedef struct _ShMemBlockSerialized {
 } ShMemBlockSerialized;
 
 /*
- * Returns a pointer to a pre-initialized, process-global shared-memory
- * allocator.  This object is owned by the process: the caller should not call
- * free or destroy.
+ * Returns a pointer to the calling thread's arena of the process-global
+ * shared-memory allocator.  Each thread gets its own arena the first time it
+ * calls this function, so that threads allocating in parallel (e.g. workers
+ * booting hosts) don't contend on a single allocator lock.  This object is
+ * owned by the process: the caller should not call free or destroy.
+ *
+ * Blocks from the global allocator should be freed and serialized with the
+ * shmemallocator_global* functions below, which find the arena that owns the
+ * block, since that need not be the calling thread's.
  *
  * THREAD SAFETY: thread-safe; can be called by two threads in parallel.
  *
- * POST: returns a pointer to the initialized global allocator or aborts if the
- * global serializer could not be created.
+ * POST: returns a pointer to the initialized arena or aborts if it could not
+ * be created.
  */
 ShMemAllocator* shmemallocator_getGlobal();
 
+/*
+ * Sets whether allocators place the shared memory files they create on the
+ * NUMA node of the allocating thread, rather than leaving placement to the
+ * kernel's first-touch policy. Intended for when threads are pinned to CPUs,
+ * so that each thread's arena of the global allocator is local to it.
+ *
+ * THREAD SAFETY: not thread-safe; call before any allocator is used.
+ */
+void shmemallocator_setNodeLocal(bool node_local);
+
 /*
  * Returns a pointer to a pre-initialized, process-global shared-memory
  * serializer.  This object is owned by the process: the caller should not call
@@ -120,9 +136,8 @@ void shmemallocator_destroyNoShmDelete(ShMemAllocator* allocator);
  */
 ShMemBlock shmemallocator_alloc(ShMemAllocator* allocator, size_t nbytes);
 
-static inline ShMemBlock shmemallocator_globalAlloc(size_t nbytes) {
-    return shmemallocator_alloc(shmemallocator_getGlobal(), nbytes);
-}
+// Allocates from the calling thread's arena of the global allocator.
+ShMemBlock shmemallocator_globalAlloc(size_t nbytes);
 
 /*
  * Semantically similar to free(blk->p).  Returns the shared-memory to the
@@ -139,9 +154,8 @@ static inline ShMemBlock shmemallocator_globalAlloc(size_t nbytes) {
  */
 void shmemallocator_free(ShMemAllocator* allocator, ShMemBlock* blk);
 
-static inline void shmemallocator_globalFree(ShMemBlock* blk) {
-    return shmemallocator_free(shmemallocator_getGlobal(), blk);
-}
+// Frees a block allocated by any thread's arena of the global allocator.
+void shmemallocator_globalFree(ShMemBlock* blk);
 
 /*
  * Converts a ShMemBlock created by an allocator into a format that is
@@ -161,10 +175,8 @@ static inline void shmemallocator_globalFree(ShMemBlock* blk) {
 ShMemBlockSerialized shmemallocator_blockSerialize(ShMemAllocator* allocator,
                                                    ShMemBlock* blk);
 
-static inline ShMemBlockSerialized
-shmemallocator_globalBlockSerialize(ShMemBlock* blk) {
-    return shmemallocator_blockSerialize(shmemallocator_getGlobal(), blk);
-}
+// Serializes a block allocated by any thread's arena of the global allocator.
+ShMemBlockSerialized shmemallocator_globalBlockSerialize(ShMemBlock* blk);
 
 /*
  * Converts a valid ShMemBlockSerialized to a valid ShMemBlock.
@@ -185,10 +197,9 @@ shmemallocator_globalBlockSerialize(ShMemBlock* blk) {
 ShMemBlock shmemallocator_blockDeserialize(ShMemAllocator* allocator,
                                            ShMemBlockSerialized* serial);
 
-static inline ShMemBlock
-shmemallocator_globalBlockDeserialize(ShMemBlockSerialized* serial) {
-    return shmemallocator_blockDeserialize(shmemallocator_getGlobal(), serial);
-}
+// Deserializes a block allocated by any thread's arena of the global
+// allocator.
+ShMemBlock shmemallocator_globalBlockDeserialize(ShMemBlockSerialized* serial);
 
 /*
  * Heap-allocate and initialize a shared-memory serializer.
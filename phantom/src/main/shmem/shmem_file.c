@@ -12,9 +12,11 @@
 #include <time.h>
 
 #include <fcntl.h>
+#include <linux/mempolicy.h>
 #include <sys/mman.h>
 #include <sys/param.h>
 #include <sys/stat.h>
+#include <sys/syscall.h>
 #include <unistd.h>
 
 #include "lib/logger/logger.h"
@@ -25,6 +27,26 @@ static const char PID_DELIM = '-';
 
 const static int SHMEM_PERMISSION_BITS = S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP;
 
+static bool _use_huge_pages = false;
+
+void shmemfile_setUseHugePages(bool use_huge_pages) { _use_huge_pages = use_huge_pages; }
+
+static void _shmemfile_adviseHugePages(ShMemFile* shmf) {
+    if (!_use_huge_pages || shmf->nbytes < SHD_SHMEM_FILE_HUGE_PAGE_NBYTES) {
+        return;
+    }
+
+    // Fails with EINVAL if the kernel was built without transparent huge
+    // pages, in which case the mapping keeps using regular pages.
+    if (madvise(shmf->p, shmf->nbytes, MADV_HUGEPAGE) != 0) {
+        static bool logged = false;
+        if (!logged) {
+            logged = true;
+            debug("unable to use huge pages for %s: %s", shmf->name, strerror(errno));
+        }
+    }
+}
+
 static void _shmemfile_getName(size_t nbytes, char* str) {
     assert(str != NULL && nbytes >= 3);
 
@@ -104,6 +126,7 @@ int shmemfile_alloc(size_t nbytes, ShMemFile* shmf) {
             if (p != MAP_FAILED) {
                 shmf->p = p;
                 shmf->nbytes = nbytes;
+                _shmemfile_adviseHugePages(shmf);
             } else {
                 panic("error on mmap: %s", strerror(errno));
                 bad = true;
@@ -159,6 +182,7 @@ int shmemfile_map(const char* name, size_t nbytes, ShMemFile* shmf) {
         if (p != MAP_FAILED) {
             shmf->p = p;
             shmf->nbytes = nbytes;
+            _shmemfile_adviseHugePages(shmf);
         } else {
             panic("error on mmap: %s", strerror(errno));
             bad = true;
@@ -198,6 +222,29 @@ int shmemfile_free(ShMemFile* shmf) {
     return rc;
 }
 
+int shmemfile_bindToLocalNode(ShMemFile* shmf) {
+    // Enough for the 1024 nodes that the kernel supports by default.
+    unsigned long nodemask[1024 / (8 * sizeof(unsigned long))] = {0};
+    const size_t max_nodes = 8 * sizeof(nodemask);
+
+    unsigned cpu = 0, node = 0;
+    if (syscall(SYS_getcpu, &cpu, &node, NULL) != 0 || node >= max_nodes) {
+        return -1;
+    }
+    nodemask[node / (8 * sizeof(unsigned long))] |= 1UL << (node % (8 * sizeof(unsigned long)));
+
+    // For a shared mapping the policy is attached to the file, so it also
+    // applies to the pages that other processes fault in first. MPOL_PREFERRED
+    // falls back to other nodes when the local node is out of memory.
+    if (syscall(SYS_mbind, shmf->p, shmf->nbytes, MPOL_PREFERRED, nodemask, max_nodes, 0) !=
+        0) {
+        debug("unable to bind %s to NUMA node %u: %s", shmf->name, node, strerror(errno));
+        return -1;
+    }
+
+    return 0;
+}
+
 size_t shmemfile_goodSizeNBytes(size_t requested_nbytes) {
     return _shmemfile_roundUpToMultiple(
         requested_nbytes, _shmemfile_systemPageNBytes());
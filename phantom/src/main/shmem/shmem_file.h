@@ -10,6 +10,9 @@
 
 #define SHD_SHMEM_FILE_NAME_NBYTES (NAME_MAX < 256 ? NAME_MAX : 256)
 
+// The size of a transparent huge page on x86-64.
+#define SHD_SHMEM_FILE_HUGE_PAGE_NBYTES (2 << 20)
+
 typedef struct _ShMemFile {
     void *p;
     size_t nbytes;
@@ -21,6 +24,14 @@ typedef struct _ShMemFile {
 extern "C" {
 #endif
 
+// Sets whether shmemfile_alloc and shmemfile_map advise the kernel to back
+// mappings of at least SHD_SHMEM_FILE_HUGE_PAGE_NBYTES with transparent huge
+// pages. This only takes effect if the tmpfs at /dev/shm allows huge pages
+// (its `huge=` mount option is `advise`, `within_size` or `always`);
+// otherwise the files keep using regular pages. Set once per process, before
+// any files are allocated or mapped.
+void shmemfile_setUseHugePages(bool use_huge_pages);
+
 bool shmemfile_nameHasShadowPrefix(const char *name);
 pid_t shmemfile_pidFromName(const char *name);
 
@@ -31,6 +42,11 @@ int shmemfile_unmap(ShMemFile *shmf);
 
 int shmemfile_free(ShMemFile *shmf);
 
+// Prefer to place the not-yet-touched pages of shmf on the NUMA node that the
+// calling thread is running on. Returns 0 on success, or -1 if the policy
+// couldn't be set, in which case the kernel's default placement applies.
+int shmemfile_bindToLocalNode(ShMemFile *shmf);
+
 size_t shmemfile_goodSizeNBytes(size_t requested_nbytes);
 
 #ifdef __cplusplus
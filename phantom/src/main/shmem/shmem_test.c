@@ -12,6 +12,7 @@
 #include <string.h>
 
 #include <glib.h>
+#include <pthread.h>
 #include <sys/types.h>
 #include <sys/wait.h>
 #include <unistd.h>
@@ -214,6 +215,59 @@ static void shmemfile_testGoodAlloc() {
     shmemfile_implTestGoodAlloc(SHD_BUDDY_POOL_MAX_NBYTES);
 }
 
+// Returns the kB of the mapping at `p` that are mapped with huge pages.
+static size_t shmemfile_hugePmdMappedKB(const void* p) {
+    FILE* smaps = fopen("/proc/self/smaps", "r");
+    g_assert_nonnull(smaps);
+
+    char line[512];
+    bool in_mapping = false;
+    size_t kb = 0;
+    while (fgets(line, sizeof(line), smaps)) {
+        unsigned long start, end;
+        if (sscanf(line, "%lx-%lx ", &start, &end) == 2) {
+            in_mapping = (uintptr_t)p >= start && (uintptr_t)p < end;
+        } else if (in_mapping) {
+            sscanf(line, "ShmemPmdMapped: %zu kB", &kb);
+        }
+    }
+
+    fclose(smaps);
+    return kb;
+}
+
+// Touches every page of a pool-sized file, returning the elapsed microseconds.
+static gint64 shmemfile_implTestHugePages(bool use_huge_pages, size_t* huge_kb) {
+    shmemfile_setUseHugePages(use_huge_pages);
+
+    ShMemFile shmf;
+    g_assert_cmpint(shmemfile_alloc(SHD_BUDDY_POOL_MAX_NBYTES, &shmf), ==, 0);
+
+    gint64 start = g_get_monotonic_time();
+    for (size_t offset = 0; offset < shmf.nbytes; offset += 4096) {
+        ((volatile uint8_t*)shmf.p)[offset] = 1;
+    }
+    gint64 elapsed = g_get_monotonic_time() - start;
+
+    *huge_kb = shmemfile_hugePmdMappedKB(shmf.p);
+    g_assert_cmpint(shmemfile_free(&shmf), ==, 0);
+    shmemfile_setUseHugePages(false);
+    return elapsed;
+}
+
+static void shmemfile_testHugePages() {
+    // Huge pages are only a hint, which the kernel ignores unless /dev/shm
+    // allows them, so this only checks that advising them is harmless, and
+    // reports the difference. Run with --verbose to see it.
+    size_t regular_kb = 0, huge_kb = 0;
+    gint64 regular_us = shmemfile_implTestHugePages(false, &regular_kb);
+    gint64 huge_us = shmemfile_implTestHugePages(true, &huge_kb);
+
+    g_test_message("touching %d MiB took %" G_GINT64_FORMAT " us with regular pages (%zu kB "
+                   "mapped huge), and %" G_GINT64_FORMAT " us with huge pages advised (%zu kB)",
+                   SHD_BUDDY_POOL_MAX_NBYTES >> 20, regular_us, regular_kb, huge_us, huge_kb);
+}
+
 static void shmemutil_testLog2() {
     for (uint32_t idx = 1; idx < 32000; ++idx) {
         uint32_t lhs = log2(idx);
@@ -324,6 +378,56 @@ static void shmemallocator_testSerial() {
     free(blks);
 }
 
+static void* shmemallocator_globalAllocThread(void* arg) {
+    ShMemBlock* blk = arg;
+    *blk = shmemallocator_globalAlloc(1024);
+    return shmemallocator_getGlobal();
+}
+
+static void shmemallocator_testGlobalArenas() {
+    // A block allocated from another thread's arena can be serialized,
+    // deserialized, and freed from this one.
+    ShMemBlock x;
+    void* other_arena = NULL;
+    pthread_t thread;
+    g_assert_cmpint(pthread_create(&thread, NULL, shmemallocator_globalAllocThread, &x), ==, 0);
+    g_assert_cmpint(pthread_join(thread, &other_arena), ==, 0);
+    g_assert_nonnull(x.p);
+    g_assert_true(other_arena != shmemallocator_getGlobal());
+
+    ShMemBlockSerialized serial = shmemallocator_globalBlockSerialize(&x);
+    ShMemBlock y = shmemallocator_globalBlockDeserialize(&serial);
+    g_assert_cmpmem(&x, sizeof(x), &y, sizeof(y));
+
+    // This thread's own blocks still come from its own arena.
+    ShMemBlock z = shmemallocator_globalAlloc(1024);
+    g_assert_nonnull(z.p);
+    g_assert_true(z.p != x.p);
+
+    shmemallocator_globalFree(&x);
+    shmemallocator_globalFree(&z);
+}
+
+static void shmemallocator_testNodeLocal() {
+    // Node-local placement is only a hint, so allocation must work whether or
+    // not the kernel accepts it.
+    shmemallocator_setNodeLocal(true);
+    ShMemAllocator* allocator = shmemallocator_create();
+    g_assert_nonnull(allocator);
+
+    ShMemBlock little = shmemallocator_alloc(allocator, 1024);
+    ShMemBlock big = shmemallocator_alloc(allocator, SHD_BUDDY_POOL_MAX_NBYTES);
+    g_assert_nonnull(little.p);
+    g_assert_nonnull(big.p);
+    memset(little.p, 0xAB, little.nbytes);
+    memset(big.p, 0xAB, big.nbytes);
+
+    shmemallocator_free(allocator, &little);
+    shmemallocator_free(allocator, &big);
+    shmemallocator_destroy(allocator);
+    shmemallocator_setNodeLocal(false);
+}
+
 static ShMemSerializer* shmemserialzer_getWarm(ShMemAllocator* allocator,
                                                ShMemBlock* blks) {
     ShMemSerializer* serializer = shmemserializer_create();
@@ -592,6 +696,13 @@ int main(int argc, char** argv) {
                shmemfile_testGoodAlloc,
                NULL);
 
+    g_test_add("/shmem/shmemfile_testHugePages",
+               void,
+               NULL,
+               NULL,
+               shmemfile_testHugePages,
+               NULL);
+
     /* shmemutil tests */
 
     g_test_add("/shmem/shmemutil_testLog2",
@@ -624,6 +735,20 @@ int main(int argc, char** argv) {
                shmemallocator_testSerial,
                NULL);
 
+    g_test_add("/shmem/shmemallocator_testGlobalArenas",
+               void,
+               NULL,
+               NULL,
+               shmemallocator_testGlobalArenas,
+               NULL);
+
+    g_test_add("/shmem/shmemallocator_testNodeLocal",
+               void,
+               NULL,
+               NULL,
+               shmemallocator_testNodeLocal,
+               NULL);
+
     g_test_add("/shmem/shmemblockserialized_testString",
                void,
                NULL,
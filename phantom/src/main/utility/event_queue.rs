@@ -46,8 +46,9 @@ impl EventQueue {
     }
 }
 
+// Ids are never reused, so listeners are stored in increasing id order.
 #[derive(Clone, Copy, PartialEq, PartialOrd)]
-struct HandleId(u32);
+struct HandleId(u64);
 
 /// A handle allows you to stop listening for events.
 pub struct Handle<T> {
@@ -91,38 +92,64 @@ impl<T: Clone + Copy + 'static> EventSource<T> {
     }
 
     pub fn notify_listeners(&mut self, message: T, event_queue: &mut EventQueue) {
-        for (_, l) in &self.inner.borrow().listeners {
-            let l_clone = l.clone();
-            event_queue.add(move |event_queue| (l_clone)(message, event_queue));
-        }
+        let (first, end) = {
+            let inner = self.inner.borrow();
+            match inner.listeners.first() {
+                Some((id, _)) => (*id, HandleId(inner.next_id)),
+                None => return,
+            }
+        };
+
+        // Notify the listeners from a single event rather than queueing one event per listener.
+        // The listeners may add or remove listeners from this source, so we don't hold the borrow
+        // while calling them, and we find the next listener by id. Listeners added after this
+        // notification aren't called, and listeners removed before their turn aren't called.
+        let inner = Arc::clone(&self.inner);
+        event_queue.add(move |event_queue| {
+            let mut next = first;
+            loop {
+                let l = match inner.borrow().next_listener(next, end) {
+                    Some((id, l)) => {
+                        next = HandleId(id.0 + 1);
+                        Arc::clone(l)
+                    }
+                    None => break,
+                };
+                (l)(message, event_queue);
+            }
+        });
     }
 }
 
 struct EventSourceInner<T> {
-    listeners: std::vec::Vec<(HandleId, Arc<Box<dyn Fn(T, &mut EventQueue) + Send + Sync>>)>,
-    next_id: std::num::Wrapping<u32>,
+    listeners: std::vec::Vec<(HandleId, Listener<T>)>,
+    next_id: u64,
 }
 
+type Listener<T> = Arc<Box<dyn Fn(T, &mut EventQueue) + Send + Sync>>;
+
 impl<T> EventSourceInner<T> {
     pub fn new() -> Self {
         Self {
             listeners: std::vec::Vec::new(),
-            next_id: std::num::Wrapping(0),
+            next_id: 0,
         }
     }
 
     fn get_unused_id(&mut self) -> HandleId {
-        // it's very unlikely that there will be collisions, but we loop anyways since we
-        // don't care about worst-case performance here
-        let handle_id = loop {
-            let id = HandleId(self.next_id.0);
-            self.next_id += std::num::Wrapping(1);
-
-            if !self.listeners.iter().any(|x| x.0 == id) {
-                break id;
-            }
-        };
-        handle_id
+        // a u64 counter won't wrap, so ids are unique and increasing
+        let id = HandleId(self.next_id);
+        self.next_id += 1;
+        id
+    }
+
+    /// The first listener with an id in `[from, end)`.
+    fn next_listener(&self, from: HandleId, end: HandleId) -> Option<(HandleId, &Listener<T>)> {
+        self.listeners
+            .iter()
+            .find(|x| x.0 >= from)
+            .filter(|x| x.0 < end)
+            .map(|x| (x.0, &x.1))
     }
 
     pub fn add_listener(
@@ -169,4 +196,30 @@ mod tests {
 
         assert_eq!(*counter.borrow(), 4);
     }
+
+    #[test]
+    fn test_eventsource_remove_during_notify() {
+        let counter = Arc::new(AtomicRefCell::new(0u32));
+
+        let mut source = EventSource::new();
+
+        // the first listener drops the second listener's handle when notified
+        let second: Arc<AtomicRefCell<Option<Handle<u32>>>> = Arc::new(AtomicRefCell::new(None));
+        let second_clone = Arc::clone(&second);
+        let counter_clone = Arc::clone(&counter);
+        let _first = source.add_listener(move |inc, _| {
+            *counter_clone.borrow_mut() += inc;
+            second_clone.borrow_mut().take();
+        });
+
+        let counter_clone = Arc::clone(&counter);
+        *second.borrow_mut() = Some(source.add_listener(move |inc, _| {
+            *counter_clone.borrow_mut() += 10 * inc;
+        }));
+
+        EventQueue::queue_and_run(|queue| source.notify_listeners(1, queue));
+        EventQueue::queue_and_run(|queue| source.notify_listeners(1, queue));
+
+        assert_eq!(*counter.borrow(), 2);
+    }
 }
@@ -5,139 +5,279 @@
 
 #include "main/utility/pcap_writer.h"
 
-#include <stdio.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
 
 #include "lib/logger/logger.h"
 #include "main/core/support/definitions.h"
 #include "main/core/worker.h"
 #include "main/host/host.h"
+#include "main/utility/utility.h"
+
+/* records are collected here and written out in one syscall when it fills up */
+#define PCAP_BUFFER_SIZE (256 * 1024)
+
+/* what we put in the file header when the user did not ask for a capture size */
+#define PCAP_DEFAULT_SNAPLEN 65535
+
+/* ethernet (14) + ipv4 (20) + tcp with 12 bytes of options (32) */
+#define PCAP_FRAME_HEADER_SIZE 66
+
+/* the largest record header we build: a pcapng enhanced packet block header */
+#define PCAP_RECORD_HEADER_MAX_SIZE 28
+
+#define PCAPNG_BLOCK_TYPE_SHB 0x0A0D0D0A
+#define PCAPNG_BLOCK_TYPE_IDB 0x00000001
+#define PCAPNG_BLOCK_TYPE_EPB 0x00000006
+#define PCAPNG_OPTION_END 0
+#define PCAPNG_OPTION_IF_NAME 2
+#define PCAPNG_OPTION_IF_TSRESOL 9
 
 struct _PCapWriter {
-    FILE *pcapFile;
+    gint fd;
+    gboolean useNg;
+    /* max bytes of each frame that we store, 0 for unlimited */
+    guint32 captureSize;
+
+    guint8* buffer;
+    gsize bufferLength;
 };
 
-static void _pcapwriter_writeHeader(PCapWriter* pcap) {
-    guint32 magic_number;   /* magic number */
-    guint16 version_major;  /* major version number */
-    guint16 version_minor;  /* minor version number */
-    gint32  thiszone;       /* GMT to local correction */
-    guint32 sigfigs;        /* accuracy of timestamps */
-    guint32 snaplen;        /* max length of captured packets, in octets */
-    guint32 network;        /* data link type */
-
-    magic_number = 0xA1B2C3D4;
-    version_major = 2;
-    version_minor = 4;
-    thiszone = 0;
-    sigfigs = 0;
-    snaplen = 65535;
-    network = 1;
-
-    fwrite(&magic_number, 1, sizeof(magic_number), pcap->pcapFile);
-    fwrite(&version_major, 1, sizeof(version_major), pcap->pcapFile);
-    fwrite(&version_minor, 1, sizeof(version_minor), pcap->pcapFile);
-    fwrite(&thiszone, 1, sizeof(thiszone), pcap->pcapFile);
-    fwrite(&sigfigs, 1, sizeof(sigfigs), pcap->pcapFile);
-    fwrite(&snaplen, 1, sizeof(snaplen), pcap->pcapFile);
-    fwrite(&network, 1, sizeof(network), pcap->pcapFile);
+static inline guint8* _pcapwriter_put8(guint8* p, guint8 value) {
+    *p = value;
+    return p + 1;
 }
 
-void pcapwriter_writePacket(PCapWriter* pcap, PCapPacket* packet) {
-    if(!pcap || !pcap->pcapFile || !packet) {
-        return;
+static inline guint8* _pcapwriter_put16(guint8* p, guint16 value) {
+    memcpy(p, &value, sizeof(value));
+    return p + sizeof(value);
+}
+
+static inline guint8* _pcapwriter_put32(guint8* p, guint32 value) {
+    memcpy(p, &value, sizeof(value));
+    return p + sizeof(value);
+}
+
+static inline guint8* _pcapwriter_putBytes(guint8* p, const void* bytes, gsize length) {
+    memcpy(p, bytes, length);
+    return p + length;
+}
+
+static inline gsize _pcapwriter_pad32(gsize length) { return (length + 3) & ~((gsize)3); }
+
+static void _pcapwriter_flush(PCapWriter* pcap) {
+    gsize offset = 0;
+
+    while(offset < pcap->bufferLength) {
+        ssize_t written = write(pcap->fd, pcap->buffer + offset, pcap->bufferLength - offset);
+        if(written < 0) {
+            if(errno == EINTR) {
+                continue;
+            }
+            warning("error writing PCAP data: %s", g_strerror(errno));
+            break;
+        }
+        offset += (gsize)written;
     }
 
-    guint32 ts_sec;         /* timestamp seconds */
-    guint32 ts_usec;        /* timestamp microseconds */
-    guint32 incl_len;       /* number of octets of packet saved in file */
-    guint32 orig_len;       /* actual length of packet */
+    pcap->bufferLength = 0;
+}
+
+/* returns a pointer to length free bytes at the end of the buffer */
+static guint8* _pcapwriter_reserve(PCapWriter* pcap, gsize length) {
+    utility_assert(length <= PCAP_BUFFER_SIZE);
 
-    /* get the current time that the packet is being sent/received */
-    SimulationTime now = worker_getCurrentTime();
-    ts_sec = now / SIMTIME_ONE_SECOND;
-    ts_usec = (now % SIMTIME_ONE_SECOND) / SIMTIME_ONE_MICROSECOND;
-
-    /* get the header and payload lengths */
-    guint headerSize = packet->headerSize;
-    guint payloadLength = packet->payloadLength;
-    incl_len = headerSize + payloadLength;
-    orig_len = headerSize + payloadLength;
-
-    /* write the PCAP packet header to the pcap file */
-    fwrite(&ts_sec, sizeof(ts_sec), 1, pcap->pcapFile);
-    fwrite(&ts_usec, sizeof(ts_usec), 1, pcap->pcapFile);
-    fwrite(&incl_len, sizeof(incl_len), 1, pcap->pcapFile);
-    fwrite(&orig_len, sizeof(orig_len), 1, pcap->pcapFile);
-
-    /* write the ethernet header */
-    guint8 destinationMAC[6] = {0x01, 0x23, 0x45, 0x67, 0x89, 0xAB};
-    guint8 sourceMAC[6] = {0xA1, 0xB2, 0xC3, 0xD4, 0xE5, 0xF6};
-    guint16 type = htons(0x0800);
-
-    fwrite(destinationMAC, 1, sizeof(destinationMAC), pcap->pcapFile);
-    fwrite(sourceMAC, 1, sizeof(sourceMAC), pcap->pcapFile);
-    fwrite(&type, 1, sizeof(type), pcap->pcapFile);
-
-    /* write the IP header */
-    guint8 versionAndHeaderLength = 0x45;
-    guint8 fields = 0x00;
-    guint16 totalLength = htons(orig_len - 14);
-    guint16 identification = 0x0000;
-    guint16 flagsAndFragment = 0x0040;
-    guint8 timeToLive = 64;
-    guint8 protocol = 6;  /* TCP */
-    guint16 headerChecksum = 0x0000;
-    guint32 sourceIP = packet->srcIP;
-    guint32 destinationIP = packet->dstIP;
-
-    fwrite(&versionAndHeaderLength, 1, sizeof(versionAndHeaderLength), pcap->pcapFile);
-    fwrite(&fields, 1, sizeof(fields), pcap->pcapFile);
-    fwrite(&totalLength, 1, sizeof(totalLength), pcap->pcapFile);
-    fwrite(&identification, 1, sizeof(identification), pcap->pcapFile);
-    fwrite(&flagsAndFragment, 1, sizeof(flagsAndFragment), pcap->pcapFile);
-    fwrite(&timeToLive, 1, sizeof(timeToLive), pcap->pcapFile);
-    fwrite(&protocol, 1, sizeof(protocol), pcap->pcapFile);
-    fwrite(&headerChecksum, 1, sizeof(headerChecksum), pcap->pcapFile);
-    fwrite(&sourceIP, 1, sizeof(sourceIP), pcap->pcapFile);
-    fwrite(&destinationIP, 1, sizeof(destinationIP), pcap->pcapFile);
-
-
-    /* write the TCP header */
-    guint16 sourcePort = packet->srcPort;
-    guint16 destinationPort = packet->dstPort;
-    guint32 sequence = htonl(packet->seq);
-    guint32 acknowledgement = 0;
-    if(packet->ackFlag) {
-        acknowledgement = htonl(packet->ack);
+    if(!pcap->buffer) {
+        pcap->buffer = g_malloc(PCAP_BUFFER_SIZE);
     }
-    guint8 headerLength = 0x80;
+    if(pcap->bufferLength + length > PCAP_BUFFER_SIZE) {
+        _pcapwriter_flush(pcap);
+    }
+
+    guint8* p = pcap->buffer + pcap->bufferLength;
+    pcap->bufferLength += length;
+    return p;
+}
+
+static guint32 _pcapwriter_getSnaplen(PCapWriter* pcap) {
+    return pcap->captureSize > 0 ? pcap->captureSize : PCAP_DEFAULT_SNAPLEN;
+}
+
+static void _pcapwriter_writeHeader(PCapWriter* pcap) {
+    guint8* p = _pcapwriter_reserve(pcap, 24);
+
+    p = _pcapwriter_put32(p, 0xA1B2C3D4); /* magic number */
+    p = _pcapwriter_put16(p, 2);          /* major version number */
+    p = _pcapwriter_put16(p, 4);          /* minor version number */
+    p = _pcapwriter_put32(p, 0);          /* GMT to local correction */
+    p = _pcapwriter_put32(p, 0);          /* accuracy of timestamps */
+    p = _pcapwriter_put32(p, _pcapwriter_getSnaplen(pcap)); /* max length of captured packets */
+    p = _pcapwriter_put32(p, 1);          /* data link type */
+}
+
+static void _pcapwriter_writeHeaderNg(PCapWriter* pcap, const gchar* interfaceName) {
+    /* section header block */
+    guint8* p = _pcapwriter_reserve(pcap, 28);
+    p = _pcapwriter_put32(p, PCAPNG_BLOCK_TYPE_SHB);
+    p = _pcapwriter_put32(p, 28);
+    p = _pcapwriter_put32(p, 0x1A2B3C4D); /* byte-order magic */
+    p = _pcapwriter_put16(p, 1);          /* major version */
+    p = _pcapwriter_put16(p, 0);          /* minor version */
+    p = _pcapwriter_put32(p, G_MAXUINT32); /* section length unknown (-1) */
+    p = _pcapwriter_put32(p, G_MAXUINT32);
+    p = _pcapwriter_put32(p, 28);
+
+    /* interface description block, with our name and nanosecond timestamps */
+    gsize nameLength = MIN(strlen(interfaceName), G_MAXUINT16);
+    gsize blockLength = 16 + (4 + _pcapwriter_pad32(nameLength)) + (4 + 4) + 4 + 4;
+
+    guint8* block = _pcapwriter_reserve(pcap, blockLength);
+    memset(block, 0, blockLength);
+    p = block;
+    p = _pcapwriter_put32(p, PCAPNG_BLOCK_TYPE_IDB);
+    p = _pcapwriter_put32(p, (guint32)blockLength);
+    p = _pcapwriter_put16(p, 1); /* ethernet */
+    p = _pcapwriter_put16(p, 0);
+    p = _pcapwriter_put32(p, _pcapwriter_getSnaplen(pcap));
+
+    p = _pcapwriter_put16(p, PCAPNG_OPTION_IF_NAME);
+    p = _pcapwriter_put16(p, (guint16)nameLength);
+    _pcapwriter_putBytes(p, interfaceName, nameLength);
+    p += _pcapwriter_pad32(nameLength);
+
+    p = _pcapwriter_put16(p, PCAPNG_OPTION_IF_TSRESOL);
+    p = _pcapwriter_put16(p, 1);
+    p = _pcapwriter_put8(p, 9);
+    p += 3;
+
+    p = _pcapwriter_put16(p, PCAPNG_OPTION_END);
+    p = _pcapwriter_put16(p, 0);
+    p = _pcapwriter_put32(p, (guint32)blockLength);
+
+    utility_assert(p == block + blockLength);
+}
+
+/* the fake ethernet/ipv4/tcp header that precedes the payload of each frame */
+static void _pcapwriter_buildFrameHeader(guint8* header, PCapPacket* packet, guint32 frameLength) {
+    guint8* p = header;
+
+    /* the ethernet header */
+    static const guint8 destinationMAC[6] = {0x01, 0x23, 0x45, 0x67, 0x89, 0xAB};
+    static const guint8 sourceMAC[6] = {0xA1, 0xB2, 0xC3, 0xD4, 0xE5, 0xF6};
+    p = _pcapwriter_putBytes(p, destinationMAC, sizeof(destinationMAC));
+    p = _pcapwriter_putBytes(p, sourceMAC, sizeof(sourceMAC));
+    p = _pcapwriter_put16(p, htons(0x0800));
+
+    /* the IP header */
+    p = _pcapwriter_put8(p, 0x45);                       /* version and header length */
+    p = _pcapwriter_put8(p, 0x00);                       /* fields */
+    p = _pcapwriter_put16(p, htons(frameLength - 14));   /* total length */
+    p = _pcapwriter_put16(p, 0x0000);                    /* identification */
+    p = _pcapwriter_put16(p, 0x0040);                    /* flags and fragment */
+    p = _pcapwriter_put8(p, 64);                         /* time to live */
+    p = _pcapwriter_put8(p, 6);                          /* protocol is TCP */
+    p = _pcapwriter_put16(p, 0x0000);                    /* header checksum */
+    p = _pcapwriter_put32(p, packet->srcIP);
+    p = _pcapwriter_put32(p, packet->dstIP);
+
+    /* the TCP header */
     guint8 tcpFlags = 0;
     if(packet->rstFlag) tcpFlags |= 0x04;
     if(packet->synFlag) tcpFlags |= 0x02;
     if(packet->ackFlag) tcpFlags |= 0x10;
     if(packet->finFlag) tcpFlags |= 0x01;
-    guint16 window = htons(packet->win);
-    guint16 tcpChecksum = 0x0000;
-    guint8 options[14] = {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
-
-    fwrite(&sourcePort, 1, sizeof(sourcePort), pcap->pcapFile);
-    fwrite(&destinationPort, 1, sizeof(destinationPort), pcap->pcapFile);
-    fwrite(&sequence, 1, sizeof(sequence), pcap->pcapFile);
-    fwrite(&acknowledgement, 1, sizeof(acknowledgement), pcap->pcapFile);
-    fwrite(&headerLength, 1, sizeof(headerLength), pcap->pcapFile);
-    fwrite(&tcpFlags, 1, sizeof(tcpFlags), pcap->pcapFile);
-    fwrite(&window, 1, sizeof(window), pcap->pcapFile);
-    fwrite(&tcpChecksum, 1, sizeof(tcpChecksum), pcap->pcapFile);
-    fwrite(options, 1, sizeof(options), pcap->pcapFile);
-
-    /* write payload data */
-    if(payloadLength > 0 && packet->payload) {
-        fwrite(packet->payload, 1, payloadLength, pcap->pcapFile);
+
+    p = _pcapwriter_put16(p, packet->srcPort);
+    p = _pcapwriter_put16(p, packet->dstPort);
+    p = _pcapwriter_put32(p, htonl(packet->seq));
+    p = _pcapwriter_put32(p, packet->ackFlag ? htonl(packet->ack) : 0);
+    p = _pcapwriter_put8(p, 0x80);                       /* header length */
+    p = _pcapwriter_put8(p, tcpFlags);
+    p = _pcapwriter_put16(p, htons(packet->win));
+    p = _pcapwriter_put16(p, 0x0000);                    /* checksum */
+    memset(p, 0, 14);                                    /* options */
+    p += 14;
+
+    utility_assert(p - header == PCAP_FRAME_HEADER_SIZE);
+}
+
+void pcapwriter_writePacket(PCapWriter* pcap, PCapPacket* packet) {
+    if(!pcap || pcap->fd < 0 || !packet) {
+        return;
     }
+
+    /* get the current time that the packet is being sent/received */
+    SimulationTime now = worker_getCurrentTime();
+
+    /* figure out how much of the frame we are going to keep */
+    guint32 frameLength = PCAP_FRAME_HEADER_SIZE + packet->payloadLength;
+    guint32 capturedLength = frameLength;
+    if(pcap->captureSize > 0) {
+        capturedLength = MIN(capturedLength, pcap->captureSize);
+    }
+    capturedLength =
+        MIN(capturedLength, PCAP_BUFFER_SIZE - PCAP_RECORD_HEADER_MAX_SIZE - 2 * sizeof(guint32));
+
+    guint8 frameHeader[PCAP_FRAME_HEADER_SIZE];
+    _pcapwriter_buildFrameHeader(frameHeader, packet, frameLength);
+
+    gsize recordLength = pcap->useNg ? 28 + _pcapwriter_pad32(capturedLength) + 4
+                                     : 16 + capturedLength;
+    guint8* record = _pcapwriter_reserve(pcap, recordLength);
+    guint8* p = record;
+
+    if(pcap->useNg) {
+        /* enhanced packet block, with nanosecond timestamps as announced in the IDB */
+        p = _pcapwriter_put32(p, PCAPNG_BLOCK_TYPE_EPB);
+        p = _pcapwriter_put32(p, (guint32)recordLength);
+        p = _pcapwriter_put32(p, 0); /* interface id */
+        p = _pcapwriter_put32(p, (guint32)(now >> 32));
+        p = _pcapwriter_put32(p, (guint32)now);
+        p = _pcapwriter_put32(p, capturedLength);
+        p = _pcapwriter_put32(p, frameLength);
+    } else {
+        p = _pcapwriter_put32(p, (guint32)(now / SIMTIME_ONE_SECOND));
+        p = _pcapwriter_put32(p, (guint32)((now % SIMTIME_ONE_SECOND) / SIMTIME_ONE_MICROSECOND));
+        p = _pcapwriter_put32(p, capturedLength);
+        p = _pcapwriter_put32(p, frameLength);
+    }
+
+    guint32 headerBytes = MIN(capturedLength, PCAP_FRAME_HEADER_SIZE);
+    p = _pcapwriter_putBytes(p, frameHeader, headerBytes);
+
+    /* copy only the payload bytes we keep, directly from the packet into the buffer */
+    guint32 payloadBytes = capturedLength - headerBytes;
+    if(payloadBytes > 0) {
+        guint copied = 0;
+        if(packet->copyPayload) {
+            copied = packet->copyPayload(packet->payloadSource, 0, p, payloadBytes);
+        }
+        if(copied < payloadBytes) {
+            memset(p + copied, 0, payloadBytes - copied);
+        }
+        p += payloadBytes;
+    }
+
+    if(pcap->useNg) {
+        gsize padding = _pcapwriter_pad32(capturedLength) - capturedLength;
+        memset(p, 0, padding);
+        p += padding;
+        p = _pcapwriter_put32(p, (guint32)recordLength);
+    }
+
+    utility_assert(p == record + recordLength);
 }
 
-PCapWriter* pcapwriter_new(Host* host, gchar* pcapDirectory, gchar* pcapFilename) {
+PCapWriter* pcapwriter_new(Host* host, gchar* pcapDirectory, gchar* pcapFilename,
+                           guint32 captureSize, gboolean useNg) {
     PCapWriter* pcap = g_new0(PCapWriter, 1);
+    pcap->fd = -1;
+    pcap->captureSize = captureSize;
+    pcap->useNg = useNg;
+
+    const gchar* suffix = useNg ? ".pcapng" : ".pcap";
 
     /* open the PCAP file for writing */
     GString *filename = g_string_new("");
@@ -152,28 +292,40 @@ PCapWriter* pcapwriter_new(Host* host, gchar* pcapDirectory, gchar* pcapFilename
         g_string_append(filename, "data/pcapdata/");
     }
 
-    if(pcapFilename) {
-        g_string_append_printf(filename, "%s", pcapFilename);
-    } else {
-        g_string_append_printf(filename, "%s", host_getName(host));
-    }
+    const gchar* interfaceName = pcapFilename ? pcapFilename : host_getName(host);
+    g_string_append_printf(filename, "%s", interfaceName);
 
-    if (!g_str_has_suffix(filename->str, ".pcap")) {
-        g_string_append(filename, ".pcap");
+    if (useNg && g_str_has_suffix(filename->str, ".pcap")) {
+        /* "name.pcap" becomes "name.pcapng", not "name.pcap.pcapng" */
+        g_string_append(filename, "ng");
+    } else if (!g_str_has_suffix(filename->str, suffix)) {
+        g_string_append(filename, suffix);
     }
 
-    pcap->pcapFile = fopen(filename->str, "w");
-    if(!pcap->pcapFile) {
+    pcap->fd = open(filename->str, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if(pcap->fd < 0) {
         warning("error trying to open PCAP file '%s' for writing", filename->str);
+    } else if(useNg) {
+        _pcapwriter_writeHeaderNg(pcap, interfaceName);
     } else {
         _pcapwriter_writeHeader(pcap);
     }
 
+    g_string_free(filename, TRUE);
+
     return pcap;
 }
 
 void pcapwriter_free(PCapWriter* pcap) {
-    if(pcap && pcap->pcapFile) {
-        fclose(pcap->pcapFile);
+    if(!pcap) {
+        return;
+    }
+
+    if(pcap->fd >= 0) {
+        _pcapwriter_flush(pcap);
+        close(pcap->fd);
     }
+
+    g_free(pcap->buffer);
+    g_free(pcap);
 }
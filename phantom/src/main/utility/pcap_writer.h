@@ -29,6 +29,11 @@
 
 typedef struct _PCapWriter PCapWriter;
 
+/* copies up to bufferLength payload bytes starting at offset into buffer, returning
+ * the number of bytes copied. packet_copyPayloadShadow has this signature. */
+typedef guint (*PCapPayloadCopyFunc)(gpointer payloadSource, gsize offset, void* buffer,
+                                     gsize bufferLength);
+
 typedef struct _PCapPacket PCapPacket;
 struct _PCapPacket {
     in_addr_t srcIP;
@@ -42,12 +47,17 @@ struct _PCapPacket {
     guint32 seq;
     guint32 ack;
     guint16 win;
-    guint headerSize;
     guint payloadLength;
-    gpointer payload;
+    /* the payload is copied straight into the writer's buffer, and only the part that
+     * fits into the capture size is copied at all */
+    PCapPayloadCopyFunc copyPayload;
+    gpointer payloadSource;
 };
 
-PCapWriter* pcapwriter_new(Host* host, gchar* pcapDirectory, gchar* pcapFilename);
+/* captureSize is the maximum number of bytes stored per packet (the snaplen), and 0 means
+ * to store whole packets. if useNg is set, the file is written in pcapng format. */
+PCapWriter* pcapwriter_new(Host* host, gchar* pcapDirectory, gchar* pcapFilename,
+                           guint32 captureSize, gboolean useNg);
 void pcapwriter_free(PCapWriter* pcap);
 void pcapwriter_writePacket(PCapWriter* pcap, PCapPacket* packet);
 
@@ -153,6 +153,17 @@ gpointer priorityqueue_find(PriorityQueue *q, gpointer data) {
     return (entry == NULL) ? NULL : *entry;
 }
 
+static void _priorityqueue_shrink(PriorityQueue *q) {
+    if ((q->heapSize > INITIAL_SIZE) && (q->size * 4 < q->heapSize)) {
+        q->heapSize /= 2;
+        gpointer *oldheap = q->heap;
+        q->heap = g_renew(gpointer, q->heap, q->heapSize);
+        if (q->heap != oldheap) {
+            _priorityqueue_refresh_map(q);
+        }
+    }
+}
+
 gpointer priorityqueue_pop(PriorityQueue *q) {
     utility_assert(q);
     if (q->size > 0) {
@@ -161,15 +172,28 @@ gpointer priorityqueue_pop(PriorityQueue *q) {
         g_hash_table_remove(q->map, data);
         q->size -= 1;
         _priorityqueue_heapify_down(q, 0);
-        if ((q->heapSize > INITIAL_SIZE) && (q->size * 4 < q->heapSize)) {
-            q->heapSize /= 2;
-            gpointer *oldheap = q->heap;
-            q->heap = g_renew(gpointer, q->heap, q->heapSize);
-            if (q->heap != oldheap) {
-                _priorityqueue_refresh_map(q);
-            }
-        }
+        _priorityqueue_shrink(q);
         return data;
     }
     return NULL;
 }
+
+/* removes data from anywhere in the queue without calling the free func.
+ * returns FALSE if data was not in the queue. */
+gboolean priorityqueue_remove(PriorityQueue *q, gpointer data) {
+    utility_assert(q);
+    gpointer *entry = g_hash_table_lookup(q->map, data);
+    if (entry == NULL) {
+        return FALSE;
+    }
+
+    guint index = entry - q->heap;
+    _priorityqueue_swap_entries(q, index, q->size - 1);
+    g_hash_table_remove(q->map, data);
+    q->size -= 1;
+    if (index < q->size) {
+        _priorityqueue_heapify_up(q, _priorityqueue_heapify_down(q, index));
+    }
+    _priorityqueue_shrink(q);
+    return TRUE;
+}
@@ -22,5 +22,6 @@ gboolean priorityqueue_push(PriorityQueue *q, gpointer data);
 gpointer priorityqueue_peek(PriorityQueue *q);
 gpointer priorityqueue_find(PriorityQueue *q, gpointer data);
 gpointer priorityqueue_pop(PriorityQueue *q);
+gboolean priorityqueue_remove(PriorityQueue *q, gpointer data);
 
 #endif /* SHD_PRIORITY_QUEUE_H */
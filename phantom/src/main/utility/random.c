@@ -9,18 +9,23 @@
 #include <string.h>
 #include <sys/types.h>
 
+#include "lib/chacha/chacha.h"
 #include "main/utility/random.h"
 #include "main/utility/utility.h"
 
 struct _Random {
     guint seedState;
     guint initialSeed;
+    /* bulk random bytes come from a separate stream so that large reads are
+     * cheap and don't disturb the sequence of values from rand_r */
+    ChaCha byteStream;
 };
 
 Random* random_new(guint seed) {
     Random* random = g_new0(Random, 1);
     random->initialSeed = seed;
     random->seedState = seed;
+    random->byteStream = ChaCha_initFromSeed(seed);
     return random;
 }
 
@@ -52,11 +57,5 @@ guint random_nextUInt(Random* random) {
 
 void random_nextNBytes(Random* random, void* buffer, gsize nbytes) {
     utility_assert(random);
-    gsize offset = 0;
-    while(offset < nbytes) {
-        guint randUInt = random_nextUInt(random);
-        gsize n = MIN((nbytes - offset), sizeof(guint));
-        memmove(buffer + offset, &randUInt, n);
-        offset += n;
-    }
+    ChaCha_fill(&random->byteStream, buffer, nbytes);
 }
@@ -44,7 +44,8 @@ gdouble random_nextDouble(Random* random);
 guint random_nextUInt(Random* random);
 
 /**
- * Gets the next nbytes in the range [0, RAND_MAX] from the random source.
+ * Gets the next nbytes from the random source. The bytes are drawn from a
+ * stream that is separate from the one used by the other functions.
  * @param random the random source
  * @param buffer the buffer to copy the random bytes to
  * @param nbytes number of bytes to copy to the buffer
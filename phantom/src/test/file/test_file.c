@@ -10,6 +10,8 @@
 #include <fcntl.h>
 #include <glib.h>
 #include <libgen.h>
+#include <limits.h>
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -565,7 +567,139 @@ __attribute__((unused)) static void _test_iov() {
     fclose(file);
 }
 
+// Returns true if the process's native fd `fd` is open on a file whose name ends
+// with `suffix`. readlink is not emulated, so under Shadow this shows the plugin's
+// native fd table rather than Shadow's descriptor table.
+static bool _native_fd_has_suffix(int fd, const char* suffix) {
+    char link[64];
+    char target[PATH_MAX];
+    snprintf(link, sizeof(link), "/proc/self/fd/%d", fd);
+    ssize_t len = readlink(link, target, sizeof(target) - 1);
+    if (len < 0) {
+        return false;
+    }
+    target[len] = '\0';
+    return g_str_has_suffix(target, suffix);
+}
+
+// The native fd that the shim writes its log to, or -1 if there isn't one.
+static int _find_shim_log_fd() {
+    for (int fd = 0; fd < 1024; fd++) {
+        if (_native_fd_has_suffix(fd, ".shimlog")) {
+            return fd;
+        }
+    }
+    return -1;
+}
+
+// Open `name`, skipping over the shim's log fd so that the file can be opened natively.
+static int _open_avoiding_shim(const char* name, int flags) {
+    int shimFd = _find_shim_log_fd();
+    int placeholder = -1;
+    int fd;
+    assert_nonneg_errno(fd = open(name, flags));
+    if (fd == shimFd) {
+        placeholder = fd;
+        assert_nonneg_errno(fd = open(name, flags));
+    }
+    if (placeholder >= 0) {
+        assert_nonneg_errno(close(placeholder));
+    }
+    return fd;
+}
+
+// With experimental.use_native_private_files, a file under the host's data directory
+// is open natively at the same fd, and I/O on it works without Shadow.
+static void _test_native_private_file() {
+    g_auto(AutoDeleteFile) adf = _create_auto_file();
+    const char wbuf[] = "native file";
+    char rbuf[sizeof(wbuf)] = {0};
+    int fd, fd2, rv;
+
+    assert_nonneg_errno(fd = _open_avoiding_shim(adf.name, O_RDWR));
+    g_assert_true(_native_fd_has_suffix(fd, adf.name));
+
+    assert_nonneg_errno(rv = write(fd, wbuf, sizeof(wbuf)));
+    g_assert_cmpint(rv, ==, sizeof(wbuf));
+    assert_nonneg_errno(lseek(fd, 0, SEEK_SET));
+    assert_nonneg_errno(rv = read(fd, rbuf, sizeof(rbuf)));
+    g_assert_cmpint(rv, ==, sizeof(wbuf));
+    g_assert_cmpstr(rbuf, ==, wbuf);
+
+    // the duplicate is native too, and shares the file offset
+    assert_nonneg_errno(fd2 = dup(fd));
+    g_assert_true(_native_fd_has_suffix(fd2, adf.name));
+    assert_nonneg_errno(lseek(fd2, 7, SEEK_SET));
+    memset(rbuf, 0, sizeof(rbuf));
+    assert_nonneg_errno(rv = read(fd, rbuf, sizeof(rbuf)));
+    g_assert_cmpint(rv, ==, sizeof(wbuf) - 7);
+    g_assert_cmpstr(rbuf, ==, "file");
+
+    // closing closes the native fds as well
+    assert_nonneg_errno(close(fd2));
+    g_assert_false(_native_fd_has_suffix(fd2, adf.name));
+    assert_nonneg_errno(close(fd));
+    g_assert_false(_native_fd_has_suffix(fd, adf.name));
+}
+
+// When the fd that Shadow assigns is already in use natively (here by the shim's
+// log), the file falls back to emulation and the native fd is left alone.
+static void _test_native_private_file_fallback() {
+    int shimFd = _find_shim_log_fd();
+    if (shimFd < 0) {
+        g_test_skip("no native shim log fd");
+        return;
+    }
+
+    g_auto(AutoDeleteFile) adf = _create_auto_file();
+    assert_nonneg_errno(close(adf.fd));
+    adf.fd = 0;
+
+    // Fill the free fds below the shim's, so that the next open gets the shim's fd.
+    int placeholders[1024];
+    int numPlaceholders = 0;
+    int fd;
+    while (true) {
+        assert_nonneg_errno(fd = open("/dev/null", O_RDONLY));
+        if (fd >= shimFd) {
+            break;
+        }
+        placeholders[numPlaceholders++] = fd;
+    }
+    g_assert_cmpint(fd, ==, shimFd);
+    assert_nonneg_errno(close(fd));
+
+    const char wbuf[] = "emulated file";
+    char rbuf[sizeof(wbuf)] = {0};
+    int rv;
+    assert_nonneg_errno(fd = open(adf.name, O_RDWR));
+    g_assert_cmpint(fd, ==, shimFd);
+    g_assert_true(_native_fd_has_suffix(fd, ".shimlog"));
+
+    assert_nonneg_errno(rv = write(fd, wbuf, sizeof(wbuf)));
+    g_assert_cmpint(rv, ==, sizeof(wbuf));
+    assert_nonneg_errno(lseek(fd, 0, SEEK_SET));
+    assert_nonneg_errno(rv = read(fd, rbuf, sizeof(rbuf)));
+    g_assert_cmpint(rv, ==, sizeof(wbuf));
+    g_assert_cmpstr(rbuf, ==, wbuf);
+
+    assert_nonneg_errno(close(fd));
+    g_assert_true(_native_fd_has_suffix(shimFd, ".shimlog"));
+
+    for (int i = 0; i < numPlaceholders; i++) {
+        assert_nonneg_errno(close(placeholders[i]));
+    }
+}
+
 int main(int argc, char* argv[]) {
+    // Only meaningful under Shadow with experimental.use_native_private_files set.
+    bool testNativePrivateFiles = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--native-private-files") == 0) {
+            testNativePrivateFiles = true;
+        }
+    }
+
     g_test_init(&argc, &argv, NULL);
 
     // These are generally ordered by increasing level of required functionality.
@@ -594,6 +728,11 @@ int main(int argc, char* argv[]) {
     g_test_add_func("/file/dup", _test_dup);
     g_test_add_func("/file/ioctl_tty", _test_ioctl_tty);
 
+    if (testNativePrivateFiles) {
+        g_test_add_func("/file/native_private_file", _test_native_private_file);
+        g_test_add_func("/file/native_private_file_fallback", _test_native_private_file_fallback);
+    }
+
     //    TODO: debug and fix iov test
     //    g_test_add_func("/file/iov", _test_iov);
 
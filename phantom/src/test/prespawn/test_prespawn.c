@@ -0,0 +1,53 @@
+/*
+ * The Shadow Simulator
+ * See LICENSE for licensing information
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// Checks that a process that Shadow spawned ahead of its start time doesn't
+// start running its own code until then.
+
+// Shadow's simulated wall clock starts at 2000-01-01 00:00:00 UTC.
+#define SIMULATION_START_SEC 946684800
+
+static time_t _constructor_sec = 0;
+
+static time_t _simulated_sec() {
+    struct timespec ts;
+    if (clock_gettime(CLOCK_REALTIME, &ts) < 0) {
+        perror("clock_gettime");
+        exit(EXIT_FAILURE);
+    }
+    return ts.tv_sec - SIMULATION_START_SEC;
+}
+
+__attribute__((constructor)) static void _record_constructor_time(void) {
+    _constructor_sec = _simulated_sec();
+}
+
+int main(int argc, char* argv[]) {
+    if (argc != 2) {
+        fprintf(stderr, "usage: %s <start time in seconds | native>\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // Outside of Shadow there's no start time to check.
+    if (argv[1][0] == 'n') {
+        return EXIT_SUCCESS;
+    }
+
+    time_t start_sec = atoi(argv[1]);
+    time_t main_sec = _simulated_sec();
+
+    if (_constructor_sec < start_sec || main_sec < start_sec) {
+        fprintf(stderr, "constructor ran at %ld and main at %ld, expected both at or after %ld\n",
+                (long)_constructor_sec, (long)main_sec, (long)start_sec);
+        return EXIT_FAILURE;
+    }
+
+    printf("process with start time %ld started at %ld\n", (long)start_sec, (long)main_sec);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,63 @@
+/*
+ * The Shadow Simulator
+ * See LICENSE for licensing information
+ */
+
+#include <glib.h>
+#include <stdint.h>
+#include <time.h>
+#include <x86intrin.h>
+
+#include "test/test_common.h"
+
+#define NUM_READS 100
+
+// Reads the timestamp counter from the same instructions several times. In
+// Shadow the first execution of each instruction traps, and later ones may
+// run through a rewritten version; they must give the same results.
+static void _test_stable_between_syscalls(void) {
+    uint64_t first = __rdtsc();
+    for (int i = 0; i < NUM_READS; i++) {
+        uint64_t now = __rdtsc();
+        if (running_in_shadow()) {
+            // Simulated time doesn't advance without a syscall.
+            g_assert_cmpint(now, ==, first);
+        } else {
+            g_assert_cmpint(now, >=, first);
+        }
+    }
+
+    unsigned int aux = 0;
+    uint64_t firstp = __rdtscp(&aux);
+    for (int i = 0; i < NUM_READS; i++) {
+        unsigned int nowAux = 0;
+        uint64_t now = __rdtscp(&nowAux);
+        if (running_in_shadow()) {
+            g_assert_cmpint(now, ==, firstp);
+            g_assert_cmpint(nowAux, ==, aux);
+        } else {
+            g_assert_cmpint(now, >=, firstp);
+        }
+    }
+}
+
+static void _test_advances_with_time(void) {
+    uint64_t prev = __rdtsc();
+    for (int i = 0; i < NUM_READS; i++) {
+        struct timespec ts = {.tv_nsec = 1000000};
+        g_assert_cmpint(nanosleep(&ts, NULL), ==, 0);
+        uint64_t now = __rdtsc();
+        g_assert_cmpint(now, >, prev);
+        prev = now;
+    }
+}
+
+int main(int argc, char** argv) {
+    g_test_init(&argc, &argv, NULL);
+
+    g_test_add("/rdtsc/stable_between_syscalls", void, NULL, NULL, _test_stable_between_syscalls,
+               NULL);
+    g_test_add("/rdtsc/advances_with_time", void, NULL, NULL, _test_advances_with_time, NULL);
+
+    return g_test_run();
+}
@@ -0,0 +1,293 @@
+/*
+ * The Shadow Simulator
+ * See LICENSE for licensing information
+ */
+
+use test_utils::set;
+use test_utils::TestEnvironment as TestEnv;
+
+const FILE_LEN: usize = 10 * 1024;
+
+fn main() -> Result<(), String> {
+    // should we restrict the tests we run?
+    let filter_shadow_passing = std::env::args().any(|x| x == "--shadow-passing");
+    let filter_libc_passing = std::env::args().any(|x| x == "--libc-passing");
+    // should we summarize the results rather than exit on a failed test
+    let summarize = std::env::args().any(|x| x == "--summarize");
+
+    let mut tests = get_tests();
+    if filter_shadow_passing {
+        tests = tests
+            .into_iter()
+            .filter(|x| x.passing(TestEnv::Shadow))
+            .collect()
+    }
+    if filter_libc_passing {
+        tests = tests
+            .into_iter()
+            .filter(|x| x.passing(TestEnv::Libc))
+            .collect()
+    }
+
+    test_utils::run_tests(&tests, summarize)?;
+
+    println!("Success.");
+    Ok(())
+}
+
+fn get_tests() -> Vec<test_utils::ShadowTest<(), String>> {
+    let tests: Vec<test_utils::ShadowTest<_, _>> = vec![
+        test_utils::ShadowTest::new(
+            "test_invalid_fds",
+            test_invalid_fds,
+            set![TestEnv::Libc, TestEnv::Shadow],
+        ),
+        test_utils::ShadowTest::new(
+            "test_sendfile_tcp",
+            test_sendfile_tcp,
+            set![TestEnv::Libc, TestEnv::Shadow],
+        ),
+        test_utils::ShadowTest::new(
+            "test_sendfile_tcp_offset",
+            test_sendfile_tcp_offset,
+            set![TestEnv::Libc, TestEnv::Shadow],
+        ),
+        test_utils::ShadowTest::new(
+            "test_sendfile_file",
+            test_sendfile_file,
+            set![TestEnv::Libc, TestEnv::Shadow],
+        ),
+        test_utils::ShadowTest::new(
+            "test_copy_file_range",
+            test_copy_file_range,
+            set![TestEnv::Libc, TestEnv::Shadow],
+        ),
+    ];
+
+    tests
+}
+
+/// Test sendfile() using invalid fds and an input fd that is not a file.
+fn test_invalid_fds() -> Result<(), String> {
+    let fd_file = file_helper("invalid-fds", FILE_LEN);
+    let fd_socket = unsafe { libc::socket(libc::AF_INET, libc::SOCK_STREAM, 0) };
+    assert!(fd_socket >= 0);
+
+    test_utils::run_and_close_fds(&[fd_file, fd_socket], || {
+        test_utils::check_system_call!(
+            || unsafe { libc::sendfile(fd_socket, -1, std::ptr::null_mut(), 10) },
+            &[libc::EBADF]
+        )?;
+        test_utils::check_system_call!(
+            || unsafe { libc::sendfile(8934, fd_file, std::ptr::null_mut(), 10) },
+            &[libc::EBADF]
+        )?;
+        test_utils::check_system_call!(
+            || unsafe { libc::sendfile(fd_file, fd_socket, std::ptr::null_mut(), 10) },
+            &[libc::EINVAL]
+        )?;
+        Ok(())
+    })
+}
+
+/// Test sendfile() from the current file offset to a TCP socket.
+fn test_sendfile_tcp() -> Result<(), String> {
+    let fd_file = file_helper("tcp", FILE_LEN);
+    let (fd_client, fd_server) = tcp_connect_helper();
+
+    test_utils::run_and_close_fds(&[fd_file, fd_client, fd_server], || {
+        let rv = unsafe { libc::sendfile(fd_client, fd_file, std::ptr::null_mut(), FILE_LEN) };
+        test_utils::result_assert_eq(rv, FILE_LEN as isize, "Unexpected sendfile() result")?;
+
+        // the file offset should have moved past the sent data
+        let pos = unsafe { libc::lseek(fd_file, 0, libc::SEEK_CUR) };
+        test_utils::result_assert_eq(pos, FILE_LEN as libc::off_t, "Unexpected file offset")?;
+
+        // nothing left to send
+        let rv = unsafe { libc::sendfile(fd_client, fd_file, std::ptr::null_mut(), FILE_LEN) };
+        test_utils::result_assert_eq(rv, 0, "Unexpected sendfile() result at EOF")?;
+
+        let received = recv_helper(fd_server, FILE_LEN);
+        test_utils::result_assert_eq(&received[..], &file_contents(FILE_LEN)[..], "Bad data")
+    })
+}
+
+/// Test sendfile() from an explicit offset to a TCP socket.
+fn test_sendfile_tcp_offset() -> Result<(), String> {
+    let fd_file = file_helper("tcp-offset", FILE_LEN);
+    let (fd_client, fd_server) = tcp_connect_helper();
+
+    test_utils::run_and_close_fds(&[fd_file, fd_client, fd_server], || {
+        let mut offset: libc::off_t = 100;
+        let rv = unsafe { libc::sendfile(fd_client, fd_file, &mut offset, 1000) };
+        test_utils::result_assert_eq(rv, 1000, "Unexpected sendfile() result")?;
+        test_utils::result_assert_eq(offset, 1100, "Unexpected updated offset")?;
+
+        // the file offset should not have changed
+        let pos = unsafe { libc::lseek(fd_file, 0, libc::SEEK_CUR) };
+        test_utils::result_assert_eq(pos, 0, "Unexpected file offset")?;
+
+        let received = recv_helper(fd_server, 1000);
+        test_utils::result_assert_eq(
+            &received[..],
+            &file_contents(FILE_LEN)[100..1100],
+            "Bad data",
+        )
+    })
+}
+
+/// Test sendfile() between two files.
+fn test_sendfile_file() -> Result<(), String> {
+    let fd_in = file_helper("file-in", FILE_LEN);
+    let fd_out = file_helper("file-out", 0);
+
+    test_utils::run_and_close_fds(&[fd_in, fd_out], || {
+        let mut offset: libc::off_t = 10;
+        let rv = unsafe { libc::sendfile(fd_out, fd_in, &mut offset, FILE_LEN) };
+        test_utils::result_assert_eq(rv, (FILE_LEN - 10) as isize, "Unexpected sendfile() result")?;
+        test_utils::result_assert_eq(offset, FILE_LEN as libc::off_t, "Unexpected offset")?;
+
+        let contents = read_helper(fd_out, FILE_LEN);
+        test_utils::result_assert_eq(&contents[..], &file_contents(FILE_LEN)[10..], "Bad data")
+    })
+}
+
+/// Test copy_file_range() between two files.
+fn test_copy_file_range() -> Result<(), String> {
+    let fd_in = file_helper("copy-in", FILE_LEN);
+    let fd_out = file_helper("copy-out", 0);
+
+    test_utils::run_and_close_fds(&[fd_in, fd_out], || {
+        let mut in_offset: libc::loff_t = 20;
+        let rv = unsafe {
+            libc::syscall(
+                libc::SYS_copy_file_range,
+                fd_in,
+                &mut in_offset,
+                fd_out,
+                std::ptr::null_mut::<libc::loff_t>(),
+                100,
+                0,
+            )
+        };
+        test_utils::result_assert_eq(rv, 100, "Unexpected copy_file_range() result")?;
+        test_utils::result_assert_eq(in_offset, 120, "Unexpected input offset")?;
+
+        // the output file offset should have moved past the copied data
+        let pos = unsafe { libc::lseek(fd_out, 0, libc::SEEK_CUR) };
+        test_utils::result_assert_eq(pos, 100, "Unexpected output file offset")?;
+
+        let contents = read_helper(fd_out, FILE_LEN);
+        test_utils::result_assert_eq(&contents[..], &file_contents(FILE_LEN)[20..120], "Bad data")
+    })
+}
+
+/// The contents of the files created with `file_helper`.
+fn file_contents(len: usize) -> Vec<u8> {
+    (0..len).map(|i| (i % 251) as u8).collect()
+}
+
+/// Create an unlinked file containing `len` bytes, with its offset at the start.
+fn file_helper(name: &str, len: usize) -> libc::c_int {
+    let path = std::ffi::CString::new(format!("sendfile-{}-{}", name, std::process::id())).unwrap();
+    let fd = unsafe {
+        libc::open(
+            path.as_ptr(),
+            libc::O_RDWR | libc::O_CREAT | libc::O_TRUNC,
+            0o600,
+        )
+    };
+    assert!(fd >= 0);
+    assert_eq!(unsafe { libc::unlink(path.as_ptr()) }, 0);
+
+    let contents = file_contents(len);
+    let rv = unsafe { libc::write(fd, contents.as_ptr() as *const libc::c_void, len) };
+    assert_eq!(rv, len as isize);
+    assert_eq!(unsafe { libc::lseek(fd, 0, libc::SEEK_SET) }, 0);
+
+    fd
+}
+
+/// Read the whole file from the start.
+fn read_helper(fd: libc::c_int, max_len: usize) -> Vec<u8> {
+    let mut buf = vec![0u8; max_len];
+    let rv = unsafe { libc::pread(fd, buf.as_mut_ptr() as *mut libc::c_void, max_len, 0) };
+    assert!(rv >= 0);
+    buf.truncate(rv as usize);
+    buf
+}
+
+/// Receive exactly `len` bytes from the socket.
+fn recv_helper(fd: libc::c_int, len: usize) -> Vec<u8> {
+    let mut buf = vec![0u8; len];
+    let mut total = 0;
+
+    while total < len {
+        let rv = unsafe {
+            libc::recv(
+                fd,
+                buf[total..].as_mut_ptr() as *mut libc::c_void,
+                len - total,
+                0,
+            )
+        };
+        assert!(rv > 0);
+        total += rv as usize;
+    }
+
+    buf
+}
+
+/// Returns a connected pair of TCP sockets.
+fn tcp_connect_helper() -> (libc::c_int, libc::c_int) {
+    let fd_client = unsafe { libc::socket(libc::AF_INET, libc::SOCK_STREAM, 0) };
+    let fd_listen = unsafe { libc::socket(libc::AF_INET, libc::SOCK_STREAM, 0) };
+    assert!(fd_client >= 0);
+    assert!(fd_listen >= 0);
+
+    // the server address
+    let mut server_addr = libc::sockaddr_in {
+        sin_family: libc::AF_INET as u16,
+        sin_port: 0u16.to_be(),
+        sin_addr: libc::in_addr {
+            s_addr: libc::INADDR_LOOPBACK.to_be(),
+        },
+        sin_zero: [0; 8],
+    };
+    let mut server_addr_size = std::mem::size_of_val(&server_addr) as libc::socklen_t;
+
+    // bind on the server address and get the assigned port number
+    let rv = unsafe {
+        libc::bind(
+            fd_listen,
+            &server_addr as *const libc::sockaddr_in as *const libc::sockaddr,
+            server_addr_size,
+        )
+    };
+    assert_eq!(rv, 0);
+    let rv = unsafe {
+        libc::getsockname(
+            fd_listen,
+            &mut server_addr as *mut libc::sockaddr_in as *mut libc::sockaddr,
+            &mut server_addr_size,
+        )
+    };
+    assert_eq!(rv, 0);
+
+    assert_eq!(unsafe { libc::listen(fd_listen, 10) }, 0);
+
+    let rv = unsafe {
+        libc::connect(
+            fd_client,
+            &server_addr as *const libc::sockaddr_in as *const libc::sockaddr,
+            server_addr_size,
+        )
+    };
+    assert_eq!(rv, 0);
+
+    let fd_server = unsafe { libc::accept(fd_listen, std::ptr::null_mut(), std::ptr::null_mut()) };
+    assert!(fd_server >= 0);
+    assert_eq!(unsafe { libc::close(fd_listen) }, 0);
+
+    (fd_client, fd_server)
+}
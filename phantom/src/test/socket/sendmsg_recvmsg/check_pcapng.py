@@ -0,0 +1,89 @@
+#!/usr/bin/env python3
+
+'''
+Check the block structure of the pcapng files given on the command line: each
+block's leading and trailing length fields must match, the options of the
+interface description block must end exactly at its trailing length field, and
+the files must contain at least one packet between them.
+'''
+
+import struct
+import sys
+
+BLOCK_TYPE_SHB = 0x0A0D0D0A
+BLOCK_TYPE_IDB = 0x00000001
+BLOCK_TYPE_EPB = 0x00000006
+OPTION_END = 0
+
+
+def pad32(length):
+    return (length + 3) & ~3
+
+
+def check_options(data, start, end):
+    '''Returns the offset just past the end-of-options option.'''
+    offset = start
+    while offset + 4 <= end:
+        code, length = struct.unpack_from('<HH', data, offset)
+        offset += 4
+        if code == OPTION_END:
+            return offset
+        offset += pad32(length)
+    raise ValueError('options run past the end of the block')
+
+
+def check_file(path):
+    with open(path, 'rb') as f:
+        data = f.read()
+
+    offset = 0
+    packets = 0
+    while offset < len(data):
+        if offset + 12 > len(data):
+            raise ValueError('truncated block header at offset {}'.format(offset))
+        block_type, length = struct.unpack_from('<II', data, offset)
+        if length < 12 or length % 4 != 0 or offset + length > len(data):
+            raise ValueError('bad block length {} at offset {}'.format(length, offset))
+        (trailing_length,) = struct.unpack_from('<I', data, offset + length - 4)
+        if trailing_length != length:
+            raise ValueError('block at offset {} has length {} but trailing length {}'.format(
+                offset, length, trailing_length))
+
+        if offset == 0 and block_type != BLOCK_TYPE_SHB:
+            raise ValueError('file does not start with a section header block')
+        if block_type == BLOCK_TYPE_IDB:
+            # link type, reserved, snaplen, then the options
+            options_end = check_options(data, offset + 16, offset + length - 4)
+            if options_end != offset + length - 4:
+                raise ValueError('interface description block at offset {} has {} bytes '
+                                 'after its options'.format(offset,
+                                                            offset + length - 4 - options_end))
+        elif block_type == BLOCK_TYPE_EPB:
+            packets += 1
+
+        offset += length
+
+    return packets
+
+
+def main():
+    if len(sys.argv) < 2:
+        print('usage: {} FILE.pcapng...'.format(sys.argv[0]), file=sys.stderr)
+        return 1
+
+    packets = 0
+    for path in sys.argv[1:]:
+        try:
+            packets += check_file(path)
+        except ValueError as e:
+            print('{}: {}'.format(path, e), file=sys.stderr)
+            return 1
+
+    if packets == 0:
+        print('no packets in {}'.format(' '.join(sys.argv[1:])), file=sys.stderr)
+        return 1
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,447 @@
+/*
+ * The Shadow Simulator
+ * See LICENSE for licensing information
+ */
+
+use test_utils::set;
+use test_utils::TestEnvironment as TestEnv;
+
+fn main() -> Result<(), String> {
+    // should we restrict the tests we run?
+    let filter_shadow_passing = std::env::args().any(|x| x == "--shadow-passing");
+    let filter_libc_passing = std::env::args().any(|x| x == "--libc-passing");
+    // should we summarize the results rather than exit on a failed test
+    let summarize = std::env::args().any(|x| x == "--summarize");
+
+    let mut tests = get_tests();
+    if filter_shadow_passing {
+        tests = tests
+            .into_iter()
+            .filter(|x| x.passing(TestEnv::Shadow))
+            .collect()
+    }
+    if filter_libc_passing {
+        tests = tests
+            .into_iter()
+            .filter(|x| x.passing(TestEnv::Libc))
+            .collect()
+    }
+
+    test_utils::run_tests(&tests, summarize)?;
+
+    println!("Success.");
+    Ok(())
+}
+
+fn get_tests() -> Vec<test_utils::ShadowTest<(), String>> {
+    let tests: Vec<test_utils::ShadowTest<_, _>> = vec![
+        test_utils::ShadowTest::new(
+            "test_invalid_fd",
+            test_invalid_fd,
+            set![TestEnv::Libc, TestEnv::Shadow],
+        ),
+        test_utils::ShadowTest::new(
+            "test_too_many_iovecs",
+            test_too_many_iovecs,
+            set![TestEnv::Libc, TestEnv::Shadow],
+        ),
+        test_utils::ShadowTest::new(
+            "test_sendmsg_recvmsg <tcp>",
+            || test_sendmsg_recvmsg(libc::SOCK_STREAM),
+            set![TestEnv::Libc, TestEnv::Shadow],
+        ),
+        test_utils::ShadowTest::new(
+            "test_sendmsg_recvmsg <udp>",
+            || test_sendmsg_recvmsg(libc::SOCK_DGRAM),
+            set![TestEnv::Libc, TestEnv::Shadow],
+        ),
+        test_utils::ShadowTest::new(
+            "test_sendmmsg_recvmmsg_udp",
+            test_sendmmsg_recvmmsg_udp,
+            set![TestEnv::Libc, TestEnv::Shadow],
+        ),
+    ];
+
+    tests
+}
+
+/// Test sendmsg() and recvmsg() using invalid fds.
+fn test_invalid_fd() -> Result<(), String> {
+    let mut buf = [0u8; 10];
+    let mut iov = libc::iovec {
+        iov_base: buf.as_mut_ptr() as *mut libc::c_void,
+        iov_len: buf.len(),
+    };
+    let mut msg = msghdr_helper(&mut iov, 1, None);
+
+    for &fd in [-1, 8934].iter() {
+        test_utils::check_system_call!(|| unsafe { libc::sendmsg(fd, &msg, 0) }, &[libc::EBADF])?;
+        test_utils::check_system_call!(
+            || unsafe { libc::recvmsg(fd, &mut msg, 0) },
+            &[libc::EBADF]
+        )?;
+    }
+
+    Ok(())
+}
+
+/// Test sendmsg() using more iovecs than the kernel accepts.
+fn test_too_many_iovecs() -> Result<(), String> {
+    let fd_client = unsafe { libc::socket(libc::AF_INET, libc::SOCK_DGRAM, 0) };
+    let fd_server = unsafe { libc::socket(libc::AF_INET, libc::SOCK_DGRAM, 0) };
+    assert!(fd_client >= 0);
+    assert!(fd_server >= 0);
+
+    udp_connect_helper(fd_client, fd_server, /* connect= */ true);
+
+    let mut buf = [0u8; 1];
+    let mut iovs: Vec<libc::iovec> = (0..(libc::UIO_MAXIOV + 1))
+        .map(|_| libc::iovec {
+            iov_base: buf.as_mut_ptr() as *mut libc::c_void,
+            iov_len: buf.len(),
+        })
+        .collect();
+    let msg = msghdr_helper(iovs.as_mut_ptr(), iovs.len(), None);
+
+    test_utils::run_and_close_fds(&[fd_client, fd_server], || {
+        test_utils::check_system_call!(
+            || unsafe { libc::sendmsg(fd_client, &msg, 0) },
+            &[libc::EMSGSIZE]
+        )?;
+        Ok(())
+    })
+}
+
+/// Test that sendmsg() gathers from all of its buffers and recvmsg() scatters into
+/// all of its buffers, and that recvmsg() only returns a source address for UDP.
+fn test_sendmsg_recvmsg(sock_type: libc::c_int) -> Result<(), String> {
+    let fd_client = unsafe { libc::socket(libc::AF_INET, sock_type, 0) };
+    let fd_server = unsafe { libc::socket(libc::AF_INET, sock_type, 0) };
+    assert!(fd_client >= 0);
+    assert!(fd_server >= 0);
+
+    // connect the client fd to the server
+    let fd_server = match sock_type {
+        libc::SOCK_STREAM => {
+            let fd_accepted = tcp_connect_helper(fd_client, fd_server);
+            unsafe { libc::close(fd_server) };
+            fd_accepted
+        }
+        libc::SOCK_DGRAM => {
+            udp_connect_helper(fd_client, fd_server, /* connect= */ true);
+            fd_server
+        }
+        _ => unreachable!(),
+    };
+
+    let mut send_bufs = [vec![1u8; 3], vec![2u8; 5], vec![3u8; 7]];
+    let mut send_iovs: Vec<libc::iovec> = send_bufs
+        .iter_mut()
+        .map(|b| libc::iovec {
+            iov_base: b.as_mut_ptr() as *mut libc::c_void,
+            iov_len: b.len(),
+        })
+        .collect();
+    let send_msg = msghdr_helper(send_iovs.as_mut_ptr(), send_iovs.len(), None);
+
+    let mut recv_bufs = [vec![0u8; 4], vec![0u8; 20]];
+    let mut recv_iovs: Vec<libc::iovec> = recv_bufs
+        .iter_mut()
+        .map(|b| libc::iovec {
+            iov_base: b.as_mut_ptr() as *mut libc::c_void,
+            iov_len: b.len(),
+        })
+        .collect();
+    let mut recv_addr: libc::sockaddr_in = unsafe { std::mem::zeroed() };
+    let mut recv_msg = msghdr_helper(
+        recv_iovs.as_mut_ptr(),
+        recv_iovs.len(),
+        Some(&mut recv_addr),
+    );
+
+    // a connected TCP socket doesn't fill in the address, and sets its length to 0
+    let expected_namelen = match sock_type {
+        libc::SOCK_STREAM => 0,
+        libc::SOCK_DGRAM => std::mem::size_of::<libc::sockaddr_in>(),
+        _ => unreachable!(),
+    };
+
+    test_utils::run_and_close_fds(&[fd_client, fd_server], || {
+        let rv = unsafe { libc::sendmsg(fd_client, &send_msg, 0) };
+        test_utils::result_assert_eq(rv, 15, "Unexpected return value from sendmsg()")?;
+
+        // shadow needs to run events, otherwise the data won't have arrived yet
+        let rv = unsafe { libc::usleep(10000) };
+        assert_eq!(rv, 0);
+
+        let rv = unsafe { libc::recvmsg(fd_server, &mut recv_msg, 0) };
+        test_utils::result_assert_eq(rv, 15, "Unexpected return value from recvmsg()")?;
+
+        test_utils::result_assert_eq(
+            &recv_bufs[0][..],
+            &[1, 1, 1, 2][..],
+            "Unexpected data in the first buffer",
+        )?;
+        test_utils::result_assert_eq(
+            &recv_bufs[1][..11],
+            &[2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 3][..],
+            "Unexpected data in the second buffer",
+        )?;
+
+        test_utils::result_assert_eq(
+            recv_msg.msg_namelen as usize,
+            expected_namelen,
+            "Unexpected msg_namelen",
+        )?;
+        if sock_type == libc::SOCK_DGRAM {
+            test_utils::result_assert_eq(
+                recv_addr.sin_family,
+                libc::AF_INET as u16,
+                "Unexpected address family",
+            )?;
+        }
+
+        Ok(())
+    })
+}
+
+/// Test that sendmmsg() and recvmmsg() transfer several datagrams in one call, and
+/// that recvmmsg() reports the source address of each one.
+fn test_sendmmsg_recvmmsg_udp() -> Result<(), String> {
+    let fd_client = unsafe { libc::socket(libc::AF_INET, libc::SOCK_DGRAM, 0) };
+    let fd_server = unsafe { libc::socket(libc::AF_INET, libc::SOCK_DGRAM, 0) };
+    assert!(fd_client >= 0);
+    assert!(fd_server >= 0);
+
+    let mut server_addr = udp_connect_helper(fd_client, fd_server, /* connect= */ false);
+    let server_addr_ptr = &mut server_addr as *mut libc::sockaddr_in;
+
+    const NUM_MSGS: usize = 3;
+
+    let mut send_bufs: Vec<Vec<u8>> = (0..NUM_MSGS).map(|i| vec![i as u8; 10 + i]).collect();
+    let mut send_iovs: Vec<libc::iovec> = send_bufs
+        .iter_mut()
+        .map(|b| libc::iovec {
+            iov_base: b.as_mut_ptr() as *mut libc::c_void,
+            iov_len: b.len(),
+        })
+        .collect();
+    let mut send_msgs: Vec<libc::mmsghdr> = send_iovs
+        .iter_mut()
+        .map(|iov| libc::mmsghdr {
+            msg_hdr: msghdr_helper(iov, 1, Some(server_addr_ptr)),
+            msg_len: 0,
+        })
+        .collect();
+
+    // room for one more message than was sent
+    let mut recv_bufs: Vec<Vec<u8>> = (0..(NUM_MSGS + 1)).map(|_| vec![0u8; 100]).collect();
+    let mut recv_addrs: Vec<libc::sockaddr_in> = vec![unsafe { std::mem::zeroed() }; NUM_MSGS + 1];
+    let mut recv_iovs: Vec<libc::iovec> = recv_bufs
+        .iter_mut()
+        .map(|b| libc::iovec {
+            iov_base: b.as_mut_ptr() as *mut libc::c_void,
+            iov_len: b.len(),
+        })
+        .collect();
+    let mut recv_msgs: Vec<libc::mmsghdr> = recv_iovs
+        .iter_mut()
+        .zip(recv_addrs.iter_mut())
+        .map(|(iov, addr)| libc::mmsghdr {
+            msg_hdr: msghdr_helper(iov, 1, Some(addr)),
+            msg_len: 0,
+        })
+        .collect();
+
+    test_utils::run_and_close_fds(&[fd_client, fd_server], || {
+        let rv =
+            unsafe { libc::sendmmsg(fd_client, send_msgs.as_mut_ptr(), send_msgs.len() as u32, 0) };
+        test_utils::result_assert_eq(
+            rv,
+            NUM_MSGS as i32,
+            "Unexpected return value from sendmmsg()",
+        )?;
+
+        for (i, msg) in send_msgs.iter().enumerate() {
+            test_utils::result_assert_eq(msg.msg_len as usize, 10 + i, "Unexpected msg_len")?;
+        }
+
+        // the address the client was implicitly bound to
+        let mut client_addr: libc::sockaddr_in = unsafe { std::mem::zeroed() };
+        let mut client_addr_len = std::mem::size_of_val(&client_addr) as libc::socklen_t;
+        let rv = unsafe {
+            libc::getsockname(
+                fd_client,
+                &mut client_addr as *mut libc::sockaddr_in as *mut libc::sockaddr,
+                &mut client_addr_len,
+            )
+        };
+        assert_eq!(rv, 0);
+
+        // shadow needs to run events, otherwise the datagrams won't have arrived yet
+        let rv = unsafe { libc::usleep(10000) };
+        assert_eq!(rv, 0);
+
+        let rv = unsafe {
+            libc::recvmmsg(
+                fd_server,
+                recv_msgs.as_mut_ptr(),
+                recv_msgs.len() as u32,
+                libc::MSG_DONTWAIT,
+                std::ptr::null_mut(),
+            )
+        };
+        test_utils::result_assert_eq(
+            rv,
+            NUM_MSGS as i32,
+            "Unexpected return value from recvmmsg()",
+        )?;
+
+        for i in 0..NUM_MSGS {
+            let msg = &recv_msgs[i];
+            test_utils::result_assert_eq(msg.msg_len as usize, 10 + i, "Unexpected msg_len")?;
+            test_utils::result_assert_eq(
+                msg.msg_hdr.msg_namelen as usize,
+                std::mem::size_of::<libc::sockaddr_in>(),
+                "Unexpected msg_namelen",
+            )?;
+            test_utils::result_assert_eq(
+                &recv_bufs[i][..msg.msg_len as usize],
+                &send_bufs[i][..],
+                "Unexpected datagram contents",
+            )?;
+            test_utils::result_assert_eq(
+                recv_addrs[i].sin_port,
+                client_addr.sin_port,
+                "Unexpected source port",
+            )?;
+        }
+
+        // nothing left to receive
+        test_utils::check_system_call!(
+            || unsafe {
+                libc::recvmmsg(
+                    fd_server,
+                    recv_msgs.as_mut_ptr(),
+                    recv_msgs.len() as u32,
+                    libc::MSG_DONTWAIT,
+                    std::ptr::null_mut(),
+                )
+            },
+            &[libc::EAGAIN]
+        )?;
+
+        Ok(())
+    })
+}
+
+/// Build a message header for the given iovecs and optional address.
+fn msghdr_helper(
+    iov: *mut libc::iovec,
+    iovlen: usize,
+    addr: Option<*mut libc::sockaddr_in>,
+) -> libc::msghdr {
+    let mut msg: libc::msghdr = unsafe { std::mem::zeroed() };
+    msg.msg_iov = iov;
+    msg.msg_iovlen = iovlen;
+    if let Some(addr) = addr {
+        msg.msg_name = addr as *mut libc::c_void;
+        msg.msg_namelen = std::mem::size_of::<libc::sockaddr_in>() as libc::socklen_t;
+    }
+    msg
+}
+
+/// A helper function to connect the client fd to the server fd over TCP. Returns
+/// the accepted fd.
+fn tcp_connect_helper(fd_client: libc::c_int, fd_server: libc::c_int) -> libc::c_int {
+    let server_addr = udp_connect_helper(fd_client, fd_server, /* connect= */ false);
+
+    // listen for connections
+    {
+        let rv = unsafe { libc::listen(fd_server, 10) };
+        assert_eq!(rv, 0);
+    }
+
+    // connect to the server address
+    {
+        let rv = unsafe {
+            libc::connect(
+                fd_client,
+                &server_addr as *const libc::sockaddr_in as *const libc::sockaddr,
+                std::mem::size_of_val(&server_addr) as u32,
+            )
+        };
+        assert_eq!(rv, 0);
+    }
+
+    // shadow needs to run events, otherwise the accept call won't know it
+    // has an incoming connection (SYN packet)
+    {
+        let rv = unsafe { libc::usleep(10000) };
+        assert_eq!(rv, 0);
+    }
+
+    // accept the connection
+    let fd = unsafe { libc::accept(fd_server, std::ptr::null_mut(), std::ptr::null_mut()) };
+    assert!(fd >= 0);
+
+    fd
+}
+
+/// A helper function to bind the server fd to a loopback address and optionally
+/// connect the client fd to it. Returns the address that the server is bound to.
+fn udp_connect_helper(
+    fd_client: libc::c_int,
+    fd_server: libc::c_int,
+    connect: bool,
+) -> libc::sockaddr_in {
+    // the server address
+    let mut server_addr = libc::sockaddr_in {
+        sin_family: libc::AF_INET as u16,
+        sin_port: 0u16.to_be(),
+        sin_addr: libc::in_addr {
+            s_addr: libc::INADDR_LOOPBACK.to_be(),
+        },
+        sin_zero: [0; 8],
+    };
+
+    // bind on the server address
+    {
+        let rv = unsafe {
+            libc::bind(
+                fd_server,
+                &server_addr as *const libc::sockaddr_in as *const libc::sockaddr,
+                std::mem::size_of_val(&server_addr) as u32,
+            )
+        };
+        assert_eq!(rv, 0);
+    }
+
+    // get the assigned port number
+    {
+        let mut server_addr_size = std::mem::size_of_val(&server_addr) as u32;
+        let rv = unsafe {
+            libc::getsockname(
+                fd_server,
+                &mut server_addr as *mut libc::sockaddr_in as *mut libc::sockaddr,
+                &mut server_addr_size as *mut libc::socklen_t,
+            )
+        };
+        assert_eq!(rv, 0);
+        assert_eq!(server_addr_size, std::mem::size_of_val(&server_addr) as u32);
+    }
+
+    // connect to the server address
+    if connect {
+        let rv = unsafe {
+            libc::connect(
+                fd_client,
+                &server_addr as *const libc::sockaddr_in as *const libc::sockaddr,
+                std::mem::size_of_val(&server_addr) as u32,
+            )
+        };
+        assert_eq!(rv, 0);
+    }
+
+    server_addr
+}
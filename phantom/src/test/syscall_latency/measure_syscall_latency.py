@@ -0,0 +1,103 @@
+#!/usr/bin/env python3
+
+import argparse
+import os
+import shutil
+import subprocess
+import sys
+import time
+
+'''
+This script runs test_syscall_latency natively and under Shadow with each way of
+interposing syscalls, and reports the wall-clock time taken per syscall. Each
+setup is also run making no syscalls, and that time is subtracted out so that
+the cost of starting and stopping the simulation isn't counted.
+'''
+
+SETUPS = [
+	('ptrace', ['--interpose-method=ptrace']),
+	('ptrace-ipc', ['--interpose-method=ptrace', '--use-ptrace-ipc=true']),
+	('preload', ['--interpose-method=preload']),
+]
+
+CONFIG = '''general:
+  stop_time: 10
+network:
+  graph:
+    type: 1_gbit_switch
+hosts:
+  testnode:
+    processes:
+    - path: {path}
+      args: "{iterations}"
+      start_time: 1
+'''
+
+def run_native(test_bin, iterations):
+	'''
+	Run the test program directly and return the elapsed wall-clock time.
+	'''
+	start = time.monotonic()
+	subprocess.run([test_bin, str(iterations)], check=True, stdout=subprocess.DEVNULL)
+	return time.monotonic() - start
+
+def run_shadow(shadow_bin, shadow_args, test_bin, iterations, name):
+	'''
+	Run the test program in a Shadow simulation and return the elapsed
+	wall-clock time of the whole simulation.
+	'''
+	data_dir = '{}.data'.format(name)
+	config_path = '{}.yaml'.format(name)
+	shutil.rmtree(data_dir, ignore_errors=True)
+	with open(config_path, 'w') as f:
+		f.write(CONFIG.format(path=test_bin, iterations=iterations))
+
+	cmd = [shadow_bin, '--data-directory={}'.format(data_dir), '--log-level=warning',
+		'--use-cpu-pinning=false'] + shadow_args + [config_path]
+	start = time.monotonic()
+	result = subprocess.run(cmd, stdout=subprocess.PIPE, stderr=subprocess.STDOUT)
+	elapsed = time.monotonic() - start
+
+	output = result.stdout.decode(errors='replace')
+	if result.returncode != 0 or 'main error code' in output:
+		sys.stderr.write(output)
+		raise RuntimeError('shadow run {} failed'.format(name))
+	return elapsed
+
+def measure(run, iterations, repeat):
+	'''
+	Return the time per syscall in nanoseconds, using the fastest of `repeat`
+	runs both with and without syscalls.
+	'''
+	loaded = min(run(iterations) for _ in range(repeat))
+	baseline = min(run(0) for _ in range(repeat))
+	return max(loaded - baseline, 0) * 1e9 / iterations
+
+def main():
+	parser = argparse.ArgumentParser(
+		description='Measure the wall-clock time per syscall under Shadow.')
+	parser.add_argument('--shadow', required=True, help='path to the shadow binary')
+	parser.add_argument('--test-bin', required=True, help='path to test_syscall_latency')
+	parser.add_argument('--iterations', type=int, default=100000,
+		help='number of syscalls to make in each timed run')
+	parser.add_argument('--repeat', type=int, default=3,
+		help='number of times to repeat each run, keeping the fastest')
+	args = parser.parse_args()
+
+	if args.iterations <= 0:
+		parser.error('--iterations must be positive')
+
+	test_bin = os.path.abspath(args.test_bin)
+
+	results = [('native', measure(lambda n: run_native(test_bin, n), args.iterations,
+		args.repeat))]
+	for (name, shadow_args) in SETUPS:
+		run = lambda n: run_shadow(args.shadow, shadow_args, test_bin, n,
+			'syscall_latency-{}-{}'.format(name, n))
+		results.append((name, measure(run, args.iterations, args.repeat)))
+
+	for (name, ns) in results:
+		print('{:<12} {:>10.0f} ns per syscall'.format(name, ns))
+
+if __name__ == '__main__':
+	main()
@@ -0,0 +1,68 @@
+/*
+ * The Shadow Simulator
+ * See LICENSE for licensing information
+ */
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// Makes a number of cheap syscalls that Shadow always has to handle itself,
+// for measure_syscall_latency.py to time. The calls are made both from the main
+// thread and from a second thread, so that the way each thread reaches Shadow
+// gets exercised.
+
+#define DEFAULT_ITERATIONS 1000
+
+static long _iterations = DEFAULT_ITERATIONS;
+static pid_t _expected_ppid = 0;
+
+static void* _make_syscalls(void* arg) {
+    long n = (long)arg;
+    for (long i = 0; i < n; i++) {
+        pid_t ppid = syscall(SYS_getppid);
+        if (ppid != _expected_ppid) {
+            fprintf(stderr, "getppid returned %d on iteration %ld, expected %d\n", ppid, i,
+                    _expected_ppid);
+            exit(EXIT_FAILURE);
+        }
+    }
+    return NULL;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1) {
+        char* end = NULL;
+        _iterations = strtol(argv[1], &end, 10);
+        if (*argv[1] == '\0' || *end != '\0' || _iterations < 0) {
+            fprintf(stderr, "usage: %s [iterations]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    _expected_ppid = getppid();
+
+    // Most of the calls come from the main thread; the second thread only
+    // checks that it can make syscalls too.
+    long thread_iterations = _iterations / 10;
+    _make_syscalls((void*)(_iterations - thread_iterations));
+
+    pthread_t thread;
+    int rv = pthread_create(&thread, NULL, _make_syscalls, (void*)thread_iterations);
+    if (rv != 0) {
+        fprintf(stderr, "pthread_create: %s\n", strerror(rv));
+        return EXIT_FAILURE;
+    }
+    rv = pthread_join(thread, NULL);
+    if (rv != 0) {
+        fprintf(stderr, "pthread_join: %s\n", strerror(rv));
+        return EXIT_FAILURE;
+    }
+
+    printf("made %ld getppid syscalls\n", _iterations);
+    return EXIT_SUCCESS;
+}
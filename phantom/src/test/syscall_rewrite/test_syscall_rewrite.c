@@ -0,0 +1,112 @@
+/*
+ * The Shadow Simulator
+ * See LICENSE for licensing information
+ */
+
+#include <errno.h>
+#include <glib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "test/test_glib_helpers.h"
+
+// Syscall sites that don't go through libc, in the forms that Shadow can
+// rewrite when `use_syscall_rewriting` is enabled. Each is called repeatedly so
+// that later calls run through the rewritten site.
+long _raw_getpid(void);
+long _raw_write(long fd, const void* buf, long count);
+long _raw_close(long fd);
+// Jumps straight to the syscall instruction of `_raw_close`, skipping the mov.
+long _raw_close_skip_mov(long fd);
+
+__asm__(".text\n"
+        "_raw_getpid:\n"
+        "movl $" G_STRINGIFY(SYS_getpid) ", %eax\n"
+        "syscall\n"
+        "ret\n"
+        "_raw_write:\n"
+        "movq $" G_STRINGIFY(SYS_write) ", %rax\n"
+        "syscall\n"
+        "ret\n"
+        "_raw_close_skip_mov:\n"
+        "movl $" G_STRINGIFY(SYS_close) ", %eax\n"
+        "jmp _raw_close_syscall\n"
+        "_raw_close:\n"
+        "movl $" G_STRINGIFY(SYS_close) ", %eax\n"
+        "_raw_close_syscall:\n"
+        "syscall\n"
+        "ret\n");
+
+#define NUM_CALLS 100
+
+static void _test_getpid(void) {
+    for (int i = 0; i < NUM_CALLS; i++) {
+        g_assert_cmpint(_raw_getpid(), ==, getpid());
+    }
+}
+
+static void _test_write(void) {
+    int fds[2];
+    assert_nonneg_errno(pipe(fds));
+
+    for (int i = 0; i < NUM_CALLS; i++) {
+        char msg[16];
+        snprintf(msg, sizeof(msg), "msg %d", i);
+        g_assert_cmpint(_raw_write(fds[1], msg, strlen(msg)), ==, strlen(msg));
+
+        char buf[16] = {0};
+        g_assert_cmpint(read(fds[0], buf, sizeof(buf)), ==, strlen(msg));
+        g_assert_cmpstr(buf, ==, msg);
+    }
+
+    assert_nonneg_errno(close(fds[0]));
+    assert_nonneg_errno(close(fds[1]));
+}
+
+static void _test_error(void) {
+    for (int i = 0; i < NUM_CALLS; i++) {
+        g_assert_cmpint(_raw_close(-1), ==, -EBADF);
+        g_assert_cmpint(_raw_close_skip_mov(-1), ==, -EBADF);
+    }
+}
+
+// Values in registers that the syscall instruction preserves must survive.
+static void _test_preserves_registers(void) {
+    for (int i = 0; i < NUM_CALLS; i++) {
+        register uint64_t r8 __asm__("r8") = 0x4444;
+        register uint64_t r9 __asm__("r9") = 0x5555;
+        register uint64_t r12 __asm__("r12") = 0x3333;
+        uint64_t rdi = 0x1111, rbx = 0x2222;
+        double xmm = 1.5 * i, xmmOut = 0;
+        long rv;
+        __asm__ volatile("movq %[xmm], %%xmm2\n"
+                         "call _raw_getpid\n"
+                         "movq %%xmm2, %[xmmOut]\n"
+                         : "=a"(rv), "+D"(rdi), "+b"(rbx), "+r"(r8), "+r"(r9), "+r"(r12),
+                           [ xmmOut ] "=m"(xmmOut)
+                         : [ xmm ] "m"(xmm)
+                         : "rcx", "r11", "xmm2", "memory");
+        g_assert_cmpint(rv, ==, getpid());
+        g_assert_cmpint(rdi, ==, 0x1111);
+        g_assert_cmpint(rbx, ==, 0x2222);
+        g_assert_cmpint(r8, ==, 0x4444);
+        g_assert_cmpint(r9, ==, 0x5555);
+        g_assert_cmpint(r12, ==, 0x3333);
+        g_assert_cmpfloat(xmmOut, ==, xmm);
+    }
+}
+
+int main(int argc, char** argv) {
+    g_test_init(&argc, &argv, NULL);
+
+    g_test_add("/syscall_rewrite/getpid", void, NULL, NULL, _test_getpid, NULL);
+    g_test_add("/syscall_rewrite/write", void, NULL, NULL, _test_write, NULL);
+    g_test_add("/syscall_rewrite/error", void, NULL, NULL, _test_error, NULL);
+    g_test_add("/syscall_rewrite/preserves_registers", void, NULL, NULL,
+               _test_preserves_registers, NULL);
+
+    return g_test_run();
+}
@@ -0,0 +1,41 @@
+/*
+ * The Shadow Simulator
+ * See LICENSE for licensing information
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// Checks that a process forked from a zygote gets its own arguments and
+// environment, and runs the program's own initializers.
+
+static pid_t _constructor_pid = 0;
+
+__attribute__((constructor)) static void _record_constructor_pid(void) {
+    _constructor_pid = getpid();
+}
+
+int main(int argc, char* argv[]) {
+    if (argc != 2) {
+        fprintf(stderr, "usage: %s <expected value of TEST_ZYGOTE_VALUE>\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    const char* value = getenv("TEST_ZYGOTE_VALUE");
+    if (value == NULL || strcmp(value, argv[1]) != 0) {
+        fprintf(stderr, "TEST_ZYGOTE_VALUE is '%s', expected '%s'\n", value ? value : "(unset)",
+                argv[1]);
+        return EXIT_FAILURE;
+    }
+
+    if (_constructor_pid != getpid()) {
+        fprintf(stderr, "constructor ran in process %d, not this process %d\n", _constructor_pid,
+                getpid());
+        return EXIT_FAILURE;
+    }
+
+    printf("process with value '%s' started correctly\n", value);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,251 @@
+#!/usr/bin/env python3
+
+'''
+Convert the binary heartbeat files that Shadow writes to the heartbeats
+directory of its data directory when `experimental.use_binary_heartbeats` is
+enabled. See src/main/host/tracker_output.h for a description of the format.
+
+The heartbeats can be converted to the text format of Shadow's heartbeat log
+messages, to one CSV file per table, or to the stats file that parse-shadow.py
+produces from a log file:
+
+$ convert_heartbeats.py text shadow.data/heartbeats/*.hbt > heartbeats.log
+$ convert_heartbeats.py csv -p out shadow.data/heartbeats/*.hbt
+$ convert_heartbeats.py stats -p out shadow.data/heartbeats/*.hbt
+
+The binary files don't record the wall-clock time of each heartbeat, so the
+text format shows 00:00:00.000000 in its place, and the stats file has no
+'ticks'.
+'''
+
+import argparse
+import array
+import csv
+import json
+import lzma
+import os
+import struct
+import sys
+
+MAGIC = b'SHDHBT01'
+
+BLOCK_SCHEMA = 1
+BLOCK_STRING = 2
+BLOCK_ROWS = 3
+
+ARRAY_TYPES = {'u': 'Q', 's': 'Q', 'f': 'd'}
+
+COUNTER_DIRECTIONS = ['inbound-localhost', 'outbound-localhost', 'inbound-remote',
+                      'outbound-remote']
+COUNTERS = ['packets-total', 'bytes-total',
+            'packets-control', 'bytes-control-header',
+            'packets-control-retrans', 'bytes-control-header-retrans',
+            'packets-data', 'bytes-data-header', 'bytes-data-payload',
+            'packets-data-retrans', 'bytes-data-header-retrans', 'bytes-data-payload-retrans']
+
+
+class Table:
+    def __init__(self, name, columns):
+        self.name = name
+        # (type, name) of each column.
+        self.columns = columns
+        # Values of each column, across all blocks.
+        self.values = [array.array(ARRAY_TYPES[t]) for t, _ in columns]
+
+    def __len__(self):
+        return len(self.values[0])
+
+
+def read_name(data, offset):
+    length = data[offset]
+    return data[offset + 1:offset + 1 + length].decode(), offset + 1 + length
+
+
+def read_file(path, tables, strings):
+    '''Adds the rows of the heartbeat file at `path` to `tables`, a dict of
+    table name -> Table. String ids are only unique within a file, so string
+    columns are resolved to the strings in `strings`.'''
+    with open(path, 'rb') as f:
+        data = f.read()
+    if data[:len(MAGIC)] != MAGIC:
+        raise ValueError('{} is not a heartbeat file'.format(path))
+
+    file_strings = {}
+    file_tables = {}
+    # Rows blocks, which are resolved once all strings are known.
+    blocks = []
+
+    offset = len(MAGIC)
+    while offset < len(data):
+        if offset + 5 > len(data):
+            print('warning: truncated block in {}'.format(path), file=sys.stderr)
+            break
+        block_type, length = struct.unpack_from('<BI', data, offset)
+        offset += 5
+        payload = data[offset:offset + length]
+        if len(payload) < length:
+            print('warning: truncated block in {}'.format(path), file=sys.stderr)
+            break
+        offset += length
+
+        if block_type == BLOCK_SCHEMA:
+            table_id = payload[0]
+            name, pos = read_name(payload, 1)
+            (ncolumns,) = struct.unpack_from('<I', payload, pos)
+            pos += 4
+            columns = []
+            for _ in range(ncolumns):
+                column_type = chr(payload[pos])
+                column_name, pos = read_name(payload, pos + 1)
+                columns.append((column_type, column_name))
+            file_tables[table_id] = (name, columns)
+            if name not in tables:
+                tables[name] = Table(name, columns)
+            elif tables[name].columns != columns:
+                raise ValueError('{} has a different schema for table {}'.format(path, name))
+        elif block_type == BLOCK_STRING:
+            (string_id,) = struct.unpack_from('<Q', payload)
+            file_strings[string_id] = payload[8:].decode('utf-8', errors='replace')
+        elif block_type == BLOCK_ROWS:
+            blocks.append(payload)
+
+    for payload in blocks:
+        table_id = payload[0]
+        (nrows,) = struct.unpack_from('<I', payload, 1)
+        name, columns = file_tables[table_id]
+        table = tables[name]
+        pos = 5
+        for i, (column_type, _) in enumerate(columns):
+            column = array.array(ARRAY_TYPES[column_type])
+            column.frombytes(payload[pos:pos + nrows * 8])
+            pos += nrows * 8
+            if column_type == 's':
+                # Renumber the file's string ids to ids in `strings`.
+                ids = {}
+                for string_id in set(column):
+                    string = file_strings.get(string_id, '<string {}>'.format(string_id))
+                    ids[string_id] = strings.setdefault(string, len(strings))
+                column = array.array('Q', (ids[v] for v in column))
+            table.values[i].extend(column)
+
+
+def load(paths):
+    tables, strings = {}, {}
+    for path in paths:
+        read_file(path, tables, strings)
+    names = {string_id: string for string, string_id in strings.items()}
+    return tables, names
+
+
+def rows(table, names):
+    '''Yields each row of `table` as a dict of column name -> value.'''
+    columns = []
+    for (column_type, name), values in zip(table.columns, table.values):
+        if column_type == 's':
+            values = [names[v] for v in values]
+        columns.append((name, values))
+    for i in range(len(table)):
+        yield {name: values[i] for name, values in columns}
+
+
+def time_of_day(nanos):
+    secs, nanos = divmod(nanos, 1000000000)
+    mins, secs = divmod(secs, 60)
+    hours, mins = divmod(mins, 60)
+    return '{:02}:{:02}:{:02}.{:09}'.format(hours, mins, secs, nanos)
+
+
+def counters(row, direction):
+    return ','.join(str(row['{}-{}'.format(direction, c)]) for c in COUNTERS)
+
+
+def to_text(tables, names, out):
+    '''Writes each row as a heartbeat message, in the layout of Shadow's log.'''
+    lines = []
+    for name, table in tables.items():
+        for row in rows(table, names):
+            if name == 'node':
+                message = '[node] {},{},{},{:f},{},{:f};{}'.format(
+                    row['interval-seconds'], row['recv-bytes'], row['send-bytes'],
+                    row['cpu-percent'], row['delayed-count'], row['avgdelay-milliseconds'],
+                    ';'.join(counters(row, d) for d in COUNTER_DIRECTIONS))
+            elif name == 'socket':
+                # Unlike the log, which has one message per host with all of
+                # its sockets, write a message per socket.
+                message = '[socket] {},{},{}:{};{},{},{},{};{},{};{}'.format(
+                    row['descriptor-number'], row['protocol-string'], row['hostname-peer'],
+                    row['port-peer'], row['inbuflen-bytes'], row['inbufsize-bytes'],
+                    row['outbuflen-bytes'], row['outbufsize-bytes'], row['recv-bytes'],
+                    row['send-bytes'], ';'.join(counters(row, d) for d in COUNTER_DIRECTIONS))
+            elif name == 'ram':
+                message = '[ram] {},{},{},{},{},{}'.format(
+                    row['interval-seconds'], row['alloc-bytes'], row['dealloc-bytes'],
+                    row['total-bytes'], row['pointers-count'], row['failfree-count'])
+            else:
+                continue
+            lines.append((row['time-nanos'], row['host'], message))
+
+    for time_nanos, host, message in sorted(lines, key=lambda line: line[:2]):
+        out.write('00:00:00.000000 [heartbeat] {} [INFO] [{}] [tracker.c:0] [tracker_heartbeat] '
+                  '[shadow-heartbeat] {}\n'.format(time_of_day(time_nanos), host, message))
+
+
+def to_csv(tables, names, prefix):
+    for name, table in tables.items():
+        path = os.path.join(prefix, 'heartbeats.{}.csv'.format(name))
+        with open(path, 'w', newline='') as f:
+            writer = csv.DictWriter(f, fieldnames=[c for _, c in table.columns])
+            writer.writeheader()
+            writer.writerows(rows(table, names))
+        print('wrote {} rows to {}'.format(len(table), path), file=sys.stderr)
+
+
+def to_stats(tables, names, prefix, with_packet_data):
+    '''Writes the per-node stats that parse-shadow.py computes from the log.'''
+    d = {'ticks': {}, 'nodes': {}}
+    table = tables.get('node')
+    if table is not None:
+        labels = [c.replace('-', '_') for c in COUNTERS]
+        if not with_packet_data:
+            labels = [l for l in labels if 'packet' not in l]
+        for row in rows(table, names):
+            second = row['time-nanos'] // 1000000000
+            node = d['nodes'].setdefault(row['host'], {
+                'recv': {l: {} for l in labels}, 'send': {l: {} for l in labels}})
+            for kind, direction in (('recv', 'inbound-remote'), ('send', 'outbound-remote')):
+                for label in labels:
+                    column = '{}-{}'.format(direction, label.replace('_', '-'))
+                    node[kind][label][second] = node[kind][label].get(second, 0) + row[column]
+
+    path = os.path.join(prefix, 'stats.shadow.json.xz')
+    with lzma.open(path, 'wt') as f:
+        json.dump(d, f, sort_keys=True, separators=(',', ': '), indent=2)
+    print('wrote stats for {} nodes to {}'.format(len(d['nodes']), path), file=sys.stderr)
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('format', choices=['text', 'csv', 'stats'], help='output format')
+    parser.add_argument('inputs', nargs='+', help='heartbeat files')
+    parser.add_argument('-p', '--prefix', default=os.getcwd(),
+                        help='directory to write csv and stats output to')
+    parser.add_argument('--packet-data', action='store_true',
+                        help='include packet counts in the stats, like parse-shadow.py')
+    args = parser.parse_args()
+
+    tables, names = load(args.inputs)
+
+    if args.format == 'text':
+        to_text(tables, names, sys.stdout)
+        return
+
+    os.makedirs(args.prefix, exist_ok=True)
+    if args.format == 'csv':
+        to_csv(tables, names, args.prefix)
+    else:
+        to_stats(tables, names, args.prefix, args.packet_data)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,186 @@
+#!/usr/bin/env python3
+
+'''
+Convert a binary log, written by Shadow or by the shim when
+`experimental.use_binary_log` is enabled, to the text format of Shadow's log.
+See src/lib/logger/binary_log.h for a description of the format.
+'''
+
+import argparse
+import re
+import struct
+import sys
+
+MAGIC = b'SHDLOGB1'
+
+ENTRY_STRING = 1
+ENTRY_RECORD = 2
+
+LEVELS = {1: 'ERROR', 2: 'WARN', 3: 'INFO', 4: 'DEBUG', 5: 'TRACE'}
+
+NO_SIM_TIME = 2**64 - 1
+
+# Header of a record's payload, up to the packed arguments.
+RECORD_HEADER = struct.Struct('<BQQQQQIQQ')
+
+# A printf conversion specification.
+CONVERSION = re.compile(
+    r'%(?P<flags>[-+ #0\'I]*)(?P<width>\*|\d*)(?:\.(?P<precision>\*|\d*))?'
+    r'(?:hh|h|ll|l|q|j|z|Z|t|L)?(?P<conversion>[%a-zA-Z])')
+
+
+def read_entries(data):
+    '''Yields the (type, payload) of each entry of the log in `data`.'''
+    if data[:len(MAGIC)] != MAGIC:
+        raise ValueError('not a binary log')
+    offset = len(MAGIC)
+    while offset < len(data):
+        if offset + 5 > len(data):
+            print('warning: truncated entry at offset {}'.format(offset), file=sys.stderr)
+            return
+        entry_type, length = struct.unpack_from('<BI', data, offset)
+        offset += 5
+        payload = data[offset:offset + length]
+        if len(payload) < length:
+            print('warning: truncated entry at offset {}'.format(offset), file=sys.stderr)
+            return
+        offset += length
+        yield entry_type, payload
+
+
+def unpack_args(data):
+    '''Returns the list of arguments packed by `binarylog_packArgs`.'''
+    args = []
+    offset = 0
+    while offset < len(data):
+        tag = chr(data[offset])
+        offset += 1
+        if tag == 'i':
+            args.append(struct.unpack_from('<q', data, offset)[0])
+            offset += 8
+        elif tag in 'up':
+            args.append(struct.unpack_from('<Q', data, offset)[0])
+            offset += 8
+        elif tag == 'f':
+            args.append(struct.unpack_from('<d', data, offset)[0])
+            offset += 8
+        elif tag == 's':
+            (length,) = struct.unpack_from('<I', data, offset)
+            offset += 4
+            args.append(data[offset:offset + length].decode('utf-8', errors='replace'))
+            offset += length
+        elif tag == 'n':
+            args.append(None)
+        else:
+            raise ValueError('unknown argument tag {!r}'.format(tag))
+    return args
+
+
+def render(format, args):
+    '''Formats `args` according to the printf-style `format`.'''
+    args = iter(args)
+
+    def convert(match):
+        conversion = match.group('conversion')
+        if conversion == '%':
+            return '%'
+        flags = match.group('flags').replace('\'', '').replace('I', '')
+        width = match.group('width')
+        if width == '*':
+            width = next(args)
+            if width < 0:
+                flags += '-'
+                width = -width
+        precision = match.group('precision')
+        if precision == '*':
+            precision = next(args)
+            precision = None if precision < 0 else precision
+        value = next(args)
+
+        if conversion in 'di':
+            spec = 'd'
+        elif conversion == 'u':
+            spec = 'd'
+        elif conversion in 'oxXeEfFgG':
+            spec = conversion
+        elif conversion == 'c':
+            spec, value = 's', chr(value)
+        elif conversion in 'sm':
+            spec, value = 's', '(null)' if value is None else value
+        elif conversion == 'p':
+            spec, value = 's', '(nil)' if value == 0 else '0x{:x}'.format(value)
+        elif conversion in 'aA':
+            # Python always prints every digit of the mantissa; printf doesn't.
+            spec, value = 's', re.sub(r'\.?0+p', 'p', float.hex(value))
+            value = value.upper() if conversion == 'A' else value
+        else:
+            return match.group(0)
+
+        python_format = '%' + flags + str(width or '')
+        if precision is not None and precision != '':
+            python_format += '.' + str(precision)
+        return (python_format + spec) % value
+
+    try:
+        return CONVERSION.sub(convert, format)
+    except (StopIteration, TypeError, ValueError):
+        return '{} <bad arguments>'.format(format)
+
+
+def time_of_day(nanos, digits):
+    secs, nanos = divmod(nanos, 1000000000)
+    mins, secs = divmod(secs, 60)
+    hours, mins = divmod(mins, 60)
+    return '{:02}:{:02}:{:02}.{:0{}}'.format(hours, mins, secs, nanos // 10**(9 - digits), digits)
+
+
+def decode(data, out):
+    entries = list(read_entries(data))
+
+    # Strings may be defined after the records that use them, so collect them
+    # all first.
+    strings = {0: None}
+    for entry_type, payload in entries:
+        if entry_type == ENTRY_STRING:
+            (string_id,) = struct.unpack_from('<Q', payload)
+            strings[string_id] = payload[8:].decode('utf-8', errors='replace')
+
+    def lookup(string_id):
+        return strings.get(string_id, '<string {}>'.format(string_id))
+
+    for entry_type, payload in entries:
+        if entry_type != ENTRY_RECORD:
+            continue
+        (level, wall_micros, sim_nanos, thread_id, host_id, file_id, line, function_id,
+         format_id) = RECORD_HEADER.unpack_from(payload)
+        args = unpack_args(payload[RECORD_HEADER.size:])
+
+        sim_time = 'n/a' if sim_nanos == NO_SIM_TIME else time_of_day(sim_nanos, 9)
+        file = lookup(file_id)
+        file = 'n/a' if file is None else file.rsplit('/', 1)[-1]
+        out.write('{} [{}] {} [{}] [{}] [{}:{}] [{}] {}\n'.format(
+            time_of_day(wall_micros * 1000, 6), lookup(thread_id), sim_time,
+            LEVELS.get(level, 'level {}'.format(level)), lookup(host_id) or 'n/a', file,
+            line or 'n/a', lookup(function_id) or 'n/a', render(lookup(format_id), args)))
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('inputs', nargs='+', help='binary log files, or - for stdin')
+    parser.add_argument('-o', '--output', help='text log file (default: stdout)')
+    args = parser.parse_args()
+
+    out = sys.stdout if args.output is None else open(args.output, 'w')
+    for input in args.inputs:
+        if input == '-':
+            data = sys.stdin.buffer.read()
+        else:
+            with open(input, 'rb') as f:
+                data = f.read()
+        decode(data, out)
+    out.close()
+
+
+if __name__ == '__main__':
+    main()